@@ -42,7 +42,9 @@ int main( int argc, char* argv[] ) {
   PCCDecoderParameters decoderParams;
   PCCMetricsParameters metricsParams;
   if ( !parseParameters( argc, argv, decoderParams, metricsParams ) ) { return -1; }
-  if ( decoderParams.nbThread_ > 0 ) { tbb::task_scheduler_init init( (int)decoderParams.nbThread_ ); }
+  PCCExecutionContext executionContext( decoderParams.nbThread_, decoderParams.pinThreads_ );
+  decoderParams.nbThread_ = executionContext.getNbThread();
+  metricsParams.nbThread_ = executionContext.getNbThread();
 
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clockWall;
@@ -116,6 +118,11 @@ bool parseParameters( int                   argc,
       decoderParams.reconstructedDataPath_,
       "Output decoded pointcloud. Multi-frame sequences may be represented by %04i" )
 
+    ( "reconstructedDataAscii",
+      decoderParams.reconstructedDataAscii_,
+      decoderParams.reconstructedDataAscii_,
+      "Write the decoded pointcloud as ASCII PLY instead of binary little endian PLY" )
+
     // sequence configuration
     ( "startFrameNumber",
       decoderParams.startFrameNumber_,
@@ -153,7 +160,23 @@ bool parseParameters( int                   argc,
     ( "nbThread",
       decoderParams.nbThread_,
       decoderParams.nbThread_,
-      "Number of thread used for parallel processing" )
+      "Number of thread used for parallel processing (0: all cores)" )
+
+    ( "pinThreads",
+      decoderParams.pinThreads_,
+      decoderParams.pinThreads_,
+      "Pin the processing threads to the cores of the process affinity mask" )
+
+    ( "streaming",
+      decoderParams.streaming_,
+      decoderParams.streaming_,
+      "Overlap the parsing of the next group of frames, the reconstruction\n"
+      "of the current one and the writing / metrics of the decoded frames" )
+
+    ( "maxResidentFrames",
+      decoderParams.maxResidentFrames_,
+      decoderParams.maxResidentFrames_,
+      "Maximum number of decoded frames waiting to be written (streaming)" )
 
     ( "postprocessSmoothingFilterType",
       decoderParams.postprocessSmoothingFilter_,
@@ -170,6 +193,19 @@ bool parseParameters( int                   argc,
       decoderParams.occupancyTargetPrecision_,
       decoderParams.occupancyTargetPrecision_,
       "Occupancy map target precision" )
+    ( "occupancyModelTileSize",
+      decoderParams.occupancyModelTileSize_,
+      decoderParams.occupancyModelTileSize_,
+      "Side of the tiles the occupancy map model is run on (0: whole frames)" )
+    ( "occupancyModelTileHalo",
+      decoderParams.occupancyModelTileHalo_,
+      decoderParams.occupancyModelTileHalo_,
+      "Margin around the occupancy map model tiles, at least the receptive field radius of the model" )
+    ( "occupancyModelTileStride",
+      decoderParams.occupancyModelTileStride_,
+      decoderParams.occupancyModelTileStride_,
+      "Total stride of the occupancy map model (product of its pooling or strided convolution factors), the tile "
+      "windows are aligned on it" )
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
       ( "modelName",
@@ -278,6 +314,100 @@ bool parseParameters( int                   argc,
   return true;
 }
 
+// Checksums, metrics and writing of decoded frames; frameNumber is the number of the first frame of reconstructs.
+static bool checkAndWrite( const PCCDecoderParameters& decoderParams,
+                           const PCCMetricsParameters& metricsParams,
+                           PCCMetrics&                 metrics,
+                           PCCChecksum&                checksum,
+                           PCCGroupOfFrames&           reconstructs,
+                           size_t&                     frameNumber ) {
+  if ( metricsParams.computeChecksum_ ) { checksum.computeDecoded( reconstructs ); }
+  if ( metricsParams.computeMetrics_ ) {
+    PCCGroupOfFrames sources, normals;
+    if ( !sources.load( metricsParams.uncompressedDataPath_, frameNumber, frameNumber + reconstructs.size(),
+                        decoderParams.colorTransform_, false, decoderParams.nbThread_ ) ) {
+      return false;
+    }
+    if ( metricsParams.normalDataPath_ != "" ) {
+      if ( !normals.load( metricsParams.normalDataPath_, frameNumber, frameNumber + reconstructs.size(),
+                          COLOR_TRANSFORM_NONE, true, decoderParams.nbThread_ ) ) {
+        return false;
+      }
+    }
+    metrics.compute( sources, reconstructs, normals );
+    sources.clear();
+    normals.clear();
+  }
+  if ( !decoderParams.reconstructedDataPath_.empty() ) {
+    reconstructs.write( decoderParams.reconstructedDataPath_, frameNumber, decoderParams.reconstructedDataAscii_ );
+  } else {
+    frameNumber += reconstructs.size();
+  }
+  return true;
+}
+
+// Streaming decoder: the bitstream of the next group of frames is parsed while the current one is reconstructed,
+// and the decoded frames are handed one by one to a writer thread through a queue holding at most
+// maxResidentFrames frames, so the memory does not grow with the number of groups of frames.
+static int decompressVideoStreaming( const PCCDecoderParameters& decoderParams,
+                                     const PCCMetricsParameters& metricsParams,
+                                     StopwatchUserTime&          clock,
+                                     SampleStreamVpccUnit&       ssvu,
+                                     PCCBitstreamStat&           bitstreamStat,
+                                     PCCMetrics&                 metrics,
+                                     PCCChecksum&                checksum ) {
+  typedef std::shared_ptr<PCCContext>       PCCContextPtr;
+  typedef std::shared_ptr<PCCGroupOfFrames> PCCGroupOfFramesPtr;
+  PCCDecoder parser, decoder;
+  parser.setParameters( decoderParams );
+  decoder.setParameters( decoderParams );
+  size_t                                             frameNumber = decoderParams.startFrameNumber_;
+  std::atomic<int>                                   ret( 0 );
+  std::atomic<bool>                                  writeFailed( false );
+  tbb::concurrent_bounded_queue<PCCGroupOfFramesPtr> decodedFrames;
+  decodedFrames.set_capacity( ( std::max )( size_t( 1 ), decoderParams.maxResidentFrames_ ) );
+  std::thread writer( [&] {
+    PCCGroupOfFramesPtr frame;
+    for ( decodedFrames.pop( frame ); frame; decodedFrames.pop( frame ) ) {
+      if ( !writeFailed && !checkAndWrite( decoderParams, metricsParams, metrics, checksum, *frame, frameNumber ) ) {
+        writeFailed = true;
+      }
+    }
+  } );
+  clock.start();
+  tbb::parallel_pipeline(
+      2,
+      tbb::make_filter<void, PCCContextPtr>(
+          tbb::filter::serial_in_order,
+          [&]( tbb::flow_control& fc ) -> PCCContextPtr {
+            auto context = std::make_shared<PCCContext>();
+            context->setBitstreamStat( bitstreamStat );
+            if ( ret != 0 || writeFailed || ssvu.getVpccUnitCount() == 0 || !parser.parse( ssvu, *context ) ) {
+              fc.stop();
+              return nullptr;
+            }
+            return context;
+          } ) &
+          tbb::make_filter<PCCContextPtr, void>(
+              tbb::filter::serial_in_order,
+              [&]( PCCContextPtr context ) {
+                PCCGroupOfFrames reconstructs;
+                if ( ret != 0 || ( ret = decoder.decode( *context, reconstructs ) ) != 0 ) { return; }
+                context.reset();
+                for ( auto& reconstruct : reconstructs ) {
+                  auto frame = std::make_shared<PCCGroupOfFrames>();
+                  frame->resize( 1 );
+                  ( *frame )[0] = std::move( reconstruct );
+                  decodedFrames.push( frame );
+                }
+              } ) );
+  clock.stop();
+  decodedFrames.push( nullptr );
+  writer.join();
+  if ( ret ) { return ret; }
+  return writeFailed ? -1 : 0;
+}
+
 int decompressVideo( const PCCDecoderParameters& decoderParams,
                      const PCCMetricsParameters& metricsParams,
                      StopwatchUserTime&          clock ) {
@@ -306,39 +436,24 @@ int decompressVideo( const PCCDecoderParameters& decoderParams,
   size_t               headerSize = bitstreamDecoder.read( bitstream, ssvu );
   bitstreamStat.incrHeader( headerSize );
 
-  bool    bMoreData = true;
-  int32_t index     = 0;
-  while ( bMoreData ) {
-    PCCGroupOfFrames reconstructs;
-    PCCContext       context;
-    context.setBitstreamStat( bitstreamStat );
-    clock.start();
-    int ret = decoder.decode( ssvu, context, reconstructs );
-    clock.stop();
+  if ( decoderParams.streaming_ ) {
+    int ret = decompressVideoStreaming( decoderParams, metricsParams, clock, ssvu, bitstreamStat, metrics, checksum );
     if ( ret ) { return ret; }
-    if ( metricsParams.computeChecksum_ ) { checksum.computeDecoded( reconstructs ); }
-    if ( metricsParams.computeMetrics_ ) {
-      PCCGroupOfFrames sources, normals;
-      if ( !sources.load( metricsParams.uncompressedDataPath_, frameNumber, frameNumber + reconstructs.size(),
-                          decoderParams.colorTransform_ ) ) {
+  } else {
+    bool bMoreData = true;
+    while ( bMoreData ) {
+      PCCGroupOfFrames reconstructs;
+      PCCContext       context;
+      context.setBitstreamStat( bitstreamStat );
+      clock.start();
+      int ret = decoder.decode( ssvu, context, reconstructs );
+      clock.stop();
+      if ( ret ) { return ret; }
+      if ( !checkAndWrite( decoderParams, metricsParams, metrics, checksum, reconstructs, frameNumber ) ) {
         return -1;
       }
-      if ( metricsParams.normalDataPath_ != "" ) {
-        if ( !normals.load( metricsParams.normalDataPath_, frameNumber, frameNumber + reconstructs.size(),
-                            COLOR_TRANSFORM_NONE, true ) ) {
-          return -1;
-        }
-      }
-      metrics.compute( sources, reconstructs, normals );
-      sources.clear();
-      normals.clear();
-    }
-    if ( !decoderParams.reconstructedDataPath_.empty() ) {
-      reconstructs.write( decoderParams.reconstructedDataPath_, frameNumber );
-    } else {
-      frameNumber += reconstructs.size();
+      bMoreData = ( ssvu.getVpccUnitCount() > 0 );
     }
-    bMoreData = ( ssvu.getVpccUnitCount() > 0 );
   }
   bitstreamStat.trace();
   if ( metricsParams.computeMetrics_ ) { metrics.display(); }
@@ -38,6 +38,7 @@
 #include "PCCCommon.h"
 #include "PCCChrono.h"
 #include "PCCMemory.h"
+#include "PCCExecutionContext.h"
 #include "PCCDecoder.h"
 #include "PCCMetrics.h"
 #include "PCCChecksum.h"
@@ -50,6 +51,8 @@
 #include "PCCMetricsParameters.h"
 #include <program_options_lite.h>
 #include <tbb/tbb.h>
+#include <atomic>
+#include <thread>
 
 bool parseParameters( int                        argc,
                       char*                      argv[],
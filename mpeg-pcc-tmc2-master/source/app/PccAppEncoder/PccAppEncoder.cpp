@@ -42,7 +42,9 @@ int main( int argc, char* argv[] ) {
   PCCEncoderParameters encoderParams;
   PCCMetricsParameters metricsParams;
   if ( !parseParameters( argc, argv, encoderParams, metricsParams ) ) { return -1; }
-  if ( encoderParams.nbThread_ > 0 ) { tbb::task_scheduler_init init( (int)encoderParams.nbThread_ ); }
+  PCCExecutionContext executionContext( encoderParams.nbThread_, encoderParams.pinThreads_ );
+  encoderParams.nbThread_ = executionContext.getNbThread();
+  metricsParams.nbThread_ = executionContext.getNbThread();
 
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clockWall;
@@ -80,6 +82,7 @@ static std::istream& readUInt( std::istream& in, T& val ) {
 
 namespace pcc {
 static std::istream& operator>>( std::istream& in, PCCColorTransform& val ) { return readUInt( in, val ); }
+static std::istream& operator>>( std::istream& in, PCCVideoCodecBackendType& val ) { return readUInt( in, val ); }
 }  // namespace pcc
 
 //---------------------------------------------------------------------------
@@ -130,6 +133,11 @@ bool parseParameters( int                   argc,
        encoderParams.reconstructedDataPath_,
        "Output decoded pointcloud. Multi-frame sequences may be represented by %04i" )
 
+    ( "reconstructedDataAscii",
+       encoderParams.reconstructedDataAscii_,
+       encoderParams.reconstructedDataAscii_,
+       "Write the decoded pointcloud as ASCII PLY instead of binary little endian PLY" )
+
     // sequence configuration
     ( "startFrameNumber",
        encoderParams.startFrameNumber_,
@@ -275,6 +283,19 @@ bool parseParameters( int                   argc,
       encoderParams.occupancyTargetPrecision_,
       encoderParams.occupancyTargetPrecision_,
       "Occupancy map target precision" )
+    ( "occupancyModelTileSize",
+      encoderParams.occupancyModelTileSize_,
+      encoderParams.occupancyModelTileSize_,
+      "Side of the tiles the occupancy map model is run on (0: whole frames)" )
+    ( "occupancyModelTileHalo",
+      encoderParams.occupancyModelTileHalo_,
+      encoderParams.occupancyModelTileHalo_,
+      "Margin around the occupancy map model tiles, at least the receptive field radius of the model" )
+    ( "occupancyModelTileStride",
+      encoderParams.occupancyModelTileStride_,
+      encoderParams.occupancyModelTileStride_,
+      "Total stride of the occupancy map model (product of its pooling or strided convolution factors), the tile "
+      "windows are aligned on it" )
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
       ( "modelName",
@@ -506,6 +527,13 @@ bool parseParameters( int                   argc,
       "Threshold of color distance to exclude outliers from the NN set" )
 
     // video encoding
+    ( "videoCodecBackend",
+      encoderParams.videoCodecBackend_,
+      encoderParams.videoCodecBackend_,
+      "Video codec used for the occupancy, geometry and texture videos:\n"
+      "  0: external HM encoder (videoEncoderPath)\n"
+      "  1: in-memory lossless reference codec" )
+
     ( "videoEncoderPath",
       encoderParams.videoEncoderPath_,
       encoderParams.videoEncoderPath_,
@@ -598,7 +626,27 @@ bool parseParameters( int                   argc,
     ( "nbThread",
       encoderParams.nbThread_,
       encoderParams.nbThread_,
-      "Number of thread used for parallel processing" )
+      "Number of thread used for parallel processing (0: all cores)" )
+
+    ( "pinThreads",
+      encoderParams.pinThreads_,
+      encoderParams.pinThreads_,
+      "Pin the processing threads to the cores of the process affinity mask" )
+
+    ( "gofPipelineDepth",
+      encoderParams.gofPipelineDepth_,
+      encoderParams.gofPipelineDepth_,
+      "Number of groups of frames loaded, encoded and written concurrently (1: serial)" )
+
+    ( "prefetchFrames",
+      encoderParams.prefetchFrames_,
+      encoderParams.prefetchFrames_,
+      "Load the next group of frames in the background while the current one is encoded" )
+
+    ( "prefetchMemoryLimit",
+      encoderParams.prefetchMemoryLimit_,
+      encoderParams.prefetchMemoryLimit_,
+      "Memory ceiling in MB of the loaded and prefetched frames above which no prefetch is done (0: no limit)" )
 
     ( "keepIntermediateFiles",
       encoderParams.keepIntermediateFiles_,
@@ -952,75 +1000,132 @@ bool parseParameters( int                   argc,
   return true;
 }
 
+// State of one group of frames travelling through the encoding pipeline.
+struct PCCEncodedGroupOfFrames {
+  size_t               contextIndex_;
+  size_t               startFrameNumber_;
+  size_t               endFrameNumber_;
+  int                  ret_;
+  PCCContext           context_;
+  PCCBitstreamStat     bitstreamStat_;
+  SampleStreamVpccUnit ssvu_;
+  PCCGroupOfFrames     sources_;
+  PCCGroupOfFrames     reconstructs_;
+};
+
 int compressVideo( const PCCEncoderParameters& encoderParams,
                    const PCCMetricsParameters& metricsParams,
                    StopwatchUserTime&          clock ) {
   const size_t startFrameNumber0        = encoderParams.startFrameNumber_;
   const size_t endFrameNumber0          = encoderParams.startFrameNumber_ + encoderParams.frameCount_;
   const size_t groupOfFramesSize0       = ( std::max )( size_t( 1 ), encoderParams.groupOfFramesSize_ );
+  const size_t gofPipelineDepth         = ( std::max )( size_t( 1 ), encoderParams.gofPipelineDepth_ );
+  const bool   pipelined                = gofPipelineDepth > 1;
   size_t       startFrameNumber         = startFrameNumber0;
   size_t       reconstructedFrameNumber = encoderParams.startFrameNumber_;
 
-  std::unique_ptr<uint8_t> buffer;
-  size_t                   contextIndex = 0;
-  PCCEncoder               encoder;
-  encoder.setParameters( encoderParams );
-  std::vector<std::vector<uint8_t>> reconstructedChecksums, sourceReorderChecksums, reconstructedReorderChecksums;
+  size_t                            contextIndex = 0;
+  int                               loadRet      = 0;
+  std::atomic<int>                  encodeRet( 0 );
   PCCMetrics                        metrics;
   PCCChecksum                       checksum;
   metrics.setParameters( metricsParams );
   checksum.setParameters( metricsParams );
+#if OCCUPANCY_MAP_MODEL
+  auto occupancyModel = std::make_shared<PCCOccupancyModel>();
+#endif
 
-  PCCBitstreamStat     bitstreamStat;
-  SampleStreamVpccUnit ssvu;
-  // Place to get/set default values for gof metadata enabled flags (in sequence level).
-  while ( startFrameNumber < endFrameNumber0 ) {
-    const size_t endFrameNumber = min( startFrameNumber + groupOfFramesSize0, endFrameNumber0 );
-    PCCContext   context;
-    context.setBitstreamStat( bitstreamStat );
-    context.addVpccParameterSet( contextIndex );
-    // context.getSps( contextIndex ).setVpccParameterSetId( contextIndex );
-
-    PCCGroupOfFrames sources, reconstructs;
-    if ( !sources.load( encoderParams.uncompressedDataPath_, startFrameNumber, endFrameNumber,
-                        encoderParams.colorTransform_ ) ) {
-      return -1;
-    }
-    clock.start();
-
-    std::cout << "Compressing group of frames " << contextIndex << ": " << startFrameNumber << " -> " << endFrameNumber
-              << "..." << std::endl;
-    int ret = encoder.encode( sources, context, ssvu, reconstructs );
-    clock.stop();
-
-    PCCGroupOfFrames normals;
-    bool             bRunMetric = true;
-    if ( metricsParams.computeMetrics_ ) {
-      if ( metricsParams.normalDataPath_ != "" ) {
-        if ( !normals.load( metricsParams.normalDataPath_, startFrameNumber, endFrameNumber, COLOR_TRANSFORM_NONE,
-                            true ) ) {
-          bRunMetric = false;
-        }
-      }
-      if ( bRunMetric ) metrics.compute( sources, reconstructs, normals );
-    }
-    if ( metricsParams.computeChecksum_ ) {
-      if ( encoderParams.losslessGeo_ ) {
-        checksum.computeSource( sources );
-        checksum.computeReordered( reconstructs );
-      }
-      checksum.computeReconstructed( reconstructs );
-    }
-    if ( ret ) { return ret; }
-    if ( !encoderParams.reconstructedDataPath_.empty() ) {
-      reconstructs.write( encoderParams.reconstructedDataPath_, reconstructedFrameNumber );
-    }
-    sources.clear();
-    reconstructs.clear();
-    normals.clear();
-    startFrameNumber = endFrameNumber;
-    contextIndex++;
-  }
+  PCCBitstreamStat       bitstreamStat;
+  SampleStreamVpccUnit   ssvu;
+  PCCGroupOfFramesLoader sourceLoader( encoderParams.uncompressedDataPath_, encoderParams.colorTransform_, false,
+                                       encoderParams.nbThread_, encoderParams.prefetchMemoryLimit_ << 20 );
+  PCCGroupOfFramesLoader normalLoader( metricsParams.normalDataPath_, COLOR_TRANSFORM_NONE, true,
+                                       encoderParams.nbThread_, encoderParams.prefetchMemoryLimit_ << 20 );
+
+  // Each group of frames has its own context: the groups are loaded, encoded and checked / written in a pipeline
+  // with at most gofPipelineDepth groups in flight. The first and last stages are serial and in order, so the
+  // V-PCC units, the statistics, the metrics and the reconstructed frames are produced as by a serial loop.
+  typedef std::shared_ptr<PCCEncodedGroupOfFrames> PCCEncodedGroupOfFramesPtr;
+  if ( pipelined ) { clock.start(); }
+  tbb::parallel_pipeline(
+      gofPipelineDepth,
+      tbb::make_filter<void, PCCEncodedGroupOfFramesPtr>(
+          tbb::filter::serial_in_order,
+          [&]( tbb::flow_control& fc ) -> PCCEncodedGroupOfFramesPtr {
+            if ( encodeRet != 0 || startFrameNumber >= endFrameNumber0 ) {
+              fc.stop();
+              return nullptr;
+            }
+            auto gof               = std::make_shared<PCCEncodedGroupOfFrames>();
+            gof->contextIndex_     = contextIndex++;
+            gof->startFrameNumber_ = startFrameNumber;
+            gof->endFrameNumber_   = min( startFrameNumber + groupOfFramesSize0, endFrameNumber0 );
+            gof->ret_              = 0;
+            startFrameNumber       = gof->endFrameNumber_;
+            gof->context_.setBitstreamStat( gof->bitstreamStat_ );
+            gof->context_.addVpccParameterSet( gof->contextIndex_ );
+            if ( !sourceLoader.load( gof->sources_, gof->startFrameNumber_, gof->endFrameNumber_ ) ) {
+              loadRet = -1;
+              fc.stop();
+              return nullptr;
+            }
+            if ( encoderParams.prefetchFrames_ ) {
+              sourceLoader.prefetch( startFrameNumber, min( startFrameNumber + groupOfFramesSize0, endFrameNumber0 ) );
+            }
+            return gof;
+          } ) &
+          tbb::make_filter<PCCEncodedGroupOfFramesPtr, PCCEncodedGroupOfFramesPtr>(
+              tbb::filter::parallel,
+              [&]( PCCEncodedGroupOfFramesPtr gof ) {
+                PCCEncoder encoder;
+                encoder.setParameters( encoderParams );
+#if OCCUPANCY_MAP_MODEL
+                encoder.setOccupancyModel( occupancyModel );
+#endif
+                std::cout << "Compressing group of frames " << gof->contextIndex_ << ": " << gof->startFrameNumber_
+                          << " -> " << gof->endFrameNumber_ << "..." << std::endl;
+                if ( !pipelined ) { clock.start(); }
+                gof->ret_ = encoder.encode( gof->sources_, gof->context_, gof->ssvu_, gof->reconstructs_ );
+                if ( !pipelined ) { clock.stop(); }
+                return gof;
+              } ) &
+          tbb::make_filter<PCCEncodedGroupOfFramesPtr, void>(
+              tbb::filter::serial_in_order, [&]( PCCEncodedGroupOfFramesPtr gof ) {
+                if ( encodeRet != 0 ) { return; }
+                PCCGroupOfFrames normals;
+                bool             bRunMetric = true;
+                if ( metricsParams.computeMetrics_ ) {
+                  if ( metricsParams.normalDataPath_ != "" ) {
+                    if ( !normalLoader.load( normals, gof->startFrameNumber_, gof->endFrameNumber_ ) ) {
+                      bRunMetric = false;
+                    } else if ( encoderParams.prefetchFrames_ ) {
+                      normalLoader.prefetch( gof->endFrameNumber_,
+                                             min( gof->endFrameNumber_ + groupOfFramesSize0, endFrameNumber0 ) );
+                    }
+                  }
+                  if ( bRunMetric ) metrics.compute( gof->sources_, gof->reconstructs_, normals );
+                }
+                if ( metricsParams.computeChecksum_ ) {
+                  if ( encoderParams.losslessGeo_ ) {
+                    checksum.computeSource( gof->sources_ );
+                    checksum.computeReordered( gof->reconstructs_ );
+                  }
+                  checksum.computeReconstructed( gof->reconstructs_ );
+                }
+                if ( gof->ret_ ) {
+                  encodeRet = gof->ret_;
+                  return;
+                }
+                bitstreamStat.appendGOFs( gof->bitstreamStat_ );
+                ssvu.appendVpccUnits( gof->ssvu_ );
+                if ( !encoderParams.reconstructedDataPath_.empty() ) {
+                  gof->reconstructs_.write( encoderParams.reconstructedDataPath_, reconstructedFrameNumber,
+                                            encoderParams.reconstructedDataAscii_ );
+                }
+              } ) );
+  if ( pipelined ) { clock.stop(); }
+  if ( encodeRet != 0 ) { return encodeRet; }
+  if ( loadRet != 0 ) { return loadRet; }
 
   PCCBitstream bitstream;
 #ifdef BITSTREAM_TRACE
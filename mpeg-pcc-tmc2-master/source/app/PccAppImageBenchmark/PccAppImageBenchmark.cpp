@@ -0,0 +1,411 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppImageBenchmark.h"
+
+using namespace std;
+using namespace pcc;
+
+int main( int argc, char* argv[] ) {
+  std::cout << "PccAppImageBenchmark v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl << std::endl;
+
+  PCCImageBenchmarkParameters params;
+  if ( !parseParameters( argc, argv, params ) ) { return -1; }
+  return runBenchmark( params );
+}
+
+//---------------------------------------------------------------------------
+// :: Command line / config parsing
+
+bool parseParameters( int argc, char* argv[], PCCImageBenchmarkParameters& params ) {
+  namespace po   = df::program_options_lite;
+  bool print_help = false;
+
+  // clang-format off
+  po::Options opts;
+  opts.addOptions()
+    ( "help", print_help, false, "This help text" )
+    ( "width", params.width_, params.width_, "Width of the benchmarked images" )
+    ( "height", params.height_, params.height_, "Height of the benchmarked images" )
+    ( "frameCount", params.frameCount_, params.frameCount_, "Number of images converted by each measure" )
+    ( "bitDepth", params.bitDepth_, params.bitDepth_, "Bit depth of the images: 8, 10 or 0 (both)" )
+    ( "downsamplingFilter",
+      params.downsamplingFilter_,
+      params.downsamplingFilter_,
+      "Chroma downsampling filter [0-22] of the conversion to 4:2:0" )
+    ( "upsamplingFilter",
+      params.upsamplingFilter_,
+      params.upsamplingFilter_,
+      "Chroma upsampling filter [0-7] of the conversion from 4:2:0" );
+  // clang-format on
+  po::setDefaults( opts );
+  po::ErrorReporter        err;
+  const list<const char*>& argv_unhandled = po::scanArgv( opts, argc, (const char**)argv, err );
+  for ( const auto arg : argv_unhandled ) { err.warn() << "Unhandled argument ignored: " << arg << "\n"; }
+  if ( print_help ) {
+    po::doHelp( std::cout, opts, 78 );
+    return false;
+  }
+  if ( params.width_ < 2 || params.height_ < 2 || ( params.width_ & 1 ) || ( params.height_ & 1 ) ) {
+    err.error() << "width and height must be even\n";
+  }
+  if ( params.bitDepth_ != 0 && params.bitDepth_ != 8 && params.bitDepth_ != 10 ) {
+    err.error() << "bitDepth must be 8, 10 or 0\n";
+  }
+  if ( params.downsamplingFilter_ > 22 ) { err.error() << "downsamplingFilter must be in [0-22]\n"; }
+  if ( params.upsamplingFilter_ > 7 ) { err.error() << "upsamplingFilter must be in [0-7]\n"; }
+  if ( err.is_errored ) return false;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+// :: Reference implementation: full frame planes and tap by tap filters
+
+namespace reference {
+
+static int clamp( int v, int a, int b ) { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
+
+static float downsamplingHorizontal( const ChromaSampler::Filter444to420& filter,
+                                     const std::vector<float>&            im,
+                                     const int                            width,
+                                     const int                            i0,
+                                     const int                            j0 ) {
+  const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.horizontal_.shift_ ) ) );
+  const float offset   = 0.00000000;
+  const int   position = int( filter.horizontal_.data_.size() - 1 ) >> 1;
+  double      value    = 0;
+  for ( int j = 0; j < (int)filter.horizontal_.data_.size(); j++ ) {
+    value +=
+        (double)filter.horizontal_.data_[j] * (double)( im[i0 * width + clamp( j0 + j - position, 0, width - 1 )] );
+  }
+  return (float)( ( value + (double)offset ) * (double)scale );
+}
+
+static float downsamplingVertical( const ChromaSampler::Filter444to420& filter,
+                                   const std::vector<float>&            im,
+                                   const int                            width,
+                                   const int                            height,
+                                   const int                            i0,
+                                   const int                            j0 ) {
+  const float offset   = 0;
+  const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.vertical_.shift_ ) ) );
+  const int   position = int( filter.vertical_.data_.size() - 1 ) >> 1;
+  double      value    = 0;
+  for ( int i = 0; i < (int)filter.vertical_.data_.size(); i++ ) {
+    value +=
+        (double)filter.vertical_.data_[i] * (double)( im[clamp( i0 + i - position, 0, height - 1 ) * width + j0] );
+  }
+  return (float)( ( value + (double)offset ) * (double)scale );
+}
+
+static float upsamplingVertical( const ChromaSampler::Filter& filter,
+                                 const std::vector<float>&    im,
+                                 const int                    width,
+                                 const int                    height,
+                                 const int                    i0,
+                                 const int                    j0 ) {
+  const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.shift_ ) ) );
+  const float offset   = 0.00000000;
+  const int   position = int( filter.data_.size() + 1 ) >> 1;
+  float       value    = 0;
+  for ( int i = 0; i < (int)filter.data_.size(); i++ ) {
+    value += filter.data_[i] * (float)( im[clamp( i0 + i - position, 0, height - 1 ) * width + j0] );
+  }
+  return (float)( ( value + (float)offset ) * (float)scale );
+}
+
+static float upsamplingHorizontal( const ChromaSampler::Filter& filter,
+                                   const std::vector<float>&    im,
+                                   const int                    width,
+                                   const int                    i0,
+                                   const int                    j0 ) {
+  const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.shift_ ) ) );
+  const float offset   = 0.00000000;
+  const int   position = int( filter.data_.size() + 1 ) >> 1;
+  float       value    = 0;
+  for ( int j = 0; j < (int)filter.data_.size(); j++ ) {
+    value += filter.data_[j] * (float)( im[i0 * width + clamp( j0 + j - position, 0, width - 1 )] );
+  }
+  return (float)( ( value + (float)offset ) * (float)scale );
+}
+
+static void downsampling( const std::vector<float>& chromaIn,
+                          std::vector<float>&       chromaOut,
+                          const int                 widthIn,
+                          const int                 heightIn,
+                          const size_t              filter ) {
+  const auto&        filter444to420 = ChromaSampler::getFilter444to420( filter );
+  int                widthOut       = widthIn / 2;
+  int                heightOut      = heightIn / 2;
+  std::vector<float> temp( widthOut * heightIn );
+  chromaOut.resize( widthOut * heightOut );
+  for ( int i = 0; i < heightIn; i++ ) {
+    for ( int j = 0; j < widthOut; j++ ) {
+      temp[i * widthOut + j] = downsamplingHorizontal( filter444to420, chromaIn, widthIn, i, j * 2 );
+    }
+  }
+  for ( int i = 0; i < heightOut; i++ ) {
+    for ( int j = 0; j < widthOut; j++ ) {
+      chromaOut[i * widthOut + j] = downsamplingVertical( filter444to420, temp, widthOut, heightIn, 2 * i, j );
+    }
+  }
+}
+
+static void upsampling( const std::vector<float>& chromaIn,
+                        std::vector<float>&       chromaOut,
+                        const int                 widthIn,
+                        const int                 heightIn,
+                        const size_t              filter ) {
+  const auto&        filter420to444 = ChromaSampler::getFilter420to444( filter );
+  int                widthOut = widthIn * 2, heightOut = heightIn * 2;
+  std::vector<float> temp( widthIn * heightOut );
+  chromaOut.resize( widthOut * heightOut );
+  for ( int i = 0; i < heightIn; i++ ) {
+    for ( int j = 0; j < widthIn; j++ ) {
+      temp[( 2 * i ) * widthIn + j] =
+          upsamplingVertical( filter420to444.vertical0_, chromaIn, widthIn, heightIn, i + 0, j );
+      temp[( 2 * i + 1 ) * widthIn + j] =
+          upsamplingVertical( filter420to444.vertical1_, chromaIn, widthIn, heightIn, i + 1, j );
+    }
+  }
+  for ( int i = 0; i < heightOut; i++ ) {
+    for ( int j = 0; j < widthIn; j++ ) {
+      chromaOut[i * widthOut + j * 2] = upsamplingHorizontal( filter420to444.horizontal0_, temp, widthIn, i, j + 0 );
+      chromaOut[i * widthOut + j * 2 + 1] =
+          upsamplingHorizontal( filter420to444.horizontal1_, temp, widthIn, i, j + 1 );
+    }
+  }
+}
+
+template <typename T>
+static void write420( const PCCImage<T, 3>& image,
+                      std::ostream&         outfile,
+                      const size_t          nbyte,
+                      const bool            convert,
+                      const size_t          filter ) {
+  const size_t width = image.getWidth(), height = image.getHeight(), count = width * height;
+  if ( convert ) {
+    const float        maxValue = nbyte == 1 ? 255.f : 1023.f;
+    std::vector<float> RGB444[3], YUV444[3], YUV420[3];
+    for ( size_t c = 0; c < 3; c++ ) {
+      RGB444[c].resize( count );
+      YUV444[c].resize( count );
+      for ( size_t i = 0; i < count; i++ ) { RGB444[c][i] = (float)image.getChannel( c )[i] / maxValue; }
+    }
+    for ( size_t i = 0; i < count; i++ ) {
+      const float R = RGB444[0][i], G = RGB444[1][i], B = RGB444[2][i];
+      YUV444[0][i] =
+          (float)( (double)( std::min )( ( std::max )( 0.212600 * R + 0.715200 * G + 0.072200 * B, 0.0 ), 1.0 ) );
+      YUV444[1][i] =
+          (float)( (double)( std::min )( ( std::max )( -0.114572 * R - 0.385428 * G + 0.500000 * B, -0.5 ), 0.5 ) );
+      YUV444[2][i] =
+          (float)( (double)( std::min )( ( std::max )( 0.500000 * R - 0.454153 * G - 0.045847 * B, -0.5 ), 0.5 ) );
+    }
+    YUV420[0] = YUV444[0];
+    downsampling( YUV444[1], YUV420[1], (int)width, (int)height, filter );
+    downsampling( YUV444[2], YUV420[2], (int)width, (int)height, filter );
+    for ( size_t c = 0; c < 3; c++ ) {
+      const double   offset = c > 0 ? ( nbyte == 1 ? 128. : 512. ) : 0.;
+      std::vector<T> YUV420T( YUV420[c].size() );
+      for ( size_t i = 0; i < YUV420T.size(); i++ ) {
+        YUV420T[i] = static_cast<T>( ( std::min )(
+            ( std::max )( std::round( (float)( maxValue * (double)YUV420[c][i] + offset ) ), 0.f ), maxValue ) );
+      }
+      outfile.write( (const char*)YUV420T.data(), YUV420T.size() * sizeof( T ) );
+    }
+  } else {
+    outfile.write( (const char*)image.getChannel( 0 ).data(), count * sizeof( T ) );
+    std::vector<T> chroma( width / 2 );
+    for ( size_t c = 1; c < 3; ++c ) {
+      const auto& channel = image.getChannel( c );
+      for ( size_t y = 0; y < height; y += 2 ) {
+        const T* const buffer1 = channel.data() + y * width;
+        const T* const buffer2 = buffer1 + width;
+        for ( size_t x = 0; x < width; x += 2 ) {
+          const uint64_t sum = buffer1[x] + buffer1[x + 1] + buffer2[x] + buffer2[x + 1];
+          chroma[x / 2]      = T( ( sum + 2 ) / 4 );
+        }
+        outfile.write( (const char*)chroma.data(), chroma.size() * sizeof( T ) );
+      }
+    }
+  }
+}
+
+template <typename T>
+static void read420( PCCImage<T, 3>& image,
+                     std::istream&   infile,
+                     const size_t    width,
+                     const size_t    height,
+                     const size_t    nbyte,
+                     const bool      convert,
+                     const size_t    filter ) {
+  const size_t count = width * height, width2 = width / 2, height2 = height / 2;
+  image.resize( width, height );
+  if ( convert ) {
+    const float        maxValue = nbyte == 1 ? 255.f : 1023.f;
+    std::vector<float> YUV420[3], YUV444[3];
+    for ( size_t c = 0; c < 3; c++ ) {
+      std::vector<T> YUV420T( c == 0 ? count : width2 * height2 );
+      infile.read( (char*)YUV420T.data(), YUV420T.size() * sizeof( T ) );
+      const float  minV   = c > 0 ? -0.5f : 0.f;
+      const float  maxV   = c > 0 ? 0.5f : 1.f;
+      const int    offset = c > 0 ? ( nbyte == 1 ? 128 : 512 ) : 0;
+      const double weight = 1.0 / (double)maxValue;
+      YUV420[c].resize( YUV420T.size() );
+      for ( size_t i = 0; i < YUV420T.size(); i++ ) {
+        YUV420[c][i] = ( std::min )( ( std::max )( (float)( weight * (double)( YUV420T[i] - offset ) ), minV ), maxV );
+      }
+    }
+    YUV444[0] = YUV420[0];
+    upsampling( YUV420[1], YUV444[1], (int)width2, (int)height2, filter );
+    upsampling( YUV420[2], YUV444[2], (int)width2, (int)height2, filter );
+    for ( size_t i = 0; i < count; i++ ) {
+      const float Y = YUV444[0][i], U = YUV444[1][i], V = YUV444[2][i];
+      const float R = (float)( (double)( std::min )( ( std::max )( Y + 1.57480 * V, 0.0 ), 1.0 ) );
+      const float G = (float)( (double)( std::min )( ( std::max )( Y - 0.18733 * U - 0.46813 * V, 0.0 ), 1.0 ) );
+      const float B = (float)( (double)( std::min )( ( std::max )( Y + 1.85563 * U, 0.0 ), 1.0 ) );
+      image.getValue( 0, i % width, i / width ) = static_cast<T>( std::round( maxValue * R ) );
+      image.getValue( 1, i % width, i / width ) = static_cast<T>( std::round( maxValue * G ) );
+      image.getValue( 2, i % width, i / width ) = static_cast<T>( std::round( maxValue * B ) );
+    }
+  } else {
+    infile.read( (char*)&image.getValue( 0, 0, 0 ), count * sizeof( T ) );
+    std::vector<T> chroma( width2 );
+    for ( size_t c = 1; c < 3; ++c ) {
+      for ( size_t y = 0; y < height; y += 2 ) {
+        infile.read( (char*)chroma.data(), width2 * sizeof( T ) );
+        T* const buffer1 = &image.getValue( c, 0, y );
+        for ( size_t x2 = 0; x2 < width2; ++x2 ) { buffer1[2 * x2] = buffer1[2 * x2 + 1] = chroma[x2]; }
+        memcpy( (char*)( buffer1 + width ), (char*)buffer1, width * sizeof( T ) );
+      }
+    }
+  }
+}
+
+}  // namespace reference
+
+//---------------------------------------------------------------------------
+// :: Benchmark
+
+template <typename T>
+static void generate( PCCImage<T, 3>& image, const size_t width, const size_t height, const int maxValue, int seed ) {
+  // smooth gradients with noise and a few saturated samples, so that every clipping path is exercised.
+  image.resize( width, height );
+  uint32_t state = 2463534242u + seed;
+  for ( size_t c = 0; c < 3; c++ ) {
+    for ( size_t v = 0; v < height; v++ ) {
+      for ( size_t u = 0; u < width; u++ ) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int value = int( ( u * ( c + 1 ) + v * ( 3 - c ) ) * maxValue / ( 2 * ( width + height ) ) );
+        value += int( state % 33 ) - 16;
+        if ( state % 97 == 0 ) { value = ( state & 128 ) ? 0 : maxValue; }
+        image.setValue( c, u, v, T( ( std::min )( ( std::max )( value, 0 ), maxValue ) ) );
+      }
+    }
+  }
+}
+
+template <typename F>
+static double measure( const size_t count, F function ) {
+  pcc::chrono::Stopwatch<std::chrono::steady_clock> clock;
+  clock.start();
+  for ( size_t i = 0; i < count; i++ ) { function( i ); }
+  clock.stop();
+  return std::chrono::duration_cast<std::chrono::microseconds>( clock.count() ).count() / 1000.0;
+}
+
+static void report( const size_t bitDepth, const std::string& name, double reference, double current, bool exact ) {
+  std::cout << std::setw( 2 ) << bitDepth << "-bit " << std::left << std::setw( 18 ) << name << std::right
+            << " reference " << std::fixed << std::setprecision( 2 ) << std::setw( 10 ) << reference << " ms"
+            << " current " << std::setw( 10 ) << current << " ms"
+            << " speed-up " << std::setw( 6 ) << ( current > 0 ? reference / current : 0. ) << "x "
+            << ( exact ? "bit exact" : "MISMATCH" ) << std::endl;
+}
+
+template <typename T>
+static bool benchmark( const PCCImageBenchmarkParameters& params, const size_t bitDepth ) {
+  const size_t                width = params.width_, height = params.height_, frameCount = params.frameCount_;
+  const size_t                nbyte = bitDepth == 8 ? 1 : 2;
+  std::vector<PCCImage<T, 3>> images( frameCount ), decoded( frameCount ), expected( frameCount );
+  std::vector<std::string>    yuv( frameCount ), references( frameCount );
+  for ( size_t i = 0; i < frameCount; i++ ) { generate( images[i], width, height, ( 1 << bitDepth ) - 1, i ); }
+  bool exact = true;
+  for ( int convert = 1; convert >= 0; convert-- ) {
+    const size_t downsampling = params.downsamplingFilter_, upsampling = params.upsamplingFilter_;
+    double       reference    = measure( frameCount, [&]( size_t i ) {
+      std::stringstream stream;
+      reference::write420( images[i], stream, nbyte, convert == 1, downsampling );
+      references[i] = stream.str();
+    } );
+    double current = measure( frameCount, [&]( size_t i ) {
+      std::stringstream stream;
+      images[i].write420( stream, nbyte, convert == 1, downsampling );
+      yuv[i] = stream.str();
+    } );
+    bool same = yuv == references;
+    report( bitDepth, convert ? "write420 convert" : "write420", reference, current, same );
+    reference = measure( frameCount, [&]( size_t i ) {
+      std::stringstream stream( yuv[i] );
+      reference::read420( expected[i], stream, width, height, nbyte, convert == 1, upsampling );
+    } );
+    current = measure( frameCount, [&]( size_t i ) {
+      std::stringstream stream( yuv[i] );
+      decoded[i].read420( stream, width, height, nbyte, convert == 1, upsampling );
+    } );
+    bool sameDecoded = true;
+    for ( size_t i = 0; i < frameCount; i++ ) {
+      for ( size_t c = 0; c < 3; c++ ) { sameDecoded &= decoded[i].getChannel( c ) == expected[i].getChannel( c ); }
+    }
+    report( bitDepth, convert ? "read420 convert" : "read420", reference, current, sameDecoded );
+    exact &= same && sameDecoded;
+  }
+  return exact;
+}
+
+int runBenchmark( const PCCImageBenchmarkParameters& params ) {
+#if defined( PCC_IMAGE_AVX2 )
+  std::cout << "Image kernels: AVX2" << std::endl;
+#elif defined( PCC_IMAGE_SSE2 )
+  std::cout << "Image kernels: SSE2" << std::endl;
+#else
+  std::cout << "Image kernels: scalar" << std::endl;
+#endif
+  std::cout << params.frameCount_ << " images of " << params.width_ << "x" << params.height_
+            << ", downsampling filter " << params.downsamplingFilter_ << ", upsampling filter "
+            << params.upsamplingFilter_ << std::endl;
+  bool exact = true;
+  if ( params.bitDepth_ != 10 ) { exact &= benchmark<uint8_t>( params, 8 ); }
+  if ( params.bitDepth_ != 8 ) { exact &= benchmark<uint16_t>( params, 10 ); }
+  return exact ? 0 : -1;
+}
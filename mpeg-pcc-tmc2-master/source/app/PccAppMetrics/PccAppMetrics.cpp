@@ -41,7 +41,8 @@ int main( int argc, char* argv[] ) {
 
   PCCMetricsParameters metricsParams;
   if ( !parseParameters( argc, argv, metricsParams ) ) { return -1; }
-  if ( metricsParams.nbThread_ > 0 ) { tbb::task_scheduler_init init( (int)metricsParams.nbThread_ ); }
+  PCCExecutionContext executionContext( metricsParams.nbThread_, metricsParams.pinThreads_ );
+  metricsParams.nbThread_ = executionContext.getNbThread();
 
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clockWall;
@@ -134,7 +135,8 @@ bool parseParameters( int argc, char* argv[], PCCMetricsParameters& metricsParam
       metricsParams.neighborsProc_,
       "0(undefined), 1(average), 2(weighted average), 3(min), 4(max) neighbors with same geometric distance" )
 
-    ( "nbThread", metricsParams.nbThread_,metricsParams.nbThread_,"Number of thread used for parallel processing" )
+    ( "nbThread", metricsParams.nbThread_,metricsParams.nbThread_,"Number of thread used for parallel processing (0: all cores)" )
+    ( "pinThreads", metricsParams.pinThreads_,metricsParams.pinThreads_,"Pin the processing threads to the cores of the process affinity mask" )
 
     ( "minimumImageHeight",    ignore, ignore, "Ignore parameter" )
     ( "flagColorPreSmoothing", ignore, ignore, "Ignore parameter" )
@@ -167,20 +169,22 @@ int computeMetrics( const PCCMetricsParameters& metricsParams, StopwatchUserTime
   size_t     contextIndex = 0;
   PCCMetrics metrics;
   metrics.setParameters( metricsParams );
-  for ( size_t frameIndex = metricsParams.startFrameNumber_;
-        frameIndex < metricsParams.startFrameNumber_ + metricsParams.frameCount_; frameIndex++ ) {
+  const size_t           endFrameNumber = metricsParams.startFrameNumber_ + metricsParams.frameCount_;
+  PCCGroupOfFramesLoader sourceLoader( metricsParams.uncompressedDataPath_, COLOR_TRANSFORM_NONE );
+  PCCGroupOfFramesLoader reconstructLoader( metricsParams.reconstructedDataPath_, COLOR_TRANSFORM_NONE );
+  PCCGroupOfFramesLoader normalLoader( metricsParams.normalDataPath_, COLOR_TRANSFORM_NONE, true );
+  for ( size_t frameIndex = metricsParams.startFrameNumber_; frameIndex < endFrameNumber; frameIndex++ ) {
     PCCGroupOfFrames sources, reconstructs, normals;
-    if ( !sources.load( metricsParams.uncompressedDataPath_, frameIndex, frameIndex + 1, COLOR_TRANSFORM_NONE ) ) {
-      return -1;
-    }
-    if ( !reconstructs.load( metricsParams.reconstructedDataPath_, frameIndex, frameIndex + 1,
-                             COLOR_TRANSFORM_NONE ) ) {
-      return -1;
-    }
+    if ( !sourceLoader.load( sources, frameIndex, frameIndex + 1 ) ) { return -1; }
+    if ( !reconstructLoader.load( reconstructs, frameIndex, frameIndex + 1 ) ) { return -1; }
     if ( metricsParams.normalDataPath_ != "" ) {
-      if ( !normals.load( metricsParams.normalDataPath_, frameIndex, frameIndex + 1, COLOR_TRANSFORM_NONE, true ) ) {
-        return -1;
-      }
+      if ( !normalLoader.load( normals, frameIndex, frameIndex + 1 ) ) { return -1; }
+    }
+    // the next frame is read while the metrics of this one are computed.
+    if ( frameIndex + 1 < endFrameNumber ) {
+      sourceLoader.prefetch( frameIndex + 1, frameIndex + 2 );
+      reconstructLoader.prefetch( frameIndex + 1, frameIndex + 2 );
+      if ( metricsParams.normalDataPath_ != "" ) { normalLoader.prefetch( frameIndex + 1, frameIndex + 2 ); }
     }
     metrics.compute( sources, reconstructs, normals );
   }
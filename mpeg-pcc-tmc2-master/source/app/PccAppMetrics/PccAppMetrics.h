@@ -37,6 +37,7 @@
 
 #include "PCCCommon.h"
 #include "PCCChrono.h"
+#include "PCCExecutionContext.h"
 
 #include "PCCGroupOfFrames.h"
 #include "PCCMetrics.h"
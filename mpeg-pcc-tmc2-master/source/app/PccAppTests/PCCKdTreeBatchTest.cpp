@@ -0,0 +1,110 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+#include "PCCPointSet.h"
+#include "PCCKdTree.h"
+#include <random>
+
+using namespace pcc;
+
+// Points of a small random lattice box, dense enough to give many equidistant neighbours, with duplicated points.
+static void generateLatticeCloud( std::mt19937& generator, PCCPointSet3& pointCloud ) {
+  auto random = [&]( int count ) { return int( generator() % count ); };
+  pointCloud.clear();
+  const int    size       = 4 + random( 28 );
+  const size_t pointCount = 1 + random( 4000 );
+  for ( size_t i = 0; i < pointCount; i++ ) {
+    pointCloud.addPoint( PCCPoint3D( random( size ), random( size ), random( size ) ) );
+  }
+  for ( int i = random( 50 ); i > 0; i-- ) { pointCloud.addPoint( pointCloud[random( (int)pointCount )] ); }
+}
+
+static bool compareResults( const PCCNNBatchResult& batch,
+                            const size_t            query,
+                            PCCNNResult&            single,
+                            const std::string&      name ) {
+  bool ok = batch.count( query ) == single.count();
+  for ( size_t j = 0; ok && j < single.count(); j++ ) {
+    ok = batch.indices( query )[j] == single.indices( j ) && batch.dist( query )[j] == float( single.dist( j ) );
+  }
+  if ( !ok ) {
+    std::cout << "  " << name << ": query " << query << " differs from the single point search" << std::endl;
+  }
+  return ok;
+}
+
+// The batched search(), searchRadius() and searchRadiusSorted() of PCCKdTree must return, for each query of the
+// range, the neighbours of the single point calls in the same order, for both spatial indexes.
+bool testKdTreeBatch( const PCCTestParameters& params ) {
+  std::mt19937     generator( (uint32_t)params.seed_ );
+  PCCPointSet3     pointCloud;
+  PCCNNBatchResult batch;
+  PCCNNResult      single;
+  bool             ok = true;
+  for ( size_t i = 0; i < ( std::max )( params.iterations_ / 100, size_t( 1 ) ) && ok; i++ ) {
+    generateLatticeCloud( generator, pointCloud );
+    const size_t pointCount  = pointCloud.getPointCount();
+    const size_t start       = generator() % pointCount;
+    const size_t end         = start + 1 + generator() % ( pointCount - start );
+    const size_t num_results = 1 + generator() % 32;
+    const double radius      = double( 1 + generator() % 24 );
+    for ( const auto type : {PCC_SPATIAL_INDEX_KDTREE, PCC_SPATIAL_INDEX_VOXEL_GRID} ) {
+      const std::string name =
+          "cloud " + std::to_string( i ) + ( type == PCC_SPATIAL_INDEX_KDTREE ? " kd-tree" : " grid" );
+      PCCKdTree kdtree( pointCloud, type );
+      kdtree.search( pointCloud, start, end, num_results, batch, params.nbThread_ );
+      for ( size_t j = start; j < end && ok; j++ ) {
+        kdtree.search( pointCloud[j], num_results, single );
+        ok = compareResults( batch, j - start, single, name + " search" );
+      }
+      kdtree.searchRadius( pointCloud, start, end, num_results, radius, batch, params.nbThread_ );
+      for ( size_t j = start; j < end && ok; j++ ) {
+        kdtree.searchRadius( pointCloud[j], num_results, radius, single );
+        ok = compareResults( batch, j - start, single, name + " searchRadius" );
+      }
+      if ( type != PCC_SPATIAL_INDEX_KDTREE ) { continue; }
+      // the sorted selection only differs from the capped one by the equidistant points it keeps
+      PCCNNResult capped;
+      kdtree.searchRadiusSorted( pointCloud, start, end, num_results, radius, batch, params.nbThread_ );
+      for ( size_t j = start; j < end && ok; j++ ) {
+        kdtree.searchRadiusSorted( pointCloud[j], num_results, radius, single );
+        ok = compareResults( batch, j - start, single, name + " searchRadiusSorted" );
+        kdtree.searchRadius( pointCloud[j], num_results, radius, capped );
+        ok &= capped.count() == single.count();
+        for ( size_t k = 0; ok && k < single.count(); k++ ) { ok = capped.dist( k ) == single.dist( k ); }
+        if ( !ok ) { std::cout << "  " << name << ": sorted and capped radius searches differ" << std::endl; }
+      }
+    }
+  }
+  return ok;
+}
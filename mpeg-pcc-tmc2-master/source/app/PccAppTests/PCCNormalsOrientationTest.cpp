@@ -0,0 +1,136 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+#include "PCCPointSet.h"
+#include "PCCKdTree.h"
+#include "PCCNormalsGenerator.h"
+#include <random>
+
+using namespace pcc;
+
+// Voxelized sphere shells and tilted planes, plus isolated and duplicated points, which give several spanning trees,
+// equal edge weights and orthogonal normals.
+static void generatePointCloud( std::mt19937& generator, PCCPointSet3& pointCloud ) {
+  auto random = [&]( int count ) { return int( generator() % count ); };
+  pointCloud.clear();
+  const int shapeCount = 1 + random( 4 );
+  for ( int shape = 0; shape < shapeCount; shape++ ) {
+    const PCCVector3D center( 100 + random( 300 ), 100 + random( 300 ), 100 + random( 300 ) );
+    const int         radius = 8 + random( 40 );
+    if ( random( 2 ) ) {
+      for ( int x = -radius - 1; x <= radius + 1; x++ ) {
+        for ( int y = -radius - 1; y <= radius + 1; y++ ) {
+          for ( int z = -radius - 1; z <= radius + 1; z++ ) {
+            if ( std::fabs( std::sqrt( double( x * x + y * y + z * z ) ) - radius ) < 0.5 ) {
+              pointCloud.addPoint( PCCPoint3D( center[0] + x, center[1] + y, center[2] + z ) );
+            }
+          }
+        }
+      }
+    } else {
+      const double a = ( random( 200 ) - 100 ) / 100.0, b = ( random( 200 ) - 100 ) / 100.0;
+      for ( int x = -radius; x <= radius; x++ ) {
+        for ( int y = -radius; y <= radius; y++ ) {
+          pointCloud.addPoint( PCCPoint3D( center[0] + x, center[1] + y, std::round( center[2] + a * x + b * y ) ) );
+        }
+      }
+    }
+  }
+  const size_t pointCount = pointCloud.getPointCount();
+  for ( int i = random( 20 ); i > 0; i-- ) {
+    pointCloud.addPoint( PCCPoint3D( random( 512 ), random( 512 ), random( 512 ) ) );
+  }
+  for ( int i = random( 20 ); i > 0 && pointCount; i-- ) {
+    pointCloud.addPoint( pointCloud[random( (int)pointCount )] );
+  }
+}
+
+static bool compareOrientations( const PCCPointSet3& pointCloud,
+                                 const std::string&  name,
+                                 const size_t        neighborCount,
+                                 const double        radius,
+                                 const size_t        nbThread ) {
+  // parameters of the patch segmenter, the orientation radius aside
+  PCCNormalsGenerator3Parameters params = {PCCVector3D( 0.0 ),
+                                           ( std::numeric_limits<double>::max )(),
+                                           ( std::numeric_limits<double>::max )(),
+                                           radius,
+                                           ( std::numeric_limits<double>::max )(),
+                                           neighborCount,
+                                           neighborCount,
+                                           neighborCount,
+                                           0,
+                                           PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE,
+                                           false,
+                                           false,
+                                           false};
+  PCCKdTree            kdtree( pointCloud );
+  PCCNormalsGenerator3 serial, parallel;
+  serial.compute( pointCloud, kdtree, params, nbThread );
+  params.orientationStrategy_ = PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE_PARALLEL;
+  parallel.compute( pointCloud, kdtree, params, nbThread );
+  size_t mismatchCount = 0;
+  for ( size_t i = 0; i < pointCloud.getPointCount(); i++ ) {
+    mismatchCount += serial.getNormal( i ) != parallel.getNormal( i );
+  }
+  if ( mismatchCount ) {
+    std::cout << "  " << name << ": " << mismatchCount << " / " << pointCloud.getPointCount()
+              << " normals differ (radius " << radius << ")" << std::endl;
+  }
+  return mismatchCount == 0;
+}
+
+// The parallel spanning tree orientation must flip the same normals as the serial one, on the generated clouds and on
+// the point cloud given with --inputPointCloud (CTC content).
+bool testNormalsOrientation( const PCCTestParameters& params ) {
+  const double unbounded = ( std::numeric_limits<double>::max )();
+  bool         ok        = true;
+  if ( !params.inputPointCloud_.empty() ) {
+    PCCPointSet3 pointCloud;
+    if ( !pointCloud.read( params.inputPointCloud_ ) ) {
+      std::cout << "Error: can't read " << params.inputPointCloud_ << std::endl;
+      return false;
+    }
+    ok &= compareOrientations( pointCloud, params.inputPointCloud_, 16, unbounded, params.nbThread_ );
+    ok &= compareOrientations( pointCloud, params.inputPointCloud_, 16, 4.0, params.nbThread_ );
+  }
+  std::mt19937 generator( (uint32_t)params.seed_ );
+  PCCPointSet3 pointCloud;
+  for ( size_t i = 0; i < ( std::max )( params.iterations_ / 250, size_t( 1 ) ); i++ ) {
+    generatePointCloud( generator, pointCloud );
+    const std::string name = "generated cloud " + std::to_string( i );
+    ok &= compareOrientations( pointCloud, name, 16, unbounded, params.nbThread_ );
+    ok &= compareOrientations( pointCloud, name, 4 + generator() % 16, 1.0 + generator() % 4, params.nbThread_ );
+  }
+  return ok;
+}
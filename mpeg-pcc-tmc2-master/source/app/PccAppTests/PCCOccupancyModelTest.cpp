@@ -0,0 +1,171 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+#if OCCUPANCY_MAP_MODEL
+#include "PCCCodec.h"
+#include "PCCContext.h"
+#include "PCCFrameContext.h"
+#include <random>
+
+using namespace pcc;
+
+// Former decoder refinement: nearest neighbour upsampling of the maps, one inference per whole frame, the output
+// rounded, converted to bytes and clamped, then the pixels unoccupied before the inference cleared.
+static bool refineReference( const std::string&    modelName,
+                             const size_t          scale,
+                             PCCVideoGeometry&     geometry,
+                             PCCVideoOccupancyMap& om ) {
+  const bool useGeometry = modelName.find( "RESI" ) != std::string::npos;
+  try {
+    torch::jit::script::Module module = torch::jit::load( modelName, at::kCPU );
+    module.eval();
+    torch::NoGradGuard noGrad;
+    for ( size_t i = 0; i < om.getFrameCount(); i++ ) {
+      auto&                frame = om.getFrame( i );
+      PCCImageOccupancyMap lowResolution( frame );
+      frame.resize( lowResolution.getWidth() * scale, lowResolution.getHeight() * scale );
+      const int64_t width = frame.getWidth(), height = frame.getHeight();
+      for ( int64_t v = 0; v < height; v++ ) {
+        for ( int64_t u = 0; u < width; u++ ) {
+          frame.setValue( 0, u, v, lowResolution.getValue( 0, u / scale, v / scale ) );
+        }
+      }
+      std::vector<torch::jit::IValue> inputs;
+      if ( useGeometry ) {
+        auto& plane = geometry.getFrame( i ).getChannel( 0 );
+        inputs.push_back( torch::from_blob( plane.data(),
+                                            {1, 1, (int64_t)geometry.getHeight(), (int64_t)geometry.getWidth()},
+                                            at::kShort )
+                              .to( at::kFloat ) );
+      }
+      auto& plane = frame.getChannel( 0 );
+      inputs.push_back( torch::from_blob( plane.data(), {1, 1, height, width}, at::kByte ).to( at::kFloat ) );
+      const at::Tensor output =
+          module.forward( inputs ).toTensor().round().to( at::kByte ).clamp( 0, 1 ).contiguous();
+      const uint8_t* refined = output.data_ptr<uint8_t>();
+      for ( size_t p = 0; p < plane.size(); p++ ) { plane[p] = plane[p] != 0 ? refined[p] : 0; }
+    }
+  } catch ( const c10::Error& error ) {
+    std::cout << "Error: can't run occupancy map model " << modelName << ": " << error.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Low resolution occupancy maps made of random rectangles, as the patches of a packed frame, and random geometry.
+static void generateFrames( std::mt19937&         generator,
+                            const size_t          frameCount,
+                            const size_t          width,
+                            const size_t          height,
+                            const size_t          geometryScale,
+                            PCCVideoGeometry&     geometry,
+                            PCCVideoOccupancyMap& om ) {
+  auto random = [&]( size_t count ) { return size_t( generator() % count ); };
+  om.resize( frameCount );
+  geometry.resize( frameCount );
+  for ( size_t i = 0; i < frameCount; i++ ) {
+    auto& frame = om.getFrame( i );
+    frame.resize( width, height );
+    std::fill( frame.getChannel( 0 ).begin(), frame.getChannel( 0 ).end(), 0 );
+    for ( size_t j = random( 16 ); j > 0; j-- ) {
+      const size_t u0 = random( width ), v0 = random( height );
+      const size_t u1 = u0 + 1 + random( width - u0 ), v1 = v0 + 1 + random( height - v0 );
+      for ( size_t v = v0; v < v1; v++ ) {
+        for ( size_t u = u0; u < u1; u++ ) { frame.setValue( 0, u, v, random( 8 ) != 0 ); }
+      }
+    }
+    auto& geometryFrame = geometry.getFrame( i );
+    geometryFrame.resize( width * geometryScale, height * geometryScale );
+    for ( auto& value : geometryFrame.getChannel( 0 ) ) { value = uint16_t( random( 256 ) ); }
+  }
+}
+
+// The decoder refinement of PCCCodec, whole frame and tiled with the --occupancyModelTile* settings, must give the
+// maps of the former per frame refinement with the TorchScript model given with --occupancyModel.
+bool testOccupancyModel( const PCCTestParameters& params ) {
+  if ( params.occupancyModel_.empty() ) {
+    std::cout << "  no --occupancyModel given, skipped" << std::endl;
+    return true;
+  }
+  std::mt19937 generator( (uint32_t)params.seed_ );
+  auto         model = std::make_shared<PCCOccupancyModel>();
+  bool         ok    = true;
+  for ( size_t i = 0; i < ( std::max )( params.iterations_ / 200, size_t( 1 ) ) && ok; i++ ) {
+    const size_t precision       = size_t( 4 ) >> ( generator() % 2 );
+    const size_t targetPrecision = ( std::max )( precision >> ( generator() % 3 ), size_t( 1 ) );
+    const size_t frameCount = 1 + generator() % 3;
+    const size_t width = 16 * ( 1 + generator() % 16 ), height = 16 * ( 1 + generator() % 16 );
+    PCCContext   context;
+    context.setOccupancyPrecision( (uint8_t)precision );
+    context.setOccupancyTargetPrecision( (uint8_t)targetPrecision );
+    PCCVideoOccupancyMap lowResolution;
+    generateFrames( generator, frameCount, width, height, precision, context.getVideoGeometry(), lowResolution );
+    PCCVideoOccupancyMap reference( lowResolution );
+    if ( !refineReference( params.occupancyModel_, precision / targetPrecision, context.getVideoGeometry(),
+                           reference ) ) {
+      return false;
+    }
+    std::vector<size_t> tileSizes = {0};
+    if ( params.occupancyModelTileSize_ ) { tileSizes.push_back( params.occupancyModelTileSize_ ); }
+    for ( const auto tileSize : tileSizes ) {
+      PCCOccupancyModelParameters modelParams;
+      modelParams.modelName_  = params.occupancyModel_;
+      modelParams.nbThread_   = params.nbThread_;
+      modelParams.tileSize_   = tileSize;
+      modelParams.tileHalo_   = params.occupancyModelTileHalo_;
+      modelParams.tileStride_ = params.occupancyModelTileStride_;
+      PCCVideoOccupancyMap om( lowResolution );
+      PCCCodec             codec;
+      codec.setOccupancyModel( model );
+      codec.upsampleOccupancyMap( context, om, params.nbThread_ );
+      if ( !codec.processIngredient( modelParams, context, om ) ) { return false; }
+      size_t mismatchCount = 0;
+      for ( size_t f = 0; f < frameCount; f++ ) {
+        const auto& refined  = om.getFrame( f ).getChannel( 0 );
+        const auto& expected = reference.getFrame( f ).getChannel( 0 );
+        if ( refined.size() != expected.size() ) {
+          mismatchCount += expected.size();
+          continue;
+        }
+        for ( size_t p = 0; p < expected.size(); p++ ) { mismatchCount += refined[p] != expected[p]; }
+      }
+      if ( mismatchCount ) {
+        std::cout << "  case " << i << ": " << mismatchCount << " occupancy samples differ (tile size " << tileSize
+                  << ")" << std::endl;
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+#endif
@@ -0,0 +1,153 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+#include "PCCOccupancyModel.h"
+#include <random>
+
+using namespace pcc;
+
+// Integer image of width x height samples, zero outside.
+struct PCCTestImage {
+  size_t               width_;
+  size_t               height_;
+  std::vector<int64_t> data_;
+  PCCTestImage( const size_t width = 0, const size_t height = 0 ) :
+      width_( width ),
+      height_( height ),
+      data_( width * height, 0 ) {}
+  int64_t get( const int64_t x, const int64_t y ) const {
+    return x < 0 || y < 0 || x >= (int64_t)width_ || y >= (int64_t)height_ ? 0 : data_[y * width_ + x];
+  }
+  int64_t& at( const size_t x, const size_t y ) { return data_[y * width_ + x]; }
+};
+
+static PCCTestImage convolve( const PCCTestImage& image ) {
+  static const int64_t kernel[3][3] = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  PCCTestImage         output( image.width_, image.height_ );
+  for ( size_t y = 0; y < image.height_; y++ ) {
+    for ( size_t x = 0; x < image.width_; x++ ) {
+      for ( int64_t dy = -1; dy <= 1; dy++ ) {
+        for ( int64_t dx = -1; dx <= 1; dx++ ) {
+          output.at( x, y ) += kernel[dy + 1][dx + 1] * image.get( (int64_t)x + dx, (int64_t)y + dy );
+        }
+      }
+    }
+  }
+  return output;
+}
+
+// Reference model of total stride stride: 3x3 convolution, stride x stride sum pooling, 3x3 convolution at low
+// resolution, nearest upsampling and 3x3 convolution, all zero padded. Its receptive field radius is 2 * stride + 1
+// and it is computed on integers, so that the tiled and whole frame outputs compare exactly.
+static PCCTestImage runModel( const PCCTestImage& input, const size_t stride ) {
+  const PCCTestImage features = convolve( input );
+  PCCTestImage       pooled( ( input.width_ + stride - 1 ) / stride, ( input.height_ + stride - 1 ) / stride );
+  for ( size_t y = 0; y < input.height_; y++ ) {
+    for ( size_t x = 0; x < input.width_; x++ ) { pooled.at( x / stride, y / stride ) += features.get( x, y ); }
+  }
+  const PCCTestImage low = convolve( pooled );
+  PCCTestImage       upsampled( input.width_, input.height_ );
+  for ( size_t y = 0; y < input.height_; y++ ) {
+    for ( size_t x = 0; x < input.width_; x++ ) { upsampled.at( x, y ) = low.get( x / stride, y / stride ); }
+  }
+  return convolve( upsampled );
+}
+
+static bool checkTiles( const size_t                              size,
+                        const size_t                              halo,
+                        const size_t                              stride,
+                        const size_t                              windowSize,
+                        const std::vector<PCCOccupancyModelTile>& tiles ) {
+  size_t next = 0;
+  for ( const auto& tile : tiles ) {
+    const size_t windowEnd = tile.window_ + windowSize;
+    if ( tile.begin_ != next || tile.end_ <= tile.begin_ || tile.begin_ < tile.window_ || windowEnd > size ||
+         tile.end_ > windowEnd || ( tile.window_ > 0 && tile.begin_ - tile.window_ < halo ) ||
+         ( windowEnd < size && windowEnd - tile.end_ < halo ) ||
+         ( tiles.size() > 1 && ( tile.window_ % stride || windowSize % stride ) ) ) {
+      return false;
+    }
+    next = tile.end_;
+  }
+  return next == size;
+}
+
+// Random frames inferred by the reference model as a whole and by the tiles of getOccupancyModelTiles(), stitched as
+// PCCCodec::processIngredient() does: the outputs must be identical when the halo covers the receptive field of the
+// model and the windows are aligned on its stride.
+bool testOccupancyModelTiles( const PCCTestParameters& params ) {
+  std::mt19937 generator( (uint32_t)params.seed_ );
+  auto         random        = [&]( size_t count ) { return size_t( generator() % count ); };
+  size_t       mismatchCount = 0;
+  for ( size_t iteration = 0; iteration < params.iterations_; iteration++ ) {
+    const size_t stride   = size_t( 1 ) << random( 3 );
+    const size_t halo     = 2 * stride + 1 + random( 3 );
+    const size_t tileSize = random( 8 ) == 0 ? 0 : 4 + random( 40 );
+    // most frames are a multiple of the stride and are tiled, the others are inferred as a whole
+    const size_t width  = random( 4 ) ? stride * ( 1 + random( 120 / stride ) ) : 1 + random( 120 );
+    const size_t height = random( 4 ) ? stride * ( 1 + random( 120 / stride ) ) : 1 + random( 120 );
+    PCCTestImage input( width, height );
+    for ( auto& value : input.data_ ) { value = random( 4 ) != 0; }
+
+    size_t                             windowWidth = 0, windowHeight = 0;
+    std::vector<PCCOccupancyModelTile> tilesX, tilesY;
+    getOccupancyModelTiles( width, tileSize, halo, stride, windowWidth, tilesX );
+    getOccupancyModelTiles( height, tileSize, halo, stride, windowHeight, tilesY );
+    bool ok = checkTiles( width, halo, stride, windowWidth, tilesX ) &&
+              checkTiles( height, halo, stride, windowHeight, tilesY );
+    const PCCTestImage reference = runModel( input, stride );
+    for ( const auto& tileY : tilesY ) {
+      for ( const auto& tileX : tilesX ) {
+        PCCTestImage window( windowWidth, windowHeight );
+        for ( size_t y = 0; y < windowHeight; y++ ) {
+          for ( size_t x = 0; x < windowWidth; x++ ) {
+            window.at( x, y ) = input.get( tileX.window_ + x, tileY.window_ + y );
+          }
+        }
+        const PCCTestImage output = runModel( window, stride );
+        for ( size_t y = tileY.begin_; ok && y < tileY.end_; y++ ) {
+          for ( size_t x = tileX.begin_; ok && x < tileX.end_; x++ ) {
+            ok = output.get( x - tileX.window_, y - tileY.window_ ) == reference.get( x, y );
+          }
+        }
+      }
+    }
+    if ( !ok ) {
+      if ( mismatchCount++ < 10 ) {
+        std::cout << "  mismatch: frame " << width << "x" << height << " tile " << tileSize << " halo " << halo
+                  << " stride " << stride << " windows " << windowWidth << "x" << windowHeight << std::endl;
+      }
+    }
+  }
+  return mismatchCount == 0;
+}
@@ -0,0 +1,105 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+#include "PCCPatch.h"
+#include "PCCPackingCanvas.h"
+#include <random>
+
+using namespace pcc;
+
+// Random canvases and patches, tested at random positions with PCCPackingCanvas and with the std::vector<bool> canvas
+// of PCCPatch::checkFitPatchCanvas(). The same canvas and patch objects are reused and mutated from one case to the
+// next, so that a mask cached for a previous patch state would be detected.
+bool testPackingCanvas( const PCCTestParameters& params ) {
+  std::mt19937      generator( (uint32_t)params.seed_ );
+  auto              random = [&]( size_t count ) { return size_t( generator() % count ); };
+  PCCPackingCanvas  canvas;
+  PCCPatch          patch;
+  std::vector<bool> reference;
+  size_t            mismatchCount = 0;
+  for ( size_t iteration = 0; iteration < params.iterations_; iteration++ ) {
+    const size_t sizeU   = 1 + random( 150 );
+    const size_t sizeV   = 1 + random( 40 );
+    const size_t density = random( 100 );
+    canvas               = PCCPackingCanvas( sizeU, sizeV );
+    reference.assign( sizeU * sizeV, false );
+    for ( size_t i = 0; i < sizeU * sizeV; i++ ) {
+      if ( random( 100 ) < density ) {
+        canvas.set( i );
+        reference[i] = true;
+      }
+    }
+    for ( size_t probe = 0; probe < 16; probe++ ) {
+      // the patch is only partly changed between probes: sizes, occupancy, orientation or safeguard
+      if ( probe == 0 || random( 2 ) ) {
+        patch.getSizeU0() = 1 + random( 20 );
+        patch.getSizeV0() = 1 + random( 20 );
+      }
+      if ( patch.getOccupancy().size() != patch.getSizeU0() * patch.getSizeV0() || random( 2 ) ) {
+        patch.getOccupancy().resize( patch.getSizeU0() * patch.getSizeV0() );
+        for ( size_t i = 0; i < patch.getOccupancy().size(); i++ ) { patch.getOccupancy()[i] = random( 4 ) != 0; }
+      }
+      patch.getPatchOrientation() = random( PATCH_ORIENTATION_MROT270 + 1 );
+      patch.getU0()               = random( sizeU + 2 );
+      patch.getV0()               = random( sizeV );
+      const int  safeguard        = (int)random( 3 );
+      const bool bPrecedence      = random( 2 ) != 0;
+      Tile       tile;
+      if ( random( 4 ) == 0 ) {
+        tile.minU = (int)random( sizeU );
+        tile.maxU = tile.minU + (int)random( sizeU - tile.minU );
+        tile.minV = (int)random( sizeV );
+        tile.maxV = tile.minV + (int)random( sizeV - tile.minV );
+      }
+      const size_t u0   = patch.getU0();
+      const size_t next = canvas.nextFit( patch, bPrecedence, safeguard, tile );
+      const bool   fit  = patch.checkFitPatchCanvas( reference, sizeU, sizeV, bPrecedence, safeguard, tile );
+      bool         ok   = ( next == u0 ) == fit;
+      // the positions skipped by nextFit() must not fit either
+      for ( size_t u = u0 + 1; ok && next != u0 && u < ( std::min )( next, sizeU ); u++ ) {
+        patch.getU0() = u;
+        ok            = !patch.checkFitPatchCanvas( reference, sizeU, sizeV, bPrecedence, safeguard, tile );
+      }
+      patch.getU0() = u0;
+      if ( !ok ) {
+        if ( mismatchCount++ < 10 ) {
+          std::cout << "  mismatch: canvas " << sizeU << "x" << sizeV << " patch " << patch.getSizeU0() << "x"
+                    << patch.getSizeV0() << " at (" << u0 << "," << patch.getV0() << ") orientation "
+                    << patch.getPatchOrientation() << " safeguard " << safeguard << " precedence " << bPrecedence
+                    << " nextFit " << next << " fit " << fit << std::endl;
+        }
+      }
+    }
+  }
+  return mismatchCount == 0;
+}
@@ -0,0 +1,117 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+#include "PCCPointSet.h"
+#include "PCCKdTree.h"
+#include <random>
+
+using namespace pcc;
+
+// Points of a random lattice box with duplicated points, and integer queries inside and around the box.
+static void generateLatticeCloud( std::mt19937& generator, PCCPointSet3& pointCloud, PCCPointSet3& queries ) {
+  auto random = [&]( int count ) { return int( generator() % count ); };
+  pointCloud.clear();
+  queries.clear();
+  const int    size       = 2 + random( 40 );
+  const size_t pointCount = 1 + random( 3000 );
+  for ( size_t i = 0; i < pointCount; i++ ) {
+    pointCloud.addPoint( PCCPoint3D( random( size ), random( size ), random( size ) ) );
+  }
+  for ( int i = random( 50 ); i > 0; i-- ) { pointCloud.addPoint( pointCloud[random( (int)pointCount )] ); }
+  for ( int i = 0; i < 200; i++ ) {
+    queries.addPoint( random( 2 ) ? pointCloud[random( (int)pointCount )]
+                                  : PCCPoint3D( random( size + 40 ) - 20, random( size + 40 ) - 20,
+                                                random( size + 40 ) - 20 ) );
+  }
+}
+
+static bool reportMismatch( const std::string& name, const PCCPoint3D& query ) {
+  std::cout << "  " << name << " differs for the query (" << query[0] << ", " << query[1] << ", " << query[2] << ")"
+            << std::endl;
+  return false;
+}
+
+// The voxel grid must return the kd-tree radius searches, capped ones included, and nearest ties, and the kd-tree
+// kNN distances with the same neighbours strictly closer than the last one, as stated by PCCSpatialIndexType.
+bool testSpatialIndex( const PCCTestParameters& params ) {
+  std::mt19937 generator( (uint32_t)params.seed_ );
+  PCCPointSet3 pointCloud, queries;
+  PCCNNResult  tree, grid;
+  bool         ok = true;
+  for ( size_t i = 0; i < ( std::max )( params.iterations_ / 20, size_t( 1 ) ) && ok; i++ ) {
+    generateLatticeCloud( generator, pointCloud, queries );
+    const PCCKdTree   kdtree( pointCloud, PCC_SPATIAL_INDEX_KDTREE );
+    const PCCKdTree   voxelGrid( pointCloud, PCC_SPATIAL_INDEX_VOXEL_GRID );
+    const std::string name        = "cloud " + std::to_string( i );
+    const size_t      num_results = 1 + generator() % 64;
+    const double      radius      = double( 1 + generator() % 100 );
+    for ( size_t j = 0; j < queries.getPointCount() && ok; j++ ) {
+      const auto& query = queries[j];
+      kdtree.searchRadius( query, num_results, radius, tree );
+      voxelGrid.searchRadius( query, num_results, radius, grid );
+      ok = tree.count() == grid.count();
+      for ( size_t k = 0; ok && k < tree.count(); k++ ) {
+        ok = tree.indices( k ) == grid.indices( k ) && tree.dist( k ) == grid.dist( k );
+      }
+      if ( !ok ) { return reportMismatch( name + " searchRadius", query ); }
+
+      kdtree.searchNearestTies( query, num_results, tree );
+      voxelGrid.searchNearestTies( query, num_results, grid );
+      ok = tree.count() == grid.count();
+      for ( size_t k = 0; ok && k < tree.count(); k++ ) {
+        ok = tree.indices( k ) == grid.indices( k ) && tree.dist( k ) == grid.dist( k );
+      }
+      if ( !ok ) { return reportMismatch( name + " searchNearestTies", query ); }
+
+      // equidistant neighbours may be ranked differently, so only the set of the strictly closer ones is compared
+      kdtree.search( query, num_results, tree );
+      voxelGrid.search( query, num_results, grid );
+      ok = tree.count() == grid.count();
+      for ( size_t k = 0; ok && k < tree.count(); k++ ) { ok = tree.dist( k ) == grid.dist( k ); }
+      if ( ok && tree.count() > 0 ) {
+        std::vector<size_t> treeCloser, gridCloser;
+        for ( size_t k = 0; k < tree.count(); k++ ) {
+          if ( tree.dist( k ) < tree.dist( tree.count() - 1 ) ) {
+            treeCloser.push_back( tree.indices( k ) );
+            gridCloser.push_back( grid.indices( k ) );
+          }
+        }
+        std::sort( treeCloser.begin(), treeCloser.end() );
+        std::sort( gridCloser.begin(), gridCloser.end() );
+        ok = treeCloser == gridCloser;
+      }
+      if ( !ok ) { return reportMismatch( name + " search", query ); }
+    }
+  }
+  return ok;
+}
@@ -0,0 +1,122 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PccAppTests.h"
+
+using namespace std;
+using namespace pcc;
+
+struct PCCTest {
+  const char* name_;
+  bool ( *run_ )( const PCCTestParameters& );
+};
+
+static const PCCTest tests[] = {
+    {"PackingCanvas", testPackingCanvas},
+    {"NormalsOrientation", testNormalsOrientation},
+    {"OccupancyModelTiles", testOccupancyModelTiles},
+    {"KdTreeBatch", testKdTreeBatch},
+    {"SpatialIndex", testSpatialIndex},
+#if OCCUPANCY_MAP_MODEL
+    {"OccupancyModel", testOccupancyModel},
+#endif
+};
+
+int main( int argc, char* argv[] ) {
+  std::cout << "PccAppTests v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl << std::endl;
+
+  PCCTestParameters params;
+  if ( !parseParameters( argc, argv, params ) ) { return -1; }
+  size_t runCount = 0, failCount = 0;
+  for ( const auto& test : tests ) {
+    if ( !params.test_.empty() && params.test_ != test.name_ ) { continue; }
+    const bool ok = test.run_( params );
+    std::cout << test.name_ << ": " << ( ok ? "OK" : "FAILED" ) << std::endl;
+    runCount++;
+    failCount += ok ? 0 : 1;
+  }
+  if ( runCount == 0 ) {
+    std::cout << "Error: unknown test " << params.test_ << std::endl;
+    return -1;
+  }
+  return failCount == 0 ? 0 : -1;
+}
+
+//---------------------------------------------------------------------------
+// :: Command line / config parsing
+
+bool parseParameters( int argc, char* argv[], PCCTestParameters& params ) {
+  namespace po    = df::program_options_lite;
+  bool print_help = false;
+
+  // clang-format off
+  po::Options opts;
+  opts.addOptions()
+    ( "help", print_help, false, "This help text" )
+    ( "test", params.test_, params.test_, "Name of the test to run, all of them when empty" )
+    ( "iterations", params.iterations_, params.iterations_, "Number of random cases of the randomized tests" )
+    ( "seed", params.seed_, params.seed_, "Seed of the randomized tests" )
+    ( "nbThread", params.nbThread_, params.nbThread_, "Number of threads of the parallel paths" )
+#if OCCUPANCY_MAP_MODEL
+    ( "occupancyModel",
+      params.occupancyModel_,
+      params.occupancyModel_,
+      "TorchScript occupancy map model of the OccupancyModel test, which is skipped when empty" )
+    ( "occupancyModelTileSize",
+      params.occupancyModelTileSize_,
+      params.occupancyModelTileSize_,
+      "Tile size also checked by the OccupancyModel test (0: whole frames only)" )
+    ( "occupancyModelTileHalo",
+      params.occupancyModelTileHalo_,
+      params.occupancyModelTileHalo_,
+      "Tile halo of the OccupancyModel test, at least the receptive field radius of the model" )
+    ( "occupancyModelTileStride",
+      params.occupancyModelTileStride_,
+      params.occupancyModelTileStride_,
+      "Total stride of the model of the OccupancyModel test" )
+#endif
+    ( "inputPointCloud",
+      params.inputPointCloud_,
+      params.inputPointCloud_,
+      "Point cloud (.ply) also used by the tests on real content, e.g. a CTC frame" );
+  // clang-format on
+  po::setDefaults( opts );
+  po::ErrorReporter        err;
+  const list<const char*>& argv_unhandled = po::scanArgv( opts, argc, (const char**)argv, err );
+  for ( const auto arg : argv_unhandled ) { err.warn() << "Unhandled argument ignored: " << arg << "\n"; }
+  if ( print_help ) {
+    po::doHelp( std::cout, opts, 78 );
+    return false;
+  }
+  if ( err.is_errored ) return false;
+  return true;
+}
@@ -0,0 +1,65 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCC_APP_TESTS_H
+#define PCC_APP_TESTS_H
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "PCCCommon.h"
+#include <program_options_lite.h>
+
+struct PCCTestParameters {
+  std::string test_       = "";  // name of the test to run, all of them when empty
+  size_t      iterations_ = 2000;
+  size_t      seed_       = 1;
+  size_t      nbThread_   = 4;
+  std::string inputPointCloud_;  // optional point cloud of the tests on real content
+  std::string occupancyModel_;   // TorchScript model of the occupancy map model test
+  size_t      occupancyModelTileSize_   = 0;
+  size_t      occupancyModelTileHalo_   = 32;
+  size_t      occupancyModelTileStride_ = 1;
+};
+
+bool parseParameters( int argc, char* argv[], PCCTestParameters& params );
+
+// each test compares an optimized path with its reference implementation and returns false on any mismatch
+bool testPackingCanvas( const PCCTestParameters& params );
+bool testNormalsOrientation( const PCCTestParameters& params );
+bool testOccupancyModelTiles( const PCCTestParameters& params );
+bool testKdTreeBatch( const PCCTestParameters& params );
+bool testSpatialIndex( const PCCTestParameters& params );
+#if OCCUPANCY_MAP_MODEL
+bool testOccupancyModel( const PCCTestParameters& params );
+#endif
+
+#endif /* PCC_APP_TESTS_H */
@@ -110,6 +110,10 @@ class PCCBitstreamStat {
     PCCBitstreamGofStat element;
     bitstreamGofStat_.push_back( element );
   }
+  void appendGOFs( const PCCBitstreamStat& other ) {
+    bitstreamGofStat_.insert( bitstreamGofStat_.end(), other.bitstreamGofStat_.begin(),
+                              other.bitstreamGofStat_.end() );
+  }
   void   setHeader( size_t size ) { header_ = size; }
   void   incrHeader( size_t size ) { header_ += size; }
   void   setVpccUnitSize( VPCCUnitType type, size_t size ) { bitstreamGofStat_.back().setVpccUnitSize( type, size ); }
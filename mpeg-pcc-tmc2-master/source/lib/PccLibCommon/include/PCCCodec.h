@@ -45,6 +45,7 @@
 #include <torch/csrc/api/include/torch/utils.h>
 #include <iostream>
 #include <memory>
+#include "PCCOccupancyModel.h"
 #endif
 
 
@@ -66,7 +67,7 @@ typedef pcc::PCCVideo<uint16_t, 3> PCCVideoGeometry;
 template <typename T, size_t N>
 class PCCImage;
 typedef pcc::PCCImage<uint16_t, 3> PCCImageGeometry;
-typedef pcc::PCCImage<uint8_t, 3>  PCCImageOccupancyMap;
+typedef pcc::PCCImage<uint8_t, 1>  PCCImageOccupancyMap;
 
 struct GeneratePointCloudParameters {
   size_t      occupancyResolution_;
@@ -167,9 +168,13 @@ class PCCCodec {
                              bool         enhancedOccupancyMapForDepthFlag );
 
 #if OCCUPANCY_MAP_MODEL
-  void upsampleOccupancyMap( PCCContext& context, PCCVideoOccupancyMap&  om);
-  void processIngredient(std::string model_name,  PCCContext& context, PCCVideoOccupancyMap&  om);
-  void refineOccupancy( PCCVideoOccupancyMap vom_org,  PCCVideoOccupancyMap& videoOccupancyMap);
+  void upsampleOccupancyMap( PCCContext& context, PCCVideoOccupancyMap& om, const size_t nbThread );
+  // refines the occupancy maps in place, the pixels unoccupied before refinement stay unoccupied.
+  bool processIngredient( const PCCOccupancyModelParameters& params,
+                          PCCContext&                        context,
+                          PCCVideoOccupancyMap&              om );
+  // shares one model session between the codecs of the groups of frames, otherwise each codec creates its own.
+  void setOccupancyModel( std::shared_ptr<PCCOccupancyModel> model ) { occupancyModel_ = model; }
 #endif
  
 #ifdef CODEC_TRACE
@@ -319,6 +324,7 @@ class PCCCodec {
                            const PCCVideoGeometry&            videoD1,
                            const PCCVideoOccupancyMap&        videoOM,
                            const GeneratePointCloudParameters params,
+                           const std::vector<PCCColor3B>&     patchColors,
                            std::vector<uint32_t>&             partition,
                            bool                               bDecoder );
 
@@ -361,7 +367,10 @@ class PCCCodec {
   void smoothPointCloudGrid( PCCPointSet3&                      reconstruct,
                              const std::vector<uint32_t>&       partition,
                              const GeneratePointCloudParameters params,
-                             int                                gridWidth );
+                             int                                gridWidth,
+                             std::vector<int>&                  gridCount,
+                             std::vector<PCCVector3D>&          gridCenter,
+                             std::vector<bool>&                 gridDoSmooth );
 
   void addGridCentroid( PCCPoint3D&               point,
                         int                       patchIdx,
@@ -419,7 +428,7 @@ class PCCCodec {
                               std::vector<PCCVector3D>&    colorGrid,
                               PCCVector3D&                 color );
 
-  void identifyBoundaryPoints( const std::vector<uint32_t>& occupancyMap,
+  void identifyBoundaryPoints( const std::vector<uint16_t>& occupancyMap,
                                const size_t                 x,
                                const size_t                 y,
                                const size_t                 imageWidth,
@@ -428,10 +437,6 @@ class PCCCodec {
                                std::vector<uint32_t>&       PBflag,
                                PCCPointSet3&                reconstruct );
 
-  std::vector<int>                  geoSmoothingCount_;
-  std::vector<PCCVector3D>          geoSmoothingCenter_;
-  std::vector<bool>                 geoSmoothingDoSmooth_;
-  std::vector<int>                  geoSmoothingPartition_;
   std::vector<int>                  colorSmoothingCount_;
   std::vector<PCCVector3D>          colorSmoothingCenter_;
   std::vector<bool>                 colorSmoothingDoSmooth_;
@@ -446,6 +451,9 @@ class PCCCodec {
   FILE* traceFile_;
 #endif
 #endif
+#if OCCUPANCY_MAP_MODEL
+  std::shared_ptr<PCCOccupancyModel> occupancyModel_;
+#endif
 };
 
 };  // namespace pcc
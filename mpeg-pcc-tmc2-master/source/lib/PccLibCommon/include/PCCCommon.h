@@ -130,6 +130,7 @@ enum PCCVideoType {
   VIDEO_TEXTURE_RAW,
   NUM_VIDEO_TYPE
 };
+enum PCCVideoCodecBackendType { VIDEO_CODEC_BACKEND_EXTERNAL = 0, VIDEO_CODEC_BACKEND_LOSSLESS = 1 };
 enum PCCMetadataType { METADATA_GOF = 0, METADATA_FRAME, METADATA_PATCH };
 enum PCCPatchOrientation {
   PATCH_ORIENTATION_DEFAULT = 0,
@@ -46,7 +46,7 @@ class PCCGroupOfFrames;
 class PCCFrameContext;
 typedef pcc::PCCVideo<uint8_t, 3>  PCCVideoTexture;
 typedef pcc::PCCVideo<uint16_t, 3> PCCVideoGeometry;
-typedef pcc::PCCVideo<uint8_t, 3>  PCCVideoOccupancyMap;
+typedef pcc::PCCVideo<uint8_t, 1>  PCCVideoOccupancyMap;
 
 class PCCPatch;
 typedef std::map<size_t, PCCPatch>                 unionPatch;     // [TrackIndex, PatchUnion]
@@ -60,7 +60,7 @@ class PCCBitstreamStat;
 // E.2.1	General SEI message syntax  <=> 7.3.8	Supplemental enhancement information message syntax
 class SEI {
  public:
-  SEI() {}
+  SEI() : payloadSize_( 0 ) {}
   virtual ~SEI() {}
   virtual SeiPayloadType getPayloadType() = 0;
   uint8_t                getPayloadSize() { return payloadSize_; }
@@ -1295,6 +1295,9 @@ class SampleStreamVpccUnit {
     vpccUnits_.resize( vpccUnits_.size() + 1 );
     return vpccUnits_.back();
   }
+  void appendVpccUnits( const SampleStreamVpccUnit& ssvu ) {
+    vpccUnits_.insert( vpccUnits_.end(), ssvu.vpccUnits_.begin(), ssvu.vpccUnits_.end() );
+  }
   void                   popFront() { vpccUnits_.erase( vpccUnits_.begin(), vpccUnits_.begin() + 1 ); }
   VpccUnit&              front() { return *( vpccUnits_.begin() ); }
   std::vector<VpccUnit>& getVpccUnit() { return vpccUnits_; }
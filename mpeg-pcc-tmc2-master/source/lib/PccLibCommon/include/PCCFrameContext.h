@@ -56,10 +56,10 @@ class PCCFrameContext {
  public:
   PCCFrameContext();
   ~PCCFrameContext();
-  std::vector<PCCVector3<size_t>>&   getPointToPixel() { return pointToPixel_; }
-  std::vector<size_t>&               getBlockToPatch() { return blockToPatch_; }
-  std::vector<uint32_t>&             getOccupancyMap() { return occupancyMap_; }
-  std::vector<uint32_t>&             getFullOccupancyMap() { return fullOccupancyMap_; }
+  std::vector<PCCVector3<uint32_t>>& getPointToPixel() { return pointToPixel_; }
+  std::vector<uint32_t>&             getBlockToPatch() { return blockToPatch_; }
+  std::vector<uint16_t>&             getOccupancyMap() { return occupancyMap_; }
+  std::vector<uint16_t>&             getFullOccupancyMap() { return fullOccupancyMap_; }
   std::vector<PCCPatch>&             getPatches() { return patches_; }
   PCCPatch&                          getPatch( size_t index ) { return patches_[index]; }
   const PCCPatch&                    getPatch( size_t index ) const { return patches_[index]; }
@@ -208,10 +208,10 @@ class PCCFrameContext {
   std::vector<std::vector<size_t>>             refAFOCList_;
   size_t                                       log2PatchQuantizerSizeX_;
   size_t                                       log2PatchQuantizerSizeY_;
-  std::vector<PCCVector3<size_t>>              pointToPixel_;
-  std::vector<size_t>                          blockToPatch_;
-  std::vector<uint32_t>                        occupancyMap_;
-  std::vector<uint32_t>                        fullOccupancyMap_;
+  std::vector<PCCVector3<uint32_t>>            pointToPixel_;
+  std::vector<uint32_t>                        blockToPatch_;
+  std::vector<uint16_t>                        occupancyMap_;
+  std::vector<uint16_t>                        fullOccupancyMap_;
   std::vector<PCCPatch>                        patches_;
   std::vector<PCCMissedPointsPatch>            missedPointsPatches_;
   std::vector<size_t>                          numberOfMissedPoints_;
@@ -220,7 +220,7 @@ class PCCFrameContext {
   std::vector<PCCPointSet3>                    srcPointCloudByPatch_;
   std::vector<PCCPointSet3>                    srcPointCloudByBlock_;
   std::vector<PCCPointSet3>                    recPointCloudByBlock_;
-  std::vector<std::vector<PCCVector3<size_t>>> pointToPixelByBlock_;
+  std::vector<std::vector<PCCVector3<uint32_t>>> pointToPixelByBlock_;
   PCCGPAFrameSize                              prePCCGPAFrameSize_;
   PCCGPAFrameSize                              curPCCGPAFrameSize_;
   PCCFrameOCPInfo                              ocpGPAInfo_;
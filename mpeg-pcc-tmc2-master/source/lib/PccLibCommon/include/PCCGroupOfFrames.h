@@ -35,6 +35,7 @@
 #define PCCGroupOfFrames_h
 
 #include "PCCCommon.h"
+#include <future>
 
 namespace pcc {
 class PCCPointSet3;
@@ -62,13 +63,43 @@ class PCCGroupOfFrames {
              const size_t            startFrameNumber,
              const size_t            endFrameNumber,
              const PCCColorTransform colorTransform,
-             const bool              readNormals = false );
+             const bool              readNormals = false,
+             const size_t            nbThread    = 1 );
 
-  bool write( const std::string reconstructedDataPath, size_t& frameNumber );
+  bool write( const std::string reconstructedDataPath, size_t& frameNumber, const bool asAscii = false );
 
  private:
   std::vector<PCCPointSet3> frames_;
 };
+
+// Loads ranges of frames of a sequence and can prefetch the next range in a background thread while the current
+// one is processed. A prefetch is skipped when the last loaded range and the estimated size of the next one would
+// exceed memoryLimit bytes (0: no limit).
+class PCCGroupOfFramesLoader {
+ public:
+  PCCGroupOfFramesLoader( const std::string       dataPath,
+                          const PCCColorTransform colorTransform,
+                          const bool              readNormals = false,
+                          const size_t            nbThread    = 1,
+                          const size_t            memoryLimit = 0 );
+  ~PCCGroupOfFramesLoader();
+
+  bool load( PCCGroupOfFrames& frames, const size_t startFrameNumber, const size_t endFrameNumber );
+  bool prefetch( const size_t startFrameNumber, const size_t endFrameNumber );
+
+ private:
+  std::string       dataPath_;
+  PCCColorTransform colorTransform_;
+  bool              readNormals_;
+  size_t            nbThread_;
+  size_t            memoryLimit_;
+  size_t            lastMemorySize_;
+  size_t            lastFrameCount_;
+  size_t            prefetchStartFrameNumber_;
+  size_t            prefetchEndFrameNumber_;
+  PCCGroupOfFrames  prefetched_;
+  std::future<bool> pending_;
+};
 }  // namespace pcc
 
 #endif /* PCCGroupOfFrames_h */
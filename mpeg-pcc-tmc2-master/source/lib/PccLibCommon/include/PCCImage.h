@@ -35,9 +35,189 @@
 #define PCCImage_h
 
 #include "PCCCommon.h"
+#if defined( __AVX2__ )
+#define PCC_IMAGE_AVX2
+#include <immintrin.h>
+#endif
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define PCC_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace pcc {
 
+class ColorConverter {
+ public:
+  ColorConverter() {}
+  ~ColorConverter() {}
+
+  // R, G and B hold the integer samples of a row, Y, U and V receive the normalized BT.709 values.
+  void convertRGBToYUV( const float* R,
+                        const float* G,
+                        const float* B,
+                        float*       Y,
+                        float*       U,
+                        float*       V,
+                        const int    count,
+                        const float  maxValue ) const {
+    int j = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    const __m128  scale = _mm_set1_ps( maxValue );
+    const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd( 1.0 );
+    const __m256d minC = _mm256_set1_pd( -0.5 ), maxC = _mm256_set1_pd( 0.5 );
+    for ( ; j + 4 <= count; j += 4 ) {
+      const __m256d r = _mm256_cvtps_pd( _mm_div_ps( _mm_loadu_ps( R + j ), scale ) );
+      const __m256d g = _mm256_cvtps_pd( _mm_div_ps( _mm_loadu_ps( G + j ), scale ) );
+      const __m256d b = _mm256_cvtps_pd( _mm_div_ps( _mm_loadu_ps( B + j ), scale ) );
+      __m256d       y = _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( 0.212600 ), r ),
+                                 _mm256_mul_pd( _mm256_set1_pd( 0.715200 ), g ) );
+      __m256d       u = _mm256_sub_pd( _mm256_mul_pd( _mm256_set1_pd( -0.114572 ), r ),
+                                 _mm256_mul_pd( _mm256_set1_pd( 0.385428 ), g ) );
+      __m256d       v = _mm256_sub_pd( _mm256_mul_pd( _mm256_set1_pd( 0.500000 ), r ),
+                                 _mm256_mul_pd( _mm256_set1_pd( 0.454153 ), g ) );
+      y               = _mm256_add_pd( y, _mm256_mul_pd( _mm256_set1_pd( 0.072200 ), b ) );
+      u               = _mm256_add_pd( u, _mm256_mul_pd( _mm256_set1_pd( 0.500000 ), b ) );
+      v               = _mm256_sub_pd( v, _mm256_mul_pd( _mm256_set1_pd( 0.045847 ), b ) );
+      _mm_storeu_ps( Y + j, _mm256_cvtpd_ps( _mm256_min_pd( _mm256_max_pd( y, zero ), one ) ) );
+      _mm_storeu_ps( U + j, _mm256_cvtpd_ps( _mm256_min_pd( _mm256_max_pd( u, minC ), maxC ) ) );
+      _mm_storeu_ps( V + j, _mm256_cvtpd_ps( _mm256_min_pd( _mm256_max_pd( v, minC ), maxC ) ) );
+    }
+#elif defined( PCC_IMAGE_SSE2 )
+    const __m128  scale = _mm_set1_ps( maxValue );
+    const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd( 1.0 );
+    const __m128d minC = _mm_set1_pd( -0.5 ), maxC = _mm_set1_pd( 0.5 );
+    for ( ; j + 2 <= count; j += 2 ) {
+      const __m128d r = _mm_cvtps_pd( _mm_div_ps( _mm_castpd_ps( _mm_load_sd( (const double*)( R + j ) ) ), scale ) );
+      const __m128d g = _mm_cvtps_pd( _mm_div_ps( _mm_castpd_ps( _mm_load_sd( (const double*)( G + j ) ) ), scale ) );
+      const __m128d b = _mm_cvtps_pd( _mm_div_ps( _mm_castpd_ps( _mm_load_sd( (const double*)( B + j ) ) ), scale ) );
+      __m128d y = _mm_add_pd( _mm_mul_pd( _mm_set1_pd( 0.212600 ), r ), _mm_mul_pd( _mm_set1_pd( 0.715200 ), g ) );
+      __m128d u = _mm_sub_pd( _mm_mul_pd( _mm_set1_pd( -0.114572 ), r ), _mm_mul_pd( _mm_set1_pd( 0.385428 ), g ) );
+      __m128d v = _mm_sub_pd( _mm_mul_pd( _mm_set1_pd( 0.500000 ), r ), _mm_mul_pd( _mm_set1_pd( 0.454153 ), g ) );
+      y         = _mm_add_pd( y, _mm_mul_pd( _mm_set1_pd( 0.072200 ), b ) );
+      u         = _mm_add_pd( u, _mm_mul_pd( _mm_set1_pd( 0.500000 ), b ) );
+      v         = _mm_sub_pd( v, _mm_mul_pd( _mm_set1_pd( 0.045847 ), b ) );
+      _mm_store_sd( (double*)( Y + j ), _mm_castps_pd( _mm_cvtpd_ps( _mm_min_pd( _mm_max_pd( y, zero ), one ) ) ) );
+      _mm_store_sd( (double*)( U + j ), _mm_castps_pd( _mm_cvtpd_ps( _mm_min_pd( _mm_max_pd( u, minC ), maxC ) ) ) );
+      _mm_store_sd( (double*)( V + j ), _mm_castps_pd( _mm_cvtpd_ps( _mm_min_pd( _mm_max_pd( v, minC ), maxC ) ) ) );
+    }
+#endif
+    for ( ; j < count; j++ ) {
+      const float r = R[j] / maxValue, g = G[j] / maxValue, b = B[j] / maxValue;
+      Y[j]          = (float)clamp( 0.212600 * r + 0.715200 * g + 0.072200 * b, 0.0, 1.0 );
+      U[j]          = (float)clamp( -0.114572 * r - 0.385428 * g + 0.500000 * b, -0.5, 0.5 );
+      V[j]          = (float)clamp( 0.500000 * r - 0.454153 * g - 0.045847 * b, -0.5, 0.5 );
+    }
+  }
+
+  // Y, U and V hold normalized BT.709 values, R, G and B receive values in [0;1].
+  void convertYUVToRGB( const float* Y,
+                        const float* U,
+                        const float* V,
+                        float*       R,
+                        float*       G,
+                        float*       B,
+                        const int    count ) const {
+    int j = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd( 1.0 );
+    for ( ; j + 4 <= count; j += 4 ) {
+      const __m256d y = _mm256_cvtps_pd( _mm_loadu_ps( Y + j ) );
+      const __m256d u = _mm256_cvtps_pd( _mm_loadu_ps( U + j ) );
+      const __m256d v = _mm256_cvtps_pd( _mm_loadu_ps( V + j ) );
+      const __m256d r = _mm256_add_pd( y, _mm256_mul_pd( _mm256_set1_pd( 1.57480 ), v ) );
+      const __m256d g = _mm256_sub_pd( _mm256_sub_pd( y, _mm256_mul_pd( _mm256_set1_pd( 0.18733 ), u ) ),
+                                       _mm256_mul_pd( _mm256_set1_pd( 0.46813 ), v ) );
+      const __m256d b = _mm256_add_pd( y, _mm256_mul_pd( _mm256_set1_pd( 1.85563 ), u ) );
+      _mm_storeu_ps( R + j, _mm256_cvtpd_ps( _mm256_min_pd( _mm256_max_pd( r, zero ), one ) ) );
+      _mm_storeu_ps( G + j, _mm256_cvtpd_ps( _mm256_min_pd( _mm256_max_pd( g, zero ), one ) ) );
+      _mm_storeu_ps( B + j, _mm256_cvtpd_ps( _mm256_min_pd( _mm256_max_pd( b, zero ), one ) ) );
+    }
+#elif defined( PCC_IMAGE_SSE2 )
+    const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd( 1.0 );
+    for ( ; j + 2 <= count; j += 2 ) {
+      const __m128d y = _mm_cvtps_pd( _mm_castpd_ps( _mm_load_sd( (const double*)( Y + j ) ) ) );
+      const __m128d u = _mm_cvtps_pd( _mm_castpd_ps( _mm_load_sd( (const double*)( U + j ) ) ) );
+      const __m128d v = _mm_cvtps_pd( _mm_castpd_ps( _mm_load_sd( (const double*)( V + j ) ) ) );
+      const __m128d r = _mm_add_pd( y, _mm_mul_pd( _mm_set1_pd( 1.57480 ), v ) );
+      const __m128d g = _mm_sub_pd( _mm_sub_pd( y, _mm_mul_pd( _mm_set1_pd( 0.18733 ), u ) ),
+                                    _mm_mul_pd( _mm_set1_pd( 0.46813 ), v ) );
+      const __m128d b = _mm_add_pd( y, _mm_mul_pd( _mm_set1_pd( 1.85563 ), u ) );
+      _mm_store_sd( (double*)( R + j ), _mm_castps_pd( _mm_cvtpd_ps( _mm_min_pd( _mm_max_pd( r, zero ), one ) ) ) );
+      _mm_store_sd( (double*)( G + j ), _mm_castps_pd( _mm_cvtpd_ps( _mm_min_pd( _mm_max_pd( g, zero ), one ) ) ) );
+      _mm_store_sd( (double*)( B + j ), _mm_castps_pd( _mm_cvtpd_ps( _mm_min_pd( _mm_max_pd( b, zero ), one ) ) ) );
+    }
+#endif
+    for ( ; j < count; j++ ) {
+      const float y = Y[j], u = U[j], v = V[j];
+      R[j]          = (float)clamp( y + 1.57480 * v, 0.0, 1.0 );
+      G[j]          = (float)clamp( y - 0.18733 * u - 0.46813 * v, 0.0, 1.0 );
+      B[j]          = (float)clamp( y + 1.85563 * u, 0.0, 1.0 );
+    }
+  }
+
+  // Maps integer samples to [0;1] (luma) or [-0.5;0.5] (chroma).
+  void normalize( const float* src, float* dst, const int count, const bool chroma, const float maxValue ) const {
+    const double offset = chroma ? ( maxValue + 1 ) / 2 : 0.;
+    const double weight = 1.0 / (double)maxValue;
+    const float  minV   = chroma ? -0.5f : 0.f;
+    const float  maxV   = chroma ? 0.5f : 1.f;
+    int          j      = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    for ( ; j + 4 <= count; j += 4 ) {
+      __m256d x = _mm256_sub_pd( _mm256_cvtps_pd( _mm_loadu_ps( src + j ) ), _mm256_set1_pd( offset ) );
+      __m128  y = _mm256_cvtpd_ps( _mm256_mul_pd( _mm256_set1_pd( weight ), x ) );
+      _mm_storeu_ps( dst + j, _mm_min_ps( _mm_max_ps( y, _mm_set1_ps( minV ) ), _mm_set1_ps( maxV ) ) );
+    }
+#elif defined( PCC_IMAGE_SSE2 )
+    for ( ; j + 4 <= count; j += 4 ) {
+      const __m128 s  = _mm_loadu_ps( src + j );
+      __m128d      lo = _mm_sub_pd( _mm_cvtps_pd( s ), _mm_set1_pd( offset ) );
+      __m128d      hi = _mm_sub_pd( _mm_cvtps_pd( _mm_movehl_ps( s, s ) ), _mm_set1_pd( offset ) );
+      __m128       y  = _mm_movelh_ps( _mm_cvtpd_ps( _mm_mul_pd( _mm_set1_pd( weight ), lo ) ),
+                                _mm_cvtpd_ps( _mm_mul_pd( _mm_set1_pd( weight ), hi ) ) );
+      _mm_storeu_ps( dst + j, _mm_min_ps( _mm_max_ps( y, _mm_set1_ps( minV ) ), _mm_set1_ps( maxV ) ) );
+    }
+#endif
+    for ( ; j < count; j++ ) { dst[j] = clamp( (float)( weight * ( (double)src[j] - offset ) ), minV, maxV ); }
+  }
+
+  // Scales normalized values by maxValue, adds offset and rounds them to integer samples in [0;maxValue].
+  void quantize( const float* src, float* dst, const int count, const float maxValue, const double offset ) const {
+    const double scale = (double)maxValue;
+    int          j     = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    for ( ; j + 4 <= count; j += 4 ) {
+      __m256d x = _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( scale ), _mm256_cvtps_pd( _mm_loadu_ps( src + j ) ) ),
+                                 _mm256_set1_pd( offset ) );
+      _mm_storeu_ps( dst + j, roundClip( _mm256_cvtpd_ps( x ), maxValue ) );
+    }
+#elif defined( PCC_IMAGE_SSE2 )
+    for ( ; j + 4 <= count; j += 4 ) {
+      const __m128 s  = _mm_loadu_ps( src + j );
+      __m128d      lo = _mm_add_pd( _mm_mul_pd( _mm_set1_pd( scale ), _mm_cvtps_pd( s ) ), _mm_set1_pd( offset ) );
+      __m128d hi = _mm_add_pd( _mm_mul_pd( _mm_set1_pd( scale ), _mm_cvtps_pd( _mm_movehl_ps( s, s ) ) ),
+                               _mm_set1_pd( offset ) );
+      _mm_storeu_ps( dst + j, roundClip( _mm_movelh_ps( _mm_cvtpd_ps( lo ), _mm_cvtpd_ps( hi ) ), maxValue ) );
+    }
+#endif
+    for ( ; j < count; j++ ) {
+      dst[j] = clamp( std::round( (float)( scale * (double)src[j] + offset ) ), 0.f, maxValue );
+    }
+  }
+
+ private:
+  float  clamp( float v, float a, float b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
+  double clamp( double v, double a, double b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
+#if defined( PCC_IMAGE_SSE2 )
+  // std::round() of x clipped to [0;maxValue]: rounding half away from zero on the truncated value.
+  inline __m128 roundClip( const __m128 x, const float maxValue ) const {
+    const __m128 v = _mm_min_ps( _mm_max_ps( x, _mm_setzero_ps() ), _mm_set1_ps( maxValue ) );
+    const __m128 t = _mm_cvtepi32_ps( _mm_cvttps_epi32( v ) );
+    return _mm_add_ps( t, _mm_and_ps( _mm_cmpge_ps( _mm_sub_ps( v, t ), _mm_set1_ps( 0.5f ) ), _mm_set1_ps( 1.f ) ) );
+  }
+#endif
+};
+
 class ChromaSampler {
  public:
   ChromaSampler() {}
@@ -59,12 +239,7 @@ class ChromaSampler {
     Filter vertical1_;
   };
 
-  void downsampling( const std::vector<float>& chroma_in,
-                     std::vector<float>&       chroma_out,
-                     const int                 widthIn,
-                     const int                 heightIn,
-                     const int                 maxValue,
-                     const size_t              filter ) const {
+  static const Filter444to420& getFilter444to420( const size_t filter ) {
     static const std::vector<Filter444to420> g_filter444to420 = {
         {// 0 DF_F0
          {{+64.0, +384.0, +64.0}, +256.0, 9.0},
@@ -326,33 +501,11 @@ class ChromaSampler {
            (float)-0.00014417970451 * 1024.0},
           512.0,
           10.0}}};
-
-    int                widthOut  = widthIn / 2;
-    int                heightOut = heightIn / 2;
-    std::vector<float> temp;
-    chroma_out.resize( widthOut * heightOut );
-    temp.resize( widthOut * heightIn );
-    for ( int i = 0; i < heightIn; i++ ) {
-      for ( int j = 0; j < widthOut; j++ ) {
-        temp[i * widthOut + j] =
-            downsamplingHorizontal( g_filter444to420[filter], chroma_in, widthIn, heightIn, i, j * 2 );
-      }
-    }
-    for ( int i = 0; i < heightOut; i++ ) {
-      for ( int j = 0; j < widthOut; j++ ) {
-        chroma_out[i * widthOut + j] =
-            downsamplingVertical( g_filter444to420[filter], temp, widthOut, heightIn, 2 * i, j );
-      }
-    }
+    return g_filter444to420[filter];
   }
 
-  void upsampling( const std::vector<float>& chromaIn,
-                   std::vector<float>&       chromaOut,
-                   const int                 widthIn,
-                   const int                 heightIn,
-                   const int                 maxValue,
-                   const size_t              filter ) const {
-    static std::vector<Filter420to444> filter420to444 = {
+  static const Filter420to444& getFilter420to444( const size_t filter ) {
+    static const std::vector<Filter420to444> filter420to444 = {
         {// 0 UF_F0
          {{0.0, +256.0}, +128.0, 8.0},
          {{-8.0, +64.0, +216.0, -16.0}, +128.0, 8.0},
@@ -393,123 +546,308 @@ class ChromaSampler {
          {{0.0, +3.0, -7.0, +14.0, -29.0, +75.0, +230.0, -43.0, +20.0, -10.0, +5.0, -2.0}, +128.0, 8.0},
          {{-1.0, +5.0, -12.0, +24.0, -49.0, +161.0, +161.0, -49.0, +24.0, -12.0, +5.0, -1.0}, +128.0, 8.0},
          {{-2.0, +5.0, -10.0, +20.0, -43.0, +230.0, +75.0, -29.0, +14.0, -7.0, +3.0, 0.0}, +128.0, 8.0}}};
-    int                widthOut = widthIn * 2, heightOut = heightIn * 2;
-    std::vector<float> temp;
-    chromaOut.resize( widthOut * heightOut );
-    temp.resize( widthIn * heightOut );
-    for ( int i = 0; i < heightIn; i++ ) {
-      for ( int j = 0; j < widthIn; j++ ) {
-        temp[( 2 * i ) * widthIn + j] =
-            upsamplingVertical0( filter420to444[filter], chromaIn, widthIn, heightIn, i + 0, j );
-        temp[( 2 * i + 1 ) * widthIn + j] =
-            upsamplingVertical1( filter420to444[filter], chromaIn, widthIn, heightIn, i + 1, j );
+    return filter420to444[filter];
+  }
+
+  // Streams a 4:4:4 chroma plane row by row and returns the 4:2:0 rows as soon as their inputs are known. The
+  // horizontally filtered rows are kept in a ring of filter length rows: every available row must be pulled before
+  // the next input row is pushed.
+  class Downsampler {
+   public:
+    Downsampler( const size_t filter, const int widthIn, const int heightIn ) :
+        filter_( getFilter444to420( filter ) ),
+        widthIn_( widthIn ),
+        heightIn_( heightIn ),
+        widthOut_( widthIn / 2 ),
+        heightOut_( heightIn / 2 ),
+        pushed_( 0 ),
+        pulled_( 0 ) {
+      position_ = int( filter_.horizontal_.data_.size() - 1 ) >> 1;
+      ringSize_ = (int)filter_.vertical_.data_.size();
+      padded_.resize( widthIn_ + filter_.horizontal_.data_.size() + 2 * position_ + 16 );
+      ring_.resize( ringSize_ * widthOut_ );
+      rows_.resize( ringSize_ );
+    }
+    float* getInputRow() { return padded_.data() + position_; }
+    void   pushRow() {
+      float* row = padded_.data() + position_;
+      std::fill( padded_.begin(), padded_.begin() + position_, row[0] );
+      std::fill( padded_.begin() + position_ + widthIn_, padded_.end(), row[widthIn_ - 1] );
+      filterHorizontal444to420( filter_.horizontal_, padded_.data(), widthOut_,
+                                ring_.data() + ( pushed_ % ringSize_ ) * widthOut_ );
+      pushed_++;
+    }
+    bool pullRow( float* rowOut ) {
+      if ( pulled_ >= heightOut_ ) { return false; }
+      const int position = int( filter_.vertical_.data_.size() - 1 ) >> 1;
+      const int first    = 2 * pulled_ - position;
+      if ( pushed_ < heightIn_ && pushed_ <= first + (int)rows_.size() - 1 ) { return false; }
+      for ( size_t i = 0; i < rows_.size(); i++ ) {
+        rows_[i] = ring_.data() + ( clamp( first + (int)i, 0, heightIn_ - 1 ) % ringSize_ ) * widthOut_;
       }
+      filterVertical444to420( filter_.vertical_, rows_.data(), widthOut_, rowOut );
+      pulled_++;
+      return true;
     }
+
+   private:
+    const Filter444to420&     filter_;
+    const int                 widthIn_, heightIn_, widthOut_, heightOut_;
+    int                       position_, ringSize_, pushed_, pulled_;
+    std::vector<float>        padded_, ring_;
+    std::vector<const float*> rows_;
+  };
+
+  // Streams a 4:2:0 chroma plane row by row: the rows are pushed while needRow() is true, then the next 4:4:4 row
+  // is pulled.
+  class Upsampler {
+   public:
+    Upsampler( const size_t filter, const int widthIn, const int heightIn ) :
+        filter_( getFilter420to444( filter ) ),
+        widthIn_( widthIn ),
+        heightIn_( heightIn ),
+        pushed_( 0 ),
+        pulled_( 0 ) {
+      position0_ = int( filter_.horizontal0_.data_.size() + 1 ) >> 1;
+      position1_ = int( filter_.horizontal1_.data_.size() + 1 ) >> 1;
+      padding_   = ( std::max )( position0_, position1_ );
+      ringSize_  = int( filter_.vertical0_.data_.size() + filter_.vertical1_.data_.size() ) + 2;
+      padded_.resize( widthIn_ + 2 * padding_ + filter_.horizontal0_.data_.size() +
+                      filter_.horizontal1_.data_.size() + 16 );
+      ring_.resize( ringSize_ * widthIn_ );
+      rows_.resize( ( std::max )( filter_.vertical0_.data_.size(), filter_.vertical1_.data_.size() ) );
+    }
+    bool needRow() const {
+      const int     i        = pulled_ >> 1;
+      const Filter& vertical = pulled_ & 1 ? filter_.vertical1_ : filter_.vertical0_;
+      const int     last     = i + ( pulled_ & 1 ) + (int)vertical.data_.size() - 1 -
+                       ( int( vertical.data_.size() + 1 ) >> 1 );
+      return pushed_ < heightIn_ && pushed_ <= last;
+    }
+    float* getInputRow() { return ring_.data() + ( pushed_ % ringSize_ ) * widthIn_; }
+    void   pushRow() { pushed_++; }
+    void   pullRow( float* rowOut ) {
+      const int     i        = ( pulled_ >> 1 ) + ( pulled_ & 1 );
+      const Filter& vertical = pulled_ & 1 ? filter_.vertical1_ : filter_.vertical0_;
+      const int     first    = i - ( int( vertical.data_.size() + 1 ) >> 1 );
+      for ( size_t k = 0; k < vertical.data_.size(); k++ ) {
+        rows_[k] = ring_.data() + ( clamp( first + (int)k, 0, heightIn_ - 1 ) % ringSize_ ) * widthIn_;
+      }
+      float* row = padded_.data() + padding_;
+      filterVertical420to444( vertical, rows_.data(), widthIn_, row );
+      std::fill( padded_.begin(), padded_.begin() + padding_, row[0] );
+      std::fill( padded_.begin() + padding_ + widthIn_, padded_.end(), row[widthIn_ - 1] );
+      filterHorizontal420to444( filter_.horizontal0_, filter_.horizontal1_, row - position0_, row + 1 - position1_,
+                                widthIn_, rowOut );
+      pulled_++;
+    }
+
+   private:
+    const Filter420to444&     filter_;
+    const int                 widthIn_, heightIn_;
+    int                       position0_, position1_, padding_, ringSize_, pushed_, pulled_;
+    std::vector<float>        padded_, ring_;
+    std::vector<const float*> rows_;
+  };
+
+  void downsampling( const std::vector<float>& chroma_in,
+                     std::vector<float>&       chroma_out,
+                     const int                 widthIn,
+                     const int                 heightIn,
+                     const int                 maxValue,
+                     const size_t              filter ) const {
+    Downsampler downsampler( filter, widthIn, heightIn );
+    const int   widthOut = widthIn / 2;
+    chroma_out.resize( widthOut * ( heightIn / 2 ) );
+    float* rowOut = chroma_out.data();
+    for ( int i = 0; i < heightIn; i++ ) {
+      std::copy( chroma_in.begin() + i * widthIn, chroma_in.begin() + ( i + 1 ) * widthIn,
+                 downsampler.getInputRow() );
+      downsampler.pushRow();
+      while ( downsampler.pullRow( rowOut ) ) { rowOut += widthOut; }
+    }
+  }
+
+  void upsampling( const std::vector<float>& chromaIn,
+                   std::vector<float>&       chromaOut,
+                   const int                 widthIn,
+                   const int                 heightIn,
+                   const int                 maxValue,
+                   const size_t              filter ) const {
+    Upsampler upsampler( filter, widthIn, heightIn );
+    int       widthOut = widthIn * 2, heightOut = heightIn * 2, rowIn = 0;
+    chromaOut.resize( widthOut * heightOut );
     for ( int i = 0; i < heightOut; i++ ) {
-      for ( int j = 0; j < widthIn; j++ ) {
-        chromaOut[i * widthOut + j * 2] =
-            upsamplingHorizontal0( filter420to444[filter], temp, widthIn, heightOut, i, j + 0 );
-        chromaOut[i * widthOut + j * 2 + 1] =
-            upsamplingHorizontal1( filter420to444[filter], temp, widthIn, heightOut, i, j + 1 );
+      while ( upsampler.needRow() ) {
+        std::copy( chromaIn.begin() + rowIn * widthIn, chromaIn.begin() + ( rowIn + 1 ) * widthIn,
+                   upsampler.getInputRow() );
+        upsampler.pushRow();
+        rowIn++;
       }
+      upsampler.pullRow( chromaOut.data() + i * widthOut );
     }
   }
 
  private:
-  int          clamp( int v, int a, int b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
-  inline float downsamplingHorizontal( const Filter444to420&     filter,
-                                       const std::vector<float>& im,
-                                       const int                 width,
-                                       const int                 height,
-                                       const int                 i0,
-                                       const int                 j0 ) const {
-    const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.horizontal_.shift_ ) ) );
-    const float offset   = 0.00000000;
-    const int   position = int( filter.horizontal_.data_.size() - 1 ) >> 1;
-    double      value    = 0;
-    for ( int j = 0; j < (int)filter.horizontal_.data_.size(); j++ ) {
-      value +=
-          (double)filter.horizontal_.data_[j] * (double)( im[i0 * width + clamp( j0 + j - position, 0, width - 1 )] );
-    }
-    return (float)( ( value + (double)offset ) * (double)scale );
-  }
-  inline float downsamplingVertical( const Filter444to420&     filter,
-                                     const std::vector<float>& im,
-                                     const int                 width,
-                                     const int                 height,
-                                     const int                 i0,
-                                     const int                 j0 ) const {
-    const float offset   = 0;
-    const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.vertical_.shift_ ) ) );
-    const int   position = int( filter.vertical_.data_.size() - 1 ) >> 1;
-    ;
-    double value = 0;
-    for ( int i = 0; i < (int)filter.vertical_.data_.size(); i++ ) {
-      value +=
-          (double)filter.vertical_.data_[i] * (double)( im[clamp( i0 + i - position, 0, height - 1 ) * width + j0] );
-    }
-    return (float)( ( value + (double)offset ) * (double)scale );
-  }
-
-  inline float upsamplingVertical0( const Filter420to444&     filter,
-                                    const std::vector<float>& im,
-                                    const int                 width,
-                                    const int                 height,
-                                    const int                 i0,
-                                    const int                 j0 ) const {
-    const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.vertical0_.shift_ ) ) );
-    const float offset   = 0.00000000;
-    const int   position = int( filter.vertical0_.data_.size() + 1 ) >> 1;
-    float       value    = 0;
-    for ( int i = 0; i < (int)filter.vertical0_.data_.size(); i++ ) {
-      value += filter.vertical0_.data_[i] * (float)( im[clamp( i0 + i - position, 0, height - 1 ) * width + j0] );
-    }
-    return (float)( ( value + (float)offset ) * (float)scale );
-  }
-  inline float upsamplingVertical1( const Filter420to444&     filter,
-                                    const std::vector<float>& im,
-                                    int                       width,
-                                    int                       height,
-                                    int                       i0,
-                                    int                       j0 ) const {
-    const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.vertical1_.shift_ ) ) );
-    const float offset   = 0.00000000;
-    const int   position = int( filter.vertical1_.data_.size() + 1 ) >> 1;
-    float       value    = 0;
-    for ( int i = 0; i < (int)filter.vertical1_.data_.size(); i++ ) {
-      value += filter.vertical1_.data_[i] * (float)( im[clamp( i0 + i - position, 0, height - 1 ) * width + j0] );
-    }
-    return (float)( ( value + (float)offset ) * (float)scale );
-  }
-  inline float upsamplingHorizontal0( const Filter420to444&     filter,
-                                      const std::vector<float>& im,
-                                      int                       width,
-                                      int                       height,
-                                      int                       i0,
-                                      int                       j0 ) const {
-    const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.horizontal0_.shift_ ) ) );
-    const float offset   = 0.00000000;
-    const int   position = int( filter.horizontal0_.data_.size() + 1 ) >> 1;
-    float       value    = 0;
-    for ( int j = 0; j < (int)filter.horizontal0_.data_.size(); j++ ) {
-      value += filter.horizontal0_.data_[j] * (float)( im[i0 * width + clamp( j0 + j - position, 0, width - 1 )] );
-    }
-    return (float)( ( value + (float)offset ) * (float)scale );
-  }
-  inline float upsamplingHorizontal1( const Filter420to444&     filter,
-                                      const std::vector<float>& im,
-                                      int                       width,
-                                      int                       height,
-                                      int                       i0,
-                                      int                       j0 ) const {
-    const float scale    = 1.0f / ( (float)( 1 << ( (int)filter.horizontal1_.shift_ ) ) );
-    const float offset   = 0.00000000;
-    const int   position = int( filter.horizontal1_.data_.size() + 1 ) >> 1;
-    float       value    = 0;
-    for ( int j = 0; j < (int)filter.horizontal1_.data_.size(); j++ ) {
-      value += filter.horizontal1_.data_[j] * (float)( im[i0 * width + clamp( j0 + j - position, 0, width - 1 )] );
-    }
-    return (float)( ( value + (float)offset ) * (float)scale );
+  static int clamp( int v, int a, int b ) { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
+
+  // The kernels below vectorize over the output samples and keep the tap order and the precision of the reference
+  // filters (double accumulation for the 4:2:0 downsampling, float for the 4:4:4 upsampling): their results are bit
+  // exact. The input rows are padded by the callers, so that in[2 * j + k] is the tap k of the output sample j.
+  static void filterHorizontal444to420( const Filter& filter, const float* in, const int width, float* out ) {
+    const int    size  = (int)filter.data_.size();
+    const double scale = (double)( 1.0f / ( (float)( 1 << ( (int)filter.shift_ ) ) ) );
+    int          j     = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    const __m256i even = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+    for ( ; j + 4 <= width; j += 4 ) {
+      __m256d value = _mm256_setzero_pd();
+      for ( int k = 0; k < size; k++ ) {
+        const __m256 x = _mm256_permutevar8x32_ps( _mm256_loadu_ps( in + 2 * j + k ), even );
+        value          = _mm256_add_pd( value, _mm256_mul_pd( _mm256_set1_pd( (double)filter.data_[k] ),
+                                                     _mm256_cvtps_pd( _mm256_castps256_ps128( x ) ) ) );
+      }
+      _mm_storeu_ps( out + j, _mm256_cvtpd_ps( _mm256_mul_pd( value, _mm256_set1_pd( scale ) ) ) );
+    }
+#elif defined( PCC_IMAGE_SSE2 )
+    for ( ; j + 4 <= width; j += 4 ) {
+      __m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+      for ( int k = 0; k < size; k++ ) {
+        const __m128  x = _mm_shuffle_ps( _mm_loadu_ps( in + 2 * j + k ), _mm_loadu_ps( in + 2 * j + k + 4 ),
+                                         _MM_SHUFFLE( 2, 0, 2, 0 ) );
+        const __m128d c = _mm_set1_pd( (double)filter.data_[k] );
+        lo              = _mm_add_pd( lo, _mm_mul_pd( c, _mm_cvtps_pd( x ) ) );
+        hi              = _mm_add_pd( hi, _mm_mul_pd( c, _mm_cvtps_pd( _mm_movehl_ps( x, x ) ) ) );
+      }
+      _mm_storeu_ps( out + j, _mm_movelh_ps( _mm_cvtpd_ps( _mm_mul_pd( lo, _mm_set1_pd( scale ) ) ),
+                                             _mm_cvtpd_ps( _mm_mul_pd( hi, _mm_set1_pd( scale ) ) ) ) );
+    }
+#endif
+    for ( ; j < width; j++ ) {
+      double value = 0;
+      for ( int k = 0; k < size; k++ ) { value += (double)filter.data_[k] * (double)in[2 * j + k]; }
+      out[j] = (float)( value * scale );
+    }
+  }
+
+  static void filterVertical444to420( const Filter& filter, const float* const* in, const int width, float* out ) {
+    const int    size  = (int)filter.data_.size();
+    const double scale = (double)( 1.0f / ( (float)( 1 << ( (int)filter.shift_ ) ) ) );
+    int          j     = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    for ( ; j + 8 <= width; j += 8 ) {
+      __m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+      for ( int k = 0; k < size; k++ ) {
+        const __m256d c = _mm256_set1_pd( (double)filter.data_[k] );
+        lo              = _mm256_add_pd( lo, _mm256_mul_pd( c, _mm256_cvtps_pd( _mm_loadu_ps( in[k] + j ) ) ) );
+        hi              = _mm256_add_pd( hi, _mm256_mul_pd( c, _mm256_cvtps_pd( _mm_loadu_ps( in[k] + j + 4 ) ) ) );
+      }
+      _mm_storeu_ps( out + j, _mm256_cvtpd_ps( _mm256_mul_pd( lo, _mm256_set1_pd( scale ) ) ) );
+      _mm_storeu_ps( out + j + 4, _mm256_cvtpd_ps( _mm256_mul_pd( hi, _mm256_set1_pd( scale ) ) ) );
+    }
+#endif
+#if defined( PCC_IMAGE_SSE2 )
+    for ( ; j + 4 <= width; j += 4 ) {
+      __m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+      for ( int k = 0; k < size; k++ ) {
+        const __m128  x = _mm_loadu_ps( in[k] + j );
+        const __m128d c = _mm_set1_pd( (double)filter.data_[k] );
+        lo              = _mm_add_pd( lo, _mm_mul_pd( c, _mm_cvtps_pd( x ) ) );
+        hi              = _mm_add_pd( hi, _mm_mul_pd( c, _mm_cvtps_pd( _mm_movehl_ps( x, x ) ) ) );
+      }
+      _mm_storeu_ps( out + j, _mm_movelh_ps( _mm_cvtpd_ps( _mm_mul_pd( lo, _mm_set1_pd( scale ) ) ),
+                                             _mm_cvtpd_ps( _mm_mul_pd( hi, _mm_set1_pd( scale ) ) ) ) );
+    }
+#endif
+    for ( ; j < width; j++ ) {
+      double value = 0;
+      for ( int k = 0; k < size; k++ ) { value += (double)filter.data_[k] * (double)in[k][j]; }
+      out[j] = (float)( value * scale );
+    }
+  }
+
+  static void filterVertical420to444( const Filter& filter, const float* const* in, const int width, float* out ) {
+    const int   size  = (int)filter.data_.size();
+    const float scale = 1.0f / ( (float)( 1 << ( (int)filter.shift_ ) ) );
+    int         j     = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    for ( ; j + 8 <= width; j += 8 ) {
+      __m256 value = _mm256_setzero_ps();
+      for ( int k = 0; k < size; k++ ) {
+        value =
+            _mm256_add_ps( value, _mm256_mul_ps( _mm256_set1_ps( filter.data_[k] ), _mm256_loadu_ps( in[k] + j ) ) );
+      }
+      _mm256_storeu_ps( out + j, _mm256_mul_ps( value, _mm256_set1_ps( scale ) ) );
+    }
+#endif
+#if defined( PCC_IMAGE_SSE2 )
+    for ( ; j + 4 <= width; j += 4 ) {
+      __m128 value = _mm_setzero_ps();
+      for ( int k = 0; k < size; k++ ) {
+        value = _mm_add_ps( value, _mm_mul_ps( _mm_set1_ps( filter.data_[k] ), _mm_loadu_ps( in[k] + j ) ) );
+      }
+      _mm_storeu_ps( out + j, _mm_mul_ps( value, _mm_set1_ps( scale ) ) );
+    }
+#endif
+    for ( ; j < width; j++ ) {
+      float value = 0;
+      for ( int k = 0; k < size; k++ ) { value += filter.data_[k] * in[k][j]; }
+      out[j] = value * scale;
+    }
+  }
+
+  // in0[j + k] and in1[j + k] are the taps k of the output samples 2 * j and 2 * j + 1.
+  static void filterHorizontal420to444( const Filter& filter0,
+                                        const Filter& filter1,
+                                        const float*  in0,
+                                        const float*  in1,
+                                        const int     width,
+                                        float*        out ) {
+    const int   size0  = (int)filter0.data_.size();
+    const int   size1  = (int)filter1.data_.size();
+    const float scale0 = 1.0f / ( (float)( 1 << ( (int)filter0.shift_ ) ) );
+    const float scale1 = 1.0f / ( (float)( 1 << ( (int)filter1.shift_ ) ) );
+    int         j      = 0;
+#if defined( PCC_IMAGE_AVX2 )
+    for ( ; j + 8 <= width; j += 8 ) {
+      __m256 value0 = _mm256_setzero_ps(), value1 = _mm256_setzero_ps();
+      for ( int k = 0; k < size0; k++ ) {
+        value0 = _mm256_add_ps( value0,
+                                _mm256_mul_ps( _mm256_set1_ps( filter0.data_[k] ), _mm256_loadu_ps( in0 + j + k ) ) );
+      }
+      for ( int k = 0; k < size1; k++ ) {
+        value1 = _mm256_add_ps( value1,
+                                _mm256_mul_ps( _mm256_set1_ps( filter1.data_[k] ), _mm256_loadu_ps( in1 + j + k ) ) );
+      }
+      value0          = _mm256_mul_ps( value0, _mm256_set1_ps( scale0 ) );
+      value1          = _mm256_mul_ps( value1, _mm256_set1_ps( scale1 ) );
+      const __m256 lo = _mm256_unpacklo_ps( value0, value1 ), hi = _mm256_unpackhi_ps( value0, value1 );
+      _mm256_storeu_ps( out + 2 * j, _mm256_permute2f128_ps( lo, hi, 0x20 ) );
+      _mm256_storeu_ps( out + 2 * j + 8, _mm256_permute2f128_ps( lo, hi, 0x31 ) );
+    }
+#endif
+#if defined( PCC_IMAGE_SSE2 )
+    for ( ; j + 4 <= width; j += 4 ) {
+      __m128 value0 = _mm_setzero_ps(), value1 = _mm_setzero_ps();
+      for ( int k = 0; k < size0; k++ ) {
+        value0 = _mm_add_ps( value0, _mm_mul_ps( _mm_set1_ps( filter0.data_[k] ), _mm_loadu_ps( in0 + j + k ) ) );
+      }
+      for ( int k = 0; k < size1; k++ ) {
+        value1 = _mm_add_ps( value1, _mm_mul_ps( _mm_set1_ps( filter1.data_[k] ), _mm_loadu_ps( in1 + j + k ) ) );
+      }
+      value0 = _mm_mul_ps( value0, _mm_set1_ps( scale0 ) );
+      value1 = _mm_mul_ps( value1, _mm_set1_ps( scale1 ) );
+      _mm_storeu_ps( out + 2 * j, _mm_unpacklo_ps( value0, value1 ) );
+      _mm_storeu_ps( out + 2 * j + 4, _mm_unpackhi_ps( value0, value1 ) );
+    }
+#endif
+    for ( ; j < width; j++ ) {
+      float value0 = 0, value1 = 0;
+      for ( int k = 0; k < size0; k++ ) { value0 += filter0.data_[k] * in0[j + k]; }
+      for ( int k = 0; k < size1; k++ ) { value1 += filter1.data_[k] * in1[j + k]; }
+      out[2 * j]     = value0 * scale0;
+      out[2 * j + 1] = value1 * scale1;
+    }
   }
 };
 
@@ -530,6 +868,7 @@ class PCCImage {
   size_t getChannelCount() const { return N; }
 
   const std::vector<T>& getChannel( size_t index ) const { return channels_[index]; }
+  std::vector<T>&       getChannel( size_t index ) { return channels_[index]; }
   void                  set( const T value = 0 ) {
     for ( auto& channel : channels_ ) {
       for ( auto& p : channel ) { p = value; }
@@ -541,74 +880,61 @@ class PCCImage {
     const size_t size = sizeU0 * sizeV0;
     for ( auto& channel : channels_ ) { channel.resize( size ); }
   }
-  bool write420( std::ofstream& outfile, const size_t nbyte, bool convert = false, const size_t filter = 4 ) const {
+  bool write420( std::ostream& outfile, const size_t nbyte, bool convert = false, const size_t filter = 4 ) const {
     if ( !outfile.good() ) { return false; }
-    if ( convert ) {
-      std::vector<float> RGB444[3], YUV444[3], YUV420[3];
-      std::vector<T>     YUV420T[3];
-      ChromaSampler      chromaSampler;
-      RGBtoFloatRGB( channels_[0], RGB444[0], nbyte );
-      RGBtoFloatRGB( channels_[1], RGB444[1], nbyte );
-      RGBtoFloatRGB( channels_[2], RGB444[2], nbyte );
-      convertRGBToYUV( RGB444[0], RGB444[1], RGB444[2], YUV444[0], YUV444[1], YUV444[2] );
-      copy( YUV444[0], YUV420[0] );
-      chromaSampler.downsampling( YUV444[1], YUV420[1], (int)width_, (int)height_, nbyte == 1 ? 255 : 1023, filter );
-      chromaSampler.downsampling( YUV444[2], YUV420[2], (int)width_, (int)height_, nbyte == 1 ? 255 : 1023, filter );
-      floatYUVToYUV( YUV420[0], YUV420T[0], 0, nbyte );
-      floatYUVToYUV( YUV420[1], YUV420T[1], 1, nbyte );
-      floatYUVToYUV( YUV420[2], YUV420T[2], 1, nbyte );
-      outfile.write( (const char*)( YUV420T[0].data() ), width_ * height_ * ( nbyte == 1 ? 1 : sizeof( T ) ) );
-      outfile.write( (const char*)( YUV420T[1].data() ), width_ * height_ * ( nbyte == 1 ? 1 : sizeof( T ) ) / 4 );
-      outfile.write( (const char*)( YUV420T[2].data() ), width_ * height_ * ( nbyte == 1 ? 1 : sizeof( T ) ) / 4 );
-    } else {
-      if ( nbyte == 1 ) {
-        std::vector<uint8_t> channels[N];
-        for ( size_t i = 0; i < N; i++ ) {
-          channels[i].resize( channels_[i].size() );
-          ( std::copy )( channels_[i].begin(), channels_[i].end(), channels[i].begin() );
+    const size_t width2 = width_ / 2, height2 = height_ / 2;
+    if ( convert && N == 3 ) {
+      // the rows are converted and downsampled one at a time, only the 4:2:0 chroma planes are buffered.
+      const int                  width = (int)width_, height = (int)height_;
+      const float                maxValue = nbyte == 1 ? 255.f : 1023.f;
+      const double               offset   = nbyte == 1 ? 128. : 512.;
+      ColorConverter             converter;
+      ChromaSampler::Downsampler downsamplerU( filter, width, height ), downsamplerV( filter, width, height );
+      std::vector<float>         R( width ), G( width ), B( width ), Y( width ), chroma( width2 );
+      std::vector<T>             row( width ), U420( width2 * height2 ), V420( width2 * height2 );
+      T*                         u = U420.data();
+      T*                         v = V420.data();
+      for ( int i = 0; i < height; i++ ) {
+        toFloat( channels_[0].data() + i * width, R.data(), width );
+        toFloat( channels_[1].data() + i * width, G.data(), width );
+        toFloat( channels_[2].data() + i * width, B.data(), width );
+        converter.convertRGBToYUV( R.data(), G.data(), B.data(), Y.data(), downsamplerU.getInputRow(),
+                                   downsamplerV.getInputRow(), width, maxValue );
+        converter.quantize( Y.data(), Y.data(), width, maxValue, 0. );
+        fromFloat( Y.data(), row.data(), width );
+        writeSamples( outfile, row.data(), width, nbyte );
+        downsamplerU.pushRow();
+        downsamplerV.pushRow();
+        while ( downsamplerU.pullRow( chroma.data() ) ) {
+          converter.quantize( chroma.data(), chroma.data(), (int)width2, maxValue, offset );
+          fromFloat( chroma.data(), u, width2 );
+          u += width2;
         }
-        outfile.write( (const char*)( channels[0].data() ), width_ * height_ );
-        std::vector<uint8_t> chroma;
-        const size_t         width2     = width_ / 2;
-        const size_t         byteCount2 = width2;
-        chroma.resize( width2 );
-        for ( size_t c = 1; c < N; ++c ) {
-          const auto& channel = channels[c];
-          for ( size_t y = 0; y < height_; y += 2 ) {
-            const uint8_t* const buffer1 = channel.data() + y * width_;
-            const uint8_t* const buffer2 = buffer1 + width_;
-            for ( size_t x = 0; x < width_; x += 2 ) {
-              const size_t   x2  = x / 2;
-              const uint64_t sum = buffer1[x] + buffer1[x + 1] + buffer2[x] + buffer2[x + 1];
-              chroma[x2]         = uint8_t( ( sum + 2 ) / 4 );
-            }
-            outfile.write( (const char*)( chroma.data() ), byteCount2 );
-          }
+        while ( downsamplerV.pullRow( chroma.data() ) ) {
+          converter.quantize( chroma.data(), chroma.data(), (int)width2, maxValue, offset );
+          fromFloat( chroma.data(), v, width2 );
+          v += width2;
         }
-      } else {
-        outfile.write( (const char*)( channels_[0].data() ), width_ * height_ * sizeof( T ) );
-        std::vector<T> chroma;
-        const size_t   width2     = width_ / 2;
-        const size_t   byteCount2 = width2 * sizeof( T );
-        chroma.resize( width2 );
-        for ( size_t c = 1; c < N; ++c ) {
-          const auto& channel = channels_[c];
-          for ( size_t y = 0; y < height_; y += 2 ) {
-            const T* const buffer1 = channel.data() + y * width_;
-            const T* const buffer2 = buffer1 + width_;
-            for ( size_t x = 0; x < width_; x += 2 ) {
-              const size_t   x2  = x / 2;
-              const uint64_t sum = buffer1[x] + buffer1[x + 1] + buffer2[x] + buffer2[x + 1];
-              chroma[x2]         = T( ( sum + 2 ) / 4 );
-            }
-            outfile.write( (const char*)( chroma.data() ), byteCount2 );
+      }
+      writeSamples( outfile, U420.data(), U420.size(), nbyte );
+      writeSamples( outfile, V420.data(), V420.size(), nbyte );
+    } else {
+      writeSamples( outfile, channels_[0].data(), width_ * height_, nbyte );
+      std::vector<T> chroma( width2 );
+      for ( size_t c = 1; c < 3; ++c ) {
+        // single plane images are stored with null chroma planes.
+        for ( size_t y = 0; y < height_; y += 2 ) {
+          if ( c < N ) {
+            const T* const buffer1 = channels_[c].data() + y * width_;
+            average2x2( buffer1, buffer1 + width_, chroma.data(), width2 );
           }
+          writeSamples( outfile, chroma.data(), width2, nbyte );
         }
       }
     }
     return true;
   }
-  bool write( std::ofstream& outfile, const size_t nbyte ) const {
+  bool write( std::ostream& outfile, const size_t nbyte ) const {
     if ( !outfile.good() ) { return false; }
     if ( nbyte == 1 ) {
       std::vector<uint8_t> channels[N];
@@ -622,6 +948,10 @@ class PCCImage {
       const size_t byteCount = width_ * height_ * sizeof( T );
       for ( const auto& channel : channels_ ) { outfile.write( (const char*)( channel.data() ), byteCount ); }
     }
+    if ( N < 3 ) {
+      const std::vector<char> zero( width_ * height_ * ( nbyte == 1 ? 1 : sizeof( T ) ), 0 );
+      for ( size_t c = N; c < 3; ++c ) { outfile.write( zero.data(), zero.size() ); }
+    }
     return true;
   }
   bool write( const std::string fileName, const size_t nbyte ) const {
@@ -632,91 +962,71 @@ class PCCImage {
     }
     return false;
   }
-  bool read420( std::ifstream& infile,
-                const size_t   sizeU0,
-                const size_t   sizeV0,
-                const size_t   nbyte,
-                const bool     convert = false,
-                const size_t   filter  = 0 ) {
+  bool read420( std::istream& infile,
+                const size_t  sizeU0,
+                const size_t  sizeV0,
+                const size_t  nbyte,
+                const bool    convert = false,
+                const size_t  filter  = 0 ) {
     if ( !infile.good() ) { return false; }
     resize( sizeU0, sizeV0 );
-    if ( convert ) {
-      size_t             widthChroma  = width_ / 2;
-      size_t             heightChroma = height_ / 2;
-      std::vector<float> RGB444[3], YUV444[3], YUV420[3];
-      std::vector<T>     YUV420T[3];
-      ChromaSampler      chromaSampler;
-      YUV420T[0].resize( width_ * height_ );
-      YUV420T[1].resize( widthChroma * heightChroma );
-      YUV420T[2].resize( widthChroma * heightChroma );
-      infile.read( (char*)( YUV420T[0].data() ), width_ * height_ * ( nbyte == 1 ? 1 : sizeof( T ) ) );
-      infile.read( (char*)( YUV420T[1].data() ), widthChroma * heightChroma * ( nbyte == 1 ? 1 : sizeof( T ) ) );
-      infile.read( (char*)( YUV420T[2].data() ), widthChroma * heightChroma * ( nbyte == 1 ? 1 : sizeof( T ) ) );
-      YUVtoFloatYUV( YUV420T[0], YUV420[0], 0, nbyte );
-      YUVtoFloatYUV( YUV420T[1], YUV420[1], 1, nbyte );
-      YUVtoFloatYUV( YUV420T[2], YUV420[2], 1, nbyte );
-      copy( YUV420[0], YUV444[0] );
-      chromaSampler.upsampling( YUV420[1], YUV444[1], widthChroma, heightChroma, nbyte == 1 ? 255 : 1023, filter );
-      chromaSampler.upsampling( YUV420[2], YUV444[2], widthChroma, heightChroma, nbyte == 1 ? 255 : 1023, filter );
-      convertYUVToRGB( YUV444[0], YUV444[1], YUV444[2], RGB444[0], RGB444[1], RGB444[2] );
-      floatRGBToRGB( RGB444[0], channels_[0], nbyte );
-      floatRGBToRGB( RGB444[1], channels_[1], nbyte );
-      floatRGBToRGB( RGB444[2], channels_[2], nbyte );
-    } else {
-      if ( nbyte == 1 ) {
-        std::vector<uint8_t> channels[N];
-        for ( size_t i = 0; i < N; i++ ) { channels[i].resize( channels_[i].size() ); }
-        infile.read( (char*)( channels[0].data() ), width_ * height_ );
-        std::vector<uint8_t> chroma;
-        const size_t         width2     = width_ / 2;
-        const size_t         byteCount1 = width_;
-        const size_t         byteCount2 = width2;
-        chroma.resize( width2 );
-        for ( size_t c = 1; c < N; ++c ) {
-          auto& channel = channels[c];
-          for ( size_t y = 0; y < height_; y += 2 ) {
-            infile.read( (char*)( chroma.data() ), byteCount2 );
-            uint8_t* const buffer1 = channel.data() + y * width_;
-            uint8_t* const buffer2 = buffer1 + width_;
-            for ( size_t x2 = 0; x2 < width2; ++x2 ) {
-              const size_t  x     = x2 * 2;
-              const uint8_t value = chroma[x2];
-              buffer1[x]          = value;
-              buffer1[x + 1]      = value;
-            }
-            memcpy( (char*)buffer2, (char*)buffer1, byteCount1 );
-          }
+    const size_t width2 = width_ / 2, height2 = height_ / 2;
+    if ( convert && N == 3 ) {
+      // the luma plane is read in place, the output rows are upsampled and converted one at a time.
+      const int                width = (int)width_, height = (int)height_;
+      const float              maxValue = nbyte == 1 ? 255.f : 1023.f;
+      ColorConverter           converter;
+      ChromaSampler::Upsampler upsamplerU( filter, (int)width2, (int)height2 ),
+          upsamplerV( filter, (int)width2, (int)height2 );
+      std::vector<float> Y( width ), U( width ), V( width ), R( width ), G( width ), B( width );
+      std::vector<T>     U420( width2 * height2 ), V420( width2 * height2 );
+      readSamples( infile, channels_[0].data(), width_ * height_, nbyte );
+      readSamples( infile, U420.data(), U420.size(), nbyte );
+      readSamples( infile, V420.data(), V420.size(), nbyte );
+      const T* u = U420.data();
+      const T* v = V420.data();
+      for ( int i = 0; i < height; i++ ) {
+        while ( upsamplerU.needRow() ) {
+          toFloat( u, upsamplerU.getInputRow(), width2 );
+          converter.normalize( upsamplerU.getInputRow(), upsamplerU.getInputRow(), (int)width2, true, maxValue );
+          upsamplerU.pushRow();
+          u += width2;
         }
-        for ( size_t i = 0; i < N; i++ ) {
-          ( std::copy )( channels[i].begin(), channels[i].end(), channels_[i].begin() );
+        while ( upsamplerV.needRow() ) {
+          toFloat( v, upsamplerV.getInputRow(), width2 );
+          converter.normalize( upsamplerV.getInputRow(), upsamplerV.getInputRow(), (int)width2, true, maxValue );
+          upsamplerV.pushRow();
+          v += width2;
         }
-      } else {
-        infile.read( (char*)( channels_[0].data() ), width_ * height_ * sizeof( T ) );
-        std::vector<T> chroma;
-        const size_t   width2     = width_ / 2;
-        const size_t   byteCount1 = width_ * sizeof( T );
-        const size_t   byteCount2 = width2 * sizeof( T );
-        chroma.resize( width2 );
-        for ( size_t c = 1; c < N; ++c ) {
-          auto& channel = channels_[c];
-          for ( size_t y = 0; y < height_; y += 2 ) {
-            infile.read( (char*)( chroma.data() ), byteCount2 );
-            T* const buffer1 = channel.data() + y * width_;
-            T* const buffer2 = buffer1 + width_;
-            for ( size_t x2 = 0; x2 < width2; ++x2 ) {
-              const size_t x     = x2 * 2;
-              const T      value = chroma[x2];
-              buffer1[x]         = value;
-              buffer1[x + 1]     = value;
-            }
-            memcpy( (char*)buffer2, (char*)buffer1, byteCount1 );
+        upsamplerU.pullRow( U.data() );
+        upsamplerV.pullRow( V.data() );
+        toFloat( channels_[0].data() + i * width, Y.data(), width );
+        converter.normalize( Y.data(), Y.data(), width, false, maxValue );
+        converter.convertYUVToRGB( Y.data(), U.data(), V.data(), R.data(), G.data(), B.data(), width );
+        converter.quantize( R.data(), R.data(), width, maxValue, 0. );
+        converter.quantize( G.data(), G.data(), width, maxValue, 0. );
+        converter.quantize( B.data(), B.data(), width, maxValue, 0. );
+        fromFloat( R.data(), channels_[0].data() + i * width, width );
+        fromFloat( G.data(), channels_[1].data() + i * width, width );
+        fromFloat( B.data(), channels_[2].data() + i * width, width );
+      }
+    } else {
+      readSamples( infile, channels_[0].data(), width_ * height_, nbyte );
+      std::vector<T> chroma( width2 );
+      for ( size_t c = 1; c < 3; ++c ) {
+        for ( size_t y = 0; y < height_; y += 2 ) {
+          readSamples( infile, chroma.data(), width2, nbyte );
+          if ( c < N ) {
+            T* const buffer1 = channels_[c].data() + y * width_;
+            duplicate( chroma.data(), buffer1, width2 );
+            memcpy( (char*)( buffer1 + width_ ), (char*)buffer1, width_ * sizeof( T ) );
           }
         }
       }
     }
     return true;
   }
-  bool read( std::ifstream& infile, const size_t sizeU0, const size_t sizeV0, const size_t nbyte ) {
+  bool read( std::istream& infile, const size_t sizeU0, const size_t sizeV0, const size_t nbyte ) {
     if ( !infile.good() ) { return false; }
     resize( sizeU0, sizeV0 );
     if ( nbyte == 1 ) {
@@ -731,6 +1041,7 @@ class PCCImage {
       const size_t byteCount = width_ * height_ * sizeof( T );
       for ( auto& channel : channels_ ) { infile.read( (char*)( channel.data() ), byteCount ); }
     }
+    if ( N < 3 ) { infile.ignore( ( 3 - N ) * width_ * height_ * ( nbyte == 1 ? 1 : sizeof( T ) ) ); }
     return true;
   }
   bool read( const std::string fileName, const size_t sizeU0, const size_t sizeV0, const size_t nbyte ) {
@@ -846,95 +1157,101 @@ class PCCImage {
   }
 
  private:
-  T      clamp( T v, T a, T b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
-  int    clamp( int v, int a, int b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
-  float  clamp( float v, float a, float b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
-  double clamp( double v, double a, double b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
+  static inline T tMin( T a, T b ) { return ( ( a ) < ( b ) ) ? ( a ) : ( b ); }
+
+  void toFloat( const T* src, float* dst, const size_t count ) const {
+    for ( size_t i = 0; i < count; i++ ) { dst[i] = (float)src[i]; }
+  }
+  void fromFloat( const float* src, T* dst, const size_t count ) const {
+    for ( size_t i = 0; i < count; i++ ) { dst[i] = static_cast<T>( src[i] ); }
+  }
 
-  void copy( const std::vector<float>& src, std::vector<float>& dst ) const {
-    size_t count = src.size();
-    dst.resize( count );
-    for ( size_t i = 0; i < count; i++ ) { dst[i] = src[i]; }
-  }
-
-  void RGBtoFloatRGB( const std::vector<T>& src, std::vector<float>& dst, const size_t nbyte ) const {
-    size_t count = src.size();
-    dst.resize( count );
-    float offset = nbyte == 1 ? 255.f : 1023.f;
-    for ( size_t i = 0; i < count; i++ ) { dst[i] = (float)src[i] / offset; }
-  }
-  void convertRGBToYUV( const std::vector<float>& R,
-                        const std::vector<float>& G,
-                        const std::vector<float>& B,
-                        std::vector<float>&       Y,
-                        std::vector<float>&       U,
-                        std::vector<float>&       V ) const {
-    size_t count = R.size();
-    Y.resize( count );
-    U.resize( count );
-    V.resize( count );
-    for ( size_t i = 0; i < count; i++ ) {
-      Y[i] = (float)( (double)clamp( 0.212600 * R[i] + 0.715200 * G[i] + 0.072200 * B[i], 0.0, 1.0 ) );
-      U[i] = (float)( (double)clamp( -0.114572 * R[i] - 0.385428 * G[i] + 0.500000 * B[i], -0.5, 0.5 ) );
-      V[i] = (float)( (double)clamp( 0.500000 * R[i] - 0.454153 * G[i] - 0.045847 * B[i], -0.5, 0.5 ) );
-    }
-  }
-  static inline T     tMin( T a, T b ) { return ( ( a ) < ( b ) ) ? ( a ) : ( b ); }
-  static inline float fMin( float a, float b ) { return ( ( a ) < ( b ) ) ? ( a ) : ( b ); }
-  static inline float fMax( float a, float b ) { return ( ( a ) > ( b ) ) ? ( a ) : ( b ); }
-  static inline float fClip( float x, float low, float high ) { return fMin( fMax( x, low ), high ); }
-  void                floatYUVToYUV( const std::vector<float>& src,
-                                     std::vector<T>&           dst,
-                                     const bool                chroma,
-                                     const size_t              nbyte ) const {
-    size_t count = src.size();
-    dst.resize( count );
-    double offset = chroma ? nbyte == 1 ? 128. : 512. : 0;
-    double scale  = nbyte == 1 ? 255. : 1023.;
-    for ( size_t i = 0; i < count; i++ ) {
-      dst[i] = static_cast<T>( fClip( std::round( (float)( scale * (double)src[i] + offset ) ), 0.f, (float)scale ) );
-    }
-  }
-  void YUVtoFloatYUV( const std::vector<T>& src,
-                      std::vector<float>&   dst,
-                      const bool            chroma,
-                      const size_t          nbBytes ) const {
-    size_t count = src.size();
-    dst.resize( count );
-    float    minV   = chroma ? -0.5f : 0.f;
-    float    maxV   = chroma ? 0.5f : 1.f;
-    uint16_t offset = chroma ? nbBytes == 1 ? 128 : 512 : 0;
-    double   scale  = nbBytes == 1 ? 255. : 1023.;
-    double   weight = 1.0 / scale;
-    for ( size_t i = 0; i < count; i++ ) {
-      dst[i] = clamp( (float)( weight * (double)( src[i] - offset ) ), minV, maxV );
-    }
-  }
-
-  void convertYUVToRGB( const std::vector<float>& Y,
-                        const std::vector<float>& U,
-                        const std::vector<float>& V,
-                        std::vector<float>&       R,
-                        std::vector<float>&       G,
-                        std::vector<float>&       B ) const {
-    size_t count = Y.size();
-    R.resize( count );
-    G.resize( count );
-    B.resize( count );
-    for ( size_t i = 0; i < count; i++ ) {
-      R[i] = (float)( (double)clamp( Y[i] + 1.57480 * V[i], 0.0, 1.0 ) );
-      G[i] = (float)( (double)clamp( Y[i] - 0.18733 * U[i] - 0.46813 * V[i], 0.0, 1.0 ) );
-      B[i] = (float)( (double)clamp( Y[i] + 1.85563 * U[i], 0.0, 1.0 ) );
-    }
-  }
-  void floatRGBToRGB( const std::vector<float>& src, std::vector<T>& dst, const size_t nbyte ) const {
-    size_t count = src.size();
-    dst.resize( count );
-    float scale = nbyte == 1 ? 255.f : 1023.f;
-    for ( size_t i = 0; i < count; i++ ) {
-      dst[i] = static_cast<T>( clamp( (T)std::round( scale * src[i] ), (T)0, (T)scale ) );
+  // the samples are stored on one byte when nbyte == 1, on sizeof( T ) bytes otherwise.
+  void writeSamples( std::ostream& outfile, const T* src, const size_t count, const size_t nbyte ) const {
+    if ( nbyte == 1 && sizeof( T ) != 1 ) {
+      uint8_t buffer[4096];
+      for ( size_t i = 0; i < count; i += sizeof( buffer ) ) {
+        const size_t size = ( std::min )( count - i, sizeof( buffer ) );
+        for ( size_t k = 0; k < size; k++ ) { buffer[k] = (uint8_t)src[i + k]; }
+        outfile.write( (const char*)buffer, size );
+      }
+    } else {
+      outfile.write( (const char*)src, count * sizeof( T ) );
+    }
+  }
+  void readSamples( std::istream& infile, T* dst, const size_t count, const size_t nbyte ) {
+    if ( nbyte == 1 && sizeof( T ) != 1 ) {
+      uint8_t buffer[4096];
+      for ( size_t i = 0; i < count; i += sizeof( buffer ) ) {
+        const size_t size = ( std::min )( count - i, sizeof( buffer ) );
+        infile.read( (char*)buffer, size );
+        for ( size_t k = 0; k < size; k++ ) { dst[i + k] = buffer[k]; }
+      }
+    } else {
+      infile.read( (char*)dst, count * sizeof( T ) );
+    }
+  }
+
+  // dst[x] is the rounded mean of the 2x2 block of row1 and row2 at column 2 * x.
+  template <typename S>
+  static void average2x2( const S* row1, const S* row2, S* dst, const size_t width2, size_t x2 = 0 ) {
+    for ( ; x2 < width2; x2++ ) {
+      const uint64_t sum = row1[2 * x2] + row1[2 * x2 + 1] + row2[2 * x2] + row2[2 * x2 + 1];
+      dst[x2]            = S( ( sum + 2 ) / 4 );
+    }
+  }
+  template <typename S>
+  static void duplicate( const S* src, S* dst, const size_t width2, size_t x2 = 0 ) {
+    for ( ; x2 < width2; x2++ ) { dst[2 * x2] = dst[2 * x2 + 1] = src[x2]; }
+  }
+#if defined( PCC_IMAGE_SSE2 )
+  static void average2x2( const uint8_t* row1, const uint8_t* row2, uint8_t* dst, const size_t width2 ) {
+    const __m128i mask = _mm_set1_epi16( 0x00FF ), two = _mm_set1_epi16( 2 );
+    size_t        x2   = 0;
+    for ( ; x2 + 8 <= width2; x2 += 8 ) {
+      const __m128i a   = _mm_loadu_si128( (const __m128i*)( row1 + 2 * x2 ) );
+      const __m128i b   = _mm_loadu_si128( (const __m128i*)( row2 + 2 * x2 ) );
+      __m128i       sum = _mm_add_epi16( _mm_add_epi16( _mm_and_si128( a, mask ), _mm_srli_epi16( a, 8 ) ),
+                                   _mm_add_epi16( _mm_and_si128( b, mask ), _mm_srli_epi16( b, 8 ) ) );
+      sum               = _mm_srli_epi16( _mm_add_epi16( sum, two ), 2 );
+      _mm_storel_epi64( (__m128i*)( dst + x2 ), _mm_packus_epi16( sum, sum ) );
+    }
+    average2x2<uint8_t>( row1, row2, dst, width2, x2 );
+  }
+  static void average2x2( const uint16_t* row1, const uint16_t* row2, uint16_t* dst, const size_t width2 ) {
+    const __m128i mask = _mm_set1_epi32( 0xFFFF ), two = _mm_set1_epi32( 2 );
+    size_t        x2   = 0;
+    for ( ; x2 + 4 <= width2; x2 += 4 ) {
+      const __m128i a   = _mm_loadu_si128( (const __m128i*)( row1 + 2 * x2 ) );
+      const __m128i b   = _mm_loadu_si128( (const __m128i*)( row2 + 2 * x2 ) );
+      __m128i       sum = _mm_add_epi32( _mm_add_epi32( _mm_and_si128( a, mask ), _mm_srli_epi32( a, 16 ) ),
+                                   _mm_add_epi32( _mm_and_si128( b, mask ), _mm_srli_epi32( b, 16 ) ) );
+      sum               = _mm_srli_epi32( _mm_add_epi32( sum, two ), 2 );
+      // the means fit on 16 bits: sign extending them lets the signed saturation of the packing keep them.
+      sum = _mm_srai_epi32( _mm_slli_epi32( sum, 16 ), 16 );
+      _mm_storel_epi64( (__m128i*)( dst + x2 ), _mm_packs_epi32( sum, sum ) );
+    }
+    average2x2<uint16_t>( row1, row2, dst, width2, x2 );
+  }
+  static void duplicate( const uint8_t* src, uint8_t* dst, const size_t width2 ) {
+    size_t x2 = 0;
+    for ( ; x2 + 16 <= width2; x2 += 16 ) {
+      const __m128i v = _mm_loadu_si128( (const __m128i*)( src + x2 ) );
+      _mm_storeu_si128( (__m128i*)( dst + 2 * x2 ), _mm_unpacklo_epi8( v, v ) );
+      _mm_storeu_si128( (__m128i*)( dst + 2 * x2 + 16 ), _mm_unpackhi_epi8( v, v ) );
+    }
+    duplicate<uint8_t>( src, dst, width2, x2 );
+  }
+  static void duplicate( const uint16_t* src, uint16_t* dst, const size_t width2 ) {
+    size_t x2 = 0;
+    for ( ; x2 + 8 <= width2; x2 += 8 ) {
+      const __m128i v = _mm_loadu_si128( (const __m128i*)( src + x2 ) );
+      _mm_storeu_si128( (__m128i*)( dst + 2 * x2 ), _mm_unpacklo_epi16( v, v ) );
+      _mm_storeu_si128( (__m128i*)( dst + 2 * x2 + 8 ), _mm_unpackhi_epi16( v, v ) );
     }
+    duplicate<uint16_t>( src, dst, width2, x2 );
   }
+#endif
 
   size_t         width_;
   size_t         height_;
@@ -72,21 +72,106 @@ class PCCNNResult {
   std::vector<double> dist_;
 };
 
+// Results of a batched query, stored in flat arrays owned by the caller: the neighbours of query i are
+// indices( i )[0] ... indices( i )[count( i ) - 1], sorted by increasing squared distance dist( i )[...].
+// The arrays only grow, so a result reused across batches does not allocate once it has reached its size.
+class PCCNNBatchResult {
+ public:
+  PCCNNBatchResult() : maxResults_( 0 ) {}
+  ~PCCNNBatchResult() = default;
+  void resize( const size_t queryCount, const size_t maxResults ) {
+    maxResults_ = maxResults;
+    counts_.resize( queryCount );
+    indices_.resize( queryCount * maxResults );
+    dist_.resize( queryCount * maxResults );
+  }
+  inline size_t          getQueryCount() const { return counts_.size(); }
+  inline size_t          getMaxResults() const { return maxResults_; }
+  inline size_t          count( size_t query ) const { return counts_[query]; }
+  inline const uint32_t* indices( size_t query ) const { return indices_.data() + query * maxResults_; }
+  inline const float*    dist( size_t query ) const { return dist_.data() + query * maxResults_; }
+  inline uint32_t&       count( size_t query ) { return counts_[query]; }
+  inline uint32_t*       indices( size_t query ) { return indices_.data() + query * maxResults_; }
+  inline float*          dist( size_t query ) { return dist_.data() + query * maxResults_; }
+
+ private:
+  size_t                maxResults_;
+  std::vector<uint32_t> counts_;
+  std::vector<uint32_t> indices_;
+  std::vector<float>    dist_;
+};
+
+// Spatial index behind PCCKdTree. The voxel grid is exact for integer positions and orders equidistant neighbours
+// by index: its radius searches equal the kd-tree ones, while tied kNN results may come in a different order.
+enum PCCSpatialIndexType { PCC_SPATIAL_INDEX_KDTREE = 0, PCC_SPATIAL_INDEX_VOXEL_GRID = 1 };
+
 class PCCKdTree {
  public:
   PCCKdTree();
-  PCCKdTree( const PCCPointSet3& pointCloud );
+  PCCKdTree( const PCCPointSet3& pointCloud, const PCCSpatialIndexType type = PCC_SPATIAL_INDEX_KDTREE );
   ~PCCKdTree();
-  void init( const PCCPointSet3& pointCloud );
+  void init( const PCCPointSet3& pointCloud, const PCCSpatialIndexType type = PCC_SPATIAL_INDEX_KDTREE );
   void search( const PCCPoint3D& point, const size_t num_results, PCCNNResult& results ) const;
+  // The num_results nearest points strictly inside radius, by increasing distance and, for equidistant points, by
+  // increasing index.
   void searchRadius( const PCCPoint3D& point,
                      const size_t      num_results,
                      const double      radius,
                      PCCNNResult&      results ) const;
+  // The first num_results points of the nanoflann radius search: every point strictly inside radius is collected
+  // and sorted by distance only, so equidistant points keep the kd-tree traversal order. The reconstruction and
+  // colour smoothing use this selection, which the reference decoders reproduce; kd-tree index only.
+  void searchRadiusSorted( const PCCPoint3D& point,
+                           const size_t      num_results,
+                           const double      radius,
+                           PCCNNResult&      results ) const;
+  // All the points at the smallest distance from point, at most num_results of them by increasing index, found in
+  // a single traversal.
+  void searchNearestTies( const PCCPoint3D& point, const size_t num_results, PCCNNResult& results ) const;
+
+  // Batched queries for the points [start, end) of queries, run in parallel on nbThread threads; the results of
+  // point i are stored at index i - start. They match the single point search(), searchRadius() and
+  // searchRadiusSorted().
+  void search( const PCCPointSet3& queries,
+               const size_t        start,
+               const size_t        end,
+               const size_t        num_results,
+               PCCNNBatchResult&   results,
+               const size_t        nbThread ) const;
+  void searchRadius( const PCCPointSet3& queries,
+                     const size_t        start,
+                     const size_t        end,
+                     const size_t        num_results,
+                     const double        radius,
+                     PCCNNBatchResult&   results,
+                     const size_t        nbThread ) const;
+  void searchRadiusSorted( const PCCPointSet3& queries,
+                           const size_t        start,
+                           const size_t        end,
+                           const size_t        num_results,
+                           const double        radius,
+                           PCCNNBatchResult&   results,
+                           const size_t        nbThread ) const;
 
  private:
-  void  clear();
-  void* kdtree_;
+  size_t knnSearch( const PCCPoint3D& point, const size_t num_results, size_t* indices, double* dists ) const;
+  size_t radiusSearch( const PCCPoint3D& point,
+                       const size_t      num_results,
+                       const double      radius,
+                       const bool        sorted,
+                       size_t*           indices,
+                       double*           dists ) const;
+  void   radiusSearch( const PCCPointSet3& queries,
+                       const size_t        start,
+                       const size_t        end,
+                       const size_t        num_results,
+                       const double        radius,
+                       const bool          sorted,
+                       PCCNNBatchResult&   results,
+                       const size_t        nbThread ) const;
+  void   clear();
+  void*  kdtree_;
+  void*  grid_;
 };
 
 }  // namespace pcc
@@ -0,0 +1,137 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCOccupancyModel_h
+#define PCCOccupancyModel_h
+
+#include "PCCCommon.h"
+
+namespace pcc {
+
+// One axis of a tile: the model is run on [window_, window_ + windowSize) and only [begin_, end_) is kept.
+struct PCCOccupancyModelTile {
+  size_t window_;
+  size_t begin_;
+  size_t end_;
+};
+
+// Splits [0, size) in tiles whose windows of windowSize pixels are kept inside [0, size), so that the model sees the
+// same borders as with whole frames and each kept pixel is at least halo pixels away from the other window edges.
+// The window origins and windowSize are multiples of stride, the total stride of the model (product of its pooling
+// and strided convolution factors): its downsampled grids then match the ones of the whole frame. A tiled inference
+// gives the whole frame result when halo is at least the receptive field radius of the model, counted in input pixels
+// and including the block alignment of its downsampled layers. Sizes that are not a multiple of stride are inferred as
+// a whole, since the partial last block of the frame can't be aligned.
+void getOccupancyModelTiles( const size_t                        size,
+                             const size_t                        tileSize,
+                             const size_t                        halo,
+                             const size_t                        stride,
+                             size_t&                             windowSize,
+                             std::vector<PCCOccupancyModelTile>& tiles );
+
+};  // namespace pcc
+
+#if OCCUPANCY_MAP_MODEL
+#include <torch/script.h>
+#include <array>
+#include <mutex>
+#include <set>
+
+namespace pcc {
+
+struct PCCOccupancyModelParameters {
+  std::string modelName_;
+  size_t      nbThread_;
+  size_t      tileSize_;     // side of the stitched tiles (0: whole frames)
+  size_t      tileHalo_;     // margin added around the tiles, at least the receptive field radius of the model
+  size_t      tileStride_;   // total stride of the model, the tile windows are aligned on it
+};
+
+// Inference settings returned by PCCOccupancyModel::load() for the shapes of one call.
+struct PCCOccupancyModelSettings {
+  torch::DeviceType device_;
+  bool              useGeometry_;
+};
+
+// TorchScript occupancy map refinement session. The module is deserialized and switched to inference mode once, and
+// warmed up once per inferred shape, then shared by all the groups of frames of the encoder/decoder, which may run
+// concurrently: the session state is only accessed under its mutex and each caller uses the settings returned by its
+// own load() call.
+class PCCOccupancyModel {
+ public:
+  PCCOccupancyModel();
+  ~PCCOccupancyModel();
+
+  // width and height are the occupancy sizes of the inferred frames or tile windows.
+  bool load( const PCCOccupancyModelParameters& params,
+             const size_t                       width,
+             const size_t                       height,
+             const size_t                       geometryWidth,
+             const size_t                       geometryHeight,
+             PCCOccupancyModelSettings&         settings );
+
+  at::Tensor forward( std::vector<torch::jit::IValue>& inputs );
+
+  bool isLoaded();
+
+ private:
+  typedef std::array<size_t, 4> Shape;  // width, height, geometry width, geometry height
+
+  void setThreadCount( const size_t nbThread );
+  void warmUp( const Shape& shape );
+
+  std::mutex                 mutex_;
+  torch::jit::script::Module module_;
+  torch::DeviceType          device_;
+  std::string                modelName_;
+  bool                       loaded_;
+  bool                       useGeometry_;
+  std::set<Shape>            warmedUpShapes_;
+};
+
+// Tensor bound in place to a window of an image plane of planeWidth samples per row, without copy: the plane must
+// outlive the tensor and 16 bits samples are seen as signed values.
+template <typename T>
+at::Tensor createTensorView( const T*     plane,
+                             const size_t planeWidth,
+                             const size_t x,
+                             const size_t y,
+                             const size_t width,
+                             const size_t height ) {
+  return torch::from_blob( const_cast<T*>( plane ) + y * planeWidth + x, {(int64_t)height, (int64_t)width},
+                           {(int64_t)planeWidth, 1}, torch::dtype( sizeof( T ) == 1 ? at::kByte : at::kShort ) );
+}
+
+};  // namespace pcc
+
+#endif
+#endif /* PCCOccupancyModel_h */
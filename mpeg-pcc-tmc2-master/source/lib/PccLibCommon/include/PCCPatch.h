@@ -393,12 +393,12 @@ class PCCPatch {
     return int( x + canvasStrideBlk * y );
   }
 
-  bool checkFitPatchCanvas( std::vector<bool> canvas,
-                            size_t            canvasStrideBlk,
-                            size_t            canvasHeightBlk,
-                            bool              bPrecedence,
-                            int               safeguard = 0,
-                            const Tile        tile      = Tile() ) {
+  bool checkFitPatchCanvas( const std::vector<bool>& canvas,
+                            size_t                   canvasStrideBlk,
+                            size_t                   canvasHeightBlk,
+                            bool                     bPrecedence,
+                            int                      safeguard = 0,
+                            const Tile               tile      = Tile() ) {
     for ( size_t v0 = 0; v0 < getSizeV0(); ++v0 ) {
       for ( size_t u0 = 0; u0 < getSizeU0(); ++u0 ) {
         for ( int deltaY = -safeguard; deltaY < safeguard + 1; deltaY++ ) {
@@ -776,11 +776,11 @@ class PCCPatch {
     return int( x + canvasStrideBlk * y );
   }
 
-  bool checkFitPatchCanvasForGPA( std::vector<bool> canvas,
-                                  size_t            canvasStrideBlk,
-                                  size_t            canvasHeightBlk,
-                                  bool              bPrecedence,
-                                  int               safeguard = 0 ) {
+  bool checkFitPatchCanvasForGPA( const std::vector<bool>& canvas,
+                                  size_t                   canvasStrideBlk,
+                                  size_t                   canvasHeightBlk,
+                                  bool                     bPrecedence,
+                                  int                      safeguard = 0 ) {
     for ( size_t v0 = 0; v0 < curGPAPatchData_.sizeV0; ++v0 ) {
       for ( size_t u0 = 0; u0 < curGPAPatchData_.sizeU0; ++u0 ) {
         for ( int deltaY = -safeguard; deltaY < safeguard + 1; deltaY++ ) {
@@ -958,7 +958,7 @@ class PCCPatch {
 
   void setLocalData( const std::vector<uint8_t>&  occupancyMapVideo,
                      const std::vector<uint16_t>& geometryVideo,
-                     std::vector<size_t>&         blockToPatch,
+                     std::vector<uint32_t>&       blockToPatch,
                      const int32_t                width,
                      const int32_t                height,
                      const int32_t                occupancyPrecision,
@@ -1181,8 +1181,8 @@ class PatchBlockFiltering {
   ~PatchBlockFiltering() {}
 
   inline void setPatches( std::vector<PCCPatch>* patches ) { patches_ = patches; }
-  inline void setBlockToPatch( std::vector<size_t>* value ) { blockToPatch_ = value; }
-  inline void setOccupancyMapEncoder( std::vector<uint32_t>* value ) { occupancyMapEncoder_ = value; }
+  inline void setBlockToPatch( std::vector<uint32_t>* value ) { blockToPatch_ = value; }
+  inline void setOccupancyMapEncoder( std::vector<uint16_t>* value ) { occupancyMapEncoder_ = value; }
   inline void setOccupancyMapVideo( const std::vector<uint8_t>* value ) { occupancyMapVideo_ = value; }
   inline void setGeometryVideo( const std::vector<uint16_t>* value ) { geometryVideo_ = value; }
 
@@ -1216,8 +1216,8 @@ class PatchBlockFiltering {
 
  private:
   std::vector<PCCPatch>*       patches_;
-  std::vector<size_t>*         blockToPatch_;
-  std::vector<uint32_t>*       occupancyMapEncoder_;
+  std::vector<uint32_t>*       blockToPatch_;
+  std::vector<uint16_t>*       occupancyMapEncoder_;
   const std::vector<uint8_t>*  occupancyMapVideo_;
   const std::vector<uint16_t>* geometryVideo_;
 };
@@ -43,7 +43,9 @@ class PCCPointSet3 {
  public:
   PCCPointSet3() : withNormals_( false ), withColors_( false ), withReflectances_( false ) {}
   PCCPointSet3( const PCCPointSet3& ) = default;
+  PCCPointSet3( PCCPointSet3&& )      = default;
   PCCPointSet3& operator=( const PCCPointSet3& rhs ) = default;
+  PCCPointSet3& operator=( PCCPointSet3&& rhs )      = default;
   ~PCCPointSet3()                                    = default;
 
   PCCPoint3D operator[]( const size_t index ) const {
@@ -167,13 +169,17 @@ class PCCPointSet3 {
                        double        maxColorDist2Fwd                        = 10000.0,
                        double        maxColorDist2Bwd                        = 10000.0,
                        const bool    excludeColorOutlier                     = false,
-                       const double  thresholdColorOutlierDist               = 10.0 ) const;
+                       const double  thresholdColorOutlierDist               = 10.0,
+                       const size_t  nbThread                                = 1 ) const;
 
-  bool transferColorsFilter3( PCCPointSet3& target, const int32_t searchRange, const bool losslessTexture ) const;
+  bool transferColorsFilter3( PCCPointSet3& target,
+                              const int32_t searchRange,
+                              const bool    losslessTexture,
+                              const size_t  nbThread = 1 ) const;
 
-  bool transferColorSimple( PCCPointSet3& target, const double bestColorSearchStep = 0.1 );
+  bool transferColorSimple( PCCPointSet3& target, const double bestColorSearchStep = 0.1, const size_t nbThread = 1 );
 
-  bool transferColorWeight( PCCPointSet3& target, const double bestColorSearchStep = 0.1 );
+  bool transferColorWeight( PCCPointSet3& target, const double bestColorSearchStep = 0.1, const size_t nbThread = 1 );
 
   size_t getPointCount() const { return positions_.size(); }
   void   resize( const size_t size ) {
@@ -193,6 +199,12 @@ class PCCPointSet3 {
     boundaryPointTypes_.reserve( size );
     pointPatchIndexes_.reserve( size );
   }
+  size_t getMemorySize() const {
+    return positions_.capacity() * sizeof( PCCPoint3D ) + colors_.capacity() * sizeof( PCCColor3B ) +
+           reflectances_.capacity() * sizeof( uint16_t ) + types_.capacity() * sizeof( uint8_t ) +
+           boundaryPointTypes_.capacity() * sizeof( uint16_t ) + pointPatchIndexes_.capacity() * sizeof( uint16_t ) +
+           normals_.capacity() * sizeof( PCCNormal3D );
+  }
   void clear() {
     positions_.clear();
     colors_.clear();
@@ -284,7 +296,7 @@ class PCCPointSet3 {
   void convertRGBToYUVClosedLoop();
   void convertYUVToRGB();
 
-  void removeDuplicate();
+  void removeDuplicate( const size_t nbThread = 1 );
   void distanceGeo( const PCCPointSet3& pointcloud, float& distPAB, float& distPBA ) const;
   void distanceGeoColor( const PCCPointSet3& pointcloud,
                          float&              distPAB,
@@ -296,13 +308,15 @@ class PCCPointSet3 {
                          float&              distVAB,
                          float&              distVBA ) const;
 
-  void                 removeDuplicate( PCCPointSet3& newPointcloud, size_t dropDuplicates ) const;
+  void                 removeDuplicate( PCCPointSet3& newPointcloud,
+                                        size_t        dropDuplicates,
+                                        const size_t  nbThread = 1 ) const;
   void                 copyNormals( const PCCPointSet3& sourceWithNormal );
   void                 scaleNormals( const PCCPointSet3& sourceWithNormal );
   std::vector<uint8_t> computeChecksum( bool reorderPoints = false );
   void                 sortColor( std::vector<size_t>& list );
-  void                 reorder();
-  void                 reorder( PCCPointSet3& newPointcloud, bool dropDuplicates );
+  void                 reorder( const size_t nbThread = 1 );
+  void                 reorder( PCCPointSet3& newPointcloud, bool dropDuplicates, const size_t nbThread = 1 );
   void                 swap( PCCPointSet3& newPointcloud );
 
  private:
@@ -331,6 +345,49 @@ class PCCPointSet3 {
   bool                     withColors_;
   bool                     withReflectances_;
 };
+
+// Bulk append of points to a PCCPointSet3. The point set is sized once from the estimated point count instead of
+// growing all its attribute arrays point by point as addPoint() does; the attributes of the added points are then
+// written in place with the setters of the point set, and commit() trims it to the points actually added. Until the
+// commit the point count of the point set includes the unused slots, the builder gives the number of added points.
+class PCCPointSetBuilder {
+ public:
+  PCCPointSetBuilder( PCCPointSet3& pointSet, const size_t estimatedCount ) :
+      pointSet_( pointSet ),
+      count_( pointSet.getPointCount() ),
+      committed_( false ) {
+    pointSet_.resize( count_ + estimatedCount );
+  }
+  ~PCCPointSetBuilder() { commit(); }
+  size_t addPoint( const PCCPoint3D& position ) {
+    const size_t index = nextIndex();
+    pointSet_[index]   = position;
+    return index;
+  }
+  size_t addPoint( const PCCVector3D& position ) {
+    const size_t index  = nextIndex();
+    pointSet_[index][0] = (int16_t)position[0];
+    pointSet_[index][1] = (int16_t)position[1];
+    pointSet_[index][2] = (int16_t)position[2];
+    return index;
+  }
+  size_t getPointCount() const { return count_; }
+  void   commit() {
+    if ( !committed_ ) { pointSet_.resize( count_ ); }
+    committed_ = true;
+  }
+
+ private:
+  size_t nextIndex() {
+    assert( !committed_ );
+    // the estimate was too small
+    if ( count_ == pointSet_.getPointCount() ) { pointSet_.resize( ( std::max )( 2 * count_, size_t( 1024 ) ) ); }
+    return count_++;
+  }
+  PCCPointSet3& pointSet_;
+  size_t        count_;
+  bool          committed_;
+};
 }  // namespace pcc
 
 #endif /* PCCPointSet_h */
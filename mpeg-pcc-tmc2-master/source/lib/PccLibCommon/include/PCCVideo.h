@@ -62,7 +62,7 @@ class PCCVideo {
     return frames_[index];
   }
   void resize( const size_t frameCount ) { frames_.resize( frameCount ); }
-  bool write( std::ofstream& outfile, const size_t nbyte ) const {
+  bool write( std::ostream& outfile, const size_t nbyte ) const {
     for ( const auto& frame : frames_ ) {
       if ( !frame.write( outfile, nbyte ) ) { return false; }
     }
@@ -77,7 +77,7 @@ class PCCVideo {
     return false;
   }
 
-  bool write420( std::ofstream& outfile, const size_t nbyte, bool convert, const size_t filter ) const {
+  bool write420( std::ostream& outfile, const size_t nbyte, bool convert, const size_t filter ) const {
     for ( const auto& frame : frames_ ) {
       if ( !frame.write420( outfile, nbyte, convert, filter ) ) { return false; }
     }
@@ -93,7 +93,7 @@ class PCCVideo {
     return false;
   }
 
-  bool write420( std::ofstream& outfile, const size_t nbyte ) const {
+  bool write420( std::ostream& outfile, const size_t nbyte ) const {
     for ( const auto& frame : frames_ ) {
       if ( !frame.write420( outfile, nbyte ) ) { return false; }
     }
@@ -107,11 +107,11 @@ class PCCVideo {
     }
     return false;
   }
-  bool read( std::ifstream& infile,
-             const size_t   sizeU0,
-             const size_t   sizeV0,
-             const size_t   frameCount,
-             const size_t   nbyte ) {
+  bool read( std::istream& infile,
+             const size_t  sizeU0,
+             const size_t  sizeV0,
+             const size_t  frameCount,
+             const size_t  nbyte ) {
     frames_.resize( frameCount );
     for ( auto& frame : frames_ ) {
       if ( !frame.read( infile, sizeU0, sizeV0, nbyte ) ) { return false; }
@@ -130,13 +130,13 @@ class PCCVideo {
     }
     return false;
   }
-  bool read420( std::ifstream& infile,
-                const size_t   sizeU0,
-                const size_t   sizeV0,
-                const size_t   frameCount,
-                const size_t   nbyte,
-                const bool     convert,
-                const size_t   filter ) {
+  bool read420( std::istream& infile,
+                const size_t  sizeU0,
+                const size_t  sizeV0,
+                const size_t  frameCount,
+                const size_t  nbyte,
+                const bool    convert,
+                const size_t  filter ) {
     frames_.resize( frameCount );
     for ( auto& frame : frames_ ) {
       if ( !frame.read420( infile, sizeU0, sizeV0, nbyte, convert, filter ) ) { return false; }
@@ -158,11 +158,11 @@ class PCCVideo {
     return false;
   }
 
-  bool read420( std::ifstream& infile,
-                const size_t   sizeU0,
-                const size_t   sizeV0,
-                const size_t   frameCount,
-                const size_t   nbyte ) {
+  bool read420( std::istream& infile,
+                const size_t  sizeU0,
+                const size_t  sizeV0,
+                const size_t  frameCount,
+                const size_t  nbyte ) {
     frames_.resize( frameCount );
     for ( auto& frame : frames_ ) {
       if ( !frame.read420( infile, sizeU0, sizeV0, nbyte ) ) { return false; }
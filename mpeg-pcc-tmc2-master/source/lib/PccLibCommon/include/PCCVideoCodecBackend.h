@@ -0,0 +1,119 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCVideoCodecBackend_h
+#define PCCVideoCodecBackend_h
+
+#include "PCCCommon.h"
+#include "PCCVideoBitstream.h"
+
+namespace pcc {
+
+struct PCCVideoCodecParameters {
+  std::string fileName_;  // prefix of the intermediate files (path + video type)
+  std::string path_;      // location of the 3D motion estimation files
+  std::string codecPath_;
+  std::string codecConfig_;
+  std::string modelName_;
+  size_t      width_;
+  size_t      height_;
+  size_t      frameCount_;
+  size_t      nbyte_;
+  size_t      internalBitDepth_;
+  int         qp_;
+  bool        use444CodecIo_;
+  bool        use3dmv_;
+  bool        keepIntermediateFiles_;
+};
+
+// Codec used for the occupancy, geometry and texture videos. The codec input and the reconstruction are planar
+// 4:2:0 (or 4:4:4 when use444CodecIo_ is set) sample streams, exactly as they would be stored in a .yuv/.rgb file.
+class PCCVideoCodecBackend {
+ public:
+  PCCVideoCodecBackend() {}
+  virtual ~PCCVideoCodecBackend() {}
+  virtual bool encode( std::istream&                  source,
+                       const PCCVideoCodecParameters& params,
+                       PCCVideoBitstream&             bitstream,
+                       std::ostream&                  reconstruction ) = 0;
+  virtual bool decode( PCCVideoBitstream&             bitstream,
+                       const PCCVideoCodecParameters& params,
+                       std::ostream&                  reconstruction,
+                       size_t&                        width,
+                       size_t&                        height ) = 0;
+
+  static std::unique_ptr<PCCVideoCodecBackend> create( PCCVideoCodecBackendType type );
+  static std::unique_ptr<PCCVideoCodecBackend> create( PCCVideoBitstream& bitstream );
+};
+
+// HM encoder/decoder run as external processes through intermediate files.
+class PCCExternalVideoCodec : public PCCVideoCodecBackend {
+ public:
+  PCCExternalVideoCodec() {}
+  ~PCCExternalVideoCodec() {}
+  bool encode( std::istream&                  source,
+               const PCCVideoCodecParameters& params,
+               PCCVideoBitstream&             bitstream,
+               std::ostream&                  reconstruction );
+  bool decode( PCCVideoBitstream&             bitstream,
+               const PCCVideoCodecParameters& params,
+               std::ostream&                  reconstruction,
+               size_t&                        width,
+               size_t&                        height );
+};
+
+// In-memory lossless reference codec: the bitstream is a small header followed by the raw codec samples. Used to
+// exercise the full pipeline without an HM binary and without touching the disk.
+class PCCLosslessVideoCodec : public PCCVideoCodecBackend {
+ public:
+  PCCLosslessVideoCodec() {}
+  ~PCCLosslessVideoCodec() {}
+  bool encode( std::istream&                  source,
+               const PCCVideoCodecParameters& params,
+               PCCVideoBitstream&             bitstream,
+               std::ostream&                  reconstruction );
+  bool decode( PCCVideoBitstream&             bitstream,
+               const PCCVideoCodecParameters& params,
+               std::ostream&                  reconstruction,
+               size_t&                        width,
+               size_t&                        height );
+
+  static bool isLossless( PCCVideoBitstream& bitstream );
+
+ private:
+  static const uint32_t magic_      = 0x4C434350;  // "PCCL"
+  static const size_t   headerSize_ = 16;
+};
+
+};  // namespace pcc
+
+#endif /* PCCVideoCodecBackend_h */
@@ -114,27 +114,45 @@ void PCCCodec::generatePointCloud( PCCGroupOfFrames&                   reconstru
 #ifdef ENABLE_PAPI_PROFILING
   PAPI_PROFILING_INITIALIZE;
 #endif
+  // frames only read the shared videos and write their own frame context, reconstruction and partition
+  partitions.resize( frames.size() );
+  // the debug patch colours are drawn beforehand, in frame then patch order, to keep the rand() sequence of a
+  // serial reconstruction.
+  std::vector<std::vector<PCCColor3B>> patchColors( frames.size() );
   for ( size_t i = 0; i < frames.size(); i++ ) {
-    TRACE_CODEC( " Frame %lu / %lu \n", i, frames.size() );
-    if ( params.pbfEnableFlag_ ) {
-      PatchBlockFiltering patchBlockFiltering;
-      patchBlockFiltering.setPatches( &( frames[i].getPatches() ) );
-      patchBlockFiltering.setBlockToPatch( &( frames[i].getBlockToPatch() ) );
-      patchBlockFiltering.setOccupancyMapEncoder( &( frames[i].getOccupancyMap() ) );
-      patchBlockFiltering.setOccupancyMapVideo(
-          &( context.getVideoOccupancyMap().getFrame( frames[i].getIndex() ).getChannel( 0 ) ) );
-      patchBlockFiltering.setGeometryVideo(
-          &( videoGeometry.getFrame( frames[i].getIndex() * ( params.mapCountMinus1_ + 1 ) ).getChannel( 0 ) ) );
-      patchBlockFiltering.patchBorderFiltering(
-          frames[i].getWidth(), frames[i].getHeight(), params.occupancyResolution_, params.occupancyPrecision_,
-          !params.enhancedDeltaDepthCode_ ? params.thresholdLossyOM_ : 0, params.pbfPassesCount_, params.pbfFilterSize_,
-          params.pbfLog2Threshold_ );
+    patchColors[i].resize( frames[i].getPatches().size(), PCCColor3B( uint8_t( 0 ) ) );
+    for ( auto& color : patchColors[i] ) {
+      while ( color[0] == color[1] || color[2] == color[1] || color[2] == color[0] ) {
+        color[0] = static_cast<uint8_t>( rand() % 32 ) * 8;
+        color[1] = static_cast<uint8_t>( rand() % 32 ) * 8;
+        color[2] = static_cast<uint8_t>( rand() % 32 ) * 8;
+      }
     }
-    std::vector<uint32_t> partition;
-    generatePointCloud( reconstructs[i], context, frames[i], videoGeometry, videoGeometryD1, videoOccupancyMap, params,
-                        partition, bDecoder );
-
+  }
+  tbb::task_arena limited( (int)params.nbThread_ );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frames.size(), [&]( const size_t i ) {
+      if ( params.pbfEnableFlag_ ) {
+        PatchBlockFiltering patchBlockFiltering;
+        patchBlockFiltering.setPatches( &( frames[i].getPatches() ) );
+        patchBlockFiltering.setBlockToPatch( &( frames[i].getBlockToPatch() ) );
+        patchBlockFiltering.setOccupancyMapEncoder( &( frames[i].getOccupancyMap() ) );
+        patchBlockFiltering.setOccupancyMapVideo(
+            &( context.getVideoOccupancyMap().getFrame( frames[i].getIndex() ).getChannel( 0 ) ) );
+        patchBlockFiltering.setGeometryVideo(
+            &( videoGeometry.getFrame( frames[i].getIndex() * ( params.mapCountMinus1_ + 1 ) ).getChannel( 0 ) ) );
+        patchBlockFiltering.patchBorderFiltering(
+            frames[i].getWidth(), frames[i].getHeight(), params.occupancyResolution_, params.occupancyPrecision_,
+            !params.enhancedDeltaDepthCode_ ? params.thresholdLossyOM_ : 0, params.pbfPassesCount_,
+            params.pbfFilterSize_, params.pbfLog2Threshold_ );
+      }
+      generatePointCloud( reconstructs[i], context, frames[i], videoGeometry, videoGeometryD1, videoOccupancyMap,
+                          params, patchColors[i], partitions[i], bDecoder );
+    } );
+  } );
 #ifdef CODEC_TRACE
+  for ( size_t i = 0; i < frames.size(); i++ ) {
+    TRACE_CODEC( " Frame %lu / %lu \n", i, frames.size() );
     TRACE_CODEC( " generatePointCloud create %lu points \n", reconstructs[i].getPointCount() );
     auto checksum = reconstructs[i].computeChecksum();
     TRACE_CODEC( "Checksum %lu: ", i );
@@ -144,9 +162,8 @@ void PCCCodec::generatePointCloud( PCCGroupOfFrames&                   reconstru
     for ( auto& c : checksum ) { printf( "%02x", c ); }
     printf( "\n" );
     fflush( stdout );
-#endif
-    partitions.push_back( partition );
   }
+#endif
 #ifdef ENABLE_PAPI_PROFILING
   PAPI_PROFILING_RESULTS;
 #endif
@@ -161,22 +178,27 @@ bool PCCCodec::colorPointCloud( PCCGroupOfFrames&                     reconstruc
                                 const size_t                          multipleStreams,
                                 const GeneratePointCloudParameters    params ) {
   TRACE_CODEC( "Color point Cloud start \n" );
-  auto& frames = context.getFrames();
-  for ( size_t i = 0; i < frames.size(); i++ ) {
-    for ( size_t attIdx = 0; attIdx < attributeCount; attIdx++ ) {
-      colorPointCloud( reconstructs[i], context, i, absoluteT1List[attIdx], multipleStreams, attributeCount, params );
+  auto&           frames = context.getFrames();
+  tbb::task_arena limited( (int)params.nbThread_ );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frames.size(), [&]( const size_t i ) {
+      for ( size_t attIdx = 0; attIdx < attributeCount; attIdx++ ) {
+        colorPointCloud( reconstructs[i], context, i, absoluteT1List[attIdx], multipleStreams, attributeCount, params );
+      }
+    } );
+  } );
 #ifdef CODEC_TRACE
-      auto checksum = reconstructs[i].computeChecksum();
-      TRACE_CODEC( "Checksum %lu: ", i );
-      for ( auto& c : checksum ) { TRACE_CODEC( "%02x", c ); }
-      TRACE_CODEC( "\n" );
-      printf( "Checksum %lu: ", i );
-      for ( auto& c : checksum ) { printf( "%02x", c ); }
-      printf( "\n" );
-      fflush( stdout );
-#endif
-    }
+  for ( size_t i = 0; i < frames.size(); i++ ) {
+    auto checksum = reconstructs[i].computeChecksum();
+    TRACE_CODEC( "Checksum %lu: ", i );
+    for ( auto& c : checksum ) { TRACE_CODEC( "%02x", c ); }
+    TRACE_CODEC( "\n" );
+    printf( "Checksum %lu: ", i );
+    for ( auto& c : checksum ) { printf( "%02x", c ); }
+    printf( "\n" );
+    fflush( stdout );
   }
+#endif
   TRACE_CODEC( "Color point Cloud done \n" );
   return true;
 }
@@ -188,8 +210,8 @@ void PCCCodec::smoothPointCloudPostprocess( PCCGroupOfFrames&
                                             std::vector<std::vector<uint32_t>>& partitions ) {
   TRACE_CODEC( "Smooth point Cloud post process start \n" );
   auto& frames = context.getFrames();
-  for ( size_t i = 0; i < frames.size(); i++ ) {
 #ifdef CODEC_TRACE
+  for ( size_t i = 0; i < frames.size(); i++ ) {
     TRACE_CODEC( "smoothPointCloudPostprocess Frame size = %lu \n", frames.size() );
     auto checksum = reconstructs[i].computeChecksum();
     TRACE_CODEC( "ChecksumIn %lu: ", i );
@@ -203,44 +225,49 @@ void PCCCodec::smoothPointCloudPostprocess( PCCGroupOfFrames&
     TRACE_CODEC( "  gridSmoothing_         = %d \n", params.gridSmoothing_ );
     TRACE_CODEC( "  gridSize_              = %lu \n", params.gridSize_ );
     TRACE_CODEC( "  thresholdSmoothing_    = %f \n", params.thresholdSmoothing_ );
-    TRACE_CODEC( "  pbfEnableFlag_         = %d \n", params.pbfEnableFlag_ );
+  }
 #endif
-    std::vector<uint32_t> partition = partitions[i];
-    if ( params.flagGeometrySmoothing_ ) {
-      if ( params.gridSmoothing_ ) {
-        // reset for each GOF
-        PCCInt16Box3D boundingBox;
-        boundingBox.min_ = boundingBox.max_ = reconstructs[i][0];
-        for ( int j = 0; j < reconstructs[i].getPointCount(); j++ ) {
-          const PCCPoint3D point = reconstructs[i][j];
-          for ( size_t k = 0; k < 3; ++k ) {
-            if ( point[k] < boundingBox.min_[k] ) { boundingBox.min_[k] = floor( point[k] ); }
-            if ( point[k] > boundingBox.max_[k] ) { boundingBox.max_[k] = ceil( point[k] ); }
+  // the smoothing grids are per frame so that the frames can be filtered concurrently
+  tbb::task_arena limited( (int)params.nbThread_ );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frames.size(), [&]( const size_t i ) {
+      const std::vector<uint32_t>& partition = partitions[i];
+      if ( params.flagGeometrySmoothing_ ) {
+        if ( params.gridSmoothing_ ) {
+          PCCInt16Box3D boundingBox;
+          boundingBox.min_ = boundingBox.max_ = reconstructs[i][0];
+          for ( int j = 0; j < reconstructs[i].getPointCount(); j++ ) {
+            const PCCPoint3D point = reconstructs[i][j];
+            for ( size_t k = 0; k < 3; ++k ) {
+              if ( point[k] < boundingBox.min_[k] ) { boundingBox.min_[k] = floor( point[k] ); }
+              if ( point[k] > boundingBox.max_[k] ) { boundingBox.max_[k] = ceil( point[k] ); }
+            }
           }
+          int maxSize =
+              ( std::max )( ( std::max )( boundingBox.max_.x(), boundingBox.max_.y() ), boundingBox.max_.z() );
+          const int                w = ( maxSize + (int)params.gridSize_ - 1 ) / ( (int)params.gridSize_ );
+          std::vector<int>         geoSmoothingCount( w * w * w, 0 );
+          std::vector<PCCVector3D> geoSmoothingCenter( w * w * w );
+          std::vector<bool>        geoSmoothingDoSmooth( w * w * w );
+          std::vector<int>         geoSmoothingPartition( w * w * w );
+          for ( int j = 0; j < reconstructs[i].getPointCount(); j++ ) {
+            addGridCentroid( reconstructs[i][j], partition[j] + 1, geoSmoothingCount, geoSmoothingCenter,
+                             geoSmoothingPartition, geoSmoothingDoSmooth, (int)params.gridSize_, w );
+          }
+          for ( size_t k = 0; k < geoSmoothingCount.size(); k++ ) {
+            if ( geoSmoothingCount[k] ) { geoSmoothingCenter[k] /= geoSmoothingCount[k]; }
+          }
+          smoothPointCloudGrid( reconstructs[i], partition, params, w, geoSmoothingCount, geoSmoothingCenter,
+                                geoSmoothingDoSmooth );
+        } else {
+          if ( !params.pbfEnableFlag_ ) { smoothPointCloud( reconstructs[i], partition, params ); }
         }
-        int maxSize = ( std::max )( ( std::max )( boundingBox.max_.x(), boundingBox.max_.y() ), boundingBox.max_.z() );
-        const int w = ( maxSize + (int)params.gridSize_ - 1 ) / ( (int)params.gridSize_ );
-        geoSmoothingCenter_.resize( w * w * w );
-        geoSmoothingCount_.resize( w * w * w );
-        geoSmoothingPartition_.resize( w * w * w );
-        geoSmoothingDoSmooth_.resize( w * w * w );
-        int size = (int)geoSmoothingCount_.size();
-        geoSmoothingCount_.resize( 0 );
-        geoSmoothingCount_.resize( size, 0 );
-        for ( int j = 0; j < reconstructs[i].getPointCount(); j++ ) {
-          addGridCentroid( reconstructs[i][j], partition[j] + 1, geoSmoothingCount_, geoSmoothingCenter_,
-                           geoSmoothingPartition_, geoSmoothingDoSmooth_, (int)params.gridSize_, w );
-        }
-        for ( int i = 0; i < geoSmoothingCount_.size(); i++ ) {
-          if ( geoSmoothingCount_[i] ) { geoSmoothingCenter_[i] /= geoSmoothingCount_[i]; }
-        }
-        smoothPointCloudGrid( reconstructs[i], partition, params, w );
-      } else {
-        if ( !params.pbfEnableFlag_ ) { smoothPointCloud( reconstructs[i], partition, params ); }
       }
-    }
+    } );
+  } );
 #ifdef CODEC_TRACE
-    checksum = reconstructs[i].computeChecksum();
+  for ( size_t i = 0; i < frames.size(); i++ ) {
+    auto checksum = reconstructs[i].computeChecksum();
     TRACE_CODEC( "ChecksumOut %lu: ", i );
     for ( auto& c : checksum ) { TRACE_CODEC( "%02x", c ); }
     TRACE_CODEC( "\n" );
@@ -248,8 +275,8 @@ void PCCCodec::smoothPointCloudPostprocess( PCCGroupOfFrames&
     for ( auto& c : checksum ) { printf( "%02x", c ); }
     printf( "\n" );
     fflush( stdout );
-#endif
   }
+#endif
   TRACE_CODEC( "Smooth point Cloud post process done \n" );
 }
 
@@ -300,14 +327,6 @@ void PCCCodec::colorSmoothing( PCCGroupOfFrames&                  reconstructs,
     colorSmoothingDoSmooth_.shrink_to_fit();
     colorSmoothingLum_.resize( 0 );
     colorSmoothingLum_.shrink_to_fit();
-    geoSmoothingCenter_.resize( 0 );
-    geoSmoothingCenter_.shrink_to_fit();
-    geoSmoothingCount_.resize( 0 );
-    geoSmoothingCount_.shrink_to_fit();
-    geoSmoothingPartition_.resize( 0 );
-    geoSmoothingPartition_.shrink_to_fit();
-    geoSmoothingDoSmooth_.resize( 0 );
-    geoSmoothingDoSmooth_.shrink_to_fit();
   }  // per frame
   TRACE_CODEC( "Color point Cloud done \n" );
 }
@@ -338,7 +357,7 @@ int PCCCodec::getDeltaNeighbors( const PCCImageGeometry& frame,
   return deltaMax;
 }
 
-void PCCCodec::identifyBoundaryPoints( const std::vector<uint32_t>& occupancyMap,
+void PCCCodec::identifyBoundaryPoints( const std::vector<uint16_t>& occupancyMap,
                                        const size_t                 x,
                                        const size_t                 y,
                                        const size_t                 imageWidth,
@@ -578,6 +597,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                                    const PCCVideoGeometry&            videoD1,
                                    const PCCVideoOccupancyMap&        videoOM,
                                    const GeneratePointCloudParameters params,
+                                   const std::vector<PCCColor3B>&     patchColors,
                                    std::vector<uint32_t>&             partition,
                                    bool                               bDecoder ) {
   TRACE_CODEC( "generatePointCloud F = %lu start \n", frame.getIndex() );
@@ -668,6 +688,9 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
   std::vector<uint32_t> BPflag;
   if ( !params.pbfEnableFlag_ ) { BPflag.resize( imageWidth * imageHeight, 0 ); }
 
+  // occupied pixels times the map count, the builder grows for the EOM and missed points
+  const size_t occupiedCount = occupancyMap.size() - std::count( occupancyMap.begin(), occupancyMap.end(), 0 );
+  PCCPointSetBuilder reconstructBuilder( reconstruct, occupiedCount * mapCount );
   std::vector<std::vector<PCCPoint3D>> eddPointsPerPatch;
   eddPointsPerPatch.resize( patchCount );
   uint32_t index;
@@ -677,21 +700,16 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                      : index;
     const size_t patchIndexPlusOne = patchIndex + 1;
     auto&        patch             = patches[patchIndex];
-    PCCColor3B   color( uint8_t( 0 ) );
+    const auto&  color             = patchColors[index];
     TRACE_CODEC(
         "P%2lu/%2lu: 2D=(%2lu,%2lu)*(%2lu,%2lu) 3D(%4lu,%4lu,%4lu)*(%4lu,%4lu) A=(%lu,%lu,%lu) Or=%lu P=%lu => %lu "
         "AxisOfAdditionalPlane = %lu \n",
         patchIndex, patchCount, patch.getU0(), patch.getV0(), patch.getSizeU0(), patch.getSizeV0(), patch.getU1(),
         patch.getV1(), patch.getD1(), patch.getSizeU0() * patch.getOccupancyResolution(),
         patch.getSizeV0() * patch.getOccupancyResolution(), patch.getNormalAxis(), patch.getTangentAxis(),
-        patch.getBitangentAxis(), patch.getPatchOrientation(), patch.getProjectionMode(), reconstruct.getPointCount(),
-        patch.getAxisOfAdditionalPlane() );
+        patch.getBitangentAxis(), patch.getPatchOrientation(), patch.getProjectionMode(),
+        reconstructBuilder.getPointCount(), patch.getAxisOfAdditionalPlane() );
 
-    while ( color[0] == color[1] || color[2] == color[1] || color[2] == color[0] ) {
-      color[0] = static_cast<uint8_t>( rand() % 32 ) * 8;
-      color[1] = static_cast<uint8_t>( rand() % 32 ) * 8;
-      color[2] = static_cast<uint8_t>( rand() % 32 ) * 8;
-    }
     for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
       for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
         const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
@@ -714,12 +732,12 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
               if ( params.enhancedDeltaDepthCode_ ) {
                 // D0
                 PCCPoint3D   point0      = patch.generatePoint( u, v, frame0.getValue( 0, x, y ) );
-                const size_t pointIndex0 = reconstruct.addPoint( point0 );
+                const size_t pointIndex0 = reconstructBuilder.addPoint( point0 );
                 reconstruct.setPointPatchIndex( pointIndex0, patchIndex );
                 reconstruct.setColor( pointIndex0, color );
                 if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex0, POINT_D0 ); }
                 partition.push_back( uint32_t( patchIndex ) );
-                pointToPixel.push_back( PCCVector3<size_t>( x, y, 0 ) );
+                pointToPixel.push_back( PCCVector3<uint32_t>( x, y, 0 ) );
                 uint16_t    eddCode = 0;
                 size_t      d1pos   = 0;
                 const auto& frame0  = video.getFrame( videoFrameIndex );
@@ -751,12 +769,12 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                 PCCPoint3D point1( point0 );
                 if ( eddCode == 0 ) {
                   if ( !params.removeDuplicatePoints_ ) {
-                    const size_t pointIndex1 = reconstruct.addPoint( point1 );
+                    const size_t pointIndex1 = reconstructBuilder.addPoint( point1 );
                     reconstruct.setPointPatchIndex( pointIndex1, patchIndex );
                     reconstruct.setColor( pointIndex1, color );
                     if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
                     partition.push_back( uint32_t( patchIndex ) );
-                    pointToPixel.push_back( PCCVector3<size_t>( x, y, 1 ) );
+                    pointToPixel.push_back( PCCVector3<uint32_t>( x, y, 1 ) );
                   }
                 } else {  // eddCode != 0
                   uint16_t addedPointCount = 0;
@@ -773,12 +791,12 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                         point1[patch.getNormalAxis()] = (double)( point0[patch.getNormalAxis()] - deltaDCur );
                       }
                       if ( ( eddCode == 1 || i == d1pos ) && ( params.mapCountMinus1_ > 0 ) ) {  // d1
-                        pointIndex1 = reconstruct.addPoint( point1 );
+                        pointIndex1 = reconstructBuilder.addPoint( point1 );
                         reconstruct.setPointPatchIndex( pointIndex1, patchIndex );
                         reconstruct.setColor( pointIndex1, color );
                         if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
                         partition.push_back( uint32_t( patchIndex ) );
-                        pointToPixel.push_back( PCCVector3<size_t>( x, y, 1 ) );
+                        pointToPixel.push_back( PCCVector3<uint32_t>( x, y, 1 ) );
                       } else {
                         eddPointsPerPatch[patchIndex].push_back( point1 );
                       }
@@ -800,13 +818,13 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                          ( ( i == 0 ) || ( createdPoints[i] != createdPoints[0] ) ) ) {
                       size_t pointindex = 0;
                       if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                        pointindex = reconstruct.addPoint( createdPoints[i] );
+                        pointindex = reconstructBuilder.addPoint( createdPoints[i] );
                         reconstruct.setPointPatchIndex( pointindex, patchIndex );
                       } else {
                         PCCVector3D tmp;
                         PCCPatch::InverseRotatePosition45DegreeOnAxis(
                             patch.getAxisOfAdditionalPlane(), params.geometryBitDepth3D_, createdPoints[i], tmp );
-                        pointindex = reconstruct.addPoint( tmp );
+                        pointindex = reconstructBuilder.addPoint( tmp );
                         reconstruct.setPointPatchIndex( pointindex, patchIndex );
                       }
                       const size_t pointindex_1 = pointindex;
@@ -822,15 +840,15 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                       }
                       partition.push_back( uint32_t( patchIndex ) );
                       if ( params.singleMapPixelInterleaving_ ) {
-                        pointToPixel.push_back( PCCVector3<size_t>(
+                        pointToPixel.push_back( PCCVector3<uint32_t>(
                             x, y,
                             i == 0 ? ( ( size_t )( x + y ) % 2 )
                                    : i == 1 ? ( ( size_t )( x + y + 1 ) % 2 ) : IntermediateLayerIndex ) );
                       } else if ( params.pointLocalReconstruction_ ) {
-                        pointToPixel.push_back( PCCVector3<size_t>(
+                        pointToPixel.push_back( PCCVector3<uint32_t>(
                             x, y, i == 0 ? 0 : i == 1 ? IntermediateLayerIndex : IntermediateLayerIndex + 1 ) );
                       } else {
-                        pointToPixel.push_back( PCCVector3<size_t>( x, y, i < 2 ? i : IntermediateLayerIndex + 1 ) );
+                        pointToPixel.push_back( PCCVector3<uint32_t>( x, y, i < 2 ? i : IntermediateLayerIndex + 1 ) );
                       }
                     }
                   }
@@ -843,7 +861,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
     }
   }
 
-  frame.setTotalNumberOfRegularPoints( reconstruct.getPointCount() );
+  frame.setTotalNumberOfRegularPoints( reconstructBuilder.getPointCount() );
   patchIndex                         = index;
   size_t       totalEddPointsInFrame = 0;
   PCCPointSet3 eddSavedPoints;
@@ -873,14 +891,14 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
           size_t vv =
               vBlock * params.occupancyResolution_ + nPixelInCurrentBlockCount / params.occupancyResolution_ + v0Eom;
           PCCPoint3D point1      = eddPointsPerPatch[memberPatchIdx][pointCount];
-          size_t     pointIndex1 = reconstruct.addPoint( point1 );
+          size_t     pointIndex1 = reconstructBuilder.addPoint( point1 );
           reconstruct.setPointPatchIndex( pointIndex1, patchIndex );
           eddSavedPoints.addPoint( point1 );
           // reconstruct.setColor( pointIndex1, color );
           if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_EDD ); }
           partition.push_back( uint32_t( patchIndex ) );
           totalPointCount++;
-          pointToPixel.push_back( PCCVector3<size_t>( uu, vv, 0 ) );
+          pointToPixel.push_back( PCCVector3<uint32_t>( uu, vv, 0 ) );
           occupancyMap[vv * imageWidth + uu] = 1;  // occupied
         }
       }
@@ -890,7 +908,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
     frame.setTotalNumberOfEddPoints( totalEddPointsInFrame );
   }
   TRACE_CODEC( " totalEddPointsInFrame = %lu  \n", totalEddPointsInFrame );
-  TRACE_CODEC( " point = %lu  \n", reconstruct.getPointCount() );
+  TRACE_CODEC( " point = %lu  \n", reconstructBuilder.getPointCount() );
   if ( params.useAdditionalPointsPatch_ ) {
     if ( useMissedPointsSeparateVideo ) {
       PCCColor3B missedPointsColor( uint8_t( 0 ) );
@@ -908,7 +926,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
             point0[0]               = missedPointsPatch.x_[i] + missedPointsPatch.u1_;
             point0[1]               = missedPointsPatch.y_[i] + missedPointsPatch.v1_;
             point0[2]               = missedPointsPatch.z_[i] + missedPointsPatch.d1_;
-            const size_t pointIndex = reconstruct.addPoint( point0 );
+            const size_t pointIndex = reconstructBuilder.addPoint( point0 );
             reconstruct.setPointPatchIndex( pointIndex, patchIndex );
             reconstruct.setColor( pointIndex, missedPointsColor );
             partition.push_back( uint32_t( patchIndex ) );
@@ -919,7 +937,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
             point0[0]               = missedPointsPatch.x_[i] + missedPointsPatch.u1_;
             point0[1]               = missedPointsPatch.x_[i + sizeofMPs] + missedPointsPatch.v1_;
             point0[2]               = missedPointsPatch.x_[i + 2 * sizeofMPs] + missedPointsPatch.d1_;
-            const size_t pointIndex = reconstruct.addPoint( point0 );
+            const size_t pointIndex = reconstructBuilder.addPoint( point0 );
             reconstruct.setPointPatchIndex( pointIndex, patchIndex );
             reconstruct.setColor( pointIndex, missedPointsColor );
             partition.push_back( uint32_t( patchIndex ) );
@@ -964,12 +982,12 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
                   point0[1] = double( frame0.getValue( 1, x, y ) ) + missedPointsPatch.v1_;
                   point0[2] = double( frame0.getValue( 2, x, y ) ) + missedPointsPatch.d1_;
 
-                  const size_t pointIndex = reconstruct.addPoint( point0 );
+                  const size_t pointIndex = reconstructBuilder.addPoint( point0 );
                   reconstruct.setPointPatchIndex( pointIndex, patchIndex );
                   reconstruct.setColor( pointIndex, missedPointsColor );
                   for ( size_t f = 0; f < mapCount; ++f ) {
                     partition.push_back( uint32_t( patchIndex ) );
-                    pointToPixel.push_back( PCCVector3<size_t>( x, y, f ) );
+                    pointToPixel.push_back( PCCVector3<uint32_t>( x, y, f ) );
                   }
                 }
               }
@@ -1003,11 +1021,11 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
               const size_t x = ( u0 + u );
               const size_t y = ( v0 + v );
               if ( counter < numMissedPts ) {
-                const size_t pointIndex = reconstruct.addPoint( missedPoints[counter] );
+                const size_t pointIndex = reconstructBuilder.addPoint( missedPoints[counter] );
                 reconstruct.setPointPatchIndex( pointIndex, patchIndex );
                 reconstruct.setColor( pointIndex, missedPointsColor );
                 partition.push_back( uint32_t( patchIndex ) );
-                pointToPixel.push_back( PCCVector3<size_t>( x, y, 0 ) );
+                pointToPixel.push_back( PCCVector3<uint32_t>( x, y, 0 ) );
                 counter++;
               }
             }
@@ -1017,6 +1035,8 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
     }  // fi :useMissedPointsSeparateVideo
   }    // fi : useAdditionalPointsPatch
 
+  reconstructBuilder.commit();
+
   if ( params.flagGeometrySmoothing_ && !params.pbfEnableFlag_ ) {
     TRACE_CODEC( " identify first boundary layer \n" );
     // identify first boundary layer
@@ -1027,9 +1047,9 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                      reconstruc
     }
     size_t pointCount = reconstruct.getPointCount() - frame.getTotalNumberOfMissedPoints();
     for ( size_t i = 0; i < pointCount; ++i ) {
-      const PCCVector3<size_t> location = pointToPixel[i];
-      const size_t             x        = location[0];
-      const size_t             y        = location[1];
+      const PCCVector3<uint32_t> location = pointToPixel[i];
+      const size_t               x        = location[0];
+      const size_t               y        = location[1];
       if ( occupancyMap[y * imageWidth + x] != 0 ) {
         identifyBoundaryPoints( occupancyMap, x, y, imageWidth, imageHeight, i, BPflag, reconstruct );
       }
@@ -1240,7 +1260,10 @@ bool PCCCodec::gridFilteringTransfer( const std::vector<uint32_t>& partition,
 void PCCCodec::smoothPointCloudGrid( PCCPointSet3&                      reconstruct,
                                      const std::vector<uint32_t>&       partition,
                                      const GeneratePointCloudParameters params,
-                                     int                                gridWidth ) {
+                                     int                                gridWidth,
+                                     std::vector<int>&                  gridCount,
+                                     std::vector<PCCVector3D>&          gridCenter,
+                                     std::vector<bool>&                 gridDoSmooth ) {
   TRACE_CODEC( " smoothPointCloudGrid start \n" );
   const size_t pointCount = reconstruct.getPointCount();
   const int    gridSize   = (int)params.gridSize_;
@@ -1257,8 +1280,8 @@ void PCCCodec::smoothPointCloudGrid( PCCPointSet3&                      reconstr
     bool        otherClusterPointCount = false;
     PCCVector3D color( 0, 0, 0 );
     if ( reconstruct.getBoundaryPointType( c ) == 1 ) {
-      otherClusterPointCount = gridFiltering( partition, reconstruct, curPoint, centroid, count, geoSmoothingCount_,
-                                              geoSmoothingCenter_, geoSmoothingDoSmooth_, gridSize, gridWidth );
+      otherClusterPointCount = gridFiltering( partition, reconstruct, curPoint, centroid, count, gridCount, gridCenter,
+                                              gridDoSmooth, gridSize, gridWidth );
     }
     if ( otherClusterPointCount ) {
       double dist2 = ( ( curVector * count - centroid ).getNorm2() + (double)count / 2.0 ) / (double)count;
@@ -1279,52 +1302,59 @@ void PCCCodec::smoothPointCloud( PCCPointSet3&                      reconstruct,
                                  const std::vector<uint32_t>&       partition,
                                  const GeneratePointCloudParameters params ) {
   TRACE_CODEC( " smoothPointCloud start \n" );
-  const size_t pointCount = reconstruct.getPointCount();
-  PCCKdTree    kdtree( reconstruct );
-  PCCPointSet3 temp;
+  const size_t     pointCount = reconstruct.getPointCount();
+  const size_t     batchSize  = 65536;
+  PCCKdTree        kdtree( reconstruct );
+  PCCNNBatchResult result;
+  PCCPointSet3     temp;
   temp.resize( pointCount );
   tbb::task_arena limited( (int)params.nbThread_ );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      const size_t clusterindex_ = partition[i];
-      PCCNNResult  result;
-      kdtree.searchRadius( reconstruct[i], params.neighborCountSmoothing_, params.radius2Smoothing_, result );
-      PCCVector3D centroid( 0.0 );
-      bool        otherClusterPointCount = false;
-      size_t      neighborCount          = 0;
-      for ( size_t r = 0; r < result.count(); ++r ) {
-        const double& dist2 = result.dist( r );
-        ++neighborCount;
-        const size_t pointindex_ = result.indices( r );
-        centroid += reconstruct[pointindex_];
-        otherClusterPointCount |=
-            ( dist2 <= params.radius2BoundaryDetection_ ) && ( partition[pointindex_] != clusterindex_ );
-      }
-      if ( otherClusterPointCount ) {
-        if ( reconstruct.getBoundaryPointType( i ) == 1 ) {
-          reconstruct.setBoundaryPointType( i, static_cast<uint16_t>( 2 ) );
-        }
-        const PCCVector3D scaledPoint =
-            double( neighborCount ) * PCCVector3D( reconstruct[i][0], reconstruct[i][1], reconstruct[i][2] );
-        const double distToCentroid2 =
-            int64_t( ( centroid - scaledPoint ).getNorm2() + ( neighborCount / 2.0 ) ) / double( neighborCount );
-        for ( size_t k = 0; k < 3; ++k ) {
-          centroid[k] = double( int64_t( ( centroid[k] + ( neighborCount / 2 ) ) / neighborCount ) );
+  for ( size_t start = 0; start < pointCount; start += batchSize ) {
+    const size_t end = ( std::min )( start + batchSize, pointCount );
+    kdtree.searchRadiusSorted( reconstruct, start, end, params.neighborCountSmoothing_, params.radius2Smoothing_,
+                               result, params.nbThread_ );
+    limited.execute( [&] {
+      tbb::parallel_for( start, end, [&]( const size_t i ) {
+        const size_t    clusterindex_          = partition[i];
+        const uint32_t* neighbors              = result.indices( i - start );
+        const float*    neighborDists          = result.dist( i - start );
+        PCCVector3D     centroid( 0.0 );
+        bool            otherClusterPointCount = false;
+        size_t          neighborCount          = 0;
+        for ( size_t r = 0; r < result.count( i - start ); ++r ) {
+          const double dist2 = neighborDists[r];
+          ++neighborCount;
+          const size_t pointindex_ = neighbors[r];
+          centroid += reconstruct[pointindex_];
+          otherClusterPointCount |=
+              ( dist2 <= params.radius2BoundaryDetection_ ) && ( partition[pointindex_] != clusterindex_ );
         }
-        if ( distToCentroid2 >= params.thresholdSmoothing_ ) {
-          temp[i][0] = centroid[0];
-          temp[i][1] = centroid[1];
-          temp[i][2] = centroid[2];
-          reconstruct.setColor( i, PCCColor3B( 255, 0, 0 ) );
-          if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( i, POINT_SMOOTH ); }
+        if ( otherClusterPointCount ) {
+          if ( reconstruct.getBoundaryPointType( i ) == 1 ) {
+            reconstruct.setBoundaryPointType( i, static_cast<uint16_t>( 2 ) );
+          }
+          const PCCVector3D scaledPoint =
+              double( neighborCount ) * PCCVector3D( reconstruct[i][0], reconstruct[i][1], reconstruct[i][2] );
+          const double distToCentroid2 =
+              int64_t( ( centroid - scaledPoint ).getNorm2() + ( neighborCount / 2.0 ) ) / double( neighborCount );
+          for ( size_t k = 0; k < 3; ++k ) {
+            centroid[k] = double( int64_t( ( centroid[k] + ( neighborCount / 2 ) ) / neighborCount ) );
+          }
+          if ( distToCentroid2 >= params.thresholdSmoothing_ ) {
+            temp[i][0] = centroid[0];
+            temp[i][1] = centroid[1];
+            temp[i][2] = centroid[2];
+            reconstruct.setColor( i, PCCColor3B( 255, 0, 0 ) );
+            if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( i, POINT_SMOOTH ); }
+          } else {
+            temp[i] = reconstruct[i];
+          }
         } else {
           temp[i] = reconstruct[i];
         }
-      } else {
-        temp[i] = reconstruct[i];
-      }
+      } );
     } );
-  } );
+  }
   limited.execute( [&] {
     tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
       reconstruct[i] = temp[i];
@@ -1345,8 +1375,8 @@ void PCCCodec::smoothPointCloudColor( PCCPointSet3& reconstruct, const GenerateP
     tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
       PCCNNResult result;
       if ( reconstruct.getBoundaryPointType( i ) == 1 ) {
-        kdtree.searchRadius( reconstruct[i], params.neighborCountColorSmoothing_, params.radius2ColorSmoothing_,
-                             result );
+        kdtree.searchRadiusSorted( reconstruct[i], params.neighborCountColorSmoothing_,
+                                   params.radius2ColorSmoothing_, result );
         PCCVector3D centroid( 0.0 );
         size_t               neighborCount = 0;
         std::vector<uint8_t> Lum;
@@ -1676,8 +1706,8 @@ void PCCCodec::createSpecificLayerReconstruct( const PCCPointSet3&
   const size_t pointCount   = reconstruct.getPointCount();
   if ( !pointCount || !reconstruct.hasColors() ) { return; }
   for ( size_t i = 0; i < pointCount; ++i ) {
-    const PCCVector3<size_t> location = pointToPixel[i];
-    const size_t             f        = location[2];
+    const PCCVector3<uint32_t> location = pointToPixel[i];
+    const size_t               f        = location[2];
     if ( f == frameCount ) {
       subReconstruct.addPoint( reconstruct[i] );
       subPartition.push_back( partition[i] );
@@ -1702,8 +1732,8 @@ void PCCCodec::createSubReconstruct( const PCCPointSet3&                 reconst
   const size_t pointCount   = reconstruct.getPointCount();
   if ( !pointCount || !reconstruct.hasColors() ) { return; }
   for ( size_t i = 0; i < pointCount; ++i ) {
-    const PCCVector3<size_t> location = pointToPixel[i];
-    const size_t             f        = location[2];
+    const PCCVector3<uint32_t> location = pointToPixel[i];
+    const size_t               f        = location[2];
     if ( f < frameCount ) {
       subReconstruct.addPoint( reconstruct[i] );
       subReconstruct.setType( frameCount, POINT_UNSET );
@@ -1790,10 +1820,10 @@ bool PCCCodec::colorPointCloud( PCCPointSet3&                       reconstruct,
     source.addColors();
     const size_t shift = frame.getIndex() * frameCount;
     for ( size_t i = 0; i < pointCount; ++i ) {
-      const PCCVector3<size_t> location = pointToPixel[i];
-      const size_t             x        = location[0];
-      const size_t             y        = location[1];
-      const size_t             f        = location[2];
+      const PCCVector3<uint32_t> location = pointToPixel[i];
+      const size_t               x        = location[0];
+      const size_t               y        = location[1];
+      const size_t               f        = location[2];
       if ( params.singleMapPixelInterleaving_ ) {
         if ( ( f == 0 && ( x + y ) % 2 == 0 ) | ( f == 1 && ( x + y ) % 2 == 1 ) ) {
           const auto& frame = video.getFrame( shift );
@@ -1846,7 +1876,7 @@ bool PCCCodec::colorPointCloud( PCCPointSet3&                       reconstruct,
     }
 
     if ( target.getPointCount() > 0 ) {
-      source.transferColorWeight( target );
+      source.transferColorWeight( target, 0.1, params.nbThread_ );
       for ( size_t i = 0; i < target.getPointCount(); ++i ) {
         reconstruct.setColor( targetIndex[i], target.getColor( i ) );
       }
@@ -2036,182 +2066,106 @@ void PCCCodec::generateOccupancyMap( PCCFrameContext&            frame,
 }
 
 #if OCCUPANCY_MAP_MODEL
-void PCCCodec::upsampleOccupancyMap(PCCContext& context, PCCVideoOccupancyMap&  vom) {
-    size_t scale =  context.getOccupancyPrecision() / context.getOccupancyTargetPrecision();
-    PCCVideoOccupancyMap vom_temp;
-    vom_temp.getFrames().assign(vom.getFrames().begin(), vom.getFrames().end());
-    auto width = vom_temp.getWidth() * scale;
-    auto height = vom_temp.getHeight() * scale;
-    for (size_t i = 0; i < vom_temp.getFrameCount(); ++i)
-    {
-      PCCImageOccupancyMap& om_temp   = vom_temp.getFrame( i );
-      PCCImageOccupancyMap& om  = vom.getFrame( i );
-      om.resize(width, height);
-      for ( size_t v = 0; v < height; ++v ) {
-        for ( size_t u = 0; u < width; ++u ) {
-	    om.setValue(0, u, v, om_temp.getValue(0, u / scale, v / scale));
-        }
+void PCCCodec::upsampleOccupancyMap( PCCContext& context, PCCVideoOccupancyMap& vom, const size_t nbThread ) {
+  const size_t scale = context.getOccupancyPrecision() / context.getOccupancyTargetPrecision();
+  if ( scale <= 1 ) { return; }
+  auto&           frames = vom.getFrames();
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frames.size(), [&]( const size_t i ) {
+      auto&        om      = frames[i];
+      const size_t width0  = om.getWidth();
+      const size_t height0 = om.getHeight();
+      const size_t width   = width0 * scale;
+      om.resize( width, height0 * scale );
+      // the plane is upsampled in place from its end, each row being widened once then replicated: a row of the
+      // output never overlaps the source rows still to be read.
+      uint8_t* data = om.getChannel( 0 ).data();
+      for ( size_t v0 = height0; v0-- > 0; ) {
+        const uint8_t* src = data + v0 * width0;
+        uint8_t*       dst = data + v0 * scale * width;
+        for ( size_t u0 = width0; u0-- > 0; ) { std::fill_n( dst + u0 * scale, scale, src[u0] ); }
+        for ( size_t k = 1; k < scale; k++ ) { std::copy( dst, dst + width, dst + k * width ); }
       }
-    }
+    } );
+  } );
 }
 
-void PCCCodec:: refineOccupancy( PCCVideoOccupancyMap vom_org,  PCCVideoOccupancyMap& vom)
-{
-    auto width = vom_org.getWidth();
-    auto height = vom_org.getHeight();
-    size_t set_num = 0;
-    for (size_t i = 0; i < vom_org.getFrameCount(); ++i)
-    {
-      PCCImageOccupancyMap& om_org   = vom_org.getFrame( i );
-      PCCImageOccupancyMap& om  = vom.getFrame( i );
-      for ( size_t v = 0; v < height; ++v ) {
-        for ( size_t u = 0; u < width; ++u ) {
-	    if (om_org.getValue(0, u, v) == 0 && om.getValue(0, u, v) == 1)
-	    {
-	         om.setValue(0, u, v, 0);
-	         ++set_num;
-	    }
+bool PCCCodec::processIngredient( const PCCOccupancyModelParameters& params,
+                                  PCCContext&                        context,
+                                  PCCVideoOccupancyMap&              om ) {
+  auto&        geometry       = context.getVideoGeometry();
+  const size_t frameCount     = om.getFrameCount();
+  const size_t width          = om.getWidth();
+  const size_t height         = om.getHeight();
+  const size_t geometryWidth  = geometry.getWidth();
+  const size_t geometryHeight = geometry.getHeight();
+
+  // large frames are inferred by tiles, each one extended by a halo, aligned on the model stride and clamped inside the
+  // frame, and only the tile interiors are written back. Each inference refines a single frame or tile, as the per
+  // frame inference does, its convolutions running on the intra-op threads of libtorch.
+  size_t                             windowWidth = 0, windowHeight = 0;
+  std::vector<PCCOccupancyModelTile> tilesX, tilesY;
+  getOccupancyModelTiles( width, params.tileSize_, params.tileHalo_, params.tileStride_, windowWidth, tilesX );
+  getOccupancyModelTiles( height, params.tileSize_, params.tileHalo_, params.tileStride_, windowHeight, tilesY );
+  const size_t tileCount     = tilesX.size() * tilesY.size();
+  const size_t scaleX        = ( std::max )( geometryWidth / width, size_t( 1 ) );
+  const size_t scaleY        = ( std::max )( geometryHeight / height, size_t( 1 ) );
+  const size_t windowWidthG  = tilesX.size() == 1 ? geometryWidth : windowWidth * scaleX;
+  const size_t windowHeightG = tilesY.size() == 1 ? geometryHeight : windowHeight * scaleY;
+
+  // the model is loaded by the first group of frames only and warmed up once per shape, the next ones reuse the
+  // session. The groups of frames may run concurrently, so only the settings returned by this call are used.
+  if ( !occupancyModel_ ) { occupancyModel_ = std::make_shared<PCCOccupancyModel>(); }
+  PCCOccupancyModelSettings settings;
+  if ( !occupancyModel_->load( params, windowWidth, windowHeight, windowWidthG, windowHeightG, settings ) ) {
+    return false;
+  }
+  const auto device = settings.device_;
+  // the tiles of a frame are refined in place one after the other, their halos are read from a copy of the unrefined
+  // plane.
+  std::vector<uint8_t> unrefinedPlane;
+  size_t               clearedCount = 0;
+  for ( size_t frameIndex = 0; frameIndex < frameCount; frameIndex++ ) {
+    auto& channel = om.getFrame( frameIndex ).getChannel( 0 );
+    if ( tileCount > 1 ) { unrefinedPlane = channel; }
+    const uint8_t* plane = tileCount > 1 ? unrefinedPlane.data() : channel.data();
+    for ( const auto& tileY : tilesY ) {
+      for ( const auto& tileX : tilesX ) {
+        std::vector<torch::jit::IValue> inputs;
+        // the windows are bound to the planes in place and converted once, by the copy into the input tensor.
+        if ( settings.useGeometry_ ) {
+          at::Tensor tgeom =
+              torch::empty( {1, 1, (int64_t)windowHeightG, (int64_t)windowWidthG}, torch::dtype( at::kFloat ) );
+          tgeom[0][0].copy_( createTensorView( geometry.getFrame( frameIndex ).getChannel( 0 ).data(), geometryWidth,
+                                               tileX.window_ * scaleX, tileY.window_ * scaleY, windowWidthG,
+                                               windowHeightG ) );
+          inputs.push_back( tgeom.to( device ) );
+        }
+        at::Tensor treco =
+            torch::empty( {1, 1, (int64_t)windowHeight, (int64_t)windowWidth}, torch::dtype( at::kFloat ) );
+        treco[0][0].copy_( createTensorView( plane, width, tileX.window_, tileY.window_, windowWidth, windowHeight ) );
+        inputs.push_back( treco.to( device ) );
+        const at::Tensor output     = occupancyModel_->forward( inputs ).to( at::kCPU, at::kFloat ).contiguous();
+        const float*     outputData = output.data_ptr<float>();
+        // a single pass rounds, converts to bytes and clamps the output as the tensor operations did, and masks it by
+        // the unrefined interior, still untouched at this point.
+        for ( size_t y = tileY.begin_; y < tileY.end_; y++ ) {
+          const float* src = outputData + ( y - tileY.window_ ) * windowWidth + tileX.begin_ - tileX.window_;
+          uint8_t*     dst = channel.data() + y * width + tileX.begin_;
+          for ( size_t x = 0; x < tileX.end_ - tileX.begin_; x++ ) {
+            const bool occupied = uint8_t( int( std::nearbyint( src[x] ) ) ) != 0;
+            clearedCount += occupied && dst[x] == 0;
+            dst[x] = occupied && dst[x] != 0 ? 1 : 0;
+          }
         }
       }
     }
-    std::cout << "set value: " << set_num <<std::endl;
-}
-
-//void PCCCodec::processIngredient( PCCVideoOccupancyMap&  om)
-//{
-//  torch::DeviceType dev_type = at::kCPU;
-//  int64_t frame_count = om.getFrameCount();
-//  int64_t i_width = om.getWidth();
-//  int64_t i_height = om.getHeight();
-//  long unsigned int stride = i_width * i_height;
-//
-//  torch::manual_seed(0);
-////  torch::jit::script::Module module = torch::jit::load("checkpointsCPP/CPP_checkpointBest_Y_RECO_GNET_FM_NONE_Q4_NB2_PS64.pt", dev_type);
-//  torch::jit::script::Module module = torch::jit::load("../mpeg-pcc-tmc2-master/checkpointsCPP/CPP_checkpointBest_Y_RECO_GNET_FM_NONE_Q4_NB2_PS64.pt", dev_type);
-//  torch::NoGradGuard no_grad;
-//  no_grad = no_grad;
-//  module.to(dev_type);
-//  module.eval();
-//  long int start = 0;
-//  std::vector<torch::jit::IValue> inputs;
-////  uint8_t *om_data = new uint8_t[frame_count * stride];
-//  std::vector<std::vector<uint8_t>> om_data;
-// for (int i = 0; i < frame_count; ++i)
-//  {
-////     memcpy(om_data + start * stride * sizeof(uint8_t), &om.getFrame(i).getChannel(0)[0], stride);
-// //    start += 1;
-//     om_data.push_back(om.getFrame(i).getChannel(0));
-//  }
-//    at::Tensor treco = torch::from_blob(&om_data[0][0], {frame_count, 1, i_height, i_width}, at::kByte).to(dev_type);
-//  //  at::Tensor treco = torch::from_blob(om_data, {frame_count, 1, i_height, i_width}, at::kByte).to(dev_type);
-//  treco = treco.to(at::kFloat);
-//  inputs.push_back(treco);
-//  at::Tensor output = module.forward(inputs).toTensor();
-//  output = output.round();
-//  output = output.to(at::kByte).clamp(0, 1);
-//  output = output.to(at::kCPU);
-//  uint8_t* out_buf = output.data_ptr<uint8_t>();
-//  start = 0;
-//  for (int i = 0; i < frame_count; ++i)
-//  {
-//      for (size_t m = 0; m < i_height; ++m)
-//      {
-//	  for (size_t n = 0; n < i_width; ++n)
-//	  {
-//	      om.getFrame(i).setValue(0, n, m, out_buf[start * stride + m * i_width + n]);
-//	  }
-//      }
-//      start += 1;
-//  }
-////  delete om_data;
-//}
-
-void PCCCodec::processIngredient( std::string model_name, PCCContext& context, PCCVideoOccupancyMap&  om)
-{
-
-//  om.write420(model_name + "_occupancy_before.yuv", 1 );
-    bool enable_geometry = false;
-  if (model_name.find("RESI") != std::string::npos) {
-      enable_geometry = true;
-  }
-  PCCVideoGeometry & v_geometry = context.getVideoGeometry();
-  torch::DeviceType dev_type = at::kCPU;
-  int64_t frame_count = om.getFrameCount();
-  int64_t i_width = om.getWidth();
-  int64_t i_height = om.getHeight();
-  long unsigned int stride = i_width * i_height;
-
-  torch::manual_seed(0);
-//  torch::jit::script::Module module = torch::jit::load("../mpeg-pcc-tmc2-master/checkpointsCPP/CPP_checkpointBest_Y_RECO_GNET_FM_NONE_O" + std::to_string(context.getOccupancyPrecision()) + std::to_string(context.getOccupancyTargetPrecision()) + "_NB2_PS64_LR0.0001_BS16.pt", dev_type);
-  torch::jit::script::Module module = torch::jit::load(model_name, dev_type);
-  torch::NoGradGuard no_grad;
-  no_grad = no_grad;
-  module.to(dev_type);
-  module.eval();
-  //long int start = 0;
- uint8_t *om_data = new uint8_t[stride];
-
- int64_t g_width = v_geometry.getWidth();
- int64_t g_height = v_geometry.getHeight();
- long unsigned int g_stride = g_width * g_height;
- uint16_t *gm_data = new uint16_t[v_geometry.getWidth() * v_geometry.getHeight()];
-// int32_t *gm_data = new int32_t[v_geometry.getWidth() * v_geometry.getHeight()];
- for (int i = 0; i < frame_count; ++i)
-  {
-	std::vector<torch::jit::IValue> inputs;
-
-	if (enable_geometry) {
-//	    for (int j = 0; j < g_stride; ++j)
-//	    {
-//		gm_data[j] = (int32_t)v_geometry.getFrame(i).getChannel(0)[j];
-//	    }
-	     memcpy(gm_data, &v_geometry.getFrame(i).getChannel(0)[0], g_stride * sizeof(uint16_t));
-	    at::Tensor tgeom = torch::from_blob(gm_data, {1, 1, g_height, g_width}, at::kShort).to(dev_type);
-//	    tgeom = tgeom.to(at::kFloat).div(255.0);
-	    tgeom = tgeom.to(at::kFloat);
-	    inputs.push_back(tgeom);
-	}
-
-	memcpy(om_data, &om.getFrame(i).getChannel(0)[0], stride * sizeof(uint8_t));
- //    start += 1;
-	at::Tensor treco = torch::from_blob(om_data, {1, 1, i_height, i_width}, at::kByte).to(dev_type);
-	  //  at::Tensor treco = torch::from_blob(om_data, {frame_count, 1, i_height, i_width}, at::kByte).to(dev_type);
-	treco = treco.to(at::kFloat);
-	inputs.push_back(treco);
-	  at::Tensor output = module.forward(inputs).toTensor();
-//	  std::cout << "output size -----------------------" << output.sizes() << std::endl;
-	  output = output.round();
-	  output = output.to(at::kByte).clamp(0, 1);
-	  output = output.to(at::kCPU);
-	  uint8_t* out_buf = output.data_ptr<uint8_t>();
-//	  start = 0;
-	       for (size_t m = 0; m < i_height; ++m)
-	      {
-		  for (size_t n = 0; n < i_width; ++n)
-		  {
-//		      om.getFrame(i).setValue(0, n, m, out_buf[m * i_width + n]);
-		      int oc_value = 1;
-//		      if (out_buf[m * i_width + n] == 1)
-//		      {
-//			oc_value = 1;
-//		      }
-//		      else 
-//		      {
-//
-//			oc_value = 1 - out_buf[stride + m * i_width + n] ;
-			oc_value =  out_buf[m * i_width + n];
-//		      }
-		      om.getFrame(i).setValue(0, n, m, oc_value);
-		  }
-	      }
-	     // start += 1;
   }
-  delete om_data;
-  delete gm_data;
-//  om.write420(model_name + "_occupancy_after.yuv", 1 );
+  std::cout << "set value: " << clearedCount << std::endl;
+  return true;
 }
 
-
 #endif
 
 void PCCCodec::generateBlockToPatchFromOccupancyMap( PCCContext&  context,
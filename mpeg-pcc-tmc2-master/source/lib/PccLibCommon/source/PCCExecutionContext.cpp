@@ -0,0 +1,108 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#define TBB_PREVIEW_GLOBAL_CONTROL 1
+#include "PCCCommon.h"
+#include "PCCExecutionContext.h"
+#include "tbb/tbb.h"
+#include "tbb/global_control.h"
+#include <atomic>
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace pcc;
+
+// Pins every thread entering the TBB scheduler (and the owner thread) to the next core of the process affinity mask.
+class PCCThreadPinningObserver : public tbb::task_scheduler_observer {
+ public:
+  PCCThreadPinningObserver( const std::vector<int>& cores ) : cores_( cores ), next_( 0 ) {
+    pinCurrentThread();
+    observe( true );
+  }
+  ~PCCThreadPinningObserver() { observe( false ); }
+  void on_scheduler_entry( bool ) override { pinCurrentThread(); }
+
+ private:
+  void pinCurrentThread() {
+#if defined( __linux__ )
+    static thread_local bool pinned = false;
+    if ( pinned || cores_.empty() ) { return; }
+    pinned = true;
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( cores_[next_++ % cores_.size()], &set );
+    pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+#endif
+  }
+  std::vector<int>    cores_;
+  std::atomic<size_t> next_;
+};
+
+class PCCExecutionContext::Scheduler {
+ public:
+  std::unique_ptr<tbb::global_control>      globalControl_;
+  std::unique_ptr<PCCThreadPinningObserver> pinningObserver_;
+};
+
+PCCExecutionContext::PCCExecutionContext( size_t nbThread, bool pinThreads ) :
+    nbThread_( nbThread ),
+    scheduler_( new Scheduler ) {
+  const size_t coreCount = (size_t)tbb::task_scheduler_init::default_num_threads();
+  if ( nbThread_ == 0 ) { nbThread_ = coreCount; }
+  if ( nbThread_ > coreCount ) {
+    std::cout << "Warning: nbThread = " << nbThread_ << " exceeds the " << coreCount << " available cores" << std::endl;
+  }
+  scheduler_->globalControl_.reset(
+      new tbb::global_control( tbb::global_control::max_allowed_parallelism, nbThread_ ) );
+  if ( pinThreads ) {
+#if defined( __linux__ )
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    std::vector<int> cores;
+    if ( sched_getaffinity( 0, sizeof( set ), &set ) == 0 ) {
+      for ( int i = 0; i < CPU_SETSIZE && cores.size() < nbThread_; i++ ) {
+        if ( CPU_ISSET( i, &set ) ) { cores.push_back( i ); }
+      }
+    }
+    scheduler_->pinningObserver_.reset( new PCCThreadPinningObserver( cores ) );
+#else
+    std::cout << "Warning: thread pinning is not supported on this platform" << std::endl;
+#endif
+  }
+}
+
+PCCExecutionContext::~PCCExecutionContext() {
+  scheduler_->pinningObserver_.reset();
+  scheduler_->globalControl_.reset();
+}
@@ -33,6 +33,7 @@
 #include "PCCCommon.h"
 #include "PCCPointSet.h"
 #include "PCCGroupOfFrames.h"
+#include "tbb/tbb.h"
 
 using namespace pcc;
 
@@ -44,29 +45,97 @@ bool PCCGroupOfFrames::load( const std::string       uncompressedDataPath,
                              const size_t            startFrameNumber,
                              const size_t            endFrameNumber,
                              const PCCColorTransform colorTransform,
-                             const bool              readNormals ) {
+                             const bool              readNormals,
+                             const size_t            nbThread ) {
   char fileName[4096];
   if ( endFrameNumber < startFrameNumber ) { return false; }
   const size_t frameCount = endFrameNumber - startFrameNumber;
   frames_.resize( frameCount );
-  for ( size_t frameNumber = startFrameNumber; frameNumber < endFrameNumber; ++frameNumber ) {
-    sprintf( fileName, uncompressedDataPath.c_str(), frameNumber );
-    auto& pointSet = frames_[frameNumber - startFrameNumber];
-    pointSet.resize( 0 );
-    if ( !pointSet.read( fileName, readNormals ) ) {
+  std::vector<uint8_t> loaded( frameCount, 0 );
+  tbb::task_arena      limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frameCount, [&]( const size_t i ) {
+      char frameFileName[4096];
+      sprintf( frameFileName, uncompressedDataPath.c_str(), startFrameNumber + i );
+      auto& pointSet = frames_[i];
+      pointSet.resize( 0 );
+      if ( !pointSet.read( frameFileName, readNormals ) ) { return; }
+      if ( colorTransform == COLOR_TRANSFORM_RGB_TO_YCBCR ) { pointSet.convertRGBToYUV(); }
+      loaded[i] = 1;
+    } );
+  } );
+  for ( size_t i = 0; i < frameCount; ++i ) {
+    if ( !loaded[i] ) {
+      sprintf( fileName, uncompressedDataPath.c_str(), startFrameNumber + i );
       std::cout << "Error: can't open " << fileName << std::endl;
       return false;
     }
-    if ( colorTransform == COLOR_TRANSFORM_RGB_TO_YCBCR ) { pointSet.convertRGBToYUV(); }
   }
   return true;
 }
 
-bool PCCGroupOfFrames::write( const std::string reconstructedDataPath, size_t& frameNumber ) {
+bool PCCGroupOfFrames::write( const std::string reconstructedDataPath, size_t& frameNumber, const bool asAscii ) {
   char fileName[4096];
   for ( auto& pointSet : frames_ ) {
     sprintf( fileName, reconstructedDataPath.c_str(), frameNumber++ );
-    if ( !pointSet.write( fileName, true ) ) { return false; }
+    if ( !pointSet.write( fileName, asAscii ) ) { return false; }
   }
   return true;
 }
+
+PCCGroupOfFramesLoader::PCCGroupOfFramesLoader( const std::string       dataPath,
+                                                const PCCColorTransform colorTransform,
+                                                const bool              readNormals,
+                                                const size_t            nbThread,
+                                                const size_t            memoryLimit ) :
+    dataPath_( dataPath ),
+    colorTransform_( colorTransform ),
+    readNormals_( readNormals ),
+    nbThread_( nbThread ),
+    memoryLimit_( memoryLimit ),
+    lastMemorySize_( 0 ),
+    lastFrameCount_( 0 ),
+    prefetchStartFrameNumber_( 0 ),
+    prefetchEndFrameNumber_( 0 ) {}
+
+PCCGroupOfFramesLoader::~PCCGroupOfFramesLoader() {
+  if ( pending_.valid() ) { pending_.wait(); }
+}
+
+bool PCCGroupOfFramesLoader::load( PCCGroupOfFrames& frames,
+                                   const size_t      startFrameNumber,
+                                   const size_t      endFrameNumber ) {
+  bool loaded = false;
+  if ( pending_.valid() ) {
+    const bool ret = pending_.get();
+    if ( prefetchStartFrameNumber_ == startFrameNumber && prefetchEndFrameNumber_ == endFrameNumber ) {
+      // the errors of the prefetched range have already been reported.
+      if ( !ret ) { return false; }
+      frames.getFrames().swap( prefetched_.getFrames() );
+      loaded = true;
+    }
+    prefetched_.clear();
+  }
+  if ( !loaded && !frames.load( dataPath_, startFrameNumber, endFrameNumber, colorTransform_, readNormals_,
+                                nbThread_ ) ) {
+    return false;
+  }
+  lastMemorySize_ = 0;
+  lastFrameCount_ = frames.size();
+  for ( auto& pointSet : frames ) { lastMemorySize_ += pointSet.getMemorySize(); }
+  return true;
+}
+
+bool PCCGroupOfFramesLoader::prefetch( const size_t startFrameNumber, const size_t endFrameNumber ) {
+  if ( pending_.valid() || endFrameNumber <= startFrameNumber ) { return false; }
+  if ( memoryLimit_ > 0 && lastFrameCount_ > 0 ) {
+    const size_t estimate = lastMemorySize_ / lastFrameCount_ * ( endFrameNumber - startFrameNumber );
+    if ( lastMemorySize_ + estimate > memoryLimit_ ) { return false; }
+  }
+  prefetchStartFrameNumber_ = startFrameNumber;
+  prefetchEndFrameNumber_   = endFrameNumber;
+  pending_                  = std::async( std::launch::async, [this, startFrameNumber, endFrameNumber] {
+    return prefetched_.load( dataPath_, startFrameNumber, endFrameNumber, colorTransform_, readNormals_, nbThread_ );
+  } );
+  return true;
+}
@@ -36,14 +36,269 @@
 #include "PCCKdTree.h"
 
 #include "KDTreeVectorOfVectorsAdaptor.h"
+#include "tbb/tbb.h"
 
 using namespace pcc;
 
 typedef KDTreeVectorOfVectorsAdaptor<PCCPointSet3, PCCType, float, 3, metric_L2_Simple_2, size_t> KdTreeAdaptor;
 
-PCCKdTree::PCCKdTree() : kdtree_( NULL ) {}
+// Result set of the radius searches: the num_results nearest points strictly inside the radius, ordered by
+// distance and then by index. Once the set is full the search radius shrinks to the current worst distance, so
+// the traversal stops early instead of collecting and sorting every point of the radius.
+// Equidistant points are deliberately ranked by increasing index so the result does not depend on the tree or
+// grid traversal order. When several points share the distance of the last kept neighbour, it may thus keep other
+// points than the sorted nanoflann radius search, which searchRadiusSorted() keeps for the smoothing.
+class PCCRadiusResultSet {
+ public:
+  PCCRadiusResultSet( const size_t capacity, const double radius, size_t* indices, double* dists ) :
+      capacity_( capacity ),
+      count_( 0 ),
+      radius_( radius ),
+      indices_( indices ),
+      dists_( dists ) {}
+  inline size_t size() const { return count_; }
+  inline bool   full() const { return count_ == capacity_; }
+  inline double worstDist() const {
+    // points at the worst distance must still be offered, a smaller index ranks them first
+    if ( !full() ) { return radius_; }
+    return ( std::min )( radius_, std::nextafter( dists_[capacity_ - 1], ( std::numeric_limits<double>::max )() ) );
+  }
+  inline void addPoint( const double dist, const size_t index ) {
+    if ( dist >= radius_ ) { return; }
+    size_t i = count_;
+    for ( ; i > 0 && ( dists_[i - 1] > dist || ( dists_[i - 1] == dist && indices_[i - 1] > index ) ); --i ) {
+      if ( i < capacity_ ) {
+        dists_[i]   = dists_[i - 1];
+        indices_[i] = indices_[i - 1];
+      }
+    }
+    if ( i < capacity_ ) {
+      dists_[i]   = dist;
+      indices_[i] = index;
+      if ( count_ < capacity_ ) { count_++; }
+    }
+  }
+
+ private:
+  size_t  capacity_;
+  size_t  count_;
+  double  radius_;
+  size_t* indices_;
+  double* dists_;
+};
+
+// Result set of the nearest tie searches: every point at the smallest distance, at most capacity of them by
+// increasing index. The search radius shrinks to the best distance found so far, so the traversal costs about
+// as much as a single nearest neighbour search.
+class PCCNearestTiesResultSet {
+ public:
+  PCCNearestTiesResultSet( const size_t capacity, size_t* indices ) :
+      capacity_( capacity ),
+      count_( 0 ),
+      best_( ( std::numeric_limits<double>::max )() ),
+      indices_( indices ) {}
+  inline size_t size() const { return count_; }
+  inline bool   full() const { return false; }
+  inline double bestDist() const { return best_; }
+  inline double worstDist() const {
+    // points at the best distance must still be offered
+    return count_ == 0 ? best_ : std::nextafter( best_, ( std::numeric_limits<double>::max )() );
+  }
+  inline void addPoint( const double dist, const size_t index ) {
+    if ( dist > best_ ) { return; }
+    if ( dist < best_ ) {
+      best_  = dist;
+      count_ = 0;
+    }
+    size_t i = count_;
+    for ( ; i > 0 && indices_[i - 1] > index; --i ) {
+      if ( i < capacity_ ) { indices_[i] = indices_[i - 1]; }
+    }
+    if ( i < capacity_ ) {
+      indices_[i] = index;
+      if ( count_ < capacity_ ) { count_++; }
+    }
+  }
+
+ private:
+  size_t  capacity_;
+  size_t  count_;
+  double  best_;
+  size_t* indices_;
+};
+
+// Exact neighbour index for points on the integer lattice. The points are bucketed in cubic cells of
+// 2^cellSizeLog2 voxels, stored in Morton order of the cells and found through an open addressing table. A query
+// visits the cells in shells of growing Chebyshev distance around its own cell and stops as soon as the next shell
+// cannot hold a point closer than the current worst result.
+class PCCVoxelGridIndex {
+ public:
+  PCCVoxelGridIndex( const PCCPointSet3& pointCloud );
+  ~PCCVoxelGridIndex() = default;
+  template <typename ResultSet>
+  void findNeighbors( ResultSet& resultSet, const PCCPoint3D& point ) const;
 
-PCCKdTree::PCCKdTree( const PCCPointSet3& pointCloud ) : kdtree_( NULL ) { init( pointCloud ); }
+ private:
+  struct Cell {
+    uint64_t key_;
+    uint32_t begin_;
+    uint32_t end_;
+  };
+  static const int32_t  cellSizeLog2 = 3;
+  static const uint64_t emptyKey     = ( std::numeric_limits<uint64_t>::max )();
+
+  static uint64_t mortonCode( const int32_t x, const int32_t y, const int32_t z ) {
+    uint64_t code = 0;
+    for ( int32_t bit = 0; bit < 21; ++bit ) {
+      code |= ( ( uint64_t( x >> bit ) & 1 ) << ( 3 * bit ) ) | ( ( uint64_t( y >> bit ) & 1 ) << ( 3 * bit + 1 ) ) |
+              ( ( uint64_t( z >> bit ) & 1 ) << ( 3 * bit + 2 ) );
+    }
+    return code;
+  }
+  static int32_t cellIndex( const int32_t value ) {
+    return value >= 0 ? value >> cellSizeLog2 : -( ( -value - 1 ) >> cellSizeLog2 ) - 1;
+  }
+  size_t slot( const uint64_t key ) const {
+    return size_t( ( key * 0x9E3779B97F4A7C15ULL ) >> ( 64 - tableSizeLog2_ ) ) & ( table_.size() - 1 );
+  }
+  const Cell* findCell( const uint64_t key ) const {
+    for ( size_t s = slot( key );; s = ( s + 1 ) & ( table_.size() - 1 ) ) {
+      if ( table_[s].key_ == key ) { return &table_[s]; }
+      if ( table_[s].key_ == emptyKey ) { return NULL; }
+    }
+  }
+  template <typename ResultSet>
+  void visitCell( ResultSet&        resultSet,
+                  const PCCPoint3D& point,
+                  const int32_t     x,
+                  const int32_t     y,
+                  const int32_t     z ) const;
+
+  int32_t                 origin_[3];
+  int32_t                 size_[3];
+  int32_t                 tableSizeLog2_;
+  std::vector<Cell>       table_;
+  std::vector<uint32_t>   indices_;
+  std::vector<PCCPoint3D> positions_;
+};
+
+PCCVoxelGridIndex::PCCVoxelGridIndex( const PCCPointSet3& pointCloud ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  int32_t      maxCoord[3];
+  for ( size_t k = 0; k < 3; ++k ) {
+    origin_[k]  = pointCount ? ( std::numeric_limits<int32_t>::max )() : 0;
+    maxCoord[k] = pointCount ? ( std::numeric_limits<int32_t>::min )() : 0;
+  }
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    for ( size_t k = 0; k < 3; ++k ) {
+      origin_[k]  = ( std::min )( origin_[k], int32_t( pointCloud[i][k] ) );
+      maxCoord[k] = ( std::max )( maxCoord[k], int32_t( pointCloud[i][k] ) );
+    }
+  }
+  for ( size_t k = 0; k < 3; ++k ) { size_[k] = ( ( maxCoord[k] - origin_[k] ) >> cellSizeLog2 ) + 1; }
+
+  // Sorting by cell code then index groups the points of a cell in increasing index order.
+  std::vector<std::pair<uint64_t, uint32_t>> keys( pointCount );
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    const auto& pos = pointCloud[i];
+    keys[i] = std::make_pair( mortonCode( ( pos[0] - origin_[0] ) >> cellSizeLog2,
+                                          ( pos[1] - origin_[1] ) >> cellSizeLog2,
+                                          ( pos[2] - origin_[2] ) >> cellSizeLog2 ),
+                              uint32_t( i ) );
+  }
+  std::sort( keys.begin(), keys.end() );
+  size_t cellCount = 0;
+  for ( size_t i = 0; i < pointCount; ++i ) { cellCount += ( i == 0 || keys[i].first != keys[i - 1].first ); }
+  for ( tableSizeLog2_ = 1; ( size_t( 1 ) << tableSizeLog2_ ) < 2 * cellCount; ++tableSizeLog2_ ) {}
+  table_.assign( size_t( 1 ) << tableSizeLog2_, Cell{emptyKey, 0, 0} );
+  indices_.resize( pointCount );
+  positions_.resize( pointCount );
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    indices_[i]   = keys[i].second;
+    positions_[i] = pointCloud[keys[i].second];
+    if ( i == 0 || keys[i].first != keys[i - 1].first ) {
+      size_t s = slot( keys[i].first );
+      while ( table_[s].key_ != emptyKey ) { s = ( s + 1 ) & ( table_.size() - 1 ); }
+      table_[s] = Cell{keys[i].first, uint32_t( i ), uint32_t( i )};
+    }
+  }
+  for ( auto& cell : table_ ) {
+    if ( cell.key_ == emptyKey ) { continue; }
+    while ( cell.end_ < pointCount && keys[cell.end_].first == cell.key_ ) { ++cell.end_; }
+  }
+}
+
+template <typename ResultSet>
+void PCCVoxelGridIndex::visitCell( ResultSet&        resultSet,
+                                   const PCCPoint3D& point,
+                                   const int32_t     x,
+                                   const int32_t     y,
+                                   const int32_t     z ) const {
+  const Cell* cell = findCell( mortonCode( x, y, z ) );
+  if ( cell == NULL ) { return; }
+  for ( uint32_t j = cell->begin_; j < cell->end_; ++j ) {
+    // same float accumulation as the kd-tree adaptor, so that equal points give equal distances
+    const auto& pos  = positions_[j];
+    float       dist = 0;
+    for ( size_t k = 0; k < 3; ++k ) {
+      const float diff = float( point[k] ) - float( pos[k] );
+      dist += diff * diff;
+    }
+    if ( dist < resultSet.worstDist() ) { resultSet.addPoint( dist, indices_[j] ); }
+  }
+}
+
+template <typename ResultSet>
+void PCCVoxelGridIndex::findNeighbors( ResultSet& resultSet, const PCCPoint3D& point ) const {
+  if ( indices_.empty() ) { return; }
+  int32_t center[3], lastShell = 0;
+  for ( size_t k = 0; k < 3; ++k ) {
+    center[k] = cellIndex( int32_t( point[k] ) - origin_[k] );
+    lastShell = ( std::max )( lastShell, ( std::max )( center[k], size_[k] - 1 - center[k] ) );
+  }
+  for ( int32_t d = 0; d <= lastShell; ++d ) {
+    if ( d > 0 ) {
+      // any point of shell d is at least ( d - 1 ) * cellSize + 1 away along one axis
+      const float gap = float( ( ( d - 1 ) << cellSizeLog2 ) + 1 );
+      if ( gap * gap >= resultSet.worstDist() ) { break; }
+    }
+    const int32_t x0 = ( std::max )( center[0] - d, 0 ), x1 = ( std::min )( center[0] + d, size_[0] - 1 );
+    const int32_t y0 = ( std::max )( center[1] - d, 0 ), y1 = ( std::min )( center[1] + d, size_[1] - 1 );
+    const int32_t z0 = ( std::max )( center[2] - d, 0 ), z1 = ( std::min )( center[2] + d, size_[2] - 1 );
+    for ( int32_t x = x0; x <= x1; ++x ) {
+      for ( int32_t y = y0; y <= y1; ++y ) {
+        if ( std::abs( x - center[0] ) == d || std::abs( y - center[1] ) == d ) {
+          for ( int32_t z = z0; z <= z1; ++z ) { visitCell( resultSet, point, x, y, z ); }
+        } else {
+          if ( center[2] - d >= 0 && center[2] - d < size_[2] ) { visitCell( resultSet, point, x, y, center[2] - d ); }
+          if ( center[2] + d >= 0 && center[2] + d < size_[2] ) { visitCell( resultSet, point, x, y, center[2] + d ); }
+        }
+      }
+    }
+  }
+}
+
+static void storeResults( const size_t               query,
+                          const size_t               count,
+                          const std::vector<size_t>& indices,
+                          const std::vector<double>& dists,
+                          PCCNNBatchResult&          results ) {
+  uint32_t* outIndices = results.indices( query );
+  float*    outDists   = results.dist( query );
+  results.count( query ) = (uint32_t)count;
+  for ( size_t j = 0; j < count; ++j ) {
+    outIndices[j] = (uint32_t)indices[j];
+    outDists[j]   = (float)dists[j];
+  }
+}
+
+PCCKdTree::PCCKdTree() : kdtree_( NULL ), grid_( NULL ) {}
+
+PCCKdTree::PCCKdTree( const PCCPointSet3& pointCloud, const PCCSpatialIndexType type ) :
+    kdtree_( NULL ),
+    grid_( NULL ) {
+  init( pointCloud, type );
+}
 
 PCCKdTree::~PCCKdTree() { clear(); }
 void PCCKdTree::clear() {
@@ -51,17 +306,72 @@ void PCCKdTree::clear() {
     delete ( (KdTreeAdaptor*)kdtree_ );
     kdtree_ = NULL;
   }
+  if ( grid_ ) {
+    delete ( (PCCVoxelGridIndex*)grid_ );
+    grid_ = NULL;
+  }
 }
 
-void PCCKdTree::init( const PCCPointSet3& pointCloud ) {
+void PCCKdTree::init( const PCCPointSet3& pointCloud, const PCCSpatialIndexType type ) {
   clear();
-  kdtree_ = new KdTreeAdaptor( 3, pointCloud, 10 );
+  if ( type == PCC_SPATIAL_INDEX_VOXEL_GRID ) {
+    grid_ = new PCCVoxelGridIndex( pointCloud );
+  } else {
+    kdtree_ = new KdTreeAdaptor( 3, pointCloud, 10 );
+  }
+}
+
+size_t PCCKdTree::knnSearch( const PCCPoint3D& point, const size_t num_results, size_t* indices, double* dists ) const {
+  if ( grid_ ) {
+    return radiusSearch( point, num_results, ( std::numeric_limits<double>::max )(), false, indices, dists );
+  }
+  if ( num_results == 0 ) { return 0; }
+  return ( (KdTreeAdaptor*)kdtree_ )->index->knnSearch( &point[0], num_results, indices, dists );
+}
+
+size_t PCCKdTree::radiusSearch( const PCCPoint3D& point,
+                                const size_t      num_results,
+                                const double      radius,
+                                const bool        sorted,
+                                size_t*           indices,
+                                double*           dists ) const {
+  if ( num_results == 0 ) { return 0; }
+  if ( sorted ) {
+    assert( kdtree_ != NULL );
+    std::vector<std::pair<size_t, double>> ret;
+    nanoflann::SearchParams                params;
+    const size_t found = ( (KdTreeAdaptor*)kdtree_ )->index->radiusSearch( &point[0], radius, ret, params );
+    const size_t count = ( std::min )( found, num_results );
+    for ( size_t i = 0; i < count; i++ ) {
+      indices[i] = ret[i].first;
+      dists[i]   = ret[i].second;
+    }
+    return count;
+  }
+  PCCRadiusResultSet resultSet( num_results, radius, indices, dists );
+  if ( grid_ ) {
+    ( (PCCVoxelGridIndex*)grid_ )->findNeighbors( resultSet, point );
+  } else {
+    ( (KdTreeAdaptor*)kdtree_ )->index->findNeighbors( resultSet, &point[0], nanoflann::SearchParams() );
+  }
+  return resultSet.size();
 }
 
 void PCCKdTree::search( const PCCPoint3D& point, const size_t num_results, PCCNNResult& results ) const {
   if ( num_results != results.size() ) { results.resize( num_results ); }
-  results.count() =
-      ( (KdTreeAdaptor*)kdtree_ )->index->knnSearch( &point[0], num_results, results.indices(), results.dist() );
+  results.count() = knnSearch( point, num_results, results.indices(), results.dist() );
+}
+
+void PCCKdTree::searchNearestTies( const PCCPoint3D& point, const size_t num_results, PCCNNResult& results ) const {
+  if ( num_results != results.size() ) { results.resize( num_results ); }
+  PCCNearestTiesResultSet resultSet( num_results, results.indices() );
+  if ( grid_ ) {
+    ( (PCCVoxelGridIndex*)grid_ )->findNeighbors( resultSet, point );
+  } else if ( num_results > 0 ) {
+    ( (KdTreeAdaptor*)kdtree_ )->index->findNeighbors( resultSet, &point[0], nanoflann::SearchParams() );
+  }
+  results.count() = resultSet.size();
+  for ( size_t i = 0; i < results.count(); ++i ) { results.dist( i ) = resultSet.bestDist(); }
 }
 
 #if 0
@@ -76,15 +386,77 @@ void PCCKdTree::searchRadius( const PCCPoint3D& point,
                               const size_t      num_results,
                               const double      radius,
                               PCCNNResult&      results ) const {
-  std::vector<std::pair<size_t, double> > ret;
-  nanoflann::SearchParams                 params;
-  results.count() = ( (KdTreeAdaptor*)kdtree_ )->index->radiusSearch( &point[0], radius, ret, params );
-  results.count() = ( std::min )( results.count(), num_results );
-  results.resize( num_results );
-  for ( size_t i = 0; i < results.count(); i++ ) {
-    results.indices( i ) = ret[i].first;
-    results.dist( i )    = ret[i].second;
-    ;
-  }
+  if ( num_results != results.size() ) { results.resize( num_results ); }
+  results.count() = radiusSearch( point, num_results, radius, false, results.indices(), results.dist() );
 }
 #endif
+
+void PCCKdTree::searchRadiusSorted( const PCCPoint3D& point,
+                                    const size_t      num_results,
+                                    const double      radius,
+                                    PCCNNResult&      results ) const {
+  if ( num_results != results.size() ) { results.resize( num_results ); }
+  results.count() = radiusSearch( point, num_results, radius, true, results.indices(), results.dist() );
+}
+
+void PCCKdTree::search( const PCCPointSet3& queries,
+                        const size_t        start,
+                        const size_t        end,
+                        const size_t        num_results,
+                        PCCNNBatchResult&   results,
+                        const size_t        nbThread ) const {
+  results.resize( end - start, num_results );
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( tbb::blocked_range<size_t>( start, end ), [&]( const tbb::blocked_range<size_t>& range ) {
+      std::vector<size_t> indices( num_results );
+      std::vector<double> dists( num_results );
+      for ( size_t i = range.begin(); i < range.end(); ++i ) {
+        const size_t count = knnSearch( queries[i], num_results, indices.data(), dists.data() );
+        storeResults( i - start, count, indices, dists, results );
+      }
+    } );
+  } );
+}
+
+void PCCKdTree::searchRadius( const PCCPointSet3& queries,
+                              const size_t        start,
+                              const size_t        end,
+                              const size_t        num_results,
+                              const double        radius,
+                              PCCNNBatchResult&   results,
+                              const size_t        nbThread ) const {
+  radiusSearch( queries, start, end, num_results, radius, false, results, nbThread );
+}
+
+void PCCKdTree::searchRadiusSorted( const PCCPointSet3& queries,
+                                    const size_t        start,
+                                    const size_t        end,
+                                    const size_t        num_results,
+                                    const double        radius,
+                                    PCCNNBatchResult&   results,
+                                    const size_t        nbThread ) const {
+  radiusSearch( queries, start, end, num_results, radius, true, results, nbThread );
+}
+
+void PCCKdTree::radiusSearch( const PCCPointSet3& queries,
+                              const size_t        start,
+                              const size_t        end,
+                              const size_t        num_results,
+                              const double        radius,
+                              const bool          sorted,
+                              PCCNNBatchResult&   results,
+                              const size_t        nbThread ) const {
+  results.resize( end - start, num_results );
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( tbb::blocked_range<size_t>( start, end ), [&]( const tbb::blocked_range<size_t>& range ) {
+      std::vector<size_t> indices( num_results );
+      std::vector<double> dists( num_results );
+      for ( size_t i = range.begin(); i < range.end(); ++i ) {
+        const size_t count = radiusSearch( queries[i], num_results, radius, sorted, indices.data(), dists.data() );
+        storeResults( i - start, count, indices, dists, results );
+      }
+    } );
+  } );
+}
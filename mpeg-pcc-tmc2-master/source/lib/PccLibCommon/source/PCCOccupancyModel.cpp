@@ -0,0 +1,151 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCOccupancyModel.h"
+
+#if OCCUPANCY_MAP_MODEL
+#include <torch/csrc/api/include/torch/utils.h>
+#include <ATen/Parallel.h>
+#endif
+
+using namespace pcc;
+
+void pcc::getOccupancyModelTiles( const size_t                        size,
+                                  const size_t                        tileSize,
+                                  const size_t                        halo,
+                                  const size_t                        stride,
+                                  size_t&                             windowSize,
+                                  std::vector<PCCOccupancyModelTile>& tiles ) {
+  tiles.clear();
+  // the windows are rounded up to the next multiple of stride, plus one more stride minus one pixel, so that rounding
+  // their origins down to a multiple of stride still keeps halo pixels after the tiles.
+  const size_t step = ( std::max )( stride, size_t( 1 ) );
+  windowSize        = ( tileSize + 2 * halo + 2 * step - 2 ) / step * step;
+  if ( tileSize == 0 || windowSize >= size || size % step != 0 ) {
+    windowSize = size;
+    tiles.push_back( {0, 0, size} );
+    return;
+  }
+  for ( size_t begin = 0; begin < size; begin += tileSize ) {
+    const size_t window = begin < halo ? 0 : ( std::min )( ( begin - halo ) / step * step, size - windowSize );
+    tiles.push_back( {window, begin, ( std::min )( begin + tileSize, size )} );
+  }
+}
+
+#if OCCUPANCY_MAP_MODEL
+
+PCCOccupancyModel::PCCOccupancyModel() : device_( at::kCPU ), loaded_( false ), useGeometry_( false ) {}
+
+PCCOccupancyModel::~PCCOccupancyModel() = default;
+
+bool PCCOccupancyModel::load( const PCCOccupancyModelParameters& params,
+                              const size_t                       width,
+                              const size_t                       height,
+                              const size_t                       geometryWidth,
+                              const size_t                       geometryHeight,
+                              PCCOccupancyModelSettings&         settings ) {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  const std::string&          modelName = params.modelName_;
+  try {
+    if ( !loaded_ || modelName != modelName_ ) {
+      loaded_ = false;
+      warmedUpShapes_.clear();
+      setThreadCount( params.nbThread_ );
+      torch::manual_seed( 0 );
+      module_ = torch::jit::load( modelName, device_ );
+      module_.to( device_ );
+      module_.eval();
+      modelName_   = modelName;
+      useGeometry_ = modelName.find( "RESI" ) != std::string::npos;
+      loaded_      = true;
+    }
+    settings.device_      = device_;
+    settings.useGeometry_ = useGeometry_;
+    const Shape shape     = {width, height, geometryWidth, geometryHeight};
+    if ( warmedUpShapes_.count( shape ) == 0 ) {
+      warmUp( shape );
+      warmedUpShapes_.insert( shape );
+    }
+  } catch ( const c10::Error& error ) {
+    std::cout << "Error: can't load occupancy map model " << modelName << ": " << error.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool PCCOccupancyModel::isLoaded() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return loaded_;
+}
+
+at::Tensor PCCOccupancyModel::forward( std::vector<torch::jit::IValue>& inputs ) {
+  // the module handle is copied under the lock, the inferences of the groups of frames then run concurrently.
+  torch::jit::script::Module module;
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    module = module_;
+  }
+  torch::NoGradGuard noGrad;
+  return module.forward( inputs ).toTensor();
+}
+
+void PCCOccupancyModel::setThreadCount( const size_t nbThread ) {
+  if ( nbThread == 0 ) { return; }
+  at::set_num_threads( (int)nbThread );
+  // the inter-op pool can only be sized once per process, before its first use.
+  static bool interOpThreadCountSet = false;
+  if ( !interOpThreadCountSet ) {
+    interOpThreadCountSet = true;
+    try {
+      at::set_num_interop_threads( (int)nbThread );
+    } catch ( const c10::Error& ) {}
+  }
+}
+
+void PCCOccupancyModel::warmUp( const Shape& shape ) {
+  // the graph executor profiles and optimizes the module during its first runs for a given input shape. Called with
+  // the mutex held.
+  const size_t       warmUpCount = 2;
+  const auto         options     = torch::TensorOptions().dtype( at::kFloat ).device( device_ );
+  torch::NoGradGuard noGrad;
+  for ( size_t i = 0; i < warmUpCount; i++ ) {
+    std::vector<torch::jit::IValue> inputs;
+    if ( useGeometry_ ) {
+      inputs.push_back( torch::zeros( {1, 1, (int64_t)shape[3], (int64_t)shape[2]}, options ) );
+    }
+    inputs.push_back( torch::zeros( {1, 1, (int64_t)shape[1], (int64_t)shape[0]}, options ) );
+    module_.forward( inputs );
+  }
+}
+
+#endif
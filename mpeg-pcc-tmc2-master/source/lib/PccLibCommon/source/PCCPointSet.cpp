@@ -36,40 +36,133 @@
 #include "PCCMath.h"
 #include "KDTreeVectorOfVectorsAdaptor.h"
 #include "PCCKdTree.h"
+#include "tbb/tbb.h"
 #include <numeric>
+#if _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace pcc;
 
-void PCCPointSet3::removeDuplicate() {
-  PCCPointSet3 newPointcloud;
-  if ( withColors_ ) { newPointcloud.hasColors(); }
-  if ( withReflectances_ ) { newPointcloud.addReflectances(); }
-  std::map<float, std::map<float, std::map<float, size_t>>> eMapA, eMapB;
-  if ( withColors_ ) {
-    for ( size_t i = 0; i < positions_.size(); ++i ) {
-      float x = positions_[i][0], y = positions_[i][1], z = positions_[i][2];
-      if ( eMapA.find( x ) != eMapA.end() && eMapA[x].find( y ) != eMapA[x].end() &&
-           eMapA[x][y].find( z ) != eMapA[x][y].end() ) {
-      } else {
-        eMapA[x][y][z] = i;
-        newPointcloud.addPoint( positions_[i], colors_[i] );
-      }
+// Read-only view of a whole file: memory-mapped on POSIX systems, loaded in memory otherwise.
+class PCCMappedFile {
+ public:
+  PCCMappedFile() : data_( nullptr ), size_( 0 ) {}
+  ~PCCMappedFile() { close(); }
+  bool open( const std::string& fileName ) {
+    close();
+#if _WIN32
+    std::ifstream ifs( fileName, std::ifstream::binary | std::ifstream::in );
+    if ( !ifs.is_open() ) { return false; }
+    ifs.seekg( 0, std::ifstream::end );
+    buffer_.resize( static_cast<size_t>( ifs.tellg() ) );
+    ifs.seekg( 0, std::ifstream::beg );
+    if ( !ifs.read( buffer_.data(), buffer_.size() ) ) { return false; }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#else
+    const int fd = ::open( fileName.c_str(), O_RDONLY );
+    if ( fd < 0 ) { return false; }
+    struct stat status;
+    if ( fstat( fd, &status ) != 0 ) {
+      ::close( fd );
+      return false;
     }
-  } else {
-    for ( size_t i = 0; i < positions_.size(); ++i ) {
-      float x = positions_[i][0], y = positions_[i][1], z = positions_[i][2];
-      if ( eMapA.find( x ) != eMapA.end() && eMapA[x].find( y ) != eMapA[x].end() &&
-           eMapA[x][y].find( z ) != eMapA[x][y].end() ) {
-      } else {
-        eMapA[x][y][z] = i;
-        newPointcloud.addPoint( positions_[i] );
+    if ( status.st_size > 0 ) {
+      void* map = mmap( nullptr, static_cast<size_t>( status.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+      if ( map == MAP_FAILED ) {
+        ::close( fd );
+        return false;
       }
+      madvise( map, static_cast<size_t>( status.st_size ), MADV_SEQUENTIAL );
+      data_ = static_cast<const char*>( map );
+      size_ = static_cast<size_t>( status.st_size );
     }
+    ::close( fd );
+#endif
+    return true;
   }
-  positions_.swap( newPointcloud.positions_ );
-  colors_.swap( newPointcloud.colors_ );
-  reflectances_.swap( newPointcloud.reflectances_ );
-  types_.swap( newPointcloud.types_ );
+  void close() {
+#if _WIN32
+    buffer_.clear();
+#else
+    if ( data_ != nullptr ) { munmap( const_cast<char*>( data_ ), size_ ); }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+  const char* data() const { return data_; }
+  size_t      size() const { return size_; }
+
+ private:
+  PCCMappedFile( const PCCMappedFile& ) = delete;
+  PCCMappedFile& operator=( const PCCMappedFile& ) = delete;
+  const char*    data_;
+  size_t         size_;
+#if _WIN32
+  std::vector<char> buffer_;
+#endif
+};
+
+template <typename T>
+static inline T readBinaryValue( const char* data, const bool swapBytes ) {
+  T value;
+  memcpy( &value, data, sizeof( T ) );
+  return swapBytes ? PCCEndianSwap( value ) : value;
+}
+
+// Packs the int16 coordinates in a 48-bit key whose unsigned order is the lexicographic order of the positions.
+static inline uint64_t positionKey( const PCCPoint3D& position ) {
+  return ( uint64_t( uint16_t( position[0] ) ^ 0x8000 ) << 32 ) |
+         ( uint64_t( uint16_t( position[1] ) ^ 0x8000 ) << 16 ) | uint64_t( uint16_t( position[2] ) ^ 0x8000 );
+}
+
+// Sorts the point indices by position, the duplicated points keeping their increasing index order, and returns
+// in groups the first sorted rank of each distinct position, followed by the point count.
+static void sortPositions( const std::vector<PCCPoint3D>& positions,
+                           std::vector<uint32_t>&         order,
+                           std::vector<uint32_t>&         groups,
+                           const size_t                   nbThread ) {
+  const size_t                               pointCount = positions.size();
+  std::vector<std::pair<uint64_t, uint32_t>> keys( pointCount );
+  tbb::task_arena                            limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
+      keys[i] = std::make_pair( positionKey( positions[i] ), uint32_t( i ) );
+    } );
+    tbb::parallel_sort( keys.begin(), keys.end() );
+  } );
+  order.resize( pointCount );
+  groups.clear();
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    order[i] = keys[i].second;
+    if ( i == 0 || keys[i].first != keys[i - 1].first ) { groups.push_back( uint32_t( i ) ); }
+  }
+  groups.push_back( uint32_t( pointCount ) );
+}
+
+void PCCPointSet3::removeDuplicate( const size_t nbThread ) {
+  std::vector<uint32_t> order, groups;
+  sortPositions( positions_, order, groups, nbThread );
+  // keep the first occurrence of each position, in the input order
+  std::vector<uint8_t> keep( positions_.size(), 0 );
+  for ( size_t g = 0; g + 1 < groups.size(); ++g ) { keep[order[groups[g]]] = 1; }
+  size_t count = 0;
+  for ( size_t i = 0; i < positions_.size(); ++i ) {
+    if ( !keep[i] ) { continue; }
+    positions_[count] = positions_[i];
+    if ( withColors_ ) { colors_[count] = colors_[i]; }
+    if ( withReflectances_ ) { reflectances_[count] = reflectances_[i]; }
+    if ( withNormals_ ) { normals_[count] = normals_[i]; }
+    if ( PCC_SAVE_POINT_TYPE ) { types_[count] = types_[i]; }
+    count++;
+  }
+  resize( count );
 }
 
 void PCCPointSet3::distanceGeo( const PCCPointSet3& pointcloud, float& distPAB, float& distPBA ) const {
@@ -161,51 +254,43 @@ PCCBox3D PCCPointSet3::computeBoundingBox() const {
   return bbox;
 }
 
-void PCCPointSet3::removeDuplicate( PCCPointSet3& newPointcloud, size_t dropDuplicates ) const {
-  if ( withColors_ ) { newPointcloud.hasColors(); }
+void PCCPointSet3::removeDuplicate( PCCPointSet3& newPointcloud,
+                                    size_t        dropDuplicates,
+                                    const size_t  nbThread ) const {
   if ( withReflectances_ ) { newPointcloud.addReflectances(); }
   if ( withNormals_ ) {
     std::cerr << "Normaled objects can't be modified or reordered \n" << std::endl;
     exit( -1 );
   }
-  std::map<float, std::map<float, std::map<float, std::vector<size_t>>>> map;
-  for ( size_t i = 0; i < positions_.size(); ++i ) {
-    float x = positions_[i][0], y = positions_[i][1], z = positions_[i][2];
-    map[x][y][z].push_back( i );
-  }
-  if ( withColors_ ) {
-    for ( auto itX = map.begin(); itX != map.end(); itX++ ) {
-      for ( auto itY = itX->second.begin(); itY != itX->second.end(); itY++ ) {
-        for ( auto itZ = itY->second.begin(); itZ != itY->second.end(); itZ++ ) {
-          auto& listIndex = itZ->second;
-          if ( listIndex.size() == 1 || dropDuplicates == 1 ) {
-            newPointcloud.addPoint( positions_[listIndex[0]], colors_[listIndex[0]] );
-          } else {
-            PCCColor3B average;
-            size_t     r = 0, g = 0, b = 0;
-            for ( auto& index : listIndex ) {
-              r += colors_[index][0];
-              g += colors_[index][1];
-              b += colors_[index][2];
-            }
-            average[0] = r / listIndex.size();
-            average[1] = g / listIndex.size();
-            average[2] = b / listIndex.size();
-            newPointcloud.addPoint( positions_[listIndex[0]], average );
-          }
-        }
-      }
-    }
-  } else {
-    for ( auto itX = map.begin(); itX != map.end(); itX++ ) {
-      for ( auto itY = itX->second.begin(); itY != itX->second.end(); itY++ ) {
-        for ( auto itZ = itY->second.begin(); itZ != itY->second.end(); itZ++ ) {
-          auto& listIndex = itZ->second;
-          newPointcloud.addPoint( positions_[listIndex[0]] );
+  std::vector<uint32_t> order, groups;
+  sortPositions( positions_, order, groups, nbThread );
+  const size_t start = newPointcloud.getPointCount();
+  newPointcloud.resize( start + groups.size() - 1 );
+  if ( withColors_ ) { newPointcloud.addColors(); }
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), groups.size() - 1, [&]( const size_t group ) {
+      const size_t index              = start + group;
+      const size_t count              = groups[group + 1] - groups[group];
+      newPointcloud.positions_[index] = positions_[order[groups[group]]];
+      if ( !withColors_ ) { return; }
+      if ( count == 1 || dropDuplicates == 1 ) {
+        newPointcloud.colors_[index] = colors_[order[groups[group]]];
+      } else {
+        PCCColor3B average;
+        size_t     r = 0, g = 0, b = 0;
+        for ( size_t i = groups[group]; i < groups[group + 1]; ++i ) {
+          r += colors_[order[i]][0];
+          g += colors_[order[i]][1];
+          b += colors_[order[i]][2];
         }
+        average[0]                   = r / count;
+        average[1]                   = g / count;
+        average[2]                   = b / count;
+        newPointcloud.colors_[index] = average;
       }
-    }
-  }
+    } );
+  } );
 }
 
 typedef unsigned int UInt;
@@ -246,57 +331,50 @@ void PCCPointSet3::sortColor( std::vector<size_t>& list ) {
   }
 }
 
-void PCCPointSet3::reorder( PCCPointSet3& newPointcloud, bool dropDuplicates ) {
-  std::map<float, std::map<float, std::map<float, std::vector<size_t>>>> map;
-  size_t                                                                 duplicate = 0;
-  for ( size_t i = 0; i < positions_.size(); ++i ) {
-    float x = positions_[i][0], y = positions_[i][1], z = positions_[i][2];
-    if ( map.find( x ) != map.end() && map[x].find( y ) != map[x].end() && map[x][y].find( z ) != map[x][y].end() ) {
-      duplicate++;
-    }
-    map[x][y][z].push_back( i );
-  }
-  if ( withColors_ ) {
-    for ( auto itX = map.begin(); itX != map.end(); itX++ ) {
-      for ( auto itY = itX->second.begin(); itY != itX->second.end(); itY++ ) {
-        for ( auto itZ = itY->second.begin(); itZ != itY->second.end(); itZ++ ) {
-          auto& listIndex = itZ->second;
-          if ( listIndex.size() > 1 ) { sortColor( listIndex ); }
-          if ( dropDuplicates ) {
-            PCCColor3B average;
-            size_t     r = 0, g = 0, b = 0;
-            for ( auto& index : listIndex ) {
-              r += colors_[index][0];
-              g += colors_[index][1];
-              b += colors_[index][2];
-            }
-            average[0] = r / listIndex.size();
-            average[1] = g / listIndex.size();
-            average[2] = b / listIndex.size();
-            newPointcloud.addPoint( positions_[listIndex[0]], average );
-          } else {
-            for ( auto& index : listIndex ) { newPointcloud.addPoint( positions_[index], colors_[index] ); }
-          }
+void PCCPointSet3::reorder( PCCPointSet3& newPointcloud, bool dropDuplicates, const size_t nbThread ) {
+  std::vector<uint32_t> order, groups;
+  sortPositions( positions_, order, groups, nbThread );
+  // duplicated points are only merged when they carry colors to average
+  const bool   merge = withColors_ && dropDuplicates;
+  const size_t start = newPointcloud.getPointCount();
+  newPointcloud.resize( start + ( merge ? groups.size() - 1 : positions_.size() ) );
+  if ( withColors_ ) { newPointcloud.addColors(); }
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), groups.size() - 1, [&]( const size_t group ) {
+      if ( merge ) {
+        const size_t count = groups[group + 1] - groups[group];
+        PCCColor3B   average;
+        size_t       r = 0, g = 0, b = 0;
+        for ( size_t i = groups[group]; i < groups[group + 1]; ++i ) {
+          r += colors_[order[i]][0];
+          g += colors_[order[i]][1];
+          b += colors_[order[i]][2];
         }
-      }
-    }
-  } else {
-    for ( auto itX = map.begin(); itX != map.end(); itX++ ) {
-      for ( auto itY = itX->second.begin(); itY != itX->second.end(); itY++ ) {
-        for ( auto itZ = itY->second.begin(); itZ != itY->second.end(); itZ++ ) {
-          auto& listIndex = itZ->second;
-          for ( auto& index : listIndex ) { newPointcloud.addPoint( positions_[index] ); }
+        average[0]                              = r / count;
+        average[1]                              = g / count;
+        average[2]                              = b / count;
+        newPointcloud.positions_[start + group] = positions_[order[groups[group]]];
+        newPointcloud.colors_[start + group]    = average;
+      } else {
+        for ( size_t i = groups[group]; i < groups[group + 1]; ++i ) {
+          newPointcloud.positions_[start + i] = positions_[order[i]];
+          if ( withColors_ ) { newPointcloud.colors_[start + i] = colors_[order[i]]; }
+        }
+        if ( withColors_ ) {
+          std::sort( newPointcloud.colors_.begin() + start + groups[group],
+                     newPointcloud.colors_.begin() + start + groups[group + 1] );
         }
       }
-    }
-  }
+    } );
+  } );
 }
 
-void PCCPointSet3::reorder() {
+void PCCPointSet3::reorder( const size_t nbThread ) {
   PCCPointSet3 newPointcloud;
   if ( withColors_ ) { newPointcloud.hasColors(); }
   if ( withReflectances_ ) { newPointcloud.addReflectances(); }
-  reorder( newPointcloud, false );
+  reorder( newPointcloud, false, nbThread );
   swap( newPointcloud );
 }
 void PCCPointSet3::swap( PCCPointSet3& newPointcloud ) {
@@ -347,31 +425,19 @@ bool PCCPointSet3::isMissedBboxEmpty( std::vector<size_t> missedPoints, PCCBox3D
 }
 
 bool PCCPointSet3::write( const std::string& fileName, const bool asAscii ) {
-  std::ofstream fout( fileName, std::ofstream::out );
+  std::ofstream fout( fileName, asAscii ? std::ofstream::out : std::ofstream::binary | std::ofstream::out );
   if ( !fout.is_open() ) { return false; }
   const size_t pointCount = getPointCount();
   fout << "ply" << std::endl;
-
   if ( asAscii ) {
     fout << "format ascii 1.0" << std::endl;
   } else {
-    PCCEndianness endianess = PCCSystemEndianness();
-    if ( endianess == PCC_BIG_ENDIAN ) {
-      fout << "format binary_big_endian 1.0" << std::endl;
-    } else {
-      fout << "format binary_little_endian 1.0" << std::endl;
-    }
+    fout << "format binary_little_endian 1.0" << std::endl;
   }
   fout << "element vertex " << pointCount << std::endl;
-  if ( asAscii ) {
-    fout << "property float x" << std::endl;
-    fout << "property float y" << std::endl;
-    fout << "property float z" << std::endl;
-  } else {
-    fout << "property int16 x" << std::endl;
-    fout << "property int16 y" << std::endl;
-    fout << "property int16 z" << std::endl;
-  }
+  fout << "property float x" << std::endl;
+  fout << "property float y" << std::endl;
+  fout << "property float z" << std::endl;
   if ( hasColors() ) {
     fout << "property uchar red" << std::endl;
     fout << "property uchar green" << std::endl;
@@ -404,29 +470,39 @@ bool PCCPointSet3::write( const std::string& fileName, const bool asAscii ) {
       fout << std::endl;
     }
   } else {
-    fout.clear();
-    fout.close();
-    fout.open( fileName, std::ofstream::binary | std::ofstream::out );
+    // the whole body is packed in memory and written at once, little endian whatever the host order.
+    const size_t stride = 3 * sizeof( float ) + ( hasColors() ? 3 * sizeof( uint8_t ) : 0 ) +
+                          ( hasReflectances() ? sizeof( uint16_t ) : 0 ) + ( PCC_SAVE_POINT_TYPE ? sizeof( uint8_t ) : 0 );
+    std::vector<char> buffer( pointCount * stride );
     for ( size_t i = 0; i < pointCount; ++i ) {
-      const PCCPoint3D& position = ( *this )[i];
-      fout.write( reinterpret_cast<const char* const>( &position ), sizeof( PCCType ) * 3 );
+      const PCCPoint3D& position = positions_[i];
+      char*             data     = buffer.data() + i * stride;
+      for ( size_t k = 0; k < 3; ++k, data += sizeof( float ) ) {
+        const float value = PCCToLittleEndian( static_cast<float>( position[k] ) );
+        memcpy( data, &value, sizeof( float ) );
+      }
       if ( hasColors() ) {
-        const PCCColor3B& color = getColor( i );
-        fout.write( reinterpret_cast<const char*>( &color ), sizeof( uint8_t ) * 3 );
+        const PCCColor3B& color = colors_[i];
+        *data++                 = static_cast<char>( color[0] );
+        *data++                 = static_cast<char>( color[1] );
+        *data++                 = static_cast<char>( color[2] );
       }
       if ( hasReflectances() ) {
-        const uint16_t& reflectance = getReflectance( i );
-        fout.write( reinterpret_cast<const char*>( &reflectance ), sizeof( uint16_t ) );
+        const uint16_t reflectance = PCCToLittleEndian( reflectances_[i] );
+        memcpy( data, &reflectance, sizeof( uint16_t ) );
+        data += sizeof( uint16_t );
       }
-      if ( PCC_SAVE_POINT_TYPE ) { fout.write( reinterpret_cast<const char* const>( &types_[i] ), sizeof( uint8_t ) ); }
+      if ( PCC_SAVE_POINT_TYPE ) { *data++ = static_cast<char>( types_[i] ); }
     }
+    fout.write( buffer.data(), buffer.size() );
   }
+  const bool success = fout.good();
   fout.close();
-  return true;
+  return success;
 }
 bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
-  std::ifstream ifs( fileName, std::ifstream::in );
-  if ( !ifs.is_open() ) { return false; }
+  PCCMappedFile file;
+  if ( !file.open( fileName ) ) { return false; }
   enum AttributeType {
     ATTRIBUTE_TYPE_FLOAT64 = 0,
     ATTRIBUTE_TYPE_FLOAT32 = 1,
@@ -443,6 +519,7 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
     std::string   name;
     AttributeType type;
     size_t        byteCount;
+    size_t        offset;
   };
 
   std::vector<AttributeInfo> attributesInfo;
@@ -451,32 +528,49 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
   char                     tmp[MAX_BUFFER_SIZE];
   const char*              sep = " \t\r";
   std::vector<std::string> tokens;
+  const char* const        end    = file.data() + file.size();
+  const char*              cursor = file.data();
+  auto                     getLine = [&]( const char*& lineEnd ) {
+    if ( cursor >= end ) { return false; }
+    lineEnd = static_cast<const char*>( memchr( cursor, '\n', end - cursor ) );
+    if ( lineEnd == nullptr ) { lineEnd = end; }
+    return true;
+  };
+  auto getHeaderTokens = [&]() {
+    const char* lineEnd = nullptr;
+    if ( !getLine( lineEnd ) ) { return false; }
+    const size_t length = ( std::min )( static_cast<size_t>( lineEnd - cursor ), MAX_BUFFER_SIZE - 1 );
+    memcpy( tmp, cursor, length );
+    tmp[length] = '\0';
+    cursor      = lineEnd < end ? lineEnd + 1 : end;
+    getTokens( tmp, sep, tokens );
+    return true;
+  };
 
-  ifs.getline( tmp, MAX_BUFFER_SIZE );
-  getTokens( tmp, sep, tokens );
-  if ( tokens.empty() || tokens[0] != "ply" ) {
+  if ( !getHeaderTokens() || tokens.empty() || tokens[0] != "ply" ) {
     std::cout << "Error: corrupted file!" << std::endl;
     return false;
   }
-  bool   isAscii          = false;
-  double version          = 1.0;
-  size_t pointCount       = 0;
-  bool   isVertexProperty = true;
+  bool          isAscii          = false;
+  PCCEndianness endianness       = PCC_LITTLE_ENDIAN;
+  double        version          = 1.0;
+  size_t        pointCount       = 0;
+  size_t        stride           = 0;
+  bool          isVertexProperty = true;
   while ( 1 ) {
-    if ( ifs.eof() ) {
+    if ( !getHeaderTokens() ) {
       std::cout << "Error: corrupted header!" << std::endl;
       return false;
     }
-    ifs.getline( tmp, MAX_BUFFER_SIZE );
-    getTokens( tmp, sep, tokens );
     if ( tokens.empty() || tokens[0] == "comment" ) { continue; }
     if ( tokens[0] == "format" ) {
       if ( tokens.size() != 3 ) {
         std::cout << "Error: corrupted format info!" << std::endl;
         return false;
       }
-      isAscii = tokens[1] == "ascii";
-      version = atof( tokens[2].c_str() );
+      isAscii    = tokens[1] == "ascii";
+      endianness = tokens[1] == "binary_big_endian" ? PCC_BIG_ENDIAN : PCC_LITTLE_ENDIAN;
+      version    = atof( tokens[2].c_str() );
     } else if ( tokens[0] == "element" ) {
       if ( tokens.size() != 3 ) {
         std::cout << "Error: corrupted element info!" << std::endl;
@@ -498,7 +592,7 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       attributesInfo.resize( attributeIndex + 1 );
       AttributeInfo& attributeInfo = attributesInfo[attributeIndex];
       attributeInfo.name           = propertyName;
-      if ( propertyType == "float64" ) {
+      if ( propertyType == "float64" || propertyType == "double" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_FLOAT64;
         attributeInfo.byteCount = 8;
       } else if ( propertyType == "float" || propertyType == "float32" ) {
@@ -507,10 +601,10 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       } else if ( propertyType == "uint64" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_UINT64;
         attributeInfo.byteCount = 8;
-      } else if ( propertyType == "uint32" ) {
+      } else if ( propertyType == "uint32" || propertyType == "uint" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_UINT32;
         attributeInfo.byteCount = 4;
-      } else if ( propertyType == "uint16" ) {
+      } else if ( propertyType == "uint16" || propertyType == "ushort" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_UINT16;
         attributeInfo.byteCount = 2;
       } else if ( propertyType == "uchar" || propertyType == "uint8" ) {
@@ -519,16 +613,21 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       } else if ( propertyType == "int64" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT64;
         attributeInfo.byteCount = 8;
-      } else if ( propertyType == "int32" ) {
+      } else if ( propertyType == "int32" || propertyType == "int" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT32;
         attributeInfo.byteCount = 4;
-      } else if ( propertyType == "int16" ) {
+      } else if ( propertyType == "int16" || propertyType == "short" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT16;
         attributeInfo.byteCount = 2;
       } else if ( propertyType == "char" || propertyType == "int8" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT8;
         attributeInfo.byteCount = 1;
+      } else {
+        std::cout << "Error: non-supported property type " << propertyType << "!" << std::endl;
+        return false;
       }
+      attributeInfo.offset = stride;
+      stride += attributeInfo.byteCount;
     } else if ( tokens[0] == "end_header" ) {
       break;
     }
@@ -551,11 +650,11 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
   const size_t attributeCount   = attributesInfo.size();
   for ( size_t a = 0; a < attributeCount; ++a ) {
     const auto& attributeInfo = attributesInfo[a];
-    if ( attributeInfo.name == "x" && ( attributeInfo.byteCount == 8 || attributeInfo.byteCount == 4 ) ) {
+    if ( attributeInfo.name == "x" ) {
       indexX = a;
-    } else if ( attributeInfo.name == "y" && ( attributeInfo.byteCount == 8 || attributeInfo.byteCount == 4 ) ) {
+    } else if ( attributeInfo.name == "y" ) {
       indexY = a;
-    } else if ( attributeInfo.name == "z" && ( attributeInfo.byteCount == 8 || attributeInfo.byteCount == 4 ) ) {
+    } else if ( attributeInfo.name == "z" ) {
       indexZ = a;
     } else if ( attributeInfo.name == "red" && attributeInfo.byteCount == 1 ) {
       indexR = a;
@@ -563,11 +662,11 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       indexG = a;
     } else if ( attributeInfo.name == "blue" && attributeInfo.byteCount == 1 ) {
       indexB = a;
-    } else if ( attributeInfo.name == "nx" && attributeInfo.byteCount == 4 && readNormals ) {
+    } else if ( attributeInfo.name == "nx" && readNormals ) {
       indexNX = a;
-    } else if ( attributeInfo.name == "ny" && attributeInfo.byteCount == 4 && readNormals ) {
+    } else if ( attributeInfo.name == "ny" && readNormals ) {
       indexNY = a;
-    } else if ( attributeInfo.name == "nz" && attributeInfo.byteCount == 4 && readNormals ) {
+    } else if ( attributeInfo.name == "nz" && readNormals ) {
       indexNZ = a;
     } else if ( ( attributeInfo.name == "reflectance" || attributeInfo.name == "refc" ) &&
                 attributeInfo.byteCount <= 2 ) {
@@ -583,120 +682,123 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
   withNormals_ = indexNX != PCC_UNDEFINED_INDEX && indexNY != PCC_UNDEFINED_INDEX && indexNZ != PCC_UNDEFINED_INDEX;
   resize( pointCount );
   if ( isAscii ) {
-    size_t pointCounter = 0;
-    while ( !ifs.eof() && pointCounter < pointCount ) {
-      ifs.getline( tmp, MAX_BUFFER_SIZE );
-      getTokens( tmp, sep, tokens );
-      if ( tokens.empty() ) { continue; }
-      if ( tokens.size() < attributeCount ) { return false; }
+    std::vector<const char*> fields( attributeCount );
+    std::vector<size_t>      lengths( attributeCount );
+    auto                     field = [&]( const size_t a ) {
+      const size_t length = ( std::min )( lengths[a], MAX_BUFFER_SIZE - 1 );
+      memcpy( tmp, fields[a], length );
+      tmp[length] = '\0';
+      return tmp;
+    };
+    size_t      pointCounter = 0;
+    const char* lineEnd      = nullptr;
+    while ( pointCounter < pointCount && getLine( lineEnd ) ) {
+      size_t fieldCount = 0;
+      for ( const char* c = cursor; c < lineEnd && fieldCount < attributeCount; ) {
+        if ( !compareSeparators( *c, sep ) ) {
+          ++c;
+          continue;
+        }
+        fields[fieldCount] = c;
+        while ( c < lineEnd && compareSeparators( *c, sep ) ) { ++c; }
+        lengths[fieldCount] = c - fields[fieldCount];
+        ++fieldCount;
+      }
+      cursor = lineEnd < end ? lineEnd + 1 : end;
+      if ( fieldCount == 0 ) { continue; }
+      if ( fieldCount < attributeCount ) { return false; }
       auto& position = positions_[pointCounter];
-      position[0]    = atof( tokens[indexX].c_str() );
-      position[1]    = atof( tokens[indexY].c_str() );
-      position[2]    = atof( tokens[indexZ].c_str() );
+      position[0]    = atof( field( indexX ) );
+      position[1]    = atof( field( indexY ) );
+      position[2]    = atof( field( indexZ ) );
       if ( hasColors() ) {
         auto& color = colors_[pointCounter];
-        color[0]    = atoi( tokens[indexR].c_str() );
-        color[1]    = atoi( tokens[indexG].c_str() );
-        color[2]    = atoi( tokens[indexB].c_str() );
+        color[0]    = atoi( field( indexR ) );
+        color[1]    = atoi( field( indexG ) );
+        color[2]    = atoi( field( indexB ) );
+      }
+      if ( hasReflectances() ) { reflectances_[pointCounter] = uint16_t( atoi( field( indexReflectance ) ) ); }
+      if ( hasNormals() ) {
+        auto& normal = normals_[pointCounter];
+        normal[0]    = atof( field( indexNX ) );
+        normal[1]    = atof( field( indexNY ) );
+        normal[2]    = atof( field( indexNZ ) );
       }
-      if ( hasReflectances() ) { reflectances_[pointCounter] = uint16_t( atoi( tokens[indexReflectance].c_str() ) ); }
       ++pointCounter;
     }
   } else {
-    ifs.close();
-    ifs.open( fileName, std::ifstream::binary | std::ifstream::in );
-    ifs.read( tmp, MAX_BUFFER_SIZE );
-    char* str       = strstr( tmp, "end_header" );
-    str             = strstr( str, "\n" );
-    int headerCount = str - tmp + 1;
-    ifs.close();
-    ifs.open( fileName, std::ifstream::binary | std::ifstream::in );
-    ifs.read( tmp, headerCount );
-    for ( size_t pointCounter = 0; pointCounter < pointCount && !ifs.eof(); ++pointCounter ) {
-      auto& position = positions_[pointCounter];
-      for ( size_t a = 0; a < attributeCount && !ifs.eof(); ++a ) {
-        const auto& attributeInfo = attributesInfo[a];
-        if ( a == indexX ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float x;
-            ifs.read( reinterpret_cast<char*>( &x ), sizeof( float ) );
-            position[0] = x;
-          } else {
-            double x;
-            ifs.read( reinterpret_cast<char*>( &x ), sizeof( double ) );
-            position[0] = x;
-          }
-        } else if ( a == indexY ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float y;
-            ifs.read( reinterpret_cast<char*>( &y ), sizeof( float ) );
-            position[1] = y;
-          } else {
-            double y;
-            ifs.read( reinterpret_cast<char*>( &y ), sizeof( double ) );
-            position[1] = y;
-          }
-        } else if ( a == indexZ ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float z;
-            ifs.read( reinterpret_cast<char*>( &z ), sizeof( float ) );
-            position[2] = z;
-          } else {
-            double z;
-            ifs.read( reinterpret_cast<char*>( &z ), sizeof( double ) );
-            position[2] = z;
-          }
-        } else if ( a == indexR && attributeInfo.byteCount == 1 ) {
-          auto& color = colors_[pointCounter];
-          ifs.read( reinterpret_cast<char*>( &color[0] ), sizeof( uint8_t ) );
-        } else if ( a == indexG && attributeInfo.byteCount == 1 ) {
+    if ( static_cast<size_t>( end - cursor ) < pointCount * stride ) {
+      std::cout << "Error: truncated file!" << std::endl;
+      return false;
+    }
+    const bool swapBytes = endianness != PCCSystemEndianness();
+    const bool isFloatXYZ =
+        attributesInfo[indexX].type == ATTRIBUTE_TYPE_FLOAT32 && attributesInfo[indexY].type == ATTRIBUTE_TYPE_FLOAT32 &&
+        attributesInfo[indexZ].type == ATTRIBUTE_TYPE_FLOAT32 &&
+        attributesInfo[indexY].offset == attributesInfo[indexX].offset + sizeof( float ) &&
+        attributesInfo[indexZ].offset == attributesInfo[indexY].offset + sizeof( float );
+    if ( isFloatXYZ && !swapBytes && !hasReflectances() && !hasNormals() ) {
+      // common layout: float x, y, z and optionally uchar red, green, blue.
+      const size_t offsetXYZ = attributesInfo[indexX].offset;
+      const size_t offsetR   = hasColors() ? attributesInfo[indexR].offset : 0;
+      const size_t offsetG   = hasColors() ? attributesInfo[indexG].offset : 0;
+      const size_t offsetB   = hasColors() ? attributesInfo[indexB].offset : 0;
+      for ( size_t pointCounter = 0; pointCounter < pointCount; ++pointCounter ) {
+        const char* data = cursor + pointCounter * stride;
+        float       xyz[3];
+        memcpy( xyz, data + offsetXYZ, sizeof( xyz ) );
+        auto& position = positions_[pointCounter];
+        position[0]    = xyz[0];
+        position[1]    = xyz[1];
+        position[2]    = xyz[2];
+        if ( hasColors() ) {
           auto& color = colors_[pointCounter];
-          ifs.read( reinterpret_cast<char*>( &color[1] ), sizeof( uint8_t ) );
-        } else if ( a == indexB && attributeInfo.byteCount == 1 ) {
+          color[0]    = static_cast<uint8_t>( data[offsetR] );
+          color[1]    = static_cast<uint8_t>( data[offsetG] );
+          color[2]    = static_cast<uint8_t>( data[offsetB] );
+        }
+      }
+    } else {
+      auto value = [&]( const char* data, const size_t a ) -> double {
+        const auto& attributeInfo = attributesInfo[a];
+        data += attributeInfo.offset;
+        switch ( attributeInfo.type ) {
+          case ATTRIBUTE_TYPE_FLOAT64: return readBinaryValue<double>( data, swapBytes );
+          case ATTRIBUTE_TYPE_FLOAT32: return readBinaryValue<float>( data, swapBytes );
+          case ATTRIBUTE_TYPE_UINT64: return static_cast<double>( readBinaryValue<uint64_t>( data, swapBytes ) );
+          case ATTRIBUTE_TYPE_UINT32: return readBinaryValue<uint32_t>( data, swapBytes );
+          case ATTRIBUTE_TYPE_UINT16: return readBinaryValue<uint16_t>( data, swapBytes );
+          case ATTRIBUTE_TYPE_UINT8: return readBinaryValue<uint8_t>( data, swapBytes );
+          case ATTRIBUTE_TYPE_INT64: return static_cast<double>( readBinaryValue<int64_t>( data, swapBytes ) );
+          case ATTRIBUTE_TYPE_INT32: return readBinaryValue<int32_t>( data, swapBytes );
+          case ATTRIBUTE_TYPE_INT16: return readBinaryValue<int16_t>( data, swapBytes );
+          case ATTRIBUTE_TYPE_INT8: return readBinaryValue<int8_t>( data, swapBytes );
+        }
+        return 0.0;
+      };
+      for ( size_t pointCounter = 0; pointCounter < pointCount; ++pointCounter ) {
+        const char* data     = cursor + pointCounter * stride;
+        auto&       position = positions_[pointCounter];
+        position[0]          = value( data, indexX );
+        position[1]          = value( data, indexY );
+        position[2]          = value( data, indexZ );
+        if ( hasColors() ) {
           auto& color = colors_[pointCounter];
-          ifs.read( reinterpret_cast<char*>( &color[2] ), sizeof( uint8_t ) );
-        } else if ( a == indexNX ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float nx;
-            ifs.read( reinterpret_cast<char*>( &nx ), sizeof( float ) );
-            normals_[pointCounter][0] = nx;
-          } else {
-            double nx;
-            ifs.read( reinterpret_cast<char*>( &nx ), sizeof( double ) );
-            normals_[pointCounter][0] = nx;
-          }
-        } else if ( a == indexNY ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float ny;
-            ifs.read( reinterpret_cast<char*>( &ny ), sizeof( float ) );
-            normals_[pointCounter][1] = ny;
-          } else {
-            double ny;
-            ifs.read( reinterpret_cast<char*>( &ny ), sizeof( double ) );
-            normals_[pointCounter][1] = ny;
-          }
-        } else if ( a == indexNZ ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float nz;
-            ifs.read( reinterpret_cast<char*>( &nz ), sizeof( float ) );
-            normals_[pointCounter][2] = nz;
-          } else {
-            double nz;
-            ifs.read( reinterpret_cast<char*>( &nz ), sizeof( double ) );
-            normals_[pointCounter][2] = nz;
-          }
-        } else if ( a == indexReflectance && attributeInfo.byteCount <= 2 ) {
-          if ( indexReflectance == 1 ) {
-            uint8_t reflectance;
-            ifs.read( reinterpret_cast<char*>( &reflectance ), sizeof( uint8_t ) );
-            reflectances_[pointCounter] = reflectance;
-          } else {
-            auto& reflectance = reflectances_[pointCounter];
-            ifs.read( reinterpret_cast<char*>( reflectance ), sizeof( uint16_t ) );
-          }
-        } else {
-          char buffer[128];
-          ifs.read( buffer, attributeInfo.byteCount );
+          color[0]    = static_cast<uint8_t>( data[attributesInfo[indexR].offset] );
+          color[1]    = static_cast<uint8_t>( data[attributesInfo[indexG].offset] );
+          color[2]    = static_cast<uint8_t>( data[attributesInfo[indexB].offset] );
+        }
+        if ( hasReflectances() ) {
+          const auto& attributeInfo = attributesInfo[indexReflectance];
+          reflectances_[pointCounter] =
+              attributeInfo.byteCount == 1 ? static_cast<uint8_t>( data[attributeInfo.offset] )
+                                           : readBinaryValue<uint16_t>( data + attributeInfo.offset, swapBytes );
+        }
+        if ( hasNormals() ) {
+          auto& normal = normals_[pointCounter];
+          normal[0]    = value( data, indexNX );
+          normal[1]    = value( data, indexNY );
+          normal[2]    = value( data, indexNZ );
         }
       }
     }
@@ -752,6 +854,36 @@ void PCCPointSet3::convertYUVToRGB() {  // BT709
   }
 }
 
+// Inverts the results of the backward searches: for each target point, the source points that found it within
+// maxDist2, listed in increasing source index order as the serial accumulation pushed them.
+static void groupBackwardNeighbors( const PCCNNBatchResult& nearest,
+                                    const size_t            pointCountSource,
+                                    const size_t            pointCountTarget,
+                                    const double            maxDist2,
+                                    std::vector<uint32_t>&  offsets,
+                                    std::vector<uint32_t>&  sources,
+                                    std::vector<float>&     dists ) {
+  offsets.assign( pointCountTarget + 1, 0 );
+  for ( size_t index = 0; index < pointCountSource; ++index ) {
+    for ( size_t i = 0; i < nearest.count( index ); ++i ) {
+      if ( nearest.dist( index )[i] <= maxDist2 ) { offsets[nearest.indices( index )[i] + 1]++; }
+    }
+  }
+  for ( size_t index = 0; index < pointCountTarget; ++index ) { offsets[index + 1] += offsets[index]; }
+  sources.resize( offsets[pointCountTarget] );
+  dists.resize( offsets[pointCountTarget] );
+  std::vector<uint32_t> cursors( offsets.begin(), offsets.end() - 1 );
+  for ( size_t index = 0; index < pointCountSource; ++index ) {
+    for ( size_t i = 0; i < nearest.count( index ); ++i ) {
+      if ( nearest.dist( index )[i] <= maxDist2 ) {
+        const uint32_t pos = cursors[nearest.indices( index )[i]]++;
+        sources[pos]       = uint32_t( index );
+        dists[pos]         = nearest.dist( index )[i];
+      }
+    }
+  }
+}
+
 bool PCCPointSet3::transferColors( PCCPointSet3& target,
                                    const int32_t searchRange,
                                    const bool    losslessTexture,
@@ -768,7 +900,8 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
                                    double        maxColorDist2Fwd,
                                    double        maxColorDist2Bwd,
                                    const bool    excludeColorOutlier,
-                                   const double  thresholdColorOutlierDist ) const {
+                                   const double  thresholdColorOutlierDist,
+                                   const size_t  nbThread ) const {
   const auto&  source           = *this;
   const size_t pointCountSource = source.getPointCount();
   const size_t pointCountTarget = target.getPointCount();
@@ -781,104 +914,103 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
   maxGeometryDist2Bwd = ( maxGeometryDist2Bwd < 512 ) ? maxGeometryDist2Bwd : std::numeric_limits<double>::max();
   maxColorDist2Fwd    = ( maxColorDist2Fwd < 512 ) ? maxColorDist2Fwd : std::numeric_limits<double>::max();
   maxColorDist2Bwd    = ( maxColorDist2Bwd < 512 ) ? maxColorDist2Bwd : std::numeric_limits<double>::max();
+  tbb::task_arena limited( (int)nbThread );
 
   // ==========================================================================================
   //                                     Forward direction
   // ==========================================================================================
   // for each target point indexed by index, derive the refined color as refinedColors1[index]
-  PCCNNResult result;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], numNeighborsColorTransferFwd, result );
-    // keep the points that satisfy geometry dist threshold
-    while ( 1 ) {
-      if ( result.count() == 1 ) { break; }
-      if ( result.dist( int( result.count() ) - 1 ) <= maxGeometryDist2Fwd ) {
-        break;
-      } else {
-        result.pop_dist();
-        result.pop_indices();
-        result.dec_count();
-      }
-    }
-    bool isDone = false;
-    if ( skipAvgIfIdenticalSourcePointPresentFwd ) {
-      if ( result.dist( 0 ) < 0.0001 ) {
-        refinedColors1[index] = source.getColor( result.indices( 0 ) );
-        isDone                = true;
-      }
-    }
-    if ( !isDone ) {
-      int nNN = (int)result.count();
-      while ( nNN > 0 && !isDone ) {
-        if ( nNN == 1 ) {
-          refinedColors1[index] = source.getColor( result.indices( 0 ) );
-          isDone                = true;
+  PCCNNBatchResult nearest;
+  kdtreeSource.search( target, 0, pointCountTarget, numNeighborsColorTransferFwd, nearest, nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, pointCountTarget ), [&]( const tbb::blocked_range<size_t>& range ) {
+      std::vector<PCCVector3D> colors;
+      for ( size_t index = range.begin(); index < range.end(); ++index ) {
+        const uint32_t* indices = nearest.indices( index );
+        const float*    dists   = nearest.dist( index );
+        size_t          count   = nearest.count( index );
+        // keep the points that satisfy geometry dist threshold
+        while ( count > 1 && dists[count - 1] > maxGeometryDist2Fwd ) { --count; }
+        bool isDone = false;
+        if ( skipAvgIfIdenticalSourcePointPresentFwd ) {
+          if ( dists[0] < 0.0001 ) {
+            refinedColors1[index] = source.getColor( indices[0] );
+            isDone                = true;
+          }
         }
         if ( !isDone ) {
-          std::vector<PCCVector3D> colors;
-          colors.resize( 0 );
-          colors.resize( nNN );
-          for ( int i = 0; i < nNN; ++i ) {
-            for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( source.getColor( result.indices( i ) )[k] ); }
-          }
-          double maxColorDist2 = std::numeric_limits<double>::min();
-          for ( int i = 0; i < nNN; ++i ) {
-            for ( int j = i + 1; j < nNN; ++j ) {
-              const double dist2 = ( colors[i] - colors[j] ).getNorm2();
-              if ( dist2 > maxColorDist2 ) { maxColorDist2 = dist2; }
+          int nNN = (int)count;
+          while ( nNN > 0 && !isDone ) {
+            if ( nNN == 1 ) {
+              refinedColors1[index] = source.getColor( indices[0] );
+              isDone                = true;
             }
-          }
-          if ( maxColorDist2 <= maxColorDist2Fwd ) {
-            PCCVector3D refinedColor( 0.0 );
-            if ( useDistWeightedAverageFwd ) {
-              double sumWeights{0.0};
+            if ( !isDone ) {
+              colors.resize( 0 );
+              colors.resize( nNN );
               for ( int i = 0; i < nNN; ++i ) {
-                const double weight = 1 / ( result.dist( i ) + distOffsetFwd );
-                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( result.indices( i ) )[k] * weight; }
-                sumWeights += weight;
+                for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( source.getColor( indices[i] )[k] ); }
               }
-              refinedColor /= sumWeights;
-              if ( excludeColorOutlier ) {
-                PCCVector3D excludeOutlierRefinedColor( 0.0 );
-                size_t      excludeCount = 0;
-                sumWeights               = 0.0;
-                for ( int i = 0; i < nNN; ++i ) {
-                  double      dist     = 0.0;
-                  PCCColor3B  tmpColor = source.getColor( result.indices( i ) );
-                  PCCVector3D sourceColor( tmpColor[0], tmpColor[1], tmpColor[2] );
-                  dist = ( sourceColor - refinedColor ).getNorm2();
-                  if ( dist > thresholdColorOutlierDist * thresholdColorOutlierDist ) {
-                    excludeCount += 1;
-                    continue;
+              double maxColorDist2 = std::numeric_limits<double>::min();
+              for ( int i = 0; i < nNN; ++i ) {
+                for ( int j = i + 1; j < nNN; ++j ) {
+                  const double dist2 = ( colors[i] - colors[j] ).getNorm2();
+                  if ( dist2 > maxColorDist2 ) { maxColorDist2 = dist2; }
+                }
+              }
+              if ( maxColorDist2 <= maxColorDist2Fwd ) {
+                PCCVector3D refinedColor( 0.0 );
+                if ( useDistWeightedAverageFwd ) {
+                  double sumWeights{0.0};
+                  for ( int i = 0; i < nNN; ++i ) {
+                    const double weight = 1 / ( dists[i] + distOffsetFwd );
+                    for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( indices[i] )[k] * weight; }
+                    sumWeights += weight;
                   }
-                  const double weight = 1 / ( result.dist( i ) + distOffsetFwd );
-                  for ( int k = 0; k < 3; ++k ) {
-                    excludeOutlierRefinedColor[k] += source.getColor( result.indices( i ) )[k] * weight;
+                  refinedColor /= sumWeights;
+                  if ( excludeColorOutlier ) {
+                    PCCVector3D excludeOutlierRefinedColor( 0.0 );
+                    size_t      excludeCount = 0;
+                    sumWeights               = 0.0;
+                    for ( int i = 0; i < nNN; ++i ) {
+                      double      dist     = 0.0;
+                      PCCColor3B  tmpColor = source.getColor( indices[i] );
+                      PCCVector3D sourceColor( tmpColor[0], tmpColor[1], tmpColor[2] );
+                      dist = ( sourceColor - refinedColor ).getNorm2();
+                      if ( dist > thresholdColorOutlierDist * thresholdColorOutlierDist ) {
+                        excludeCount += 1;
+                        continue;
+                      }
+                      const double weight = 1 / ( dists[i] + distOffsetFwd );
+                      for ( int k = 0; k < 3; ++k ) {
+                        excludeOutlierRefinedColor[k] += source.getColor( indices[i] )[k] * weight;
+                      }
+                      sumWeights += weight;
+                    }
+
+                    if ( excludeCount != nNN && excludeCount != 0 ) {
+                      refinedColor = excludeOutlierRefinedColor / sumWeights;
+                    }
                   }
-                  sumWeights += weight;
+                } else {
+                  for ( int i = 0; i < nNN; ++i ) {
+                    for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( indices[i] )[k]; }
+                  }
+                  refinedColor /= nNN;
                 }
-
-                if ( excludeCount != nNN && excludeCount != 0 ) {
-                  refinedColor = excludeOutlierRefinedColor / sumWeights;
+                for ( int k = 0; k < 3; ++k ) {
+                  refinedColors1[index][k] = uint8_t( PCCClip( round( refinedColor[k] ), 0.0, 255.0 ) );
                 }
+                isDone = true;
+              } else {
+                --nNN;
               }
-            } else {
-              for ( int i = 0; i < nNN; ++i ) {
-                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( result.indices( i ) )[k]; }
-              }
-              refinedColor /= nNN;
-            }
-            for ( int k = 0; k < 3; ++k ) {
-              refinedColors1[index][k] = uint8_t( PCCClip( round( refinedColor[k] ), 0.0, 255.0 ) );
             }
-            isDone = true;
-          } else {
-            --nNN;
           }
         }
       }
-    }
-  }
+    } );
+  } );
   // ==========================================================================================
   //                                  Backward direction
   // ==========================================================================================
@@ -889,197 +1021,198 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
     double     dist;
     PCCColor3B color;
   };
-  std::vector<std::vector<DistColor>> refinedColorsDists2;
-  refinedColorsDists2.resize( pointCountTarget );
-  // populate refinedColorsDists2
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor3B color = source.getColor( index );
-    kdtreeTarget.search( source[index], numNeighborsColorTransferBwd, result );
-    // keep the points that satisfy geometry dist threshold
-    for ( int i = 0; i < result.count(); ++i ) {
-      if ( result.dist( i ) <= maxGeometryDist2Bwd ) {
-        refinedColorsDists2[result.indices( i )].push_back( DistColor{result.dist( i ), color} );
-      }
-    }
-  }
-  // sort refinedColorsDists2 according to distance
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    std::sort( refinedColorsDists2[index].begin(), refinedColorsDists2[index].end(),
-               []( DistColor& dc1, DistColor& dc2 ) { return dc1.dist < dc2.dist; } );
-  }
+  std::vector<uint32_t> candidateOffsets, candidateSources;
+  std::vector<float>    candidateDists;
+  kdtreeTarget.search( source, 0, pointCountSource, numNeighborsColorTransferBwd, nearest, nbThread );
+  groupBackwardNeighbors( nearest, pointCountSource, pointCountTarget, maxGeometryDist2Bwd, candidateOffsets,
+                          candidateSources, candidateDists );
   // compute centroid2
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    const PCCColor3B color1 = refinedColors1[index];       // refined color derived in forward direction
-    auto& colorsDists2      = refinedColorsDists2[index];  // set of candidate points derived in backward direction
-    if ( colorsDists2.empty() || losslessTexture ) {
-      target.setColor( index, color1 );
-    } else {
-      bool              isDone = false;
-      const PCCVector3D centroid1( color1[0], color1[1], color1[2] );
-      PCCVector3D       centroid2( 0.0 );
-      if ( skipAvgIfIdenticalSourcePointPresentBwd ) {
-        if ( colorsDists2[0].dist < 0.0001 ) {
-          auto temp = colorsDists2[0];
-          colorsDists2.clear();
-          colorsDists2.push_back( temp );
-          for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
-          isDone = true;
+  limited.execute( [&] {
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, pointCountTarget ), [&]( const tbb::blocked_range<size_t>& range ) {
+      std::vector<DistColor>   colorsDists2;  // set of candidate points derived in backward direction
+      std::vector<PCCVector3D> colors;
+      for ( size_t index = range.begin(); index < range.end(); ++index ) {
+        const PCCColor3B color1 = refinedColors1[index];  // refined color derived in forward direction
+        colorsDists2.clear();
+        for ( size_t i = candidateOffsets[index]; i < candidateOffsets[index + 1]; ++i ) {
+          colorsDists2.push_back( DistColor{candidateDists[i], source.getColor( candidateSources[i] )} );
         }
-      }
-      if ( !isDone ) {
-        int nNN = (int)colorsDists2.size();
-        while ( nNN > 0 && !isDone ) {
-          nNN = (int)colorsDists2.size();
-          if ( nNN == 1 ) {
-            auto temp = colorsDists2[0];
-            colorsDists2.clear();
-            colorsDists2.push_back( temp );
-            for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
-            isDone = true;
+        // sort colorsDists2 according to distance
+        std::sort( colorsDists2.begin(), colorsDists2.end(),
+                   []( DistColor& dc1, DistColor& dc2 ) { return dc1.dist < dc2.dist; } );
+        if ( colorsDists2.empty() || losslessTexture ) {
+          target.setColor( index, color1 );
+        } else {
+          bool              isDone = false;
+          const PCCVector3D centroid1( color1[0], color1[1], color1[2] );
+          PCCVector3D       centroid2( 0.0 );
+          if ( skipAvgIfIdenticalSourcePointPresentBwd ) {
+            if ( colorsDists2[0].dist < 0.0001 ) {
+              auto temp = colorsDists2[0];
+              colorsDists2.clear();
+              colorsDists2.push_back( temp );
+              for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
+              isDone = true;
+            }
           }
           if ( !isDone ) {
-            std::vector<PCCVector3D> colors;
-            colors.resize( 0 );
-            colors.resize( nNN );
-            for ( int i = 0; i < nNN; ++i ) {
-              for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( colorsDists2[i].color[k] ); }
-            }
-            double maxColorDist2 = std::numeric_limits<double>::min();
-            for ( int i = 0; i < nNN; ++i ) {
-              for ( int j = i + 1; j < nNN; ++j ) {
-                const double dist2 = ( colors[i] - colors[j] ).getNorm2();
-                if ( dist2 > maxColorDist2 ) { maxColorDist2 = dist2; }
+            int nNN = (int)colorsDists2.size();
+            while ( nNN > 0 && !isDone ) {
+              nNN = (int)colorsDists2.size();
+              if ( nNN == 1 ) {
+                auto temp = colorsDists2[0];
+                colorsDists2.clear();
+                colorsDists2.push_back( temp );
+                for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
+                isDone = true;
               }
-            }
-            if ( maxColorDist2 <= maxColorDist2Bwd ) {
-              for ( size_t k = 0; k < 3; ++k ) { centroid2[k] = 0; }
-              if ( useDistWeightedAverageBwd ) {
-                double sumWeights{0.0};
-                for ( int i = 0; i < colorsDists2.size(); ++i ) {
-                  const double weight = 1 / ( sqrt( colorsDists2[i].dist ) + distOffsetBwd );
-                  for ( size_t k = 0; k < 3; ++k ) { centroid2[k] += ( colorsDists2[i].color[k] * weight ); }
-                  sumWeights += weight;
+              if ( !isDone ) {
+                colors.resize( 0 );
+                colors.resize( nNN );
+                for ( int i = 0; i < nNN; ++i ) {
+                  for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( colorsDists2[i].color[k] ); }
                 }
-                centroid2 /= sumWeights;
-                if ( excludeColorOutlier ) {
-                  PCCVector3D excludeOutlierCentroid2( 0.0 );
-                  size_t      excludeCount = 0;
-                  sumWeights               = 0.0;
-                  for ( int i = 0; i < colorsDists2.size(); ++i ) {
-                    double      dist = 0.0;
-                    PCCVector3D sourceColor( colorsDists2[i].color[0], colorsDists2[i].color[1],
-                                             colorsDists2[i].color[2] );
-                    dist = ( sourceColor - centroid2 ).getNorm2();
-                    if ( dist > thresholdColorOutlierDist * thresholdColorOutlierDist ) {
-                      excludeCount += 1;
-                      continue;
+                double maxColorDist2 = std::numeric_limits<double>::min();
+                for ( int i = 0; i < nNN; ++i ) {
+                  for ( int j = i + 1; j < nNN; ++j ) {
+                    const double dist2 = ( colors[i] - colors[j] ).getNorm2();
+                    if ( dist2 > maxColorDist2 ) { maxColorDist2 = dist2; }
+                  }
+                }
+                if ( maxColorDist2 <= maxColorDist2Bwd ) {
+                  for ( size_t k = 0; k < 3; ++k ) { centroid2[k] = 0; }
+                  if ( useDistWeightedAverageBwd ) {
+                    double sumWeights{0.0};
+                    for ( int i = 0; i < colorsDists2.size(); ++i ) {
+                      const double weight = 1 / ( sqrt( colorsDists2[i].dist ) + distOffsetBwd );
+                      for ( size_t k = 0; k < 3; ++k ) { centroid2[k] += ( colorsDists2[i].color[k] * weight ); }
+                      sumWeights += weight;
                     }
-                    const double weight = 1 / ( sqrt( colorsDists2[i].dist ) + distOffsetBwd );
-                    for ( size_t k = 0; k < 3; ++k ) {
-                      excludeOutlierCentroid2[k] += ( colorsDists2[i].color[k] * weight );
+                    centroid2 /= sumWeights;
+                    if ( excludeColorOutlier ) {
+                      PCCVector3D excludeOutlierCentroid2( 0.0 );
+                      size_t      excludeCount = 0;
+                      sumWeights               = 0.0;
+                      for ( int i = 0; i < colorsDists2.size(); ++i ) {
+                        double      dist = 0.0;
+                        PCCVector3D sourceColor( colorsDists2[i].color[0], colorsDists2[i].color[1],
+                                                 colorsDists2[i].color[2] );
+                        dist = ( sourceColor - centroid2 ).getNorm2();
+                        if ( dist > thresholdColorOutlierDist * thresholdColorOutlierDist ) {
+                          excludeCount += 1;
+                          continue;
+                        }
+                        const double weight = 1 / ( sqrt( colorsDists2[i].dist ) + distOffsetBwd );
+                        for ( size_t k = 0; k < 3; ++k ) {
+                          excludeOutlierCentroid2[k] += ( colorsDists2[i].color[k] * weight );
+                        }
+                        sumWeights += weight;
+                      }
+
+                      if ( excludeCount != nNN && excludeCount != 0 ) {
+                        centroid2 = excludeOutlierCentroid2 / sumWeights;
+                      }
                     }
-                    sumWeights += weight;
+                  } else {
+                    for ( auto& coldist : colorsDists2 ) {
+                      for ( int k = 0; k < 3; ++k ) { centroid2[k] += coldist.color[k]; }
+                    }
+                    centroid2 /= colorsDists2.size();
                   }
-
-                  if ( excludeCount != nNN && excludeCount != 0 ) { centroid2 = excludeOutlierCentroid2 / sumWeights; }
+                  isDone = true;
+                } else {
+                  colorsDists2.pop_back();
                 }
-              } else {
-                for ( auto& coldist : colorsDists2 ) {
-                  for ( int k = 0; k < 3; ++k ) { centroid2[k] += coldist.color[k]; }
-                }
-                centroid2 /= colorsDists2.size();
               }
-              isDone = true;
-            } else {
-              colorsDists2.pop_back();
             }
           }
-        }
-      }
-      double H  = double( colorsDists2.size() );
-      double D2 = 0.0;
-      for ( const auto color2dist : colorsDists2 ) {
-        auto color2 = color2dist.color;
-        for ( size_t k = 0; k < 3; ++k ) {
-          const double d2 = centroid2[k] - color2[k];
-          D2 += d2 * d2;
-        }
-      }
-      const double r      = double( pointCountTarget ) / double( pointCountSource );
-      const double delta2 = ( centroid2 - centroid1 ).getNorm2();
-      const double eps    = 0.000001;
-
-      const bool fixWeight = 1;           // m42538
-      if ( fixWeight || delta2 > eps ) {  // centroid2 != centroid1
-        double w = 0.0;
-
-        if ( !fixWeight ) {
-          const double alpha = D2 / delta2;
-          const double a     = H * r - 1.0;
-          const double c     = alpha * r - 1.0;
-          if ( fabs( a ) < eps ) {
-            w = -0.5 * c;
-          } else {
-            const double delta = 1.0 - a * c;
-            if ( delta >= 0.0 ) { w = ( -1.0 + sqrt( delta ) ) / a; }
+          double H  = double( colorsDists2.size() );
+          double D2 = 0.0;
+          for ( const auto color2dist : colorsDists2 ) {
+            auto color2 = color2dist.color;
+            for ( size_t k = 0; k < 3; ++k ) {
+              const double d2 = centroid2[k] - color2[k];
+              D2 += d2 * d2;
+            }
           }
-        }
-        const double oneMinusW = 1.0 - w;
-        PCCVector3D  color0;
-        for ( size_t k = 0; k < 3; ++k ) {
-          color0[k] = PCCClip( round( w * centroid1[k] + oneMinusW * centroid2[k] ), 0.0, 255.0 );
-        }
-        const double rSource  = 1.0 / double( pointCountSource );
-        const double rTarget  = 1.0 / double( pointCountTarget );
-        const double maxValue = std::numeric_limits<uint8_t>::max();
-        double       minError = std::numeric_limits<double>::max();
-        PCCVector3D  bestColor( color0 );
-        PCCVector3D  color;
-        for ( int32_t s1 = -searchRange; s1 <= searchRange; ++s1 ) {
-          color[0] = PCCClip( color0[0] + s1, 0.0, maxValue );
-          for ( int32_t s2 = -searchRange; s2 <= searchRange; ++s2 ) {
-            color[1] = PCCClip( color0[1] + s2, 0.0, maxValue );
-            for ( int32_t s3 = -searchRange; s3 <= searchRange; ++s3 ) {
-              color[2] = PCCClip( color0[2] + s3, 0.0, maxValue );
+          const double r      = double( pointCountTarget ) / double( pointCountSource );
+          const double delta2 = ( centroid2 - centroid1 ).getNorm2();
+          const double eps    = 0.000001;
 
-              double e1 = 0.0;
-              for ( size_t k = 0; k < 3; ++k ) {
-                const double d = color[k] - color1[k];
-                e1 += d * d;
-              }
-              e1 *= rTarget;
+          const bool fixWeight = 1;           // m42538
+          if ( fixWeight || delta2 > eps ) {  // centroid2 != centroid1
+            double w = 0.0;
 
-              double e2 = 0.0;
-              for ( const auto color2dist : colorsDists2 ) {
-                auto color2 = color2dist.color;
-                for ( size_t k = 0; k < 3; ++k ) {
-                  const double d = color[k] - color2[k];
-                  e2 += d * d;
-                }
+            if ( !fixWeight ) {
+              const double alpha = D2 / delta2;
+              const double a     = H * r - 1.0;
+              const double c     = alpha * r - 1.0;
+              if ( fabs( a ) < eps ) {
+                w = -0.5 * c;
+              } else {
+                const double delta = 1.0 - a * c;
+                if ( delta >= 0.0 ) { w = ( -1.0 + sqrt( delta ) ) / a; }
               }
-              e2 *= rSource;
+            }
+            const double oneMinusW = 1.0 - w;
+            PCCVector3D  color0;
+            for ( size_t k = 0; k < 3; ++k ) {
+              color0[k] = PCCClip( round( w * centroid1[k] + oneMinusW * centroid2[k] ), 0.0, 255.0 );
+            }
+            const double rSource  = 1.0 / double( pointCountSource );
+            const double rTarget  = 1.0 / double( pointCountTarget );
+            const double maxValue = std::numeric_limits<uint8_t>::max();
+            double       minError = std::numeric_limits<double>::max();
+            PCCVector3D  bestColor( color0 );
+            PCCVector3D  color;
+            for ( int32_t s1 = -searchRange; s1 <= searchRange; ++s1 ) {
+              color[0] = PCCClip( color0[0] + s1, 0.0, maxValue );
+              for ( int32_t s2 = -searchRange; s2 <= searchRange; ++s2 ) {
+                color[1] = PCCClip( color0[1] + s2, 0.0, maxValue );
+                for ( int32_t s3 = -searchRange; s3 <= searchRange; ++s3 ) {
+                  color[2] = PCCClip( color0[2] + s3, 0.0, maxValue );
+
+                  double e1 = 0.0;
+                  for ( size_t k = 0; k < 3; ++k ) {
+                    const double d = color[k] - color1[k];
+                    e1 += d * d;
+                  }
+                  e1 *= rTarget;
+
+                  double e2 = 0.0;
+                  for ( const auto color2dist : colorsDists2 ) {
+                    auto color2 = color2dist.color;
+                    for ( size_t k = 0; k < 3; ++k ) {
+                      const double d = color[k] - color2[k];
+                      e2 += d * d;
+                    }
+                  }
+                  e2 *= rSource;
 
-              const double error = std::max( e1, e2 );
-              if ( error < minError ) {
-                minError  = error;
-                bestColor = color;
+                  const double error = std::max( e1, e2 );
+                  if ( error < minError ) {
+                    minError  = error;
+                    bestColor = color;
+                  }
+                }
               }
             }
+            target.setColor( index,
+                             PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
+          } else {  // centroid2 == centroid1
+            target.setColor( index, color1 );
           }
         }
-        target.setColor( index,
-                         PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
-      } else {  // centroid2 == centroid1
-        target.setColor( index, color1 );
       }
-    }
-  }
+    } );
+  } );
   return true;
 }
 
 bool PCCPointSet3::transferColorsFilter3( PCCPointSet3& target,
                                           const int32_t searchRange,
-                                          const bool    losslessTexture ) const {
+                                          const bool    losslessTexture,
+                                          const size_t  nbThread ) const {
   const auto&  source           = *this;
   const size_t pointCountSource = source.getPointCount();
   const size_t pointCountTarget = target.getPointCount();
@@ -1087,70 +1220,68 @@ bool PCCPointSet3::transferColorsFilter3( PCCPointSet3& target,
 
   PCCKdTree kdtreeTarget( target ), kdtreeSource( source );
   target.addColors();
-  std::vector<PCCColor3B>              refinedColors1;
-  std::vector<std::vector<PCCColor3B>> refinedColors2;
-  refinedColors1.resize( pointCountTarget );
-  refinedColors2.resize( pointCountTarget );
-  const size_t num_results = 1;
-  PCCNNResult  result;
+  const size_t          num_results = 1;
+  PCCNNBatchResult      nearest1, nearest2;
+  std::vector<uint32_t> offsets2, sources2;
+  std::vector<float>    dists2;
   //  Find THE closest point in reconstruction to each source point
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], num_results, result );
-    refinedColors1[index] = source.getColor( result.indices( 0 ) );
-  }
+  kdtreeSource.search( target, 0, pointCountTarget, num_results, nearest1, nbThread );
   //  Find points in source that are closest to point in reconstruction
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor3B color = source.getColor( index );
-    kdtreeTarget.search( source[index], num_results, result );
-    refinedColors2[result.indices( 0 )].push_back( color );
-  }
+  kdtreeTarget.search( source, 0, pointCountSource, num_results, nearest2, nbThread );
+  groupBackwardNeighbors( nearest2, pointCountSource, pointCountTarget, ( std::numeric_limits<double>::max )(),
+                          offsets2, sources2, dists2 );
 
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    const PCCColor3B               color1  = refinedColors1[index];
-    const std::vector<PCCColor3B>& colors2 = refinedColors2[index];
-    if ( colors2.empty() || losslessTexture ) {
-      target.setColor( index, color1 );
-    } else {
-      const double      H = double( colors2.size() );
-      const PCCVector3D centroid1( color1[0], color1[1], color1[2] );
-      PCCVector3D       centroid2( 0.0 );
-      for ( const auto color2 : colors2 ) {
-        for ( size_t k = 0; k < 3; ++k ) { centroid2[k] += color2[k]; }
-      }
-      centroid2 /= H;
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+      const PCCColor3B color1 = source.getColor( nearest1.indices( index )[0] );
+      const size_t     begin2 = offsets2[index], end2 = offsets2[index + 1];
+      if ( begin2 == end2 || losslessTexture ) {
+        target.setColor( index, color1 );
+      } else {
+        const double      H = double( end2 - begin2 );
+        const PCCVector3D centroid1( color1[0], color1[1], color1[2] );
+        PCCVector3D       centroid2( 0.0 );
+        for ( size_t i = begin2; i < end2; ++i ) {
+          const auto color2 = source.getColor( sources2[i] );
+          for ( size_t k = 0; k < 3; ++k ) { centroid2[k] += color2[k]; }
+        }
+        centroid2 /= H;
 
-      double D2 = 0.0;
-      for ( const auto color2 : colors2 ) {
-        for ( size_t k = 0; k < 3; ++k ) {
-          const double d2 = centroid2[k] - color2[k];
-          D2 += d2 * d2;
+        double D2 = 0.0;
+        for ( size_t i = begin2; i < end2; ++i ) {
+          const auto color2 = source.getColor( sources2[i] );
+          for ( size_t k = 0; k < 3; ++k ) {
+            const double d2 = centroid2[k] - color2[k];
+            D2 += d2 * d2;
+          }
         }
-      }
-      //      const double r = double(pointCountTarget) / double(pointCountSource);
-      const double delta2 = ( centroid2 - centroid1 ).getNorm2();
-      const double eps    = 0.000001;
+        //      const double r = double(pointCountTarget) / double(pointCountSource);
+        const double delta2 = ( centroid2 - centroid1 ).getNorm2();
+        const double eps    = 0.000001;
 
-      const bool fixWeight = 1;           // m42538
-      if ( fixWeight || delta2 > eps ) {  // centroid2 != centroid1
-        double w = 0.0;
+        const bool fixWeight = 1;           // m42538
+        if ( fixWeight || delta2 > eps ) {  // centroid2 != centroid1
+          double w = 0.0;
 
-        const double oneMinusW = 1.0 - w;
-        PCCVector3D  color0;
-        for ( size_t k = 0; k < 3; ++k ) {
-          color0[k] = PCCClip( round( w * centroid1[k] + oneMinusW * centroid2[k] ), 0.0, 255.0 );
+          const double oneMinusW = 1.0 - w;
+          PCCVector3D  color0;
+          for ( size_t k = 0; k < 3; ++k ) {
+            color0[k] = PCCClip( round( w * centroid1[k] + oneMinusW * centroid2[k] ), 0.0, 255.0 );
+          }
+          PCCVector3D bestColor( color0 );
+          target.setColor( index,
+                           PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
+        } else {  // centroid2 == centroid1
+          target.setColor( index, color1 );
         }
-        PCCVector3D bestColor( color0 );
-        target.setColor( index,
-                         PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
-      } else {  // centroid2 == centroid1
-        target.setColor( index, color1 );
       }
-    }
-  }
+    } );
+  } );
   return true;
 }
 
-bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestColorSearchStep ) {
+bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestColorSearchStep, const size_t nbThread ) {
   const auto&  source           = *this;
   const size_t pointCountSource = source.getPointCount();
   const size_t pointCountTarget = target.getPointCount();
@@ -1159,105 +1290,110 @@ bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestC
 
   PCCKdTree kdtreeSource( source ), kdtreeTarget( target );
 
-  std::vector<PCCColor3B>              refinedColors1;
-  std::vector<std::vector<PCCColor3B>> refinedColors2;
-  refinedColors1.resize( pointCountTarget );
-  refinedColors2.resize( pointCountTarget );
-  const size_t num_results = 1;
-  PCCNNResult  result;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], num_results, result );
-    refinedColors1[index] = source.getColor( result.indices( 0 ) );
-  }
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor3B color = source.getColor( index );
-    kdtreeTarget.search( source[index], num_results, result );
-    refinedColors2[result.indices( 0 )].push_back( color );
-  }
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    const PCCColor3B              color1  = refinedColors1[index];
-    const std::vector<PCCColor3B> colors2 = refinedColors2[index];
-    if ( colors2.empty() ) {
-      target.setColor( index, color1 );
-    } else {
-      double      s        = 1.0 / colors2.size();
-      double      r1       = 1.0 / pointCountTarget;
-      double      r2       = 1.0 / ( pointCountSource * colors2.size() );
-      double      w1       = 0.0;
-      double      minError = std::numeric_limits<double>::max();
-      PCCVector3D bestColor;
-      while ( w1 <= 1.0 ) {
-        const double w2 = 1.0 - w1;
-        PCCVector3D  color( 0.0 );
-        for ( const auto color2 : colors2 ) {
-          for ( size_t k = 0; k < 3; ++k ) { color[k] += color2[k]; }
-        }
-        for ( size_t k = 0; k < 3; ++k ) {
-          color[k] = ( std::min )( round( w2 * s * color[k] + w1 * color1[k] ), 255.0 );
-        }
+  const size_t          num_results = 1;
+  PCCNNBatchResult      nearest1, nearest2;
+  std::vector<uint32_t> offsets2, sources2;
+  std::vector<float>    dists2;
+  kdtreeSource.search( target, 0, pointCountTarget, num_results, nearest1, nbThread );
+  kdtreeTarget.search( source, 0, pointCountSource, num_results, nearest2, nbThread );
+  groupBackwardNeighbors( nearest2, pointCountSource, pointCountTarget, ( std::numeric_limits<double>::max )(),
+                          offsets2, sources2, dists2 );
 
-        double e1 = 0.0;
-        for ( size_t k = 0; k < 3; ++k ) {
-          const double d = color[k] - color1[k];
-          e1 += d * d;
-        }
-        e1 *= r1;
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+      const PCCColor3B color1 = source.getColor( nearest1.indices( index )[0] );
+      const size_t     begin2 = offsets2[index], end2 = offsets2[index + 1];
+      if ( begin2 == end2 ) {
+        target.setColor( index, color1 );
+      } else {
+        double      s        = 1.0 / ( end2 - begin2 );
+        double      r1       = 1.0 / pointCountTarget;
+        double      r2       = 1.0 / ( pointCountSource * ( end2 - begin2 ) );
+        double      w1       = 0.0;
+        double      minError = std::numeric_limits<double>::max();
+        PCCVector3D bestColor;
+        while ( w1 <= 1.0 ) {
+          const double w2 = 1.0 - w1;
+          PCCVector3D  color( 0.0 );
+          for ( size_t i = begin2; i < end2; ++i ) {
+            const auto color2 = source.getColor( sources2[i] );
+            for ( size_t k = 0; k < 3; ++k ) { color[k] += color2[k]; }
+          }
+          for ( size_t k = 0; k < 3; ++k ) {
+            color[k] = ( std::min )( round( w2 * s * color[k] + w1 * color1[k] ), 255.0 );
+          }
 
-        double e2 = 0.0;
-        for ( const auto color2 : colors2 ) {
+          double e1 = 0.0;
           for ( size_t k = 0; k < 3; ++k ) {
-            const double d = color[k] - color2[k];
-            e2 += d * d;
+            const double d = color[k] - color1[k];
+            e1 += d * d;
           }
-        }
-        e2 *= r2;
+          e1 *= r1;
 
-        const double e = ( std::max )( e1, e2 );
-        if ( e < minError ) {
-          bestColor = color;
-          minError  = e;
+          double e2 = 0.0;
+          for ( size_t i = begin2; i < end2; ++i ) {
+            const auto color2 = source.getColor( sources2[i] );
+            for ( size_t k = 0; k < 3; ++k ) {
+              const double d = color[k] - color2[k];
+              e2 += d * d;
+            }
+          }
+          e2 *= r2;
+
+          const double e = ( std::max )( e1, e2 );
+          if ( e < minError ) {
+            bestColor = color;
+            minError  = e;
+          }
+          w1 += bestColorSearchStep;
         }
-        w1 += bestColorSearchStep;
+        target.setColor( index,
+                         PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
       }
-      target.setColor( index, PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
-    }
-  }
+    } );
+  } );
   return true;
 }
 
-bool PCCPointSet3::transferColorWeight( PCCPointSet3& target, const double bestColorSearchStep ) {
+bool PCCPointSet3::transferColorWeight( PCCPointSet3& target, const double bestColorSearchStep, const size_t nbThread ) {
   const auto&  source           = *this;
   const size_t pointCountSource = source.getPointCount();
   const size_t pointCountTarget = target.getPointCount();
   if ( !pointCountSource || !pointCountTarget || !source.hasColors() ) { return false; }
   target.addColors();
-  PCCKdTree    kdtreeSource( source );
-  PCCNNResult  result;
-  const size_t num_results = 5;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], num_results, result );
-    double color[3] = {0., 0., 0.};
-    double sum      = 0;
-    if ( result.count() > 1 && result.dist( 0 ) > 0.0001 ) {
-      for ( size_t i = 0; i < result.count(); i++ ) {
-        const auto&  found = source.getColor( result.indices( i ) );
-        const double w     = 1.0 / pow( result.dist( i ), 2.0 );
-        color[0] += found[0] * w;
-        color[1] += found[1] * w;
-        color[2] += found[2] * w;
-        sum += w;
+  PCCKdTree        kdtreeSource( source );
+  PCCNNBatchResult nearest;
+  const size_t     num_results = 5;
+  kdtreeSource.search( target, 0, pointCountTarget, num_results, nearest, nbThread );
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+      const uint32_t* indices  = nearest.indices( index );
+      const float*    dists    = nearest.dist( index );
+      double          color[3] = {0., 0., 0.};
+      double          sum      = 0;
+      if ( nearest.count( index ) > 1 && dists[0] > 0.0001 ) {
+        for ( size_t i = 0; i < nearest.count( index ); i++ ) {
+          const auto&  found = source.getColor( indices[i] );
+          const double w     = 1.0 / pow( dists[i], 2.0 );
+          color[0] += found[0] * w;
+          color[1] += found[1] * w;
+          color[2] += found[2] * w;
+          sum += w;
+        }
+        color[0] /= sum;
+        color[1] /= sum;
+        color[2] /= sum;
+      } else {
+        const auto& found = source.getColor( indices[0] );
+        color[0]          = found[0];
+        color[1]          = found[1];
+        color[2]          = found[2];
       }
-      color[0] /= sum;
-      color[1] /= sum;
-      color[2] /= sum;
-    } else {
-      const auto& found = source.getColor( result.indices( 0 ) );
-      color[0]          = found[0];
-      color[1]          = found[1];
-      color[2]          = found[2];
-    }
-    target.setColor( index, PCCColor3B( uint8_t( color[0] ), uint8_t( color[1] ), uint8_t( color[2] ) ) );
-  }
+      target.setColor( index, PCCColor3B( uint8_t( color[0] ), uint8_t( color[1] ), uint8_t( color[2] ) ) );
+    } );
+  } );
   return true;
 }
 
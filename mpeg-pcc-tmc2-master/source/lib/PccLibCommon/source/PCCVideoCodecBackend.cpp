@@ -0,0 +1,270 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCSystem.h"
+#include "PCCVideoBitstream.h"
+#include "PCCVideoCodecBackend.h"
+
+#include "PCCHevcParser.h"
+
+using namespace pcc;
+
+static bool writeFile( const std::string& fileName, std::istream& data ) {
+  std::ofstream file( fileName, std::ios::binary );
+  if ( !file.good() ) { return false; }
+  file << data.rdbuf();
+  file.close();
+  return true;
+}
+
+static bool readFile( const std::string& fileName, std::ostream& data ) {
+  std::ifstream file( fileName, std::ios::binary );
+  if ( !file.good() ) { return false; }
+  data << file.rdbuf();
+  file.close();
+  return true;
+}
+
+std::unique_ptr<PCCVideoCodecBackend> PCCVideoCodecBackend::create( PCCVideoCodecBackendType type ) {
+  switch ( type ) {
+    case VIDEO_CODEC_BACKEND_LOSSLESS: return std::unique_ptr<PCCVideoCodecBackend>( new PCCLosslessVideoCodec );
+    case VIDEO_CODEC_BACKEND_EXTERNAL:
+    default: return std::unique_ptr<PCCVideoCodecBackend>( new PCCExternalVideoCodec );
+  }
+}
+
+std::unique_ptr<PCCVideoCodecBackend> PCCVideoCodecBackend::create( PCCVideoBitstream& bitstream ) {
+  return create( PCCLosslessVideoCodec::isLossless( bitstream ) ? VIDEO_CODEC_BACKEND_LOSSLESS
+                                                                : VIDEO_CODEC_BACKEND_EXTERNAL );
+}
+
+bool PCCExternalVideoCodec::encode( std::istream&                  source,
+                                    const PCCVideoCodecParameters& params,
+                                    PCCVideoBitstream&             bitstream,
+                                    std::ostream&                  reconstruction ) {
+  const size_t      width                = params.width_;
+  const size_t      height               = params.height_;
+  const size_t      depth                = params.nbyte_ == 1 ? 8 : 10;
+  const bool        use444CodecIo        = params.use444CodecIo_;
+  const std::string format               = use444CodecIo ? "444" : "420";
+  const std::string binFileName          = params.fileName_ + ".bin";
+  const std::string blockToPatchFileName = params.path_ + "blockToPatch.txt";
+  const std::string occupancyMapFileName = params.path_ + "occupancy.txt";
+  const std::string patchInfoFileName    = params.path_ + "patchInfo.txt";
+  const std::string srcYuvFileName = addVideoFormat( params.fileName_ + ( use444CodecIo ? ".rgb" : ".yuv" ), width,
+                                                     height, !use444CodecIo, params.nbyte_ == 2 ? "10" : "8" );
+  const std::string recYuvFileName =
+      addVideoFormat( params.fileName_ + "_rec" + ( use444CodecIo ? ".rgb" : ".yuv" ), width, height, !use444CodecIo,
+                      params.nbyte_ == 2 ? "10" : "8" );
+  if ( !writeFile( srcYuvFileName, source ) ) { return false; }
+
+  std::stringstream cmd;
+  if ( use444CodecIo ) {
+    cmd << params.codecPath_ << " -c " << params.codecConfig_ << " -i " << srcYuvFileName
+        << " --InputBitDepth=" << depth << " --InternalBitDepth=" << depth << " --InternalBitDepthC=" << depth
+        << " --InputChromaFormat=" << format << " --FrameRate=30 "
+        << " --FrameSkip=0 "
+        << " --SourceWidth=" << width << " --SourceHeight=" << height << " --ConformanceWindowMode=1 "
+        << " --FramesToBeEncoded=" << params.frameCount_ << " --BitstreamFile=" << binFileName
+        << " --ReconFile=" << recYuvFileName << " --QP=" << params.qp_ << " --InputColourSpaceConvert=RGBtoGBR";
+    if ( params.use3dmv_ ) {
+      cmd << " --UsePccMotionEstimation=1 --BlockToPatchFile=" << blockToPatchFileName
+          << " --OccupancyMapFile=" << occupancyMapFileName << " --PatchInfoFile=" << patchInfoFileName;
+    }
+  } else {
+    cmd << params.codecPath_ << " -c " << params.codecConfig_ << " -i " << srcYuvFileName
+        << " --InputBitDepth=" << depth << " --InputChromaFormat=" << format << " --FrameRate=30 "
+        << " --FrameSkip=0 "
+        << " --SourceWidth=" << width << " --SourceHeight=" << height << " --ConformanceWindowMode=1 "
+        << " --FramesToBeEncoded=" << params.frameCount_ << " --BitstreamFile=" << binFileName
+        << " --ReconFile=" << recYuvFileName << " --QP=" << params.qp_;
+
+    if ( params.internalBitDepth_ != 0 ) {
+#if GEOMETRY_ATTRIBUTES_MODEL || ANCHOR
+      cmd << " --InternalBitDepth=8  --InternalBitDepthC=8 ";
+#else
+      cmd << " --InternalBitDepth=" << params.internalBitDepth_ << " --InternalBitDepthC=" << params.internalBitDepth_;
+#endif
+    }
+
+    cmd << " --OutputBitDepth=" << depth;
+    cmd << " --OutputBitDepthC=" << depth;
+    if ( params.use3dmv_ ) {
+      cmd << " --UsePccMotionEstimation=1 --BlockToPatchFile=" << blockToPatchFileName
+          << " --OccupancyMapFile=" << occupancyMapFileName << " --PatchInfoFile=" << patchInfoFileName;
+    }
+#if GEOMETRY_ATTRIBUTES_MODEL
+    if ( recYuvFileName.find( "geometry_rec" ) != std::string::npos ) { cmd << " -resi " << params.modelName_; }
+#endif
+  }
+  std::cout << cmd.str() << std::endl;
+  if ( pcc::system( cmd.str().c_str() ) ) {
+    std::cout << "Error: can't run system command!" << std::endl;
+    return false;
+  }
+
+  std::ifstream file( binFileName, std::ios::binary | std::ios::ate );
+  if ( !file.good() ) { return false; }
+  const uint64_t fileSize = file.tellg();
+  bitstream.resize( (size_t)fileSize );
+  file.clear();
+  file.seekg( 0 );
+  file.read( reinterpret_cast<char*>( bitstream.buffer() ), fileSize );
+  file.close();
+
+  if ( !readFile( recYuvFileName, reconstruction ) ) { return false; }
+  if ( !params.keepIntermediateFiles_ ) {
+    removeFile( binFileName );
+#if ONLY_KEEP_OCCUPANCY_MAP
+    if ( params.codecPath_.find( "binOC" ) == std::string::npos ) { removeFile( srcYuvFileName ); }
+#else
+    removeFile( srcYuvFileName );
+#endif
+    removeFile( recYuvFileName );
+  }
+  return true;
+}
+
+bool PCCExternalVideoCodec::decode( PCCVideoBitstream&             bitstream,
+                                    const PCCVideoCodecParameters& params,
+                                    std::ostream&                  reconstruction,
+                                    size_t&                        width,
+                                    size_t&                        height ) {
+  if ( params.codecPath_.empty() || !exist( params.codecPath_ ) ) {
+    std::cout << "Error: video decoder path not set or not exist: \"" << params.codecPath_ << "\"" << std::endl;
+    return false;
+  }
+  const bool        use444CodecIo = params.use444CodecIo_;
+  const std::string binFileName   = params.fileName_ + ".bin";
+  PCCHevcParser     hevcParser;
+  hevcParser.getVideoSize( bitstream.vector(), width, height );
+
+  const std::string yuvRecFileName =
+      addVideoFormat( params.fileName_ + "_rec" + ( use444CodecIo ? ".rgb" : ".yuv" ), width, height, !use444CodecIo,
+                      params.nbyte_ == 2 ? "10" : "8" );
+  std::ofstream file( binFileName, std::ios::binary );
+  if ( !file.good() ) { return false; }
+  file.write( reinterpret_cast<char*>( bitstream.buffer() ), bitstream.size() );
+  file.close();
+
+  std::stringstream cmd;
+  if ( use444CodecIo ) {
+    cmd << params.codecPath_ << " --OutputColourSpaceConvert=GBRtoRGB"
+        << " --BitstreamFile=" << binFileName << " --ReconFile=" << yuvRecFileName;
+  } else {
+    cmd << params.codecPath_ << " --BitstreamFile=" << binFileName << " --ReconFile=" << yuvRecFileName;
+    // if bitDepth == 8 ensure output bitdepth as 8bit. This is to cater for case if 10bit encoding was used for lossy
+    // cases.
+    if ( params.nbyte_ == 1 ) { cmd << " --OutputBitDepth=8 --OutputBitDepthC=8"; }
+#if GEOMETRY_ATTRIBUTES_MODEL
+    if ( yuvRecFileName.find( "geometry_rec" ) != std::string::npos ) { cmd << " -resi " << params.modelName_; }
+#endif
+  }
+  std::cout << cmd.str() << '\n';
+  if ( pcc::system( cmd.str().c_str() ) ) {
+    std::cout << "Error: can't run system command!" << std::endl;
+    return false;
+  }
+  if ( !readFile( yuvRecFileName, reconstruction ) ) { return false; }
+  if ( !params.keepIntermediateFiles_ ) {
+    removeFile( binFileName );
+    removeFile( yuvRecFileName );
+  }
+  return true;
+}
+
+bool PCCLosslessVideoCodec::isLossless( PCCVideoBitstream& bitstream ) {
+  if ( bitstream.size() < headerSize_ ) { return false; }
+  const uint8_t* data  = bitstream.buffer();
+  uint32_t       magic = 0;
+  for ( size_t i = 0; i < 4; i++ ) { magic |= uint32_t( data[i] ) << ( 8 * i ); }
+  return magic == magic_;
+}
+
+bool PCCLosslessVideoCodec::encode( std::istream&                  source,
+                                    const PCCVideoCodecParameters& params,
+                                    PCCVideoBitstream&             bitstream,
+                                    std::ostream&                  reconstruction ) {
+  const size_t planeSize   = params.width_ * params.height_;
+  const size_t sampleCount = params.use444CodecIo_ ? 3 * planeSize : planeSize + planeSize / 2;
+  const size_t byteCount   = sampleCount * params.nbyte_ * params.frameCount_;
+  bitstream.resize( headerSize_ + byteCount );
+  uint8_t* data = bitstream.buffer();
+  for ( size_t i = 0; i < 4; i++ ) {
+    data[i]     = uint8_t( magic_ >> ( 8 * i ) );
+    data[4 + i] = uint8_t( params.width_ >> ( 8 * i ) );
+    data[8 + i] = uint8_t( params.height_ >> ( 8 * i ) );
+  }
+  data[12] = uint8_t( params.frameCount_ );
+  data[13] = uint8_t( params.frameCount_ >> 8 );
+  data[14] = uint8_t( params.nbyte_ );
+  data[15] = uint8_t( params.use444CodecIo_ ? 1 : 0 );
+  source.read( reinterpret_cast<char*>( data + headerSize_ ), byteCount );
+  if ( size_t( source.gcount() ) != byteCount ) {
+    std::cout << "Error: lossless video codec: source size is " << source.gcount() << " bytes, " << byteCount
+              << " bytes expected" << std::endl;
+    return false;
+  }
+  reconstruction.write( reinterpret_cast<char*>( data + headerSize_ ), byteCount );
+  return true;
+}
+
+bool PCCLosslessVideoCodec::decode( PCCVideoBitstream&             bitstream,
+                                    const PCCVideoCodecParameters& params,
+                                    std::ostream&                  reconstruction,
+                                    size_t&                        width,
+                                    size_t&                        height ) {
+  if ( !isLossless( bitstream ) ) { return false; }
+  const uint8_t* data = bitstream.buffer();
+  width               = 0;
+  height              = 0;
+  for ( size_t i = 0; i < 4; i++ ) {
+    width |= size_t( data[4 + i] ) << ( 8 * i );
+    height |= size_t( data[8 + i] ) << ( 8 * i );
+  }
+  if ( data[14] != params.nbyte_ || ( data[15] != 0 ) != params.use444CodecIo_ ) {
+    std::cout << "Error: lossless video codec: sample format does not match the decoder settings" << std::endl;
+    return false;
+  }
+  const size_t frameCount  = size_t( data[12] ) | ( size_t( data[13] ) << 8 );
+  const size_t planeSize   = width * height;
+  const size_t sampleCount = data[15] ? 3 * planeSize : planeSize + planeSize / 2;
+  const size_t byteCount   = sampleCount * data[14] * frameCount;
+  if ( bitstream.size() < headerSize_ + byteCount ) {
+    std::cout << "Error: lossless video codec: bitstream size is " << bitstream.size() << " bytes, "
+              << headerSize_ + byteCount << " bytes expected" << std::endl;
+    return false;
+  }
+  reconstruction.write( reinterpret_cast<const char*>( data + headerSize_ ), byteCount );
+  return true;
+}
@@ -53,7 +53,7 @@ class PointLocalReconstructionData;
 
 template <typename T, size_t N>
 class PCCImage;
-typedef pcc::PCCImage<uint8_t, 3> PCCImageOccupancyMap;
+typedef pcc::PCCImage<uint8_t, 1> PCCImageOccupancyMap;
 
 class PCCDecoder : public PCCCodec {
  public:
@@ -62,6 +62,10 @@ class PCCDecoder : public PCCCodec {
 
   int decode( SampleStreamVpccUnit& ssvu, PCCContext& context, PCCGroupOfFrames& reconstructs );
 
+  bool parse( SampleStreamVpccUnit& ssvu, PCCContext& context );
+
+  int decode( PCCContext& context, PCCGroupOfFrames& reconstructs );
+
   void setParameters( PCCDecoderParameters value );
 
   void setGeneratePointCloudParameters( GeneratePointCloudParameters& gpcParams, PCCContext& context );
@@ -71,8 +75,6 @@ class PCCDecoder : public PCCCodec {
   void createPatchFrameDataStructure( PCCContext& context, PCCFrameContext& frame, size_t frameIndex );
 
  private:
-  int decode( PCCContext& context, PCCGroupOfFrames& reconstruct );
-
   void setPointLocalReconstruction( PCCContext& context );
   void setPointLocalReconstructionData( PCCFrameContext&              frame,
                                         PCCPatch&                     patch,
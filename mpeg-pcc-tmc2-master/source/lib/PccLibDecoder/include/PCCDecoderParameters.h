@@ -48,12 +48,16 @@ class PCCDecoderParameters {
   size_t            startFrameNumber_;
   std::string       compressedStreamPath_;
   std::string       reconstructedDataPath_;
+  bool              reconstructedDataAscii_;
   std::string       videoDecoderPath_;
   std::string       videoDecoderOccupancyMapPath_;
   PCCColorTransform colorTransform_;
   std::string       colorSpaceConversionPath_;
   std::string       inverseColorSpaceConversionConfig_;
   size_t            nbThread_;
+  bool              pinThreads_;
+  bool              streaming_;
+  size_t            maxResidentFrames_;
   bool              keepIntermediateFiles_;
   bool              patchColorSubsampling_;
   size_t            postprocessSmoothingFilter_;
@@ -72,6 +76,9 @@ class PCCDecoderParameters {
   double            maxColorDist2Bwd_;
 #if OCCUPANCY_MAP_MODEL
   size_t      occupancyTargetPrecision_;
+  size_t      occupancyModelTileSize_;
+  size_t      occupancyModelTileHalo_;
+  size_t      occupancyModelTileStride_;
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
   std::string      modelName_;
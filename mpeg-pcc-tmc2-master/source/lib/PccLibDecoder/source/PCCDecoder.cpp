@@ -55,8 +55,11 @@ PCCDecoder::~PCCDecoder() {}
 void PCCDecoder::setParameters( PCCDecoderParameters params ) { params_ = params; }
 
 int PCCDecoder::decode( SampleStreamVpccUnit& ssvu, PCCContext& context, PCCGroupOfFrames& reconstructs ) {
-  int ret = 0;
-  if ( params_.nbThread_ > 0 ) { tbb::task_scheduler_init init( (int)params_.nbThread_ ); }
+  if ( !parse( ssvu, context ) ) { return 0; }
+  return decode( context, reconstructs );
+}
+
+bool PCCDecoder::parse( SampleStreamVpccUnit& ssvu, PCCContext& context ) {
   PCCBitstreamDecoder bitstreamDecoder;
 #ifdef BITSTREAM_TRACE
   PCCBitstream bitstream;
@@ -64,7 +67,7 @@ int PCCDecoder::decode( SampleStreamVpccUnit& ssvu, PCCContext& context, PCCGrou
   bitstream.openTrace( removeFileExtension( params_.compressedStreamPath_ ) + "_hls_decode.txt" );
   bitstreamDecoder.setTraceFile( bitstream.getTraceFile() );
 #endif
-  if ( !bitstreamDecoder.decode( ssvu, context ) ) { return 0; }
+  if ( !bitstreamDecoder.decode( ssvu, context ) ) { return false; }
 #ifdef BITSTREAM_TRACE
   bitstream.closeTrace();
 #endif
@@ -78,8 +81,7 @@ int PCCDecoder::decode( SampleStreamVpccUnit& ssvu, PCCContext& context, PCCGrou
 #ifdef CODEC_TRACE
   closeTrace();
 #endif
-  ret |= decode( context, reconstructs );
-  return ret;
+  return true;
 }
 
 int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
@@ -106,10 +108,12 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
   const size_t mapCount           = sps.getMapCountMinus1( atlasIndex ) + 1;
   auto&        videoBitstreamOM   = context.getVideoBitstream( VIDEO_OCCUPANCY );
   int          decodedBitDepthOM  = 8;
-  videoDecoder.decompress( context.getVideoOccupancyMap(), path.str(), context.size(), videoBitstreamOM,
-                           params_.videoDecoderOccupancyMapPath_, context, decodedBitDepthOM,
-                           params_.keepIntermediateFiles_, ( sps.getLosslessGeo() ? sps.getLosslessGeo444() : false ),
-                           false, "", "" );
+  if ( !videoDecoder.decompress( context.getVideoOccupancyMap(), path.str(), context.size(), videoBitstreamOM,
+                                 params_.videoDecoderOccupancyMapPath_, context, decodedBitDepthOM,
+                                 params_.keepIntermediateFiles_,
+                                 ( sps.getLosslessGeo() ? sps.getLosslessGeo444() : false ), false, "", "" ) ) {
+    return -1;
+  }
   auto& videoOcc = context.getVideoOccupancyMap();
   // converting the decoded bitdepth to the nominal bitdepth
   context.getVideoOccupancyMap().convertBitdepth( decodedBitDepthOM, oi.getOccupancyNominal2DBitdepthMinus1() + 1,
@@ -138,9 +142,12 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
     // Compress D0
     int   decodedBitDepthD0 = gi.getGeometryNominal2dBitdepthMinus1() + 1;
     auto& videoBitstreamD0  = context.getVideoBitstream( VIDEO_GEOMETRY_D0 );
-    videoDecoder.decompress( context.getVideoGeometry(), path.str(), context.size(), videoBitstreamD0,
-                             params_.videoDecoderPath_, context, decodedBitDepthD0, params_.keepIntermediateFiles_,
-                             ( sps.getLosslessGeo() ? sps.getLosslessGeo444() : false ) );
+    if ( !videoDecoder.decompress( context.getVideoGeometry(), path.str(), context.size(), videoBitstreamD0,
+                                   params_.videoDecoderPath_, context, decodedBitDepthD0,
+                                   params_.keepIntermediateFiles_,
+                                   ( sps.getLosslessGeo() ? sps.getLosslessGeo444() : false ) ) ) {
+      return -1;
+    }
     context.getVideoGeometry().convertBitdepth( decodedBitDepthD0, gi.getGeometryNominal2dBitdepthMinus1() + 1,
                                                 gi.getGeometryMSBAlignFlag() );
     std::cout << "geometry D0 video ->" << videoBitstreamD0.size() << " B" << std::endl;
@@ -148,9 +155,12 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
     // Compress D1
     int   decodedBitDepthD1 = gi.getGeometryNominal2dBitdepthMinus1() + 1;
     auto& videoBitstreamD1  = context.getVideoBitstream( VIDEO_GEOMETRY_D1 );
-    videoDecoder.decompress( context.getVideoGeometryD1(), path.str(), context.size(), videoBitstreamD1,
-                             params_.videoDecoderPath_, context, decodedBitDepthD1, params_.keepIntermediateFiles_,
-                             ( sps.getLosslessGeo() ? sps.getLosslessGeo444() : false ) );
+    if ( !videoDecoder.decompress( context.getVideoGeometryD1(), path.str(), context.size(), videoBitstreamD1,
+                                   params_.videoDecoderPath_, context, decodedBitDepthD1,
+                                   params_.keepIntermediateFiles_,
+                                   ( sps.getLosslessGeo() ? sps.getLosslessGeo444() : false ) ) ) {
+      return -1;
+    }
     context.getVideoGeometryD1().convertBitdepth( decodedBitDepthD1, gi.getGeometryNominal2dBitdepthMinus1() + 1,
                                                   gi.getGeometryMSBAlignFlag() );
     std::cout << "geometry D1 video ->" << videoBitstreamD1.size() << " B" << std::endl;
@@ -160,9 +170,11 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
   } else {
     int   decodedBitDepthGeo = gi.getGeometryNominal2dBitdepthMinus1() + 1;
     auto& videoBitstream     = context.getVideoBitstream( VIDEO_GEOMETRY );
-    videoDecoder.decompress( context.getVideoGeometry(), path.str(), context.size() * frameCountGeometry,
-                             videoBitstream, params_.videoDecoderPath_, context, decodedBitDepthGeo,
-                             params_.keepIntermediateFiles_, sps.getLosslessGeo() & sps.getLosslessGeo444() );
+    if ( !videoDecoder.decompress( context.getVideoGeometry(), path.str(), context.size() * frameCountGeometry,
+                                   videoBitstream, params_.videoDecoderPath_, context, decodedBitDepthGeo,
+                                   params_.keepIntermediateFiles_, sps.getLosslessGeo() & sps.getLosslessGeo444() ) ) {
+      return -1;
+    }
     context.getVideoGeometry().convertBitdepth( decodedBitDepthGeo, gi.getGeometryNominal2dBitdepthMinus1() + 1,
                                                 gi.getGeometryMSBAlignFlag() );
     std::cout << "geometry video ->" << videoBitstream.size() << " B" << std::endl;
@@ -171,8 +183,11 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
   if ( sps.getRawPatchEnabledFlag( atlasIndex ) && sps.getRawSeparateVideoPresentFlag( atlasIndex ) ) {
     int   decodedBitDepthMP = gi.getGeometryNominal2dBitdepthMinus1() + 1;
     auto& videoBitstreamMP  = context.getVideoBitstream( VIDEO_GEOMETRY_RAW );
-    videoDecoder.decompress( context.getVideoMPsGeometry(), path.str(), context.size(), videoBitstreamMP,
-                             params_.videoDecoderPath_, context, decodedBitDepthMP, params_.keepIntermediateFiles_ );
+    if ( !videoDecoder.decompress( context.getVideoMPsGeometry(), path.str(), context.size(), videoBitstreamMP,
+                                   params_.videoDecoderPath_, context, decodedBitDepthMP,
+                                   params_.keepIntermediateFiles_ ) ) {
+      return -1;
+    }
     context.getVideoMPsGeometry().convertBitdepth( decodedBitDepthMP, gi.getGeometryNominal2dBitdepthMinus1() + 1,
                                                    gi.getGeometryMSBAlignFlag() );
     generateMissedPointsGeometryfromVideo( context, reconstructs );
@@ -191,7 +206,7 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
   context.setOccupancyTargetPrecision( params_.occupancyTargetPrecision_ );
 
   auto& videoOccupancyMap = context.getVideoOccupancyMap();
-  upsampleOccupancyMap(context, videoOccupancyMap);
+  upsampleOccupancyMap( context, videoOccupancyMap, params_.nbThread_ );
 //  std::ofstream wf = std::ofstream("ocAnchor255.yuv", std::ios::binary);
 ////  wf.write((char*)&videoOccupancyMap.getFrame(0).getChannel(0)[0], videoOccupancyMap.getHeight() * videoOccupancyMap.getHeight() );
 //  for (int i = 0; i < videoOccupancyMap.getWidth() * videoOccupancyMap.getHeight(); ++i)
@@ -201,10 +216,13 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
 //  }
 //  wf.close();
   
-    PCCVideoOccupancyMap vom_org;
-    vom_org.getFrames().assign(videoOccupancyMap.getFrames().begin(), videoOccupancyMap.getFrames().end());
-  processIngredient(params_.modelName_, context, videoOccupancyMap);
-  refineOccupancy(vom_org, videoOccupancyMap);
+  PCCOccupancyModelParameters occupancyModelParams;
+  occupancyModelParams.modelName_   = params_.modelName_;
+  occupancyModelParams.nbThread_    = params_.nbThread_;
+  occupancyModelParams.tileSize_    = params_.occupancyModelTileSize_;
+  occupancyModelParams.tileHalo_    = params_.occupancyModelTileHalo_;
+  occupancyModelParams.tileStride_  = params_.occupancyModelTileStride_;
+  if ( !processIngredient( occupancyModelParams, context, videoOccupancyMap ) ) { return -1; }
 #endif
 
 
@@ -216,36 +234,43 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
     if ( sps.getMultipleMapStreamsPresentFlag( 0 ) ) {
       // decompress T0
       auto& videoBitstreamT0 = context.getVideoBitstream( VIDEO_TEXTURE_T0 );
-      videoDecoder.decompress( context.getVideoTexture(), path.str(), context.size(), videoBitstreamT0,
-                               params_.videoDecoderPath_, context, ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1,
-                               params_.keepIntermediateFiles_, sps.getLosslessGeo() != 0,
-                               params_.patchColorSubsampling_, params_.inverseColorSpaceConversionConfig_,
-                               params_.colorSpaceConversionPath_ );
+      if ( !videoDecoder.decompress( context.getVideoTexture(), path.str(), context.size(), videoBitstreamT0,
+                                     params_.videoDecoderPath_, context,
+                                     ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1, params_.keepIntermediateFiles_,
+                                     sps.getLosslessGeo() != 0, params_.patchColorSubsampling_,
+                                     params_.inverseColorSpaceConversionConfig_, params_.colorSpaceConversionPath_ ) ) {
+        return -1;
+      }
       std::cout << "texture T0 video ->" << videoBitstreamT0.size() << " B" << std::endl;
 
       // decompress T1
       auto& videoBitstreamT1 = context.getVideoBitstream( VIDEO_TEXTURE_T1 );
-      videoDecoder.decompress( context.getVideoTextureT1(), path.str(), context.size(), videoBitstreamT1,
-                               params_.videoDecoderPath_, context, ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1,
-                               params_.keepIntermediateFiles_, sps.getLosslessGeo() != 0,
-                               params_.patchColorSubsampling_, params_.inverseColorSpaceConversionConfig_,
-                               params_.colorSpaceConversionPath_ );
+      if ( !videoDecoder.decompress( context.getVideoTextureT1(), path.str(), context.size(), videoBitstreamT1,
+                                     params_.videoDecoderPath_, context,
+                                     ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1, params_.keepIntermediateFiles_,
+                                     sps.getLosslessGeo() != 0, params_.patchColorSubsampling_,
+                                     params_.inverseColorSpaceConversionConfig_, params_.colorSpaceConversionPath_ ) ) {
+        return -1;
+      }
       std::cout << "texture T1 video ->" << videoBitstreamT1.size() << " B" << std::endl;
       std::cout << "texture    video ->" << videoBitstreamT0.size() + videoBitstreamT1.size() << " B"
                 << std::endl;
     } else {
       auto& videoBitstream = context.getVideoBitstream( VIDEO_TEXTURE );
-      videoDecoder.decompress( context.getVideoTexture(),       // video,
-                               path.str(),                      // path,
-                               context.size() * mapCount,       // frameCount,
-                               videoBitstream,                  // bitstream,
-                               params_.videoDecoderPath_,       // decoderPath,
-                               context,                         // contexts,
-                               decodedBitdepthAttribute,        // bitDepth,
-                               params_.keepIntermediateFiles_,  // keepIntermediateFiles
-                               sps.getLosslessGeo() != 0,       // use444CodecIo
-                               params_.patchColorSubsampling_,  // patchColorSubsampling
-                               params_.inverseColorSpaceConversionConfig_, params_.colorSpaceConversionPath_ );
+      if ( !videoDecoder.decompress( context.getVideoTexture(),       // video,
+                                     path.str(),                      // path,
+                                     context.size() * mapCount,       // frameCount,
+                                     videoBitstream,                  // bitstream,
+                                     params_.videoDecoderPath_,       // decoderPath,
+                                     context,                         // contexts,
+                                     decodedBitdepthAttribute,        // bitDepth,
+                                     params_.keepIntermediateFiles_,  // keepIntermediateFiles
+                                     sps.getLosslessGeo() != 0,       // use444CodecIo
+                                     params_.patchColorSubsampling_,  // patchColorSubsampling
+                                     params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
+                                     params_.colorSpaceConversionPath_ ) ) {      // colorSpaceConversionPath
+        return -1;
+      }
       context.getVideoTexture().convertBitdepth(
           decodedBitdepthAttribute, ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1, ai.getAttributeMSBAlignFlag() );
       std::cout << "texture video  ->" << videoBitstream.size() << " B" << std::endl;
@@ -253,10 +278,12 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
     if ( sps.getRawPatchEnabledFlag( atlasIndex ) && sps.getRawSeparateVideoPresentFlag( atlasIndex ) ) {
       int   decodedBitdepthAttributeMP = ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1;
       auto& videoBitstreamMP           = context.getVideoBitstream( VIDEO_TEXTURE_RAW );
-      videoDecoder.decompress( context.getVideoMPsTexture(), path.str(), context.size(), videoBitstreamMP,
-                               params_.videoDecoderPath_, context, decodedBitdepthAttributeMP,
-                               params_.keepIntermediateFiles_, sps.getLosslessGeo(), false,
-                               params_.inverseColorSpaceConversionConfig_, params_.colorSpaceConversionPath_ );
+      if ( !videoDecoder.decompress( context.getVideoMPsTexture(), path.str(), context.size(), videoBitstreamMP,
+                                     params_.videoDecoderPath_, context, decodedBitdepthAttributeMP,
+                                     params_.keepIntermediateFiles_, sps.getLosslessGeo(), false,
+                                     params_.inverseColorSpaceConversionConfig_, params_.colorSpaceConversionPath_ ) ) {
+        return -1;
+      }
       context.getVideoTexture().convertBitdepth(
           decodedBitdepthAttributeMP, ai.getAttributeNominal2dBitdepthMinus1( 0 ) + 1, ai.getAttributeMSBAlignFlag() );      
       generateMissedPointsTexturefromVideo( context, reconstructs );
@@ -280,11 +307,13 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs ) {
         // These are different attribute transfer functions
         if ( params_.postprocessSmoothingFilter_ == 1 ) {
           tempFrameBuffer[i].transferColors( reconstructs[i], int32_t( 0 ), sps.getLosslessGeo() == 1, 8, 1, 1, 1, 1, 0,
-                                             4, 4, 1000, 1000, 1000, 1000 );  // jkie: make it general
+                                             4, 4, 1000, 1000, 1000, 1000, false, 10.0,
+                                             params_.nbThread_ );  // jkie: make it general
         } else if ( params_.postprocessSmoothingFilter_ == 2 ) {
-          tempFrameBuffer[i].transferColorWeight( reconstructs[i], 0.1 );
+          tempFrameBuffer[i].transferColorWeight( reconstructs[i], 0.1, params_.nbThread_ );
         } else if ( params_.postprocessSmoothingFilter_ == 3 ) {
-          tempFrameBuffer[i].transferColorsFilter3( reconstructs[i], int32_t( 0 ), sps.getLosslessGeo() == 1 );
+          tempFrameBuffer[i].transferColorsFilter3( reconstructs[i], int32_t( 0 ), sps.getLosslessGeo() == 1,
+                                                    params_.nbThread_ );
         }
       }
     }
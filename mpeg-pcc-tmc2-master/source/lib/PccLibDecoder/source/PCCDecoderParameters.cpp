@@ -38,6 +38,7 @@ using namespace pcc;
 PCCDecoderParameters::PCCDecoderParameters() {
   compressedStreamPath_              = {};
   reconstructedDataPath_             = {};
+  reconstructedDataAscii_            = false;
   startFrameNumber_                  = 0;
   colorTransform_                    = COLOR_TRANSFORM_RGB_TO_YCBCR;
   colorSpaceConversionPath_          = {};
@@ -45,10 +46,16 @@ PCCDecoderParameters::PCCDecoderParameters() {
   videoDecoderPath_                  = {};
   videoDecoderOccupancyMapPath_      = {};
   nbThread_                          = 1;
+  pinThreads_                        = false;
+  streaming_                         = false;
+  maxResidentFrames_                 = 16;
   keepIntermediateFiles_             = false;
   postprocessSmoothingFilter_        = 1;
 #if OCCUPANCY_MAP_MODEL
   occupancyTargetPrecision_                      = 1;
+  occupancyModelTileSize_                        = 0;
+  occupancyModelTileHalo_                        = 32;
+  occupancyModelTileStride_                      = 1;
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
   modelName_                                               = "";
@@ -61,9 +68,13 @@ void PCCDecoderParameters::print() {
   std::cout << "+ Parameters" << std::endl;
   std::cout << "\t compressedStreamPath                " << compressedStreamPath_ << std::endl;
   std::cout << "\t reconstructedDataPath               " << reconstructedDataPath_ << std::endl;
+  std::cout << "\t reconstructedDataAscii              " << reconstructedDataAscii_ << std::endl;
   std::cout << "\t startFrameNumber                    " << startFrameNumber_ << std::endl;
   std::cout << "\t colorTransform                      " << colorTransform_ << std::endl;
   std::cout << "\t nbThread                            " << nbThread_ << std::endl;
+  std::cout << "\t pinThreads                          " << pinThreads_ << std::endl;
+  std::cout << "\t streaming                           " << streaming_ << std::endl;
+  std::cout << "\t maxResidentFrames                   " << maxResidentFrames_ << std::endl;
   std::cout << "\t keepIntermediateFiles               " << keepIntermediateFiles_ << std::endl;
   std::cout << "\t video encoding" << std::endl;
   std::cout << "\t   colorSpaceConversionPath          " << colorSpaceConversionPath_ << std::endl;
@@ -73,6 +84,9 @@ void PCCDecoderParameters::print() {
   std::cout << "\t   patchColorSubsampling             " << patchColorSubsampling_ << std::endl;
 #if OCCUPANCY_MAP_MODEL
   std::cout << "\t   occupancyTargetPrecision                     " << occupancyTargetPrecision_ << std::endl;
+  std::cout << "\t   occupancyModelTileSize                       " << occupancyModelTileSize_ << std::endl;
+  std::cout << "\t   occupancyModelTileHalo                       " << occupancyModelTileHalo_ << std::endl;
+  std::cout << "\t   occupancyModelTileStride                     " << occupancyModelTileStride_ << std::endl;
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
   std::cout << "\t   modelName             " << modelName_<< std::endl;
@@ -117,21 +131,14 @@ bool PCCDecoderParameters::check() {
     ret = false;
     std::cerr << "compressedStreamPath not exist\n";
   }
-  if ( videoDecoderPath_.empty() ) {
-    ret = false;
-    std::cerr << "videoDecoderPath not set\n";
-  }
-  if ( !exist( videoDecoderPath_ ) ) {
-    ret = false;
-    std::cerr << "videoDecoderPath not exist\n";
+  // the video codec of each sub-stream is only known once it is read: the lossless reference codec needs no external
+  // decoder, the HM one checks its path when it is run.
+  if ( videoDecoderPath_.empty() || !exist( videoDecoderPath_ ) ) {
+    std::cout << "Info: videoDecoderPath not set or not exist, only lossless video streams can be decoded\n";
   }
-  if ( videoDecoderOccupancyMapPath_.empty() ) {
-    ret = false;
-    std::cerr << "videoDecoderOccupancyMapPath not set\n";
-  }
-  if ( !exist( videoDecoderOccupancyMapPath_ ) ) {
-    ret = false;
-    std::cerr << "videoDecoderOccupancyMapPath not exist\n";
+  if ( videoDecoderOccupancyMapPath_.empty() || !exist( videoDecoderOccupancyMapPath_ ) ) {
+    std::cout << "Info: videoDecoderOccupancyMapPath not set or not exist, only lossless occupancy map video "
+                 "streams can be decoded\n";
   }
   return ret;
 }
@@ -55,12 +55,12 @@ template <typename T, size_t N>
 class PCCVideo;
 typedef pcc::PCCVideo<uint8_t, 3>  PCCVideoTexture;
 typedef pcc::PCCVideo<uint16_t, 3> PCCVideoGeometry;
-typedef pcc::PCCVideo<uint8_t, 3>  PCCVideoOccupancyMap;
+typedef pcc::PCCVideo<uint8_t, 1>  PCCVideoOccupancyMap;
 template <typename T, size_t N>
 class PCCImage;
 typedef pcc::PCCImage<uint8_t, 3>  PCCImageTexture;
 typedef pcc::PCCImage<uint16_t, 3> PCCImageGeometry;
-typedef pcc::PCCImage<uint8_t, 3>  PCCImageOccupancyMap;
+typedef pcc::PCCImage<uint8_t, 1>  PCCImageOccupancyMap;
 struct PCCPatchSegmenter3Parameters;
 class PCCPatch;
 struct PCCBistreamPosition;
@@ -132,7 +132,7 @@ class PCCEncoder : public PCCCodec {
   bool generateOccupancyMapVideo( const PCCGroupOfFrames& sources, PCCContext& context );
   bool generateOccupancyMapVideo( const size_t           imageWidth,
                                   const size_t           imageHeight,
-                                  std::vector<uint32_t>& occupancyMap,
+                                  std::vector<uint16_t>& occupancyMap,
                                   PCCImageOccupancyMap&  videoFrameOccupancyMap );
 
   template <typename T>
@@ -141,7 +141,7 @@ class PCCEncoder : public PCCCodec {
   bool modifyOccupancyMap( const PCCGroupOfFrames& sources, PCCContext& context );
   bool modifyOccupancyMap( const size_t           imageWidth,
                            const size_t           imageHeight,
-                           std::vector<uint32_t>& occupancyMap,
+                           std::vector<uint16_t>& occupancyMap,
                            PCCImageOccupancyMap&  videoFrameOccupancyMap,
                            std::ofstream&         ofile );
 
@@ -188,12 +188,12 @@ class PCCEncoder : public PCCCodec {
   template <typename T>
   void pushPullMip( const PCCImage<T, 3>&        image,
                     PCCImage<T, 3>&              mip,
-                    const std::vector<uint32_t>& occupancyMap,
-                    std::vector<uint32_t>&       mipOccupancyMap );
+                    const std::vector<uint16_t>& occupancyMap,
+                    std::vector<uint16_t>&       mipOccupancyMap );
   template <typename T>
   void pushPullFill( PCCImage<T, 3>&              image,
                      const PCCImage<T, 3>&        mip,
-                     const std::vector<uint32_t>& occupancyMap,
+                     const std::vector<uint16_t>& occupancyMap,
                      int                          numIters );
   template <typename T>
   void dilateSmoothedPushPull( PCCFrameContext& frame, PCCImage<T, 3>& image );
@@ -202,10 +202,10 @@ class PCCEncoder : public PCCCodec {
   template <typename T>
   void CreateCoarseLayer( PCCImage<T, 3>&        image,
                           PCCImage<T, 3>&        mip,
-                          std::vector<uint32_t>& occupancyMap,
-                          std::vector<uint32_t>& mipOccupancyMap );
+                          std::vector<uint16_t>& occupancyMap,
+                          std::vector<uint16_t>& mipOccupancyMap );
   template <typename T>
-  void   regionFill( PCCImage<T, 3>& image, std::vector<uint32_t>& occupancyMap, PCCImage<T, 3>& imageLowRes );
+  void   regionFill( PCCImage<T, 3>& image, std::vector<uint16_t>& occupancyMap, PCCImage<T, 3>& imageLowRes );
   void   pack( PCCFrameContext& frame, int safeguard = 0, bool enablePointCloudPartitioning = false );
   void   packFlexible( PCCFrameContext& frame, int safeguard = 0, bool enablePointCloudPartitioning = false );
   void   packTetris( PCCFrameContext& frame, int safeguard = 0 );
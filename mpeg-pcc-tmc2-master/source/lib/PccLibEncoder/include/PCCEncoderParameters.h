@@ -55,6 +55,7 @@ class PCCEncoderParameters {
 
   std::string compressedStreamPath_;
   std::string reconstructedDataPath_;
+  bool        reconstructedDataAscii_;
 
   PCCColorTransform colorTransform_;
   std::string       colorSpaceConversionPath_;
@@ -63,10 +64,16 @@ class PCCEncoderParameters {
   std::string       videoEncoderAuxPath_;
   std::string       videoEncoderOccupancyMapPath_;
 
+  PCCVideoCodecBackendType videoCodecBackend_;
+
   std::string colorSpaceConversionConfig_;
   std::string inverseColorSpaceConversionConfig_;
 
   size_t nbThread_;
+  bool   pinThreads_;
+  size_t gofPipelineDepth_;
+  bool   prefetchFrames_;
+  size_t prefetchMemoryLimit_;
 
   size_t      frameCount_;
   size_t      groupOfFramesSize_;
@@ -107,6 +114,9 @@ class PCCEncoderParameters {
 #endif
 #if OCCUPANCY_MAP_MODEL
   size_t      occupancyTargetPrecision_;
+  size_t      occupancyModelTileSize_;
+  size_t      occupancyModelTileHalo_;
+  size_t      occupancyModelTileStride_;
 #endif
   std::string occupancyMapVideoEncoderConfig_;
   size_t      occupancyMapQP_;
@@ -0,0 +1,86 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCNeighborGraph_h
+#define PCCNeighborGraph_h
+
+#include "PCCCommon.h"
+#include <functional>
+
+namespace pcc {
+
+class PCCNNResult;
+
+// Neighbourhood graph stored in compressed sparse row layout: the neighbours of point i are
+// neighbors_[ offsets_[i] ] ... neighbors_[ offsets_[i + 1] - 1 ], kept in kd-tree search order.
+class PCCNeighborGraph {
+ public:
+  class Neighbors {
+   public:
+    Neighbors( const uint32_t* begin, const uint32_t* end ) : begin_( begin ), end_( end ) {}
+    const uint32_t* begin() const { return begin_; }
+    const uint32_t* end() const { return end_; }
+    size_t          size() const { return end_ - begin_; }
+    uint32_t        operator[]( const size_t index ) const { return begin_[index]; }
+
+   private:
+    const uint32_t* begin_;
+    const uint32_t* end_;
+  };
+
+  PCCNeighborGraph()  = default;
+  ~PCCNeighborGraph() = default;
+
+  size_t    size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+  Neighbors operator[]( const size_t index ) const {
+    return Neighbors( neighbors_.data() + offsets_[index], neighbors_.data() + offsets_[index + 1] );
+  }
+  double getDistance( const size_t index, const size_t n ) const { return distances_[offsets_[index] + n]; }
+  void   clear() {
+    offsets_.clear();
+    neighbors_.clear();
+    distances_.clear();
+  }
+  void build( const size_t                                       pointCount,
+              const bool                                         storeDistances,
+              const size_t                                       nbThread,
+              const std::function<void( size_t, PCCNNResult& )>& search );
+
+ private:
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> neighbors_;
+  std::vector<double>   distances_;
+};
+
+};  // namespace pcc
+
+#endif /* PCCNeighborGraph_h */
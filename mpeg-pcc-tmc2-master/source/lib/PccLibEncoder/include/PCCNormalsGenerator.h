@@ -38,9 +38,10 @@
 
 namespace pcc {
 enum PCCNormalsGeneratorOrientation {
-  PCC_NORMALS_GENERATOR_ORIENTATION_NONE          = 0,
-  PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE = 1,
-  PCC_NORMALS_GENERATOR_ORIENTATION_VIEW_POINT    = 2
+  PCC_NORMALS_GENERATOR_ORIENTATION_NONE                   = 0,
+  PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE          = 1,
+  PCC_NORMALS_GENERATOR_ORIENTATION_VIEW_POINT             = 2,
+  PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE_PARALLEL = 3
 };
 
 struct PCCNormalsGenerator3Parameters {
@@ -101,15 +102,21 @@ class PCCNormalsGenerator3 {
 
   void computeNormal( const size_t                          index,
                       const PCCPointSet3&                   pointCloud,
-                      const PCCKdTree&                      kdtree,
-                      const PCCNormalsGenerator3Parameters& params,
-                      PCCNNResult&                          nNResult );
+                      const uint32_t*                       neighbors,
+                      const size_t                          neighborCount,
+                      const PCCNormalsGenerator3Parameters& params );
   void computeNormals( const PCCPointSet3&                   pointCloud,
                        const PCCKdTree&                      kdtree,
                        const PCCNormalsGenerator3Parameters& params );
   void orientNormals( const PCCPointSet3&                   pointCloud,
                       const PCCKdTree&                      kdtree,
                       const PCCNormalsGenerator3Parameters& params );
+  void orientNormalsSpanningTree( const PCCPointSet3&                   pointCloud,
+                                  const PCCKdTree&                      kdtree,
+                                  const PCCNormalsGenerator3Parameters& params );
+  void orientNormalsSpanningTreeParallel( const PCCPointSet3&                   pointCloud,
+                                          const PCCKdTree&                      kdtree,
+                                          const PCCNormalsGenerator3Parameters& params );
   void addNeighbors( const uint32_t      current,
                      const PCCPointSet3& pointCloud,
                      const PCCKdTree&    kdtree,
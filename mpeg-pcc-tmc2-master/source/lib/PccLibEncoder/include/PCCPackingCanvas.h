@@ -0,0 +1,84 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCPackingCanvas_h
+#define PCCPackingCanvas_h
+
+#include "PCCCommon.h"
+
+namespace pcc {
+
+class PCCPatch;
+
+// Block occupancy canvas used by the patch packers, stored as one row of 64-bit words per block row. The fit tests
+// give the same answers as PCCPatch::checkFitPatchCanvas() on the equivalent std::vector<bool> canvas (index
+// u + sizeU * v), but test whole rows of the patch footprint with word operations.
+class PCCPackingCanvas {
+ public:
+  PCCPackingCanvas( size_t sizeU = 0, size_t sizeV = 0 );
+  ~PCCPackingCanvas() {}
+
+  // keeps the content of the rows already allocated
+  void   resize( size_t sizeU, size_t sizeV );
+  void   set( size_t index ) { set( index % sizeU_, index / sizeU_ ); }
+  void   set( size_t u, size_t v ) { rows_[v * wordsPerRow_ + ( u >> 6 )] |= uint64_t( 1 ) << ( u & 63 ); }
+  bool   get( size_t u, size_t v ) const { return ( rows_[v * wordsPerRow_ + ( u >> 6 )] >> ( u & 63 ) ) & 1; }
+  size_t getSizeU() const { return sizeU_; }
+  size_t getSizeV() const { return sizeV_; }
+
+  bool checkFit( const PCCPatch& patch, bool bPrecedence, int safeguard = 0, const Tile& tile = Tile() );
+
+  // Returns the patch U0 when the patch fits at its current position and orientation. Otherwise, returns a lower bound
+  // of the next U0 of the same row where it may fit (greater than getSizeU() when no position of the row can fit).
+  size_t nextFit( const PCCPatch& patch, bool bPrecedence, int safeguard = 0, const Tile& tile = Tile() );
+
+ private:
+  uint64_t getBits( size_t v, size_t u, size_t count ) const;
+  void     buildMask( const PCCPatch& patch, int safeguard, size_t maskSizeU, size_t maskSizeV );
+
+  size_t                sizeU_;
+  size_t                sizeV_;
+  size_t                wordsPerRow_;
+  std::vector<uint64_t> rows_;
+
+  // dilated occupancy of the last patch tested with bPrecedence, in canvas orientation, per patch orientation. The
+  // masks are kept while the patch sizes, occupancy and safeguard are unchanged, whatever the patch object.
+  size_t                             maskSizeU0_;
+  size_t                             maskSizeV0_;
+  int                                maskSafeguard_;
+  std::vector<bool>                  maskOccupancy_;
+  std::vector<std::vector<uint64_t>> masks_;
+};
+
+};  // namespace pcc
+
+#endif /* PCCPackingCanvas_h */
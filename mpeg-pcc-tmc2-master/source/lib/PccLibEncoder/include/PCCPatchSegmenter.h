@@ -35,6 +35,7 @@
 #define PCCPatchSegmenter_h
 
 #include "PCCCommon.h"
+#include "PCCNeighborGraph.h"
 #include <set>
 
 namespace pcc {
@@ -43,6 +44,7 @@ class PCCNormalsGenerator3;
 class PCCKdTree;
 class PCCPatch;
 
+
 struct PCCPatchSegmenter3Parameters {
   size_t           nnNormalEstimation_;
   bool             gridBasedRefineSegmentation_;
@@ -115,22 +117,21 @@ class PCCPatchSegmenter3 {
                             const PCCVector3D*          orientations,
                             const size_t                orientationCount,
                             std::vector<size_t>&        partition );
-  void computeAdjacencyInfo( const PCCPointSet3&               pointCloud,
-                             const PCCKdTree&                  kdtree,
-                             std::vector<std::vector<size_t>>& adj,
-                             const size_t                      maxNNCount );
-
-  void computeAdjacencyInfoDist( const PCCPointSet3&               pointCloud,
-                                 const PCCKdTree&                  kdtree,
-                                 std::vector<std::vector<size_t>>& adj,
-                                 std::vector<std::vector<double>>& adjDist,
-                                 const size_t                      maxNNCount );
-
-  void computeAdjacencyInfoInRadius( const PCCPointSet3&               pointCloud,
-                                     const PCCKdTree&                  kdtree,
-                                     std::vector<std::vector<size_t>>& adj,
-                                     const size_t                      maxNNCount,
-                                     const size_t                      radius );
+  void computeAdjacencyInfo( const PCCPointSet3& pointCloud,
+                             const PCCKdTree&    kdtree,
+                             PCCNeighborGraph&   adj,
+                             const size_t        maxNNCount );
+
+  void computeAdjacencyInfoDist( const PCCPointSet3& pointCloud,
+                                 const PCCKdTree&    kdtree,
+                                 PCCNeighborGraph&   adj,
+                                 const size_t        maxNNCount );
+
+  void computeAdjacencyInfoInRadius( const PCCPointSet3& pointCloud,
+                                     const PCCKdTree&    kdtree,
+                                     PCCNeighborGraph&   adj,
+                                     const size_t        maxNNCount,
+                                     const size_t        radius );
 
   void segmentPatches( const PCCPointSet3&                 points,
                        const size_t                        frameIndex,
@@ -232,7 +233,7 @@ class PCCPatchSegmenter3 {
                                    const double                      minGradient,
                                    const size_t                      minNumHighGradientPoints,
                                    std::vector<size_t>&              partition,
-                                   std::vector<std::vector<size_t>>& adj,
+                                   const PCCNeighborGraph&           adj,
                                    std::vector<std::vector<size_t>>& connectedComponents );
   void determinePatchOrientation( const size_t         additionalProjectionAxis,
                                   const bool           absoluteD1,
@@ -257,7 +258,7 @@ class PCCPatchSegmenter3 {
                           const double                      minGradient,
                           const size_t                      minNumHighGradientPoints,
                           PCCPatch&                         patch,
-                          std::vector<std::vector<size_t>>& adj,
+                          const PCCNeighborGraph&           adj,
                           std::vector<std::vector<size_t>>& highGradientConnectedComponents,
                           std::vector<bool>&                isRemoved );
 
@@ -38,6 +38,7 @@
 #include "PCCFrameContext.h"
 #include "PCCPatch.h"
 #include "PCCPatchSegmenter.h"
+#include "PCCPackingCanvas.h"
 #include "PCCVideoEncoder.h"
 #include "PCCSystem.h"
 #include "PCCGroupOfFrames.h"
@@ -80,8 +81,6 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources,
   size_t pointLocalReconstructionOriginal     = params_.pointLocalReconstruction_;
   size_t layerCountMinus1Original             = params_.mapCountMinus1_;
   size_t singleLayerPixelInterleavingOriginal = params_.singleMapPixelInterleaving_;
-  if ( params_.nbThread_ > 0 ) { tbb::task_scheduler_init init( (int)params_.nbThread_ ); }
-
   params_.initializeContext( context );
   ret |= encode( sources, context, reconstructs );
   PCCBitstreamEncoder bitstreamEncoder;
@@ -142,6 +141,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
 
   PCCVideoEncoder videoEncoder;
   const size_t    pointCount = sources[0].getPointCount();
+  videoEncoder.setBackend( params_.videoCodecBackend_ );
 
   // GENERATE GEOMETRY VIDEO
   generateGeometryVideo( sources, context );
@@ -219,85 +219,115 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
 
   if ( params_.losslessGeo_ ) { internalBitDepth = geometryVideoBitDepth; }
 
+  if ( params_.multipleStreams_ && params_.lossyMissedPointsPatch_ ) {
+    std::cout << "Error: lossyMissedPointsPatch has not been implemented for absoluteD1_ = 0 as "
+                 "yet. Exiting... "
+              << std::endl;
+    std::exit( -1 );
+  }
+  const bool rawSeparateVideo =
+      sps.getRawPatchEnabledFlag( atlasIndex ) && sps.getRawSeparateVideoPresentFlag( atlasIndex );
+  const std::string& geometryEncoderPath =
+      ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_;
+
+  // The geometry sub-streams only depend on the dilated geometry video and on the raw points: they are all created
+  // here and then encoded concurrently. The video bitstreams are stored in a vector in the context, so none of them
+  // can be created while the encoders hold references to the others.
   if ( params_.multipleStreams_ ) {
-    if ( params_.lossyMissedPointsPatch_ ) {
-      std::cout << "Error: lossyMissedPointsPatch has not been implemented for absoluteD1_ = 0 as "
-                   "yet. Exiting... "
-                << std::endl;
-      std::exit( -1 );
-    }
-
-    // Compress geometryD0
-    auto& videoBitstreamD0 = context.createVideoBitstream( VIDEO_GEOMETRY_D0 );
-    auto& videoGeometry    = context.getVideoGeometry();
-    videoEncoder.compress(
-        videoGeometry, path.str(), ( params_.geometryQP_ - 1 ), videoBitstreamD0, params_.geometryD0Config_,
-        ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_, context,
-        nbyteGeo,                                         // nbyte
-        params_.losslessGeo_ && params_.losslessGeo444_,  // use444CodecIo
-        params_.use3dmc_,                                 // use3dmv
-        internalBitDepth,                                 // internalBitDepth
-        false,                                            // useConversion
-        params_.keepIntermediateFiles_ );                 // keepIntermediateFiles
-    size_t sizeGeometryVideoD0 = videoBitstreamD0.size();
+    context.createVideoBitstream( VIDEO_GEOMETRY_D0 );
+    context.createVideoBitstream( VIDEO_GEOMETRY_D1 );
+  } else {
+    context.createVideoBitstream( VIDEO_GEOMETRY );
+  }
+  if ( rawSeparateVideo ) {
+    context.createVideoBitstream( VIDEO_GEOMETRY_RAW );
+    generateMissedPointsGeometryVideo( context, reconstructs );
+  }
+  tbb::task_arena limited( (int)params_.nbThread_ );
+  limited.execute( [&] {
+    tbb::task_group videoTasks;
+    if ( params_.multipleStreams_ ) {
+      auto& videoBitstreamD0 = context.getVideoBitstream( VIDEO_GEOMETRY_D0 );
+      auto& videoBitstreamD1 = context.getVideoBitstream( VIDEO_GEOMETRY_D1 );
+      auto& videoGeometry    = context.getVideoGeometry();
+      auto& videoGeometryD1  = context.getVideoGeometryD1();
+      auto  compressD0       = [&] {
+        videoEncoder.compress( videoGeometry, path.str(), ( params_.geometryQP_ - 1 ), videoBitstreamD0,
+                               params_.geometryD0Config_, geometryEncoderPath, context,
+                               nbyteGeo,                                         // nbyte
+                               params_.losslessGeo_ && params_.losslessGeo444_,  // use444CodecIo
+                               params_.use3dmc_,                                 // use3dmv
+                               internalBitDepth,                                 // internalBitDepth
+                               false,                                            // useConversion
+                               params_.keepIntermediateFiles_ );                 // keepIntermediateFiles
+      };
+      auto compressD1 = [&] {
+        videoEncoder.compress( videoGeometryD1, path.str(), params_.geometryQP_, videoBitstreamD1,
+                               params_.geometryD1Config_, geometryEncoderPath, context,
+                               nbyteGeo,                                         // nbyte
+                               params_.losslessGeo_ && params_.losslessGeo444_,  // use444CodecIo
+                               params_.use3dmc_,                                 // use3dmv
+                               internalBitDepth,                                 // internalBitDepth
+                               false,                                            // useConversion
+                               params_.keepIntermediateFiles_ );
+      };
+      if ( params_.absoluteD1_ ) {
+        videoTasks.run( compressD0 );
+        videoTasks.run( compressD1 );
+      } else {
+        // differential D1 is predicted from the reconstructed D0
+        videoTasks.run( [&] {
+          compressD0();
+          for ( size_t f = 0; f < frames.size(); ++f ) {
+            auto& frame1 = videoGeometryD1.getFrame( f );
+            predictGeometryFrame( frames[f], videoGeometry.getFrame( f ), frame1 );
+            dilate3DPadding( sources[f], frames[f], frame1, videoOccupancyMap.getFrame( f ) );
+          }
+          compressD1();
+        } );
+      }
+    } else {
+      videoTasks.run( [&] {
+        videoEncoder.compress(
+            context.getVideoGeometry(), path.str(), params_.geometryQP_, context.getVideoBitstream( VIDEO_GEOMETRY ),
+            params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.geometryConfig_ ) : params_.geometryConfig_,
+            geometryEncoderPath, context,
+            nbyteGeo,                                         // nbyte
+            params_.losslessGeo_ && params_.losslessGeo444_,  // use444CodecIo
+            params_.use3dmc_,                                 // use3dmv
+            internalBitDepth,                                 // internalBitDepth
+            false,                                            // useConversion
+            params_.keepIntermediateFiles_ );                 // keepIntermediateFiles
+      } );
+    }
+    if ( rawSeparateVideo ) {
+      videoTasks.run( [&] {
+        videoEncoder.compress( context.getVideoMPsGeometry(), path.str(),
+                               params_.lossyMissedPointsPatch_ ? params_.lossyMppGeoQP_ : params_.geometryQP_,
+                               context.getVideoBitstream( VIDEO_GEOMETRY_RAW ), params_.geometryMPConfig_,
+                               params_.videoEncoderPath_, context,
+                               nbyteGeoMP,        // nbyte
+                               false,             // use444CodecIo
+                               false,             // use3dmv
+                               internalBitDepth,  // internalBitDepth
+                               false,             // useConversion
+                               params_.keepIntermediateFiles_ );
+      } );
+    }
+    videoTasks.wait();
+  } );
+  if ( params_.multipleStreams_ ) {
+    size_t sizeGeometryVideoD0 = context.getVideoBitstream( VIDEO_GEOMETRY_D0 ).size();
+    size_t sizeGeometryVideoD1 = context.getVideoBitstream( VIDEO_GEOMETRY_D1 ).size();
     std::cout << "sizeGeometryVideoD0: " << sizeGeometryVideoD0 << std::endl;
-    if ( !params_.absoluteD1_ ) {
-      // Form differential video geometryD1
-      for ( size_t f = 0; f < frames.size(); ++f ) {
-        auto& frame1 = context.getVideoGeometryD1().getFrame( f );
-        predictGeometryFrame( frames[f], videoGeometry.getFrame( f ), frame1 );
-        dilate3DPadding( sources[f], frames[f], frame1, videoOccupancyMap.getFrame( f ) );
-      }
-    }
-
-    // Compress geometryD1
-    auto& videoGeometryD1  = context.getVideoGeometryD1();
-    auto& videoBitstreamD1 = context.createVideoBitstream( VIDEO_GEOMETRY_D1 );
-    videoEncoder.compress(
-        videoGeometryD1, path.str(), params_.geometryQP_, videoBitstreamD1, params_.geometryD1Config_,
-        ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_, context,
-        nbyteGeo,                                         // nbyte
-        params_.losslessGeo_ && params_.losslessGeo444_,  // use444CodecIo
-        params_.use3dmc_,                                 // use3dmv
-        internalBitDepth,                                 // internalBitDepth
-        false,                                            // useConversion
-        params_.keepIntermediateFiles_ );
-
-    size_t sizeGeometryVideoD1 = videoBitstreamD1.size();
-    std::cout << "sizeGeometryVideoD1: " << sizeGeometryVideoD1 << std::endl;    
+    std::cout << "sizeGeometryVideoD1: " << sizeGeometryVideoD1 << std::endl;
     std::cout << "geometryVideo ->" << ( sizeGeometryVideoD0 + sizeGeometryVideoD1 ) << "=" << sizeGeometryVideoD0
               << "+" << sizeGeometryVideoD1 << " B ("
               << ( ( sizeGeometryVideoD0 + sizeGeometryVideoD1 ) * 8.0 ) / ( 2 * frames.size() * pointCount ) << " bpp)"
               << std::endl;
-  } else {
-    auto& videoBitstream = context.createVideoBitstream( VIDEO_GEOMETRY );
-    auto& videoGeometry  = context.getVideoGeometry();
-    videoEncoder.compress(
-        videoGeometry, path.str(), params_.geometryQP_, videoBitstream,
-        params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.geometryConfig_ ) : params_.geometryConfig_,
-        ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_, context,
-        nbyteGeo,                                         // nbyte
-        params_.losslessGeo_ && params_.losslessGeo444_,  // use444CodecIo
-        params_.use3dmc_,                                 // use3dmv
-        internalBitDepth,                                 // internalBitDepth
-        false,                                            // useConversion
-        params_.keepIntermediateFiles_ );                 // keepIntermediateFiles
-  }
-
-  if ( sps.getRawPatchEnabledFlag( atlasIndex ) && sps.getRawSeparateVideoPresentFlag( atlasIndex ) ) {
-    auto& videoBitstreamMP = context.createVideoBitstream( VIDEO_GEOMETRY_RAW );
-    generateMissedPointsGeometryVideo( context, reconstructs );
-    auto& videoMPsGeometry = context.getVideoMPsGeometry();
-    videoEncoder.compress( videoMPsGeometry, path.str(),
-                           params_.lossyMissedPointsPatch_ ? params_.lossyMppGeoQP_ : params_.geometryQP_,
-                           videoBitstreamMP, params_.geometryMPConfig_, params_.videoEncoderPath_, context,
-                           nbyteGeoMP,        // nbyte
-                           false,             // use444CodecIo
-                           false,             // use3dmv
-                           internalBitDepth,  // internalBitDepth
-                           false,             // useConversion
-                           params_.keepIntermediateFiles_ );
-    if ( params_.lossyMissedPointsPatch_ ) { generateMissedPointsGeometryfromVideo( context, reconstructs ); }
+  }
+  if ( rawSeparateVideo && params_.lossyMissedPointsPatch_ ) {
+    generateMissedPointsGeometryfromVideo( context, reconstructs );
   }
 
   // RECONSTRUCT POINT CLOUD GEOMETRY
@@ -309,7 +339,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
   std::vector<std::vector<uint32_t>> partitions;
 
 #if OCCUPANCY_MAP_MODEL
-  upsampleOccupancyMap(context, videoOccupancyMap);
+  upsampleOccupancyMap( context, videoOccupancyMap, params_.nbThread_ );
 
 #if KEEP_OCCUPANCY_MAP_255
   std::string base_path_255 = params_.compressedStreamPath_;
@@ -323,9 +353,13 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
   wf.close();
 #endif
 
-    PCCVideoOccupancyMap vom_org;
-    vom_org.getFrames().assign(videoOccupancyMap.getFrames().begin(), videoOccupancyMap.getFrames().end());
-  processIngredient(params_.modelName_, context, videoOccupancyMap);
+  PCCOccupancyModelParameters occupancyModelParams;
+  occupancyModelParams.modelName_   = params_.modelName_;
+  occupancyModelParams.nbThread_    = params_.nbThread_;
+  occupancyModelParams.tileSize_    = params_.occupancyModelTileSize_;
+  occupancyModelParams.tileHalo_    = params_.occupancyModelTileHalo_;
+  occupancyModelParams.tileStride_  = params_.occupancyModelTileStride_;
+  if ( !processIngredient( occupancyModelParams, context, videoOccupancyMap ) ) { return -1; }
 
 #if KEEP_OCCUPANCY_MAP_255
  wf = std::ofstream(base_path_255.substr(0, base_path_255.length() - 4)+ "_ocModel255.yuv", std::ios::binary);
@@ -338,8 +372,6 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
   wf.close();
 #endif
 
-  refineOccupancy(vom_org, videoOccupancyMap);
-
 #else
 #if KEEP_OCCUPANCY_MAP_255
   std::string base_path_255 = params_.compressedStreamPath_;
@@ -476,105 +508,131 @@ generatePointCloud( reconstructs, context, gpcParams, partitions, false );
     }
 
     // ENCODE ATTRIBUTE IMAGE
+    // as for the geometry, the attribute sub-streams are created first and the independent ones encoded concurrently
     if ( params_.multipleStreams_ ) {
-      size_t nbyteAtt     = 1;
-      auto&  videoTexture = context.getVideoTexture();
-      // Compress textureT0
-      auto& videoBitstreamT0 = context.createVideoBitstream( VIDEO_TEXTURE_T0 );
-      videoEncoder.compress(
-          videoTexture, path.str(), params_.textureQP_, videoBitstreamT0,
-          params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.textureConfig_ ) : params_.textureT0Config_,
-          ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_, context,
-          nbyteAtt,                                    // nbyte
-          params_.losslessGeo_,                        // use444CodecIo
-          params_.use3dmc_,                            // use3dmv
-          10,                                          // internalBitDepth
-          !params_.losslessGeo_,                       // useConversion
-          params_.keepIntermediateFiles_,              // keepIntermediateFiles
-          params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
-          params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
-          params_.colorSpaceConversionPath_ );
-
-      size_t sizeTextureVideoT0 = videoBitstreamT0.size();
-      std::cout << "sizeTextureVideoT0: " << sizeTextureVideoT0 << std::endl;      
-      // Form differential video textureT1
-      auto& videoTextureT1 = context.getVideoTextureT1();
-      if ( !params_.absoluteT1_ ) {
-        for ( size_t f = 0; f < frames.size(); ++f ) {
-          auto& frame1 = videoTextureT1.getFrame( f );
-          predictTextureFrame( frames[f], videoTexture.getFrame( f ), frame1 );
-          if ( !( params_.losslessGeo_ && params_.textureDilationOffLossless_ ) ) {
-            switch ( params_.textureBGFill_ ) {
-              case 0: dilate( frames[f], videoTextureT1.getFrame( f ) ); break;
-              case 1: dilateSmoothedPushPull( frames[f], videoTextureT1.getFrame( f ) ); break;
-              case 2: dilateHarmonicBackgroundFill( frames[f], videoTextureT1.getFrame( f ) ); break;
-              default: std::cout << "Warning: no texture padding applied!" << std::endl;
+      context.createVideoBitstream( VIDEO_TEXTURE_T0 );
+      context.createVideoBitstream( VIDEO_TEXTURE_T1 );
+    } else {
+      context.createVideoBitstream( VIDEO_TEXTURE );
+    }
+    if ( rawSeparateVideo ) {
+      context.createVideoBitstream( VIDEO_TEXTURE_RAW );
+      generateMissedPointsTextureVideo( context, reconstructs );  // 1. texture
+    }
+    const std::string& textureEncoderPath =
+        ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_;
+    limited.execute( [&] {
+      tbb::task_group videoTasks;
+      if ( params_.multipleStreams_ ) {
+        size_t nbyteAtt         = 1;
+        auto&  videoBitstreamT0 = context.getVideoBitstream( VIDEO_TEXTURE_T0 );
+        auto&  videoBitstreamT1 = context.getVideoBitstream( VIDEO_TEXTURE_T1 );
+        auto   compressT0       = [&] {
+          videoEncoder.compress(
+              videoTexture, path.str(), params_.textureQP_, videoBitstreamT0,
+              params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.textureConfig_ ) : params_.textureT0Config_,
+              textureEncoderPath, context,
+              nbyteAtt,                                    // nbyte
+              params_.losslessGeo_,                        // use444CodecIo
+              params_.use3dmc_,                            // use3dmv
+              10,                                          // internalBitDepth
+              !params_.losslessGeo_,                       // useConversion
+              params_.keepIntermediateFiles_,              // keepIntermediateFiles
+              params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
+              params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
+              params_.colorSpaceConversionPath_ );
+        };
+        auto compressT1 = [&] {
+          videoEncoder.compress(
+              videoTextureT1, path.str(), params_.textureQP_ + params_.qpAdjT1_, videoBitstreamT1,
+              params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.textureConfig_ ) : params_.textureT1Config_,
+              textureEncoderPath, context,
+              nbyteAtt,                                    // nbyte
+              params_.losslessGeo_,                        // use444CodecIo
+              params_.use3dmc_,                            // use3dmv
+              10,                                          // internalBitDepth
+              !params_.losslessGeo_,                       // useConversion
+              params_.keepIntermediateFiles_,              // keepIntermediateFiles
+              params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
+              params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
+              params_.colorSpaceConversionPath_ );
+        };
+        if ( params_.absoluteT1_ ) {
+          videoTasks.run( compressT0 );
+          videoTasks.run( compressT1 );
+        } else {
+          // differential T1 is predicted from the reconstructed T0
+          videoTasks.run( [&] {
+            compressT0();
+            for ( size_t f = 0; f < frames.size(); ++f ) {
+              auto& frame1 = videoTextureT1.getFrame( f );
+              predictTextureFrame( frames[f], videoTexture.getFrame( f ), frame1 );
+              if ( !( params_.losslessGeo_ && params_.textureDilationOffLossless_ ) ) {
+                switch ( params_.textureBGFill_ ) {
+                  case 0: dilate( frames[f], videoTextureT1.getFrame( f ) ); break;
+                  case 1: dilateSmoothedPushPull( frames[f], videoTextureT1.getFrame( f ) ); break;
+                  case 2: dilateHarmonicBackgroundFill( frames[f], videoTextureT1.getFrame( f ) ); break;
+                  default: std::cout << "Warning: no texture padding applied!" << std::endl;
+                }
+              }
             }
-          }
+            std::cout << "texture prediction done " << std::endl;
+            compressT1();
+          } );
         }
-        std::cout << "texture prediction done " << std::endl;        
-      }  //! absoluteT1
-
-      // compress textureT1
-      auto& videoBitstreamT1 = context.createVideoBitstream( VIDEO_TEXTURE_T1 );
-      videoEncoder.compress(
-          videoTextureT1, path.str(), params_.textureQP_ + params_.qpAdjT1_, videoBitstreamT1,
-          params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.textureConfig_ ) : params_.textureT1Config_,
-          ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_, context,
-          nbyteAtt,                                    // nbyte
-          params_.losslessGeo_,                        // use444CodecIo
-          params_.use3dmc_,                            // use3dmv
-          10,                                          // internalBitDepth
-          !params_.losslessGeo_,                       // useConversion
-          params_.keepIntermediateFiles_,              // keepIntermediateFiles
-          params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
-          params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
-          params_.colorSpaceConversionPath_ );
-
-      size_t sizeTextureVideoT1 = videoBitstreamT1.size();
+      } else {
+        std::cout << "texture video " << std::endl;
+        videoTasks.run( [&] {
+          const size_t nbyteAtt = 1;
+          videoEncoder.compress(
+              videoTexture, path.str(), params_.textureQP_, context.getVideoBitstream( VIDEO_TEXTURE ),
+              params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.textureConfig_ ) : params_.textureConfig_,
+              textureEncoderPath, context,
+              nbyteAtt,                                    // nbyte
+              params_.losslessGeo_,                        // use444CodecIo
+              params_.use3dmc_,                            // use3dmv
+              10,                                          // internalBitDepth
+              !params_.losslessGeo_,                       // useConversion
+              params_.keepIntermediateFiles_,              // keepIntermediateFiles
+              params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
+              params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
+              params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
+        } );
+      }
+      if ( rawSeparateVideo ) {
+        videoTasks.run( [&] {
+          const size_t nByteAttMP = 1;
+          videoEncoder.compress( context.getVideoMPsTexture(), path.str(), params_.textureQP_,
+                                 context.getVideoBitstream( VIDEO_TEXTURE_RAW ), params_.textureMPConfig_,
+                                 params_.videoEncoderPath_, context,
+                                 nByteAttMP,                                  // nbyte
+                                 params_.losslessGeo_,                        // use444CodecIo
+                                 false,                                       // use3dmv
+                                 10,                                          // internalBitDepth
+                                 !params_.losslessGeo_,                       // useConversion
+                                 params_.keepIntermediateFiles_,              // keepIntermediateFiles
+                                 params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
+                                 params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
+                                 params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
+        } );
+      }
+      videoTasks.wait();
+    } );
+    if ( params_.multipleStreams_ ) {
+      size_t sizeTextureVideoT0 = context.getVideoBitstream( VIDEO_TEXTURE_T0 ).size();
+      size_t sizeTextureVideoT1 = context.getVideoBitstream( VIDEO_TEXTURE_T1 ).size();
+      std::cout << "sizeTextureVideoT0: " << sizeTextureVideoT0 << std::endl;
       std::cout << "texture video ->" << ( sizeTextureVideoT0 + sizeTextureVideoT1 ) << "=" << sizeTextureVideoT0 << "+"
                 << sizeTextureVideoT1 << " B ("
                 << ( ( sizeTextureVideoT0 + sizeTextureVideoT1 ) * 8.0 ) / ( 2 * frames.size() * pointCount ) << " bpp)"
-                << std::endl;      
+                << std::endl;
     } else {
-      std::cout << "texture video " << std::endl;
-      auto&        videoBitstream = context.createVideoBitstream( VIDEO_TEXTURE );
-      const size_t nbyteAtt       = 1;
-      videoEncoder.compress(
-          videoTexture, path.str(), params_.textureQP_, videoBitstream,
-          params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.textureConfig_ ) : params_.textureConfig_,
-          ( params_.use3dmc_ != 0 ) ? params_.videoEncoderAuxPath_ : params_.videoEncoderPath_, context,
-          nbyteAtt,                                    // nbyte
-          params_.losslessGeo_,                        // use444CodecIo
-          params_.use3dmc_,                            // use3dmv
-          10,                                          // internalBitDepth
-          !params_.losslessGeo_,                       // useConversion
-          params_.keepIntermediateFiles_,              // keepIntermediateFiles
-          params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
-          params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
-          params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
-      auto sizeTextureVideo = videoBitstream.size();
+      auto sizeTextureVideo = context.getVideoBitstream( VIDEO_TEXTURE ).size();
       std::cout << "texture video ->" << sizeTextureVideo << " B ("
                 << ( sizeTextureVideo * 8.0 ) / ( 2 * frames.size() * pointCount ) << " bpp)" << std::endl;
     }
-
-    if ( sps.getRawPatchEnabledFlag( atlasIndex ) && sps.getRawSeparateVideoPresentFlag( atlasIndex ) ) {
-      auto& videoBitstreamMP = context.createVideoBitstream( VIDEO_TEXTURE_RAW );
-      generateMissedPointsTextureVideo( context, reconstructs );  // 1. texture
-      auto&        videoMPsTexture = context.getVideoMPsTexture();
-      const size_t nByteAttMP      = 1;
-      videoEncoder.compress( videoMPsTexture, path.str(), params_.textureQP_, videoBitstreamMP,
-                             params_.textureMPConfig_, params_.videoEncoderPath_, context,
-                             nByteAttMP,                                  // nbyte
-                             params_.losslessGeo_,                        // use444CodecIo
-                             false,                                       // use3dmv
-                             10,                                          // internalBitDepth
-                             !params_.losslessGeo_,                       // useConversion
-                             params_.keepIntermediateFiles_,              // keepIntermediateFiles
-                             params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
-                             params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
-                             params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
-      if ( params_.lossyMissedPointsPatch_ ) { generateMissedPointsTexturefromVideo( context, reconstructs ); }
+    if ( rawSeparateVideo && params_.lossyMissedPointsPatch_ ) {
+      generateMissedPointsTexturefromVideo( context, reconstructs );
     }
   }
 
@@ -608,11 +666,12 @@ generatePointCloud( reconstructs, context, gpcParams, partitions, false );
         // These are different attribute transfer functions
         if ( params_.postprocessSmoothingFilter_ == 1 ) {
           tempFrameBuffer[i].transferColors( reconstructs[i], int32_t( 0 ), sps.getLosslessGeo() == 1, 8, 1, 1, 1, 1, 0,
-                                             4, 4, 1000, 1000, 1000, 1000 );
+                                             4, 4, 1000, 1000, 1000, 1000, false, 10.0, params_.nbThread_ );
         } else if ( params_.postprocessSmoothingFilter_ == 2 ) {
-          tempFrameBuffer[i].transferColorWeight( reconstructs[i], 0.1 );
+          tempFrameBuffer[i].transferColorWeight( reconstructs[i], 0.1, params_.nbThread_ );
         } else if ( params_.postprocessSmoothingFilter_ == 3 ) {
-          tempFrameBuffer[i].transferColorsFilter3( reconstructs[i], int32_t( 0 ), sps.getLosslessGeo() == 1 );
+          tempFrameBuffer[i].transferColorsFilter3( reconstructs[i], int32_t( 0 ), sps.getLosslessGeo() == 1,
+                                                    params_.nbThread_ );
         }
       }
     }
@@ -708,7 +767,7 @@ bool PCCEncoder::generateOccupancyMapVideo( const PCCGroupOfFrames& sources, PCC
 
 bool PCCEncoder::generateOccupancyMapVideo( const size_t           imageWidth,
                                             const size_t           imageHeight,
-                                            std::vector<uint32_t>& occupancyMap,
+                                            std::vector<uint16_t>& occupancyMap,
                                             PCCImageOccupancyMap&  videoFrameOccupancyMap ) {
   const size_t   blockSize0  = params_.occupancyResolution_ / params_.occupancyPrecision_;
   const size_t   pointCount0 = blockSize0 * blockSize0;
@@ -796,7 +855,7 @@ bool PCCEncoder::modifyOccupancyMap( const PCCGroupOfFrames& sources, PCCContext
 
 bool PCCEncoder::modifyOccupancyMap( const size_t           imageWidth,
                                      const size_t           imageHeight,
-                                     std::vector<uint32_t>& occupancyMap,
+                                     std::vector<uint16_t>& occupancyMap,
                                      PCCImageOccupancyMap&  videoFrameOccupancyMap,
                                      std::ofstream&         ofile ) {
   const size_t numSubBlksV = imageHeight / params_.occupancyPrecision_;
@@ -804,7 +863,7 @@ bool PCCEncoder::modifyOccupancyMap( const size_t           imageWidth,
 
   // const size_t threshold = OM_OFFSET / 2;
 
-  std::vector<uint32_t> newOccupancyMap;
+  std::vector<uint16_t> newOccupancyMap;
   newOccupancyMap.resize( imageWidth * imageHeight );
   char tmpC;
 
@@ -2672,6 +2731,7 @@ void PCCEncoder::pack( PCCFrameContext& frame, int safeguard, bool enablePointCl
 
   std::vector<bool> occupancyMap;
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  PCCPackingCanvas canvas( occupancySizeU, occupancySizeV );
   if ( !enablePointCloudPartitioning ) {
     for ( auto& patch : patches ) {
       assert( patch.getSizeU0() <= occupancySizeU );
@@ -2681,18 +2741,21 @@ void PCCEncoder::pack( PCCFrameContext& frame, int safeguard, bool enablePointCl
       while ( !locationFound ) {
         patch.getPatchOrientation() = PATCH_ORIENTATION_DEFAULT;  // only allowed orientation in anchor
         for ( int v = 0; v <= occupancySizeV && !locationFound; ++v ) {
-          for ( int u = 0; u <= occupancySizeU && !locationFound; ++u ) {
-            patch.getU0() = u;
-            patch.getV0() = v;
-            if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                            safeguard ) ) {
+          for ( int u = 0; u <= occupancySizeU && !locationFound; ) {
+            patch.getU0()      = u;
+            patch.getV0()      = v;
+            const size_t nextU = canvas.nextFit( patch, params_.lowDelayEncoding_, safeguard );
+            if ( nextU == u ) {
               locationFound = true;
+            } else {
+              u = (int)nextU;
             }
           }
         }
         if ( !locationFound ) {
           occupancySizeV *= 2;
           occupancyMap.resize( occupancySizeU * occupancySizeV );
+          canvas.resize( occupancySizeU, occupancySizeV );
         }
       }
       for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
@@ -2704,6 +2767,7 @@ void PCCEncoder::pack( PCCFrameContext& frame, int safeguard, bool enablePointCl
           else
             occupancyMap[v * occupancySizeU + u] =
                 occupancyMap[v * occupancySizeU + u] || occupancy[v0 * patch.getSizeU0() + u0];
+          if ( occupancyMap[v * occupancySizeU + u] ) { canvas.set( u, v ); }
         }
       }
 
@@ -2762,8 +2826,7 @@ void PCCEncoder::pack( PCCFrameContext& frame, int safeguard, bool enablePointCl
                   }
                 }
                 if ( tileIsAvailable ) {
-                  if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV,
-                                                  params_.lowDelayEncoding_, safeguard, tile ) ) {
+                  if ( canvas.checkFit( patch, params_.lowDelayEncoding_, safeguard, tile ) ) {
                     locationFound = true;
                     if ( tileIndex > lastOccupiedTileIndex ) { lastOccupiedTileIndex = tileIndex; }
                     std::cout << "ROI-" << roiIndex + 1 << " patch-" << patch.getIndex() << " fitted in tile-"
@@ -2777,6 +2840,7 @@ void PCCEncoder::pack( PCCFrameContext& frame, int safeguard, bool enablePointCl
           if ( !locationFound ) {
             occupancySizeV *= 2;
             occupancyMap.resize( occupancySizeU * occupancySizeV );
+            canvas.resize( occupancySizeU, occupancySizeV );
           }
         }
         for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
@@ -2785,6 +2849,7 @@ void PCCEncoder::pack( PCCFrameContext& frame, int safeguard, bool enablePointCl
             const size_t u = patch.getU0() + u0;
             occupancyMap[v * occupancySizeU + u] =
                 occupancyMap[v * occupancySizeU + u] || occupancy[v0 * patch.getSizeU0() + u0];
+            if ( occupancyMap[v * occupancySizeU + u] ) { canvas.set( u, v ); }
           }
         }
 
@@ -2853,6 +2918,7 @@ void PCCEncoder::packFlexible( PCCFrameContext& frame, int safeguard, bool enabl
                                                              // rotated)
   int numOrientations = params_.useEightOrientations_ ? 8 : 2;
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  PCCPackingCanvas canvas( occupancySizeU, occupancySizeV );
   if ( !params_.enablePointCloudPartitioning_ ) {
     for ( auto& patch : patches ) {
       assert( patch.getSizeU0() <= occupancySizeU );
@@ -2861,29 +2927,34 @@ void PCCEncoder::packFlexible( PCCFrameContext& frame, int safeguard, bool enabl
       auto& occupancy     = patch.getOccupancy();
       while ( !locationFound ) {
         for ( size_t v = 0; v < occupancySizeV && !locationFound; ++v ) {
-          for ( size_t u = 0; u < occupancySizeU && !locationFound; ++u ) {
+          for ( size_t u = 0; u < occupancySizeU && !locationFound; ) {
             patch.getU0() = u;
             patch.getV0() = v;
+            // next position where at least one of the orientations may fit
+            size_t nextU = ( std::numeric_limits<size_t>::max )();
             for ( size_t orientationIdx = 0; orientationIdx < numOrientations && !locationFound; orientationIdx++ ) {
               if ( patch.getSizeU0() > patch.getSizeV0() ) {
                 patch.getPatchOrientation() = orientation_horizontal[orientationIdx];
               } else {
                 patch.getPatchOrientation() = orientation_vertical[orientationIdx];
               }
-              if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                              safeguard ) ) {
+              const size_t orientationNextU = canvas.nextFit( patch, params_.lowDelayEncoding_, safeguard );
+              if ( orientationNextU == u ) {
                 locationFound = true;
                 if ( printDetailedInfo ) {
                   std::cout << "Orientation " << patch.getPatchOrientation() << " selected for patch "
                             << patch.getIndex() << " (" << u << "," << v << ")" << std::endl;
                 }
               }
+              nextU = ( std::min )( nextU, orientationNextU );
             }
+            if ( !locationFound ) { u = nextU; }
           }
         }
         if ( !locationFound ) {
           occupancySizeV *= 2;
           occupancyMap.resize( occupancySizeU * occupancySizeV );
+          canvas.resize( occupancySizeU, occupancySizeV );
         }
       }
       for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
@@ -2893,6 +2964,7 @@ void PCCEncoder::packFlexible( PCCFrameContext& frame, int safeguard, bool enabl
             occupancyMap[coord] = true;
           else
             occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
+          if ( occupancyMap[coord] ) { canvas.set( coord ); }
         }
       }
 
@@ -2963,8 +3035,7 @@ void PCCEncoder::packFlexible( PCCFrameContext& frame, int safeguard, bool enabl
                     } else {
                       patch.getPatchOrientation() = orientation_vertical[orientationIdx];
                     }
-                    if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV,
-                                                    params_.lowDelayEncoding_, safeguard, tile ) ) {
+                    if ( canvas.checkFit( patch, params_.lowDelayEncoding_, safeguard, tile ) ) {
                       locationFound = true;
                       if ( tileIndex > lastOccupiedTileIndex ) { lastOccupiedTileIndex = tileIndex; }
                       std::cout << "ROI-" << roiIndex + 1 << " patch-" << patch.getIndex() << " fitted in tile-"
@@ -2983,12 +3054,14 @@ void PCCEncoder::packFlexible( PCCFrameContext& frame, int safeguard, bool enabl
           if ( !locationFound ) {
             occupancySizeV *= 2;
             occupancyMap.resize( occupancySizeU * occupancySizeV );
+            canvas.resize( occupancySizeU, occupancySizeV );
           }
         }  // while loop
         for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
           for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
             int coord           = patch.patchBlock2CanvasBlock( u0, v0, occupancySizeU, occupancySizeV );
             occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
+            if ( occupancyMap[coord] ) { canvas.set( coord ); }
           }
         }
 
@@ -3044,6 +3117,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, int safeguard ) {
 
   std::vector<bool> occupancyMap;
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  PCCPackingCanvas canvas( occupancySizeU, occupancySizeV );
   std::vector<int> horizon;
   horizon.resize( occupancySizeU, 0 );
   if ( printDetailedInfo ) {
@@ -3091,8 +3165,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, int safeguard ) {
             }
             if ( printDetailedInfo )
               std::cout << "(" << u << "," << v << "|" << patch.getPatchOrientation() << ")" << std::endl;
-            if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                            safeguard ) ) {
+            if ( canvas.checkFit( patch, params_.lowDelayEncoding_, safeguard ) ) {
               // now calculate the wasted space
               int wasted_space =
                   patch.calculate_wasted_space( horizon, top_horizon, bottom_horizon, right_horizon, left_horizon );
@@ -3111,6 +3184,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, int safeguard ) {
       if ( !locationFound ) {
         occupancySizeV *= 2;
         occupancyMap.resize( occupancySizeU * occupancySizeV );
+        canvas.resize( occupancySizeU, occupancySizeV );
         if ( printDetailedInfo )
           std::cout << "Increasing frame size (" << occupancySizeU << "," << occupancySizeV << ")" << std::endl;
       } else {
@@ -3138,6 +3212,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, int safeguard ) {
           occupancyMap[coord] = true;
         else
           occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
+        if ( occupancyMap[coord] ) { canvas.set( coord ); }
       }
     }
     if ( !( patch.isPatchDimensionSwitched() ) ) {
@@ -3935,7 +4010,11 @@ void PCCEncoder::generateMissedPointsPatch( const PCCPointSet3& source,
 
   const size_t geometry3dCoordinatesBitdepth = params_.geometry3dCoordinatesBitdepth_;
 
-  PCCPointSet3 pointsToBeProjected;
+  // two depths per patch pixel, the builder grows for the EOM points
+  size_t pixelCount = 0;
+  for ( const auto& patch : patches ) { pixelCount += patch.getSizeU() * patch.getSizeV(); }
+  PCCPointSet3       pointsToBeProjected;
+  PCCPointSetBuilder pointsToBeProjectedBuilder( pointsToBeProjected, 2 * pixelCount );
   for ( const auto& patch : patches ) {
     for ( size_t v = 0; v < patch.getSizeV(); ++v ) {
       for ( size_t u = 0; u < patch.getSizeU(); ++u ) {
@@ -3961,7 +4040,7 @@ void PCCEncoder::generateMissedPointsPatch( const PCCPointSet3& source,
             point0.y() = tmp1.y();
             point0.z() = tmp1.z();
           }
-          pointsToBeProjected.addPoint( point0 );
+          pointsToBeProjectedBuilder.addPoint( point0 );
           if ( useEnhancedDeltaDepthCode ) {
             if ( patch.getDepthEnhancedDeltaD()[p] != 0 ) {
               PCCPoint3D point1;
@@ -3986,7 +4065,7 @@ void PCCEncoder::generateMissedPointsPatch( const PCCPointSet3& source,
                   } else {
                     point1[patch.getNormalAxis()] = double( patch.getD1() - depth0 - nDeltaDCur );
                   }
-                  pointsToBeProjected.addPoint( point1 );
+                  pointsToBeProjectedBuilder.addPoint( point1 );
                 }
               }  // for each i
             }    // if( patch.getDepthEnhancedDeltaD()[p] != 0) )
@@ -4009,20 +4088,20 @@ void PCCEncoder::generateMissedPointsPatch( const PCCPointSet3& source,
               point1.y() = tmp3.y();
               point1.z() = tmp3.z();
             }
-            pointsToBeProjected.addPoint( point1 );
+            pointsToBeProjectedBuilder.addPoint( point1 );
           }
         }
       }
     }
   }
+  pointsToBeProjectedBuilder.commit();
   PCCKdTree           kdtreeMissedPoints( pointsToBeProjected );
-  PCCNNResult         result;
+  PCCNNBatchResult    nearest;
   std::vector<size_t> missedPoints;
   missedPoints.resize( 0 );
+  kdtreeMissedPoints.search( source, 0, source.getPointCount(), 1, nearest, params_.nbThread_ );
   for ( size_t i = 0; i < source.getPointCount(); ++i ) {
-    kdtreeMissedPoints.search( source[i], 1, result );
-    const double dist2 = result.dist( 0 );
-    if ( dist2 > 0.0 ) { missedPoints.push_back( i ); }
+    if ( !nearest.count( i ) || nearest.dist( i )[0] > 0.0 ) { missedPoints.push_back( i ); }
   }
   size_t numMissedPts = missedPoints.size();
 
@@ -4566,7 +4645,7 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
   auto&                 patches         = frame.getPatches();
   auto&                 blockToPatch    = frame.getBlockToPatch();
   auto&                 occupancyMapOrg = frame.getOccupancyMap();
-  std::vector<uint32_t> occupancyMap;
+  std::vector<uint16_t> occupancyMap;
   occupancyMap.resize( occupancyMapOrg.size(), 0 );
   for ( size_t i = 0; i < occupancyMapOrg.size(); i++ ) { occupancyMap[i] = ( occupancyMapOrg[i] >= 1 ); }
   const size_t width              = frame.getWidth();
@@ -4620,7 +4699,10 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
       distance.resize( nbOfOptimizationMode );
       size_t optimizationIndex = 0, optimizationIndexMin = 0;
       for ( size_t i = 0; i < nbOfOptimizationMode; i++ ) {
-        auto& mode = context.getPointLocalReconstructionMode( i );
+        auto&              mode = context.getPointLocalReconstructionMode( i );
+        PCCPointSetBuilder reconstructBuilder( reconstruct[optimizationIndex],
+                                               patchSize * patch.getOccupancyResolution() *
+                                                   patch.getOccupancyResolution() * ( params.mapCountMinus1_ + 1 ) );
         for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
           for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
             const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
@@ -4636,7 +4718,7 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
                                                        mode.interpolate_, mode.filling_, mode.minD1_, mode.neighbor_ );
                   if ( createdPoints.size() > 0 ) {
                     for ( size_t i = 0; i < createdPoints.size(); i++ ) {
-                      reconstruct[optimizationIndex].addPoint( createdPoints[i] );
+                      reconstructBuilder.addPoint( createdPoints[i] );
                     }
                   }
                 }
@@ -4644,6 +4726,7 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
             }
           }
         }
+        reconstructBuilder.commit();
         float distancePSrcRec, distancePRecSrc;
         srcPointCloudPatch.distanceGeo( reconstruct[optimizationIndex], distancePSrcRec, distancePRecSrc );
         distance[optimizationIndex] = ( std::max )( distancePSrcRec, distancePRecSrc );
@@ -4678,7 +4761,10 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
             distance.resize( nbOfOptimizationMode );
             size_t optimizationIndex = 0, optimizationIndexMin = 0;
             for ( size_t i = 0; i < nbOfOptimizationMode; i++ ) {
-              auto& mode = context.getPointLocalReconstructionMode( i );
+              auto&              mode = context.getPointLocalReconstructionMode( i );
+              PCCPointSetBuilder reconstructBuilder(
+                  reconstruct[optimizationIndex],
+                  patch.getOccupancyResolution() * patch.getOccupancyResolution() * ( params.mapCountMinus1_ + 1 ) );
               for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
                 const size_t v = v0 * patch.getOccupancyResolution() + v1;
                 for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
@@ -4691,17 +4777,18 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
                   if ( createdPoints.size() > 0 ) {
                     for ( size_t i = 0; i < createdPoints.size(); i++ ) {
                       if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                        reconstruct[optimizationIndex].addPoint( createdPoints[i] );
+                        reconstructBuilder.addPoint( createdPoints[i] );
                       } else {
                         PCCVector3D tmp;
                         PCCPatch::InverseRotatePosition45DegreeOnAxis(
                             patch.getAxisOfAdditionalPlane(), params.geometryBitDepth3D_, createdPoints[i], tmp );
-                        reconstruct[optimizationIndex].addPoint( tmp );
+                        reconstructBuilder.addPoint( tmp );
                       }
                     }
                   }
                 }
               }
+              reconstructBuilder.commit();
               float distancePSrcRec, distancePRecSrc;
               blockSrcPointCloud.distanceGeo( reconstruct[optimizationIndex], distancePSrcRec, distancePRecSrc );
               distance[optimizationIndex] = ( std::max )( distancePSrcRec, distancePRecSrc );
@@ -5142,7 +5229,7 @@ void PCCEncoder::dilateHarmonicBackgroundFill( PCCFrameContext& frame, PCCImage<
   auto                               occupancyMapTemp = frame.getOccupancyMap();
   int                                i                = 0;
   std::vector<PCCImage<T, 3>>        mipVec;
-  std::vector<std::vector<uint32_t>> mipOccupancyMapVec;
+  std::vector<std::vector<uint16_t>> mipOccupancyMapVec;
   int                                miplev = 0;
 
   // create coarse image by dyadic sampling
@@ -5173,8 +5260,8 @@ void PCCEncoder::dilateHarmonicBackgroundFill( PCCFrameContext& frame, PCCImage<
 template <typename T>
 void PCCEncoder::CreateCoarseLayer( PCCImage<T, 3>&        image,
                                     PCCImage<T, 3>&        mip,
-                                    std::vector<uint32_t>& occupancyMap,
-                                    std::vector<uint32_t>& mipOccupancyMap ) {
+                                    std::vector<uint16_t>& occupancyMap,
+                                    std::vector<uint16_t>& mipOccupancyMap ) {
   int dyadicWidth = 1;
   while ( dyadicWidth < image.getWidth() ) dyadicWidth *= 2;
   int dyadicHeight = 1;
@@ -5211,7 +5298,7 @@ void PCCEncoder::CreateCoarseLayer( PCCImage<T, 3>&        image,
 }
 
 template <typename T>
-void PCCEncoder::regionFill( PCCImage<T, 3>& image, std::vector<uint32_t>& occupancyMap, PCCImage<T, 3>& imageLowRes ) {
+void PCCEncoder::regionFill( PCCImage<T, 3>& image, std::vector<uint16_t>& occupancyMap, PCCImage<T, 3>& imageLowRes ) {
   int                   stride        = image.getWidth();
   int                   numElem       = 0;
   int                   numSparseElem = 0;
@@ -5383,8 +5470,8 @@ int PCCEncoder::mean4w( T             p1,
 template <typename T>
 void PCCEncoder::pushPullMip( const PCCImage<T, 3>&        image,
                               PCCImage<T, 3>&              mip,
-                              const std::vector<uint32_t>& occupancyMap,
-                              std::vector<uint32_t>&       mipOccupancyMap ) {
+                              const std::vector<uint16_t>& occupancyMap,
+                              std::vector<uint16_t>&       mipOccupancyMap ) {
   unsigned char w1, w2, w3, w4;
   unsigned char val1, val2, val3, val4;
   const size_t  width     = image.getWidth();
@@ -5442,7 +5529,7 @@ void PCCEncoder::pushPullMip( const PCCImage<T, 3>&        image,
 template <typename T>
 void PCCEncoder::pushPullFill( PCCImage<T, 3>&              image,
                                const PCCImage<T, 3>&        mip,
-                               const std::vector<uint32_t>& occupancyMap,
+                               const std::vector<uint16_t>& occupancyMap,
                                int                          numIters ) {
   const size_t width    = mip.getWidth();
   const size_t height   = mip.getHeight();
@@ -5540,7 +5627,7 @@ void PCCEncoder::dilateSmoothedPushPull( PCCFrameContext& frame, PCCImage<T, 3>&
   auto                               occupancyMapTemp = frame.getOccupancyMap();
   int                                i                = 0;
   std::vector<PCCImage<T, 3>>        mipVec;
-  std::vector<std::vector<uint32_t>> mipOccupancyMapVec;
+  std::vector<std::vector<uint16_t>> mipOccupancyMapVec;
   int                                div    = 2;
   int                                miplev = 0;
 
@@ -5600,8 +5687,8 @@ void PCCEncoder::presmoothPointCloudColor( PCCPointSet3& reconstruct, const PCCE
 
       PCCNNResult result;
       if ( reconstruct.getBoundaryPointType( i ) == 2 ) {
-        kdtree.searchRadius( reconstruct[i], params.neighborCountColorSmoothing_, params.radius2ColorSmoothing_,
-                             result );
+        kdtree.searchRadiusSorted( reconstruct[i], params.neighborCountColorSmoothing_,
+                                   params.radius2ColorSmoothing_, result );
         PCCVector3D          centroid( 0.0 );
         size_t               neighborCount = 0;
         std::vector<uint8_t> Lum;
@@ -5682,7 +5769,7 @@ bool PCCEncoder::generateTextureVideo( const PCCGroupOfFrames&    sources,
                                  params_.skipAvgIfIdenticalSourcePointPresentBwd_, params_.distOffsetFwd_,
                                  params_.distOffsetBwd_, params_.maxGeometryDist2Fwd_, params_.maxGeometryDist2Bwd_,
                                  params_.maxColorDist2Fwd_, params_.maxColorDist2Bwd_, params_.excludeColorOutlier_,
-                                 params_.thresholdColorOutlierDist_ );
+                                 params_.thresholdColorOutlierDist_, params_.nbThread_ );
 
       for ( size_t j = 0; j < numPointSub; j++ ) {
         reconstructs[i].setColor( subReconstructIndex[j], subReconstruct.getColor( j ) );
@@ -5703,7 +5790,7 @@ bool PCCEncoder::generateTextureVideo( const PCCGroupOfFrames&    sources,
                                  params_.skipAvgIfIdenticalSourcePointPresentBwd_, params_.distOffsetFwd_,
                                  params_.distOffsetBwd_, params_.maxGeometryDist2Fwd_, params_.maxGeometryDist2Bwd_,
                                  params_.maxColorDist2Fwd_, params_.maxColorDist2Bwd_, params_.excludeColorOutlier_,
-                                 params_.thresholdColorOutlierDist_ );
+                                 params_.thresholdColorOutlierDist_, params_.nbThread_ );
       // color pre-smoothing
       if ( !params_.losslessGeo_ && params_.flagColorPreSmoothing_ ) {
         presmoothPointCloudColor( reconstructs[i], params );
@@ -5763,11 +5850,11 @@ bool PCCEncoder::generateTextureVideo( const PCCPointSet3& reconstruct,
   }
 
   for ( size_t i = 0; i < pointCount; ++i ) {
-    const PCCVector3<size_t> location = pointToPixel[i];
-    const PCCColor3B         color    = reconstruct.getColor( i );
-    const size_t             u        = location[0];
-    const size_t             v        = location[1];
-    const size_t             f        = location[2];
+    const PCCVector3<uint32_t> location = pointToPixel[i];
+    const PCCColor3B           color    = reconstruct.getColor( i );
+    const size_t               u        = location[0];
+    const size_t               v        = location[1];
+    const size_t               f        = location[2];
     if ( params_.singleMapPixelInterleaving_ ) {
       if ( ( f == 0 && ( ( u + v ) % 2 == 0 ) ) || ( f == 1 && ( ( u + v ) % 2 == 1 ) ) ) {
         auto& image = video.getFrame( curNumOfVideoFrames );
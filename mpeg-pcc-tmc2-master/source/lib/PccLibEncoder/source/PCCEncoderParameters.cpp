@@ -45,6 +45,7 @@ PCCEncoderParameters::PCCEncoderParameters() {
   uncompressedDataPath_                    = {};
   compressedStreamPath_                    = {};
   reconstructedDataPath_                   = {};
+  reconstructedDataAscii_                  = false;
   configurationFolder_                     = {};
   uncompressedDataFolder_                  = {};
   startFrameNumber_                        = 0;
@@ -76,6 +77,9 @@ PCCEncoderParameters::PCCEncoderParameters() {
   occupancyPrecision_                      = 4;
 #if OCCUPANCY_MAP_MODEL
   occupancyTargetPrecision_                      = 1;
+  occupancyModelTileSize_                        = 0;
+  occupancyModelTileHalo_                        = 32;
+  occupancyModelTileStride_                      = 1;
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
   modelName_                                               = "";
@@ -108,6 +112,7 @@ PCCEncoderParameters::PCCEncoderParameters() {
   excludeColorOutlier_                     = false;
   thresholdColorOutlierDist_               = 10.0;
   videoEncoderPath_                        = {};
+  videoCodecBackend_                       = VIDEO_CODEC_BACKEND_EXTERNAL;
   videoEncoderAuxPath_                     = {};
   videoEncoderOccupancyMapPath_            = {};
   geometryQP_                              = 28;
@@ -125,6 +130,10 @@ PCCEncoderParameters::PCCEncoderParameters() {
   geometryMPConfig_                        = {};
   textureMPConfig_                         = {};
   nbThread_                                = 1;
+  pinThreads_                              = false;
+  gofPipelineDepth_                        = 1;
+  prefetchFrames_                          = false;
+  prefetchMemoryLimit_                     = 0;
   keepIntermediateFiles_                   = false;
 
   absoluteD1_                             = true;
@@ -266,12 +275,17 @@ void PCCEncoderParameters::print() {
   std::cout << "\t uncompressedDataPath                     " << uncompressedDataPath_ << std::endl;
   std::cout << "\t compressedStreamPath                     " << compressedStreamPath_ << std::endl;
   std::cout << "\t reconstructedDataPath                    " << reconstructedDataPath_ << std::endl;
+  std::cout << "\t reconstructedDataAscii                   " << reconstructedDataAscii_ << std::endl;
   std::cout << "\t frameCount                               " << frameCount_ << std::endl;
   std::cout << "\t mapCountMinus1                          " << mapCountMinus1_ << std::endl;
   std::cout << "\t startFrameNumber                         " << startFrameNumber_ << std::endl;
   std::cout << "\t groupOfFramesSize                        " << groupOfFramesSize_ << std::endl;
   std::cout << "\t colorTransform                           " << colorTransform_ << std::endl;
   std::cout << "\t nbThread                                 " << nbThread_ << std::endl;
+  std::cout << "\t pinThreads                               " << pinThreads_ << std::endl;
+  std::cout << "\t gofPipelineDepth                         " << gofPipelineDepth_ << std::endl;
+  std::cout << "\t prefetchFrames                           " << prefetchFrames_ << std::endl;
+  std::cout << "\t prefetchMemoryLimit                      " << prefetchMemoryLimit_ << std::endl;
   std::cout << "\t keepIntermediateFiles                    " << keepIntermediateFiles_ << std::endl;
   std::cout << "\t absoluteD1                               " << absoluteD1_ << std::endl;
   std::cout << "\t multipleStreams                          " << multipleStreams_ << std::endl;
@@ -324,6 +338,7 @@ void PCCEncoderParameters::print() {
   std::cout << "\t   geometryQP                             " << geometryQP_ << std::endl;
   std::cout << "\t   textureQP                              " << textureQP_ << std::endl;
   std::cout << "\t   colorSpaceConversionPath               " << colorSpaceConversionPath_ << std::endl;
+  std::cout << "\t   videoCodecBackend                      " << videoCodecBackend_ << std::endl;
   std::cout << "\t   videoEncoderPath                       " << videoEncoderPath_ << std::endl;
   std::cout << "\t   videoEncoderAuxPath                    " << videoEncoderAuxPath_ << std::endl;
   std::cout << "\t   videoEncoderOccupancyMapPath           " << videoEncoderOccupancyMapPath_ << std::endl;
@@ -355,6 +370,9 @@ void PCCEncoderParameters::print() {
   std::cout << "\t   occupancyPrecision                     " << occupancyPrecision_ << std::endl;
 #if OCCUPANCY_MAP_MODEL
   std::cout << "\t   occupancyTargetPrecision                     " << occupancyTargetPrecision_ << std::endl;
+  std::cout << "\t   occupancyModelTileSize                       " << occupancyModelTileSize_ << std::endl;
+  std::cout << "\t   occupancyModelTileHalo                       " << occupancyModelTileHalo_ << std::endl;
+  std::cout << "\t   occupancyModelTileStride                     " << occupancyModelTileStride_ << std::endl;
 #endif
 #if GEOMETRY_ATTRIBUTES_MODEL
   std::cout << "\t   modelName             " << modelName_<< std::endl;
@@ -532,13 +550,15 @@ bool PCCEncoderParameters::check() {
     ret = false;
     std::cerr << "uncompressedDataPath not set\n";
   }
-  if ( videoEncoderPath_.empty() ) {
-    ret = false;
-    std::cerr << "videoEncoderPath not set\n";
-  }
-  if ( !exist( videoEncoderPath_ ) ) {
-    ret = false;
-    std::cerr << "videoEncoderPath not exist\n";
+  if ( videoCodecBackend_ == VIDEO_CODEC_BACKEND_EXTERNAL ) {
+    if ( videoEncoderPath_.empty() ) {
+      ret = false;
+      std::cerr << "videoEncoderPath not set\n";
+    }
+    if ( !exist( videoEncoderPath_ ) ) {
+      ret = false;
+      std::cerr << "videoEncoderPath not exist\n";
+    }
   }
 
   if ( ( videoEncoderOccupancyMapPath_.empty() || !exist( videoEncoderOccupancyMapPath_ ) ) ) {
@@ -0,0 +1,82 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+
+#include "PCCKdTree.h"
+#include "tbb/tbb.h"
+#include "PCCNeighborGraph.h"
+
+using namespace pcc;
+
+void PCCNeighborGraph::build( const size_t                                       pointCount,
+                              const bool                                         storeDistances,
+                              const size_t                                       nbThread,
+                              const std::function<void( size_t, PCCNNResult& )>& search ) {
+  // Points are searched in fixed blocks so that each task appends to a single buffer; the
+  // blocks are then concatenated in point order, which keeps the graph independent of nbThread.
+  const size_t                       blockSize  = 4096;
+  const size_t                       blockCount = ( pointCount + blockSize - 1 ) / blockSize;
+  std::vector<std::vector<uint32_t>> blockNeighbors( blockCount );
+  std::vector<std::vector<double>>   blockDistances( storeDistances ? blockCount : 0 );
+  offsets_.assign( pointCount + 1, 0 );
+  tbb::task_arena limited( (int)nbThread );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), blockCount, [&]( const size_t block ) {
+      const size_t start = block * blockSize;
+      const size_t end   = ( std::min )( start + blockSize, pointCount );
+      auto&        nn    = blockNeighbors[block];
+      PCCNNResult  result;
+      for ( size_t i = start; i < end; ++i ) {
+        search( i, result );
+        offsets_[i + 1] = (uint32_t)result.count();
+        for ( size_t j = 0; j < result.count(); ++j ) { nn.push_back( (uint32_t)result.indices( j ) ); }
+        if ( storeDistances ) {
+          auto& dist = blockDistances[block];
+          for ( size_t j = 0; j < result.count(); ++j ) { dist.push_back( result.dist( j ) ); }
+        }
+      }
+    } );
+  } );
+  for ( size_t i = 0; i < pointCount; ++i ) { offsets_[i + 1] += offsets_[i]; }
+  neighbors_.resize( offsets_[pointCount] );
+  distances_.resize( storeDistances ? offsets_[pointCount] : 0 );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), blockCount, [&]( const size_t block ) {
+      const size_t start = offsets_[block * blockSize];
+      std::copy( blockNeighbors[block].begin(), blockNeighbors[block].end(), neighbors_.begin() + start );
+      if ( storeDistances ) {
+        std::copy( blockDistances[block].begin(), blockDistances[block].end(), distances_.begin() + start );
+      }
+    } );
+  } );
+}
@@ -34,6 +34,7 @@
 
 #include "PCCKdTree.h"
 #include "tbb/tbb.h"
+#include "PCCNeighborGraph.h"
 #include "PCCNormalsGenerator.h"
 
 using namespace pcc;
@@ -68,20 +69,19 @@ void PCCNormalsGenerator3::compute( const PCCPointSet3&                   pointC
 }
 void PCCNormalsGenerator3::computeNormal( const size_t                          index,
                                           const PCCPointSet3&                   pointCloud,
-                                          const PCCKdTree&                      kdtree,
-                                          const PCCNormalsGenerator3Parameters& params,
-                                          PCCNNResult&                          nNResult ) {
+                                          const uint32_t*                       neighbors,
+                                          const size_t                          neighborCount,
+                                          const PCCNormalsGenerator3Parameters& params ) {
   PCCVector3D bary( pointCloud[index][0], pointCloud[index][1], pointCloud[index][2] ), normal( 0.0 ), eigenval( 0.0 );
   PCCMatrix3D covMat, Q, D;
-  kdtree.search( pointCloud[index], params.numberOfNearestNeighborsInNormalEstimation_, nNResult );
-  if ( nNResult.count() > 1 ) {
+  if ( neighborCount > 1 ) {
     bary = 0.0;
-    for ( size_t i = 0; i < nNResult.count(); ++i ) { bary += pointCloud[nNResult.indices( i )]; }
-    bary /= double( nNResult.count() );
+    for ( size_t i = 0; i < neighborCount; ++i ) { bary += pointCloud[neighbors[i]]; }
+    bary /= double( neighborCount );
     covMat = 0.0;
     PCCVector3D pt;
-    for ( size_t i = 0; i < nNResult.count(); ++i ) {
-      pt = pointCloud[nNResult.indices( i )] - bary;
+    for ( size_t i = 0; i < neighborCount; ++i ) {
+      pt = pointCloud[neighbors[i]] - bary;
       covMat[0][0] += pt[0] * pt[0];
       covMat[1][1] += pt[1] * pt[1];
       covMat[2][2] += pt[2] * pt[2];
@@ -92,7 +92,7 @@ void PCCNormalsGenerator3::computeNormal( const size_t
     covMat[1][0] = covMat[0][1];
     covMat[2][0] = covMat[0][2];
     covMat[2][1] = covMat[1][2];
-    covMat /= ( nNResult.count() - 1.0 );
+    covMat /= ( neighborCount - 1.0 );
 
     PCCDiagonalize( covMat, Q, D );
 
@@ -146,70 +146,38 @@ void PCCNormalsGenerator3::computeNormal( const size_t
   if ( params.storeEigenvalues_ ) { eigenvalues_[index] = eigenval; }
   if ( params.storeCentroids_ ) { barycenters_[index] = bary; }
   if ( params.storeNumberOfNearestNeighborsInNormalEstimation_ ) {
-    numberOfNearestNeighborsInNormalEstimation_[index] = uint32_t( nNResult.count() );
+    numberOfNearestNeighborsInNormalEstimation_[index] = uint32_t( neighborCount );
   }
 }
 void PCCNormalsGenerator3::computeNormals( const PCCPointSet3&                   pointCloud,
                                            const PCCKdTree&                      kdtree,
                                            const PCCNormalsGenerator3Parameters& params ) {
-  const size_t pointCount = pointCloud.getPointCount();
+  const size_t     pointCount = pointCloud.getPointCount();
+  const size_t     batchSize  = 65536;
+  PCCNNBatchResult nNResult;
   normals_.resize( pointCount );
-  std::vector<size_t> subRanges;
-  const size_t        chunckCount = 64;
-  PCCDivideRange( 0, pointCount, chunckCount, subRanges );
   tbb::task_arena limited( (int)nbThread_ );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), subRanges.size() - 1, [&]( const size_t i ) {
-      const size_t start = subRanges[i];
-      const size_t end   = subRanges[i + 1];
-      PCCNNResult  nNResult;
-      for ( size_t ptIndex = start; ptIndex < end; ++ptIndex ) {
-        computeNormal( ptIndex, pointCloud, kdtree, params, nNResult );
-      }
+  for ( size_t start = 0; start < pointCount; start += batchSize ) {
+    const size_t end = ( std::min )( start + batchSize, pointCount );
+    kdtree.search( pointCloud, start, end, params.numberOfNearestNeighborsInNormalEstimation_, nNResult, nbThread_ );
+    limited.execute( [&] {
+      tbb::parallel_for( start, end, [&]( const size_t ptIndex ) {
+        computeNormal( ptIndex, pointCloud, nNResult.indices( ptIndex - start ), nNResult.count( ptIndex - start ),
+                       params );
+      } );
     } );
-  } );
+  }
 }
 void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&                   pointCloud,
                                           const PCCKdTree&                      kdtree,
                                           const PCCNormalsGenerator3Parameters& params ) {
-  if ( params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE ) {
+  if ( params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE ||
+       params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE_PARALLEL ) {
     const size_t pointCount = pointCloud.getPointCount();
-    PCCNNResult  nNResult;
-    visited_.resize( pointCount );
-    std::fill( visited_.begin(), visited_.end(), 0 );
-    PCCNNQuery3 nNQuery  = {PCCPoint3D( 0.0 ), (float)params.radiusNormalOrientation_ * params.radiusNormalOrientation_,
-                           params.numberOfNearestNeighborsInNormalOrientation_};
-    PCCNNQuery3 nNQuery2 = {PCCPoint3D( 0.0 ), ( std::numeric_limits<float>::max )(),
-                            params.numberOfNearestNeighborsInNormalOrientation_};
-    size_t      processedPointCount = 0;
-    for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
-      if ( !visited_[ptIndex] ) {
-        visited_[ptIndex] = 1;
-        ++processedPointCount;
-        size_t      numberOfNormals;
-        PCCVector3D accumulatedNormals;
-        addNeighbors( uint32_t( ptIndex ), pointCloud, kdtree, nNQuery2, nNResult, accumulatedNormals,
-                      numberOfNormals );
-        if ( !numberOfNormals ) {
-          if ( ptIndex ) {
-            accumulatedNormals = normals_[ptIndex - 1];
-          } else {
-            accumulatedNormals = ( params.viewPoint_ - pointCloud[ptIndex] );
-          }
-        }
-        if ( normals_[ptIndex] * accumulatedNormals < 0.0 ) { normals_[ptIndex] = -normals_[ptIndex]; }
-        while ( !edges_.empty() ) {
-          PCCWeightedEdge edge = edges_.top();
-          edges_.pop();
-          uint32_t current = edge.end_;
-          if ( !visited_[current] ) {
-            visited_[current] = 1;
-            ++processedPointCount;
-            if ( normals_[edge.start_] * normals_[current] < 0.0 ) { normals_[current] = -normals_[current]; }
-            addNeighbors( current, pointCloud, kdtree, nNQuery, nNResult, accumulatedNormals, numberOfNormals );
-          }
-        }
-      }
+    if ( params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE ) {
+      orientNormalsSpanningTree( pointCloud, kdtree, params );
+    } else {
+      orientNormalsSpanningTreeParallel( pointCloud, kdtree, params );
     }
     size_t negNormalCount = 0;
     for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
@@ -230,6 +198,178 @@ void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&
     } );
   }
 }
+void PCCNormalsGenerator3::orientNormalsSpanningTree( const PCCPointSet3&                   pointCloud,
+                                                      const PCCKdTree&                      kdtree,
+                                                      const PCCNormalsGenerator3Parameters& params ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  PCCNNResult  nNResult;
+  visited_.resize( pointCount );
+  std::fill( visited_.begin(), visited_.end(), 0 );
+  PCCNNQuery3 nNQuery  = {PCCPoint3D( 0.0 ), (float)params.radiusNormalOrientation_ * params.radiusNormalOrientation_,
+                         params.numberOfNearestNeighborsInNormalOrientation_};
+  PCCNNQuery3 nNQuery2 = {PCCPoint3D( 0.0 ), ( std::numeric_limits<float>::max )(),
+                          params.numberOfNearestNeighborsInNormalOrientation_};
+  size_t      processedPointCount = 0;
+  for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
+    if ( !visited_[ptIndex] ) {
+      visited_[ptIndex] = 1;
+      ++processedPointCount;
+      size_t      numberOfNormals;
+      PCCVector3D accumulatedNormals;
+      addNeighbors( uint32_t( ptIndex ), pointCloud, kdtree, nNQuery2, nNResult, accumulatedNormals,
+                    numberOfNormals );
+      if ( !numberOfNormals ) {
+        if ( ptIndex ) {
+          accumulatedNormals = normals_[ptIndex - 1];
+        } else {
+          accumulatedNormals = ( params.viewPoint_ - pointCloud[ptIndex] );
+        }
+      }
+      if ( normals_[ptIndex] * accumulatedNormals < 0.0 ) { normals_[ptIndex] = -normals_[ptIndex]; }
+      while ( !edges_.empty() ) {
+        PCCWeightedEdge edge = edges_.top();
+        edges_.pop();
+        uint32_t current = edge.end_;
+        if ( !visited_[current] ) {
+          visited_[current] = 1;
+          ++processedPointCount;
+          if ( normals_[edge.start_] * normals_[current] < 0.0 ) { normals_[current] = -normals_[current]; }
+          addNeighbors( current, pointCloud, kdtree, nNQuery, nNResult, accumulatedNormals, numberOfNormals );
+        }
+      }
+    }
+  }
+}
+void PCCNormalsGenerator3::orientNormalsSpanningTreeParallel( const PCCPointSet3&                   pointCloud,
+                                                              const PCCKdTree&                      kdtree,
+                                                              const PCCNormalsGenerator3Parameters& params ) {
+  // Same result as orientNormalsSpanningTree(). The trees grown from successive roots never share points and
+  // a tree only reaches points of later trees through its own edges, so the points are first split into the
+  // trees of the serial traversal, then the trees are grown concurrently with signs relative to their root,
+  // and the roots, which depend on the normals of earlier trees, are oriented last in serial order.
+  const size_t pointCount = pointCloud.getPointCount();
+  PCCNNQuery3  nNQuery  = {PCCPoint3D( 0.0 ), (float)params.radiusNormalOrientation_ * params.radiusNormalOrientation_,
+                          params.numberOfNearestNeighborsInNormalOrientation_};
+  PCCNNQuery3  nNQuery2 = {PCCPoint3D( 0.0 ), ( std::numeric_limits<float>::max )(),
+                          params.numberOfNearestNeighborsInNormalOrientation_};
+  auto search = [&]( const PCCNNQuery3& query, const size_t index, PCCNNResult& result ) {
+    if ( query.radius > 32768.0 ) {
+      kdtree.search( pointCloud[index], query.nearestNeighborCount, result );
+    } else {
+      kdtree.searchRadius( pointCloud[index], query.nearestNeighborCount, query.radius, result );
+    }
+  };
+  PCCNeighborGraph graph;
+  graph.build( pointCount, false, nbThread_,
+               [&]( const size_t i, PCCNNResult& result ) { search( nNQuery, i, result ); } );
+
+  // Split the points into trees; roots use the unbounded query, as in the serial traversal.
+  const uint32_t        noTree = ( std::numeric_limits<uint32_t>::max )();
+  std::vector<uint32_t> tree( pointCount, noTree );
+  std::vector<uint32_t> roots;
+  std::vector<uint32_t> rootNeighbors;
+  std::vector<uint32_t> rootNeighborOffsets( 1, 0 );
+  std::vector<uint32_t> stack;
+  PCCNNResult           nNResult;
+  for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
+    if ( tree[ptIndex] != noTree ) { continue; }
+    const uint32_t treeIndex = (uint32_t)roots.size();
+    roots.push_back( (uint32_t)ptIndex );
+    tree[ptIndex] = treeIndex;
+    search( nNQuery2, ptIndex, nNResult );
+    for ( size_t i = 0; i < nNResult.count(); ++i ) {
+      const uint32_t index = (uint32_t)nNResult.indices( i );
+      rootNeighbors.push_back( index );
+      if ( tree[index] == noTree ) {
+        tree[index] = treeIndex;
+        stack.push_back( index );
+      }
+    }
+    rootNeighborOffsets.push_back( (uint32_t)rootNeighbors.size() );
+    while ( !stack.empty() ) {
+      const uint32_t current = stack.back();
+      stack.pop_back();
+      for ( const auto index : graph[current] ) {
+        if ( tree[index] == noTree ) {
+          tree[index] = treeIndex;
+          stack.push_back( index );
+        }
+      }
+    }
+  }
+
+  // Grow each tree. A point whose normal is orthogonal to its parent's one is never flipped, whatever the sign
+  // of the root, so the signs below it are absolute rather than relative to the root.
+  const size_t         treeCount = roots.size();
+  std::vector<uint8_t> visited( pointCount, 0 );
+  std::vector<int8_t>  signs( pointCount, 1 );
+  std::vector<uint8_t> absolute( pointCount, 0 );
+  tbb::task_arena      limited( (int)nbThread_ );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), treeCount, [&]( const size_t treeIndex ) {
+      std::priority_queue<PCCWeightedEdge> edges;
+      auto addEdges = [&]( const uint32_t current, const uint32_t* begin, const uint32_t* end ) {
+        PCCWeightedEdge newEdge;
+        for ( auto it = begin; it != end; ++it ) {
+          if ( tree[*it] == treeIndex && !visited[*it] ) {
+            newEdge.weight_ = fabs( normals_[current] * normals_[*it] );
+            newEdge.end_    = *it;
+            newEdge.start_  = current;
+            edges.push( newEdge );
+          }
+        }
+      };
+      const uint32_t root = roots[treeIndex];
+      visited[root]       = 1;
+      addEdges( root, rootNeighbors.data() + rootNeighborOffsets[treeIndex],
+                rootNeighbors.data() + rootNeighborOffsets[treeIndex + 1] );
+      while ( !edges.empty() ) {
+        const PCCWeightedEdge edge = edges.top();
+        edges.pop();
+        const uint32_t current = edge.end_;
+        if ( !visited[current] ) {
+          const double dot     = normals_[edge.start_] * normals_[current];
+          const auto   neighbors = graph[current];
+          visited[current]       = 1;
+          absolute[current]      = dot == 0.0 ? 1 : absolute[edge.start_];
+          signs[current]         = signs[edge.start_] * dot < 0.0 ? -1 : 1;
+          addEdges( current, neighbors.begin(), neighbors.end() );
+        }
+      }
+    } );
+  } );
+
+  // Orient the roots in serial order from the final normals of the earlier trees.
+  std::vector<int8_t> rootSigns( treeCount, 1 );
+  auto getSign = [&]( const uint32_t index ) -> int {
+    return absolute[index] ? signs[index] : rootSigns[tree[index]] * signs[index];
+  };
+  auto getNormal = [&]( const uint32_t index ) { return getSign( index ) < 0 ? -normals_[index] : normals_[index]; };
+  for ( size_t treeIndex = 0; treeIndex < treeCount; ++treeIndex ) {
+    const uint32_t root               = roots[treeIndex];
+    size_t         numberOfNormals    = 0;
+    PCCVector3D    accumulatedNormals = 0.0;
+    for ( size_t i = rootNeighborOffsets[treeIndex]; i < rootNeighborOffsets[treeIndex + 1]; ++i ) {
+      if ( tree[rootNeighbors[i]] < treeIndex ) {
+        accumulatedNormals += getNormal( rootNeighbors[i] );
+        ++numberOfNormals;
+      }
+    }
+    if ( !numberOfNormals ) {
+      if ( root ) {
+        accumulatedNormals = getNormal( root - 1 );
+      } else {
+        accumulatedNormals = ( params.viewPoint_ - pointCloud[root] );
+      }
+    }
+    if ( normals_[root] * accumulatedNormals < 0.0 ) { rootSigns[treeIndex] = -1; }
+  }
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t ptIndex ) {
+      if ( getSign( (uint32_t)ptIndex ) < 0 ) { normals_[ptIndex] = -normals_[ptIndex]; }
+    } );
+  } );
+}
 void PCCNormalsGenerator3::addNeighbors( const uint32_t      current,
                                          const PCCPointSet3& pointCloud,
                                          const PCCKdTree&    kdtree,
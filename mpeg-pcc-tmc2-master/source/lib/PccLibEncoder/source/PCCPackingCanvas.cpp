@@ -0,0 +1,165 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCPatch.h"
+#include "PCCPackingCanvas.h"
+
+using namespace pcc;
+
+static bool isFootprintSwitched( size_t orientation ) {
+  return !( orientation == PATCH_ORIENTATION_DEFAULT || orientation == PATCH_ORIENTATION_ROT180 ||
+            orientation == PATCH_ORIENTATION_MIRROR || orientation == PATCH_ORIENTATION_MROT180 );
+}
+
+PCCPackingCanvas::PCCPackingCanvas( size_t sizeU, size_t sizeV ) :
+    sizeU_( 0 ),
+    sizeV_( 0 ),
+    wordsPerRow_( 0 ),
+    maskSizeU0_( 0 ),
+    maskSizeV0_( 0 ),
+    maskSafeguard_( 0 ),
+    masks_( PATCH_ORIENTATION_MROT270 + 1 ) {
+  resize( sizeU, sizeV );
+}
+
+void PCCPackingCanvas::resize( size_t sizeU, size_t sizeV ) {
+  const size_t wordsPerRow = ( sizeU + 63 ) / 64;
+  if ( wordsPerRow == wordsPerRow_ ) {
+    rows_.resize( wordsPerRow * sizeV, 0 );
+  } else {
+    std::vector<uint64_t> rows( wordsPerRow * sizeV, 0 );
+    for ( size_t v = 0; v < ( std::min )( sizeV, sizeV_ ); v++ ) {
+      for ( size_t u = 0; u < ( std::min )( sizeU, sizeU_ ); u++ ) {
+        if ( get( u, v ) ) { rows[v * wordsPerRow + ( u >> 6 )] |= uint64_t( 1 ) << ( u & 63 ); }
+      }
+    }
+    std::swap( rows, rows_ );
+  }
+  sizeU_       = sizeU;
+  sizeV_       = sizeV;
+  wordsPerRow_ = wordsPerRow;
+}
+
+// bits [u, u + count) of row v, count <= 64, bit i of the result being the block u + i
+uint64_t PCCPackingCanvas::getBits( size_t v, size_t u, size_t count ) const {
+  const uint64_t* row   = rows_.data() + v * wordsPerRow_;
+  const size_t    word  = u >> 6;
+  const size_t    shift = u & 63;
+  uint64_t        bits  = row[word] >> shift;
+  if ( shift != 0 && word + 1 < wordsPerRow_ ) { bits |= row[word + 1] << ( 64 - shift ); }
+  return count < 64 ? bits & ( ( uint64_t( 1 ) << count ) - 1 ) : bits;
+}
+
+void PCCPackingCanvas::buildMask( const PCCPatch& patch, int safeguard, size_t maskSizeU, size_t maskSizeV ) {
+  const size_t wordsPerRow = ( maskSizeU + 63 ) / 64;
+  auto&        mask        = masks_[patch.getPatchOrientation()];
+  mask.assign( wordsPerRow * maskSizeV, 0 );
+  const auto&  occupancy = patch.getOccupancy();
+  const size_t x0        = patch.getU0();
+  const size_t y0        = patch.getV0();
+  for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
+    for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
+      if ( !occupancy[u0 + patch.getSizeU0() * v0] ) { continue; }
+      // the patch lies in the canvas here, so the canvas position is relative to its origin
+      const size_t pos = (size_t)patch.patchBlock2CanvasBlock( u0, v0, sizeU_, sizeV_ );
+      const size_t x   = pos % sizeU_ - x0;
+      const size_t y   = pos / sizeU_ - y0;
+      for ( size_t dy = 0; dy <= 2 * (size_t)safeguard; dy++ ) {
+        for ( size_t dx = 0; dx <= 2 * (size_t)safeguard; dx++ ) {
+          const size_t u = x + dx;
+          mask[( y + dy ) * wordsPerRow + ( u >> 6 )] |= uint64_t( 1 ) << ( u & 63 );
+        }
+      }
+    }
+  }
+}
+
+bool PCCPackingCanvas::checkFit( const PCCPatch& patch, bool bPrecedence, int safeguard, const Tile& tile ) {
+  return nextFit( patch, bPrecedence, safeguard, tile ) == patch.getU0();
+}
+
+size_t PCCPackingCanvas::nextFit( const PCCPatch& patch, bool bPrecedence, int safeguard, const Tile& tile ) {
+  const size_t u0 = patch.getU0();
+  if ( patch.getSizeU0() == 0 || patch.getSizeV0() == 0 ) { return u0; }
+  const bool    switched = isFootprintSwitched( patch.getPatchOrientation() );
+  const int64_t s        = safeguard;
+  const int64_t x0       = (int64_t)u0 - s;
+  const int64_t y0       = (int64_t)patch.getV0() - s;
+  const int64_t w        = (int64_t)( switched ? patch.getSizeV0() : patch.getSizeU0() ) + 2 * s;
+  const int64_t h        = (int64_t)( switched ? patch.getSizeU0() : patch.getSizeV0() ) + 2 * s;
+  int64_t       minU = 0, minV = 0, maxU = (int64_t)sizeU_ - 1, maxV = (int64_t)sizeV_ - 1;
+  if ( tile.minU != -1 ) {
+    minU = ( std::max )( minU, (int64_t)tile.minU );
+    minV = ( std::max )( minV, (int64_t)tile.minV );
+    maxU = ( std::min )( maxU, (int64_t)tile.maxU );
+    maxV = ( std::min )( maxV, (int64_t)tile.maxV );
+  }
+  const size_t none = ( std::max )( sizeU_, u0 ) + 1;
+  if ( y0 < minV || y0 + h - 1 > maxV || x0 + w - 1 > maxU ) { return none; }
+  if ( x0 < minU ) { return (size_t)( minU + s ); }
+  if ( bPrecedence ) {
+    if ( maskSizeU0_ != patch.getSizeU0() || maskSizeV0_ != patch.getSizeV0() || maskSafeguard_ != safeguard ||
+         maskOccupancy_ != patch.getOccupancy() ) {
+      for ( auto& mask : masks_ ) { mask.clear(); }
+      maskSizeU0_    = patch.getSizeU0();
+      maskSizeV0_    = patch.getSizeV0();
+      maskSafeguard_ = safeguard;
+      maskOccupancy_ = patch.getOccupancy();
+    }
+    if ( masks_[patch.getPatchOrientation()].empty() ) { buildMask( patch, safeguard, (size_t)w, (size_t)h ); }
+    const int64_t wordsPerRow = ( w + 63 ) / 64;
+    for ( int64_t dy = 0; dy < h; dy++ ) {
+      const uint64_t* mask = masks_[patch.getPatchOrientation()].data() + dy * wordsPerRow;
+      for ( int64_t k = 0; k < wordsPerRow; k++ ) {
+        const size_t count = (size_t)( std::min )( (int64_t)64, w - 64 * k );
+        if ( mask[k] & getBits( (size_t)( y0 + dy ), (size_t)( x0 + 64 * k ), count ) ) { return u0 + 1; }
+      }
+    }
+    return u0;
+  }
+  // the whole dilated footprint must be free: the next candidate starts after the right-most occupied block
+  int64_t lastOccupied = -1;
+  for ( int64_t dy = 0; dy < h; dy++ ) {
+    for ( int64_t k = ( w - 1 ) / 64; k >= 0; k-- ) {
+      const size_t count = (size_t)( std::min )( (int64_t)64, w - 64 * k );
+      uint64_t     bits  = getBits( (size_t)( y0 + dy ), (size_t)( x0 + 64 * k ), count );
+      if ( bits ) {
+        int64_t bit = 63;
+        while ( !( ( bits >> bit ) & 1 ) ) { bit--; }
+        lastOccupied = ( std::max )( lastOccupied, x0 + 64 * k + bit );
+        break;
+      }
+    }
+  }
+  return lastOccupied < 0 ? u0 : (size_t)( lastOccupied + s + 1 );
+}
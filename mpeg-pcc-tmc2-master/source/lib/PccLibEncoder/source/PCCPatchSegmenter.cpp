@@ -41,10 +41,7 @@
 
 using namespace pcc;
 
-void PCCPatchSegmenter3::setNbThread( size_t nbThread ) {
-  nbThread_ = nbThread;
-  if ( nbThread_ > 0 ) { tbb::task_scheduler_init init( (int)nbThread ); }
-}
+void PCCPatchSegmenter3::setNbThread( size_t nbThread ) { nbThread_ = nbThread; }
 
 void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
                                   const size_t                        frameIndex,
@@ -84,7 +81,7 @@ void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
                                                            params.nnNormalEstimation_,
                                                            params.nnNormalEstimation_,
                                                            0,
-                                                           PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE,
+                                                           PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE_PARALLEL,
                                                            false,
                                                            false,
                                                            false};
@@ -167,65 +164,31 @@ void PCCPatchSegmenter3::initialSegmentation( const PCCPointSet3&         geomet
   } );
 }
 
-void PCCPatchSegmenter3::computeAdjacencyInfo( const PCCPointSet3&               pointCloud,
-                                               const PCCKdTree&                  kdtree,
-                                               std::vector<std::vector<size_t>>& adj,
-                                               const size_t                      maxNNCount ) {
-  const size_t pointCount = pointCloud.getPointCount();
-  adj.resize( pointCount );
-  tbb::task_arena limited( (int)nbThread_ );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      PCCNNResult result;
-      kdtree.search( pointCloud[i], maxNNCount, result );
-      std::vector<size_t>& neighbors = adj[i];
-      neighbors.resize( result.count() );
-      for ( size_t j = 0; j < result.count(); ++j ) { neighbors[j] = result.indices( j ); }
-    } );
+void PCCPatchSegmenter3::computeAdjacencyInfo( const PCCPointSet3& pointCloud,
+                                               const PCCKdTree&    kdtree,
+                                               PCCNeighborGraph&   adj,
+                                               const size_t        maxNNCount ) {
+  adj.build( pointCloud.getPointCount(), false, nbThread_, [&]( const size_t i, PCCNNResult& result ) {
+    kdtree.search( pointCloud[i], maxNNCount, result );
   } );
 }
 
-void PCCPatchSegmenter3::computeAdjacencyInfoInRadius( const PCCPointSet3&               pointCloud,
-                                                       const PCCKdTree&                  kdtree,
-                                                       std::vector<std::vector<size_t>>& adj,
-                                                       const size_t                      maxNNCount,
-                                                       const size_t                      radius ) {
-  const size_t pointCount = pointCloud.getPointCount();
-  adj.resize( pointCount );
-  tbb::task_arena limited( (int)nbThread_ );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      PCCNNResult result;
-      kdtree.searchRadius( pointCloud[i], maxNNCount, radius, result );
-      std::vector<size_t>& neighbors = adj[i];
-      neighbors.resize( result.count() );
-      for ( size_t j = 0; j < result.count(); ++j ) { neighbors[j] = result.indices( j ); }
-    } );
+void PCCPatchSegmenter3::computeAdjacencyInfoInRadius( const PCCPointSet3& pointCloud,
+                                                       const PCCKdTree&    kdtree,
+                                                       PCCNeighborGraph&   adj,
+                                                       const size_t        maxNNCount,
+                                                       const size_t        radius ) {
+  adj.build( pointCloud.getPointCount(), false, nbThread_, [&]( const size_t i, PCCNNResult& result ) {
+    kdtree.searchRadius( pointCloud[i], maxNNCount, radius, result );
   } );
 }
 
-void PCCPatchSegmenter3::computeAdjacencyInfoDist( const PCCPointSet3&               pointCloud,
-                                                   const PCCKdTree&                  kdtree,
-                                                   std::vector<std::vector<size_t>>& adj,
-                                                   std::vector<std::vector<double>>& adjDist,
-                                                   const size_t                      maxNNCount ) {
-  const size_t pointCount = pointCloud.getPointCount();
-  adj.resize( pointCount );
-  adjDist.resize( pointCount );
-  tbb::task_arena limited( (int)nbThread_ );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      PCCNNResult result;
-      kdtree.search( pointCloud[i], maxNNCount, result );
-      std::vector<size_t>& neighbors     = adj[i];
-      std::vector<double>& neighborsDist = adjDist[i];
-      neighbors.resize( result.count() );
-      neighborsDist.resize( result.count() );
-      for ( size_t j = 0; j < result.count(); ++j ) {
-        neighbors[j]     = result.indices( j );
-        neighborsDist[j] = result.dist( j );
-      }
-    } );
+void PCCPatchSegmenter3::computeAdjacencyInfoDist( const PCCPointSet3& pointCloud,
+                                                   const PCCKdTree&    kdtree,
+                                                   PCCNeighborGraph&   adj,
+                                                   const size_t        maxNNCount ) {
+  adj.build( pointCloud.getPointCount(), true, nbThread_, [&]( const size_t i, PCCNNResult& result ) {
+    kdtree.search( pointCloud[i], maxNNCount, result );
   } );
 }
 
@@ -302,19 +265,18 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
   size_t numEDDonlyPoints = 0;
   // size_t numRawPoints=0;
   std::cout << "\n\t Computing adjacency info... ";
-  std::vector<std::vector<size_t>>              adj;
-  std::vector<std::vector<double>>              adjDist;
-  std::vector<bool>                             flagExp;
-  int                                           numROIs;
-  int                                           numChunks;
-  std::vector<PCCPointSet3>                     pointsChunks;
-  std::vector<std::vector<size_t>>              pointsIndexChunks;
-  std::vector<size_t>                           pointCountChunks;
-  std::vector<PCCKdTree>                        kdtreeChunks;
-  std::vector<PCCBox3D>                         boundingBoxChunks;
-  std::vector<std::vector<std::vector<size_t>>> adjChunks;
+  PCCNeighborGraph                 adj;
+  std::vector<bool>                flagExp;
+  int                              numROIs;
+  int                              numChunks;
+  std::vector<PCCPointSet3>        pointsChunks;
+  std::vector<std::vector<size_t>> pointsIndexChunks;
+  std::vector<size_t>              pointCountChunks;
+  std::vector<PCCKdTree>           kdtreeChunks;
+  std::vector<PCCBox3D>            boundingBoxChunks;
+  std::vector<PCCNeighborGraph>    adjChunks;
   if ( patchExpansionEnabled ) {
-    computeAdjacencyInfoDist( points, kdtree, adj, adjDist, maxNNCount );
+    computeAdjacencyInfoDist( points, kdtree, adj, maxNNCount );
     flagExp.resize( pointCount, false );
   } else {
     if ( !enablePointCloudPartitioning ) {
@@ -737,8 +699,8 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
             if ( ( clusterIndex == partition[n] ) ||  // same plane
                  ( clusterIndex + 3 == partition[n] ) || ( clusterIndex == partition[n] + 3 ) )
               continue;
-            const double dist2 = adjDist[i][ac];  // sum of square
-            if ( dist2 <= 2 ) {                   // <-- expansion distance
+            const double dist2 = adj.getDistance( i, ac );  // sum of square
+            if ( dist2 <= 2 ) {                             // <-- expansion distance
               fifoa.push_back( n );
               flagExp[n] = true;  // add point
             }
@@ -1615,9 +1577,9 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
           }
         }
         for ( const auto& p : rec.getPositions() ) { testRec.addPoint( p ); }
-        testSrc.transferColorSimple( testRec );
+        testSrc.transferColorSimple( testRec, 0.1, nbThread_ );
         float distPAB, distPBA, distYAB, distYBA, distUAB, distUBA, distVAB, distVBA;
-        testRec.removeDuplicate();
+        testRec.removeDuplicate( nbThread_ );
         testSrc.distanceGeoColor( testRec, distPAB, distPBA, distYAB, distYBA, distUAB, distUBA, distVAB, distVBA );
         meanPAB += distPAB * testSrc.getPointCount();
         meanPBA += distPBA * testRec.getPointCount();
@@ -1664,11 +1626,12 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
                 << patch.getSizeV() << " ),Normal: " << size_t( patch.getNormalAxis() )
                 << " Direction: " << patch.getProjectionMode() << " Edd: " << patch.getEddCount() << std::endl;
     }
-    PCCKdTree kdtreeResampled( resampled );
+    PCCKdTree        kdtreeResampled( resampled );
+    PCCNNBatchResult nearest;
+    kdtreeResampled.search( points, 0, pointCount, 1, nearest, nbThread_ );
     missedPoints.resize( 0 );
     for ( size_t i = 0; i < pointCount; ++i ) {
-      kdtreeResampled.search( points[i], 1, result );
-      const double dist2      = result.dist( 0 );
+      const double dist2      = nearest.count( i ) ? nearest.dist( i )[0] : ( std::numeric_limits<double>::max )();
       missedPointsDistance[i] = dist2;
       if ( dist2 > maxAllowedDist2MissedPointsSelection ) { missedPoints.push_back( i ); }
     }
@@ -1712,19 +1675,19 @@ void PCCPatchSegmenter3::refineSegmentation( const PCCPointSet3&         pointCl
                                              const size_t                iterationCount,
                                              std::vector<size_t>&        partition ) {
   assert( orientations );
-  std::vector<std::vector<size_t>> adj;
+  PCCNeighborGraph adj;
   computeAdjacencyInfo( pointCloud, kdtree, adj, maxNNCount );
-  const size_t                     pointCount = pointCloud.getPointCount();
-  const double                     weight     = lambda / maxNNCount;
-  std::vector<size_t>              tempPartition( pointCount );
-  std::vector<std::vector<size_t>> scoresSmooth( pointCount, std::vector<size_t>( orientationCount ) );
+  const size_t          pointCount = pointCloud.getPointCount();
+  const double          weight     = lambda / maxNNCount;
+  std::vector<size_t>   tempPartition( pointCount );
+  std::vector<uint32_t> scoresSmooth( pointCount * orientationCount );
   for ( size_t k = 0; k < iterationCount; ++k ) {
     tbb::task_arena limited( (int)nbThread_ );
     limited.execute( [&] {
       tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-        auto& scoreSmooth = scoresSmooth[i];
-        std::fill( scoreSmooth.begin(), scoreSmooth.end(), 0 );
-        for ( auto& neighbor : adj[i] ) { scoreSmooth[partition[neighbor]]++; }
+        uint32_t* scoreSmooth = scoresSmooth.data() + i * orientationCount;
+        std::fill( scoreSmooth, scoreSmooth + orientationCount, 0 );
+        for ( const auto neighbor : adj[i] ) { scoreSmooth[partition[neighbor]]++; }
       } );
     } );
     limited.execute( [&] {
@@ -1732,7 +1695,7 @@ void PCCPatchSegmenter3::refineSegmentation( const PCCPointSet3&         pointCl
         const PCCVector3D normal       = normalsGen.getNormal( i );
         size_t            clusterIndex = partition[i];
         double            bestScore    = 0.0;
-        const auto&       scoreSmooth  = scoresSmooth[i];
+        const uint32_t*   scoreSmooth  = scoresSmooth.data() + i * orientationCount;
         for ( size_t j = 0; j < orientationCount; ++j ) {
           const double scoreNormal = normal * orientations[j];
           const double score       = scoreNormal + weight * scoreSmooth[j];
@@ -1746,8 +1709,6 @@ void PCCPatchSegmenter3::refineSegmentation( const PCCPointSet3&         pointCl
     } );
     swap( tempPartition, partition );
   }
-  for ( auto& vector : scoresSmooth ) { vector.clear(); }
-  scoresSmooth.clear();
 }
 
 void PCCPatchSegmenter3::refineSegmentationGridBased( const PCCPointSet3&         pointCloud,
@@ -1779,84 +1740,108 @@ void PCCPatchSegmenter3::refineSegmentationGridBased( const PCCPointSet3&
     ;
   const size_t gridDimShiftSqr = gridDimShift << 1;
   const size_t voxDimHalf      = voxDim >> 1;
-
-  struct voxelType {
-    std::vector<size_t> pointIndices;
-    std::vector<size_t> scoreSmooth;
-
-    size_t pointCount;
-    void   init( size_t cap, size_t orientationCount ) {
-      pointIndices.reserve( cap );
-      scoreSmooth.resize( orientationCount, 0 );
-      pointCount = 0;
-    }
-  };
   auto subToInd = [&]( size_t x, size_t y, size_t z ) { return x + ( y << gridDimShift ) + ( z << gridDimShiftSqr ); };
 
-  PCCPointSet3                          gridCenters;
-  std::unordered_map<size_t, voxelType> grid;
+  // Voxels are numbered densely in order of first occurrence, which is also the order of gridCenters;
+  // the hash map is only used here, every later access goes through the voxel number.
+  PCCPointSet3                         gridCenters;
+  PCCPointSetBuilder                   gridCentersBuilder( gridCenters, pointCount );
+  std::unordered_map<size_t, uint32_t> voxelIndices;
+  std::vector<uint32_t>                pointVoxels( pointCount );
+  std::vector<uint32_t>                voxelPointOffsets( 1, 0 );
+  voxelIndices.reserve( pointCount );
   for ( size_t i = 0; i < pointCount; i++ ) {
-    const auto&  pos = pointCloud[i];
-    const size_t x0  = ( ( (size_t)pos[0] + voxDimHalf ) >> voxDimShift );
-    const size_t y0  = ( ( (size_t)pos[1] + voxDimHalf ) >> voxDimShift );
-    const size_t z0  = ( ( (size_t)pos[2] + voxDimHalf ) >> voxDimShift );
-    size_t       p   = subToInd( x0, y0, z0 );
-    if ( !grid.count( p ) ) {
-      grid[p].init( 64, orientationCount );
-      gridCenters.addPoint( PCCVector3D( x0, y0, z0 ) );
+    const auto&  pos    = pointCloud[i];
+    const size_t x0     = ( ( (size_t)pos[0] + voxDimHalf ) >> voxDimShift );
+    const size_t y0     = ( ( (size_t)pos[1] + voxDimHalf ) >> voxDimShift );
+    const size_t z0     = ( ( (size_t)pos[2] + voxDimHalf ) >> voxDimShift );
+    const auto   insert = voxelIndices.emplace( subToInd( x0, y0, z0 ), (uint32_t)gridCentersBuilder.getPointCount() );
+    if ( insert.second ) {
+      gridCentersBuilder.addPoint( PCCVector3D( x0, y0, z0 ) );
+      voxelPointOffsets.push_back( 0 );
     }
-    auto& voxel = grid[p];
-    voxel.pointIndices.push_back( i );
-    voxel.pointCount++;
+    pointVoxels[i] = insert.first->second;
+    voxelPointOffsets[pointVoxels[i] + 1]++;
+  }
+  voxelIndices.clear();
+  gridCentersBuilder.commit();
+
+  // Points of each voxel in compressed sparse row layout, kept in increasing point order.
+  const size_t voxelCount = gridCenters.getPointCount();
+  for ( size_t v = 0; v < voxelCount; v++ ) { voxelPointOffsets[v + 1] += voxelPointOffsets[v]; }
+  std::vector<uint32_t> voxelPoints( pointCount );
+  {
+    std::vector<uint32_t> position( voxelPointOffsets.begin(), voxelPointOffsets.end() - 1 );
+    for ( size_t i = 0; i < pointCount; i++ ) { voxelPoints[position[pointVoxels[i]]++] = (uint32_t)i; }
   }
 
-  PCCKdTree                        kdtree( gridCenters );
-  const size_t                     voxSearchRadius  = searchRadius >> voxDimShift;
-  const size_t                     maxNeighborCount = ( std::numeric_limits<int16_t>::max )();
-  std::vector<std::vector<size_t>> adj( gridCenters.getPointCount() );
+  PCCKdTree        kdtree( gridCenters );
+  const size_t     voxSearchRadius  = searchRadius >> voxDimShift;
+  const size_t     maxNeighborCount = ( std::numeric_limits<int16_t>::max )();
+  PCCNeighborGraph adj;
   computeAdjacencyInfoInRadius( gridCenters, kdtree, adj, maxNeighborCount, voxSearchRadius );
 
-  std::vector<size_t> tmpPartition( pointCount );
-  for ( size_t n = 0; n < iterationCount; n++ ) {
-    for ( auto& gridElm : grid ) {
-      auto& voxel = gridElm.second;
-      std::fill( voxel.scoreSmooth.begin(), voxel.scoreSmooth.end(), 0 );
-      for ( auto& j : voxel.pointIndices ) { voxel.scoreSmooth[partition[j]]++; }
-    }
-    /*tbb::task_arena limited((int)nbThread_);
-    limited.execute([&] {
-      tbb::parallel_for(size_t(0), gridCenters.getPointCount(), [&](const size_t i) {*/
-    for ( size_t i = 0; i < gridCenters.getPointCount(); i++ ) {
-      auto&               pos = gridCenters[i];
-      size_t              p   = subToInd( pos[0], pos[1], pos[2] );
-      std::vector<size_t> scoreSmooth( orientationCount, 0 );
-      size_t              nnPointCount = 0;
-      for ( auto& j : adj[i] ) {
-        auto&  pos = gridCenters[j];
-        size_t q   = subToInd( pos[0], pos[1], pos[2] );
-        /*std::transform(scoreSmooth.begin(), scoreSmooth.end(), grid[q].scoreSmooth.begin(),
-          scoreSmooth.begin(), std::plus<size_t>());*/
-        for ( size_t k = 0; k < orientationCount; k++ ) { scoreSmooth[k] += grid[q].scoreSmooth[k]; }
-        nnPointCount += grid[q].pointCount;
+  // The neighbourhood of a voxel is cut once maxNNCount points are reached; voxel occupancy does not change
+  // between iterations, so the number of neighbour voxels used and the smoothing weight are computed once.
+  std::vector<uint32_t> voxelNeighborCounts( voxelCount );
+  std::vector<double>   voxelWeights( voxelCount );
+  tbb::task_arena       limited( (int)nbThread_ );
+  limited.execute( [&] {
+    tbb::parallel_for( size_t( 0 ), voxelCount, [&]( const size_t v ) {
+      const auto neighbors    = adj[v];
+      size_t     nnPointCount = 0;
+      size_t     count        = 0;
+      for ( const auto j : neighbors ) {
+        count++;
+        nnPointCount += voxelPointOffsets[j + 1] - voxelPointOffsets[j];
         if ( nnPointCount >= maxNNCount ) break;
       }
-      const double weight = lambda / nnPointCount;
-      for ( auto& j : grid[p].pointIndices ) {
-        const PCCVector3D normal       = normalsGen.getNormal( j );
-        size_t            clusterIndex = partition[j];
-        double            bestScore    = 0.0;
-        for ( size_t k = 0; k < orientationCount; k++ ) {
-          const double scoreNormal = normal * orientations[k];
-          const double score       = scoreNormal + weight * scoreSmooth[k];
-          if ( score > bestScore ) {
-            bestScore    = score;
-            clusterIndex = k;
+      voxelNeighborCounts[v] = (uint32_t)count;
+      voxelWeights[v]        = lambda / nnPointCount;
+    } );
+  } );
+
+  std::vector<uint32_t> voxelScores( voxelCount * orientationCount );
+  std::vector<size_t>   tmpPartition( pointCount );
+  for ( size_t n = 0; n < iterationCount; n++ ) {
+    limited.execute( [&] {
+      tbb::parallel_for( size_t( 0 ), voxelCount, [&]( const size_t v ) {
+        uint32_t* scoreSmooth = voxelScores.data() + v * orientationCount;
+        std::fill( scoreSmooth, scoreSmooth + orientationCount, 0 );
+        for ( size_t p = voxelPointOffsets[v]; p < voxelPointOffsets[v + 1]; p++ ) {
+          scoreSmooth[partition[voxelPoints[p]]]++;
+        }
+      } );
+    } );
+    limited.execute( [&] {
+      tbb::parallel_for( tbb::blocked_range<size_t>( 0, voxelCount ), [&]( const tbb::blocked_range<size_t>& range ) {
+        std::vector<size_t> scoreSmooth( orientationCount );
+        for ( size_t v = range.begin(); v < range.end(); v++ ) {
+          const auto neighbors = adj[v];
+          std::fill( scoreSmooth.begin(), scoreSmooth.end(), 0 );
+          for ( size_t m = 0; m < voxelNeighborCounts[v]; m++ ) {
+            const uint32_t* neighborScore = voxelScores.data() + neighbors[m] * orientationCount;
+            for ( size_t k = 0; k < orientationCount; k++ ) { scoreSmooth[k] += neighborScore[k]; }
+          }
+          const double weight = voxelWeights[v];
+          for ( size_t p = voxelPointOffsets[v]; p < voxelPointOffsets[v + 1]; p++ ) {
+            const size_t      j            = voxelPoints[p];
+            const PCCVector3D normal       = normalsGen.getNormal( j );
+            size_t            clusterIndex = partition[j];
+            double            bestScore    = 0.0;
+            for ( size_t k = 0; k < orientationCount; k++ ) {
+              const double scoreNormal = normal * orientations[k];
+              const double score       = scoreNormal + weight * scoreSmooth[k];
+              if ( score > bestScore ) {
+                bestScore    = score;
+                clusterIndex = k;
+              }
+            }
+            tmpPartition[j] = clusterIndex;
           }
         }
-        tmpPartition[j] = clusterIndex;
-      }
-    } /*);
-   });*/
+      } );
+    } );
     swap( tmpPartition, partition );
   }
 }
@@ -1881,7 +1866,7 @@ void PCCPatchSegmenter3::separateHighGradientPoints( const PCCPointSet3&
                                                      const double                      minGradient,
                                                      const size_t                      minNumHighGradientPoints,
                                                      std::vector<size_t>&              partition,
-                                                     std::vector<std::vector<size_t>>& adj,
+                                                     const PCCNeighborGraph&           adj,
                                                      std::vector<std::vector<size_t>>& connectedComponents ) {
   // detect and remove high gradient points
   std::vector<std::vector<size_t>> highGradientConnectedComponents;
@@ -2162,7 +2147,7 @@ void PCCPatchSegmenter3::calculateGradient( const PCCPointSet3&               po
                                             const double                      minGradient,
                                             const size_t                      minNumHighGradientPoints,
                                             PCCPatch&                         patch,
-                                            std::vector<std::vector<size_t>>& adj,
+                                            const PCCNeighborGraph&           adj,
                                             std::vector<std::vector<size_t>>& highGradientConnectedComponents,
                                             std::vector<bool>&                isRemoved ) {
   /* for the case that the xyz components of a normal are the same:
@@ -36,6 +36,6 @@
 
 using namespace pcc;
 
-PCCVideoEncoder::PCCVideoEncoder() {}
+PCCVideoEncoder::PCCVideoEncoder() : backend_( PCCVideoCodecBackend::create( VIDEO_CODEC_BACKEND_EXTERNAL ) ) {}
 
 PCCVideoEncoder::~PCCVideoEncoder() {}
@@ -59,6 +59,7 @@ class PCCMetricsParameters {
   std::string         normalDataPath_;
 
   size_t              nbThread_;
+  bool                pinThreads_;
 
   float               resolution_;        //! intrinsic resolution, imported. for geometric distortion
   int                 dropDuplicates_;    //! 0(detect) 1(drop) 2(average) subsequent points with same geo coordinates
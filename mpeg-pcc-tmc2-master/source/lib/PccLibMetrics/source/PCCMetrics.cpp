@@ -55,8 +55,7 @@ void convertRGBtoYUV(const PCCColor3B  &rgb, std::vector<float>& yuv ) {
   yuv[2] = float( ( 0.615 * rgb[0] - 0.515 * rgb[1] - 0.100 * rgb[2]) / 255.0 );
 }
 
-void convertRGBtoYUV_BT709(const PCCColor3B &rgb, std::vector<float>& yuv ) {
-  yuv.resize( 3 );
+static void convertRGBtoYUV_BT709( const PCCColor3B& rgb, float* yuv ) {
   yuv[0] = float( ( 0.2126 * rgb[0] + 0.7152 * rgb[1] + 0.0722 * rgb[2]) / 255.0 );
   yuv[1] = float( (-0.1146 * rgb[0] - 0.3854 * rgb[1] + 0.5000 * rgb[2]) / 255.0 + 0.5000 );
   yuv[2] = float( ( 0.5000 * rgb[0] - 0.4542 * rgb[1] - 0.0458 * rgb[2]) / 255.0 + 0.5000 );
@@ -82,169 +81,174 @@ void QualityMetrics::setParameters( PCCMetricsParameters params ){
   params_ = params;
 }
 
-void QualityMetrics::compute( const PCCPointSet3& pointcloudA, const PCCPointSet3& pointcloudB ) {
-  double maxC2c = (std::numeric_limits<double>::min)(), maxC2p = (std::numeric_limits<double>::min)();
-  double sseC2p = 0, sseC2c = 0, sseReflectance = 0;
-  size_t num = 0;
-  double sseColor[3];
-  sseColor[0] = sseColor[1] = sseColor[2] = 0.0;
+// Sums of the per point errors of a chunk of points. The chunks have a fixed size and their sums are added in chunk
+// order, so the metrics do not depend on the number of threads.
+struct QualityMetricsSums {
+  QualityMetricsSums() :
+      sseC2c_( 0.0 ),
+      sseC2p_( 0.0 ),
+      sseReflectance_( 0.0 ),
+      maxC2c_( ( std::numeric_limits<double>::min )() ),
+      maxC2p_( ( std::numeric_limits<double>::min )() ) {
+    sseColor_[0] = sseColor_[1] = sseColor_[2] = 0.0;
+  }
+  void add( const QualityMetricsSums& sums ) {
+    sseC2c_ += sums.sseC2c_;
+    sseC2p_ += sums.sseC2p_;
+    for ( size_t i = 0; i < 3; i++ ) { sseColor_[i] += sums.sseColor_[i]; }
+    sseReflectance_ += sums.sseReflectance_;
+    maxC2c_ = ( std::max )( maxC2c_, sums.maxC2c_ );
+    maxC2p_ = ( std::max )( maxC2p_, sums.maxC2p_ );
+  }
+  double sseC2c_;
+  double sseC2p_;
+  double sseColor_[3];
+  double sseReflectance_;
+  double maxC2c_;
+  double maxC2p_;
+};
 
+// The points of A are processed in parallel in the task arena of the caller.
+void QualityMetrics::compute( const PCCPointSet3& pointcloudA, const PCCPointSet3& pointcloudB ) {
+  const size_t num_results_max = 30;
+  const size_t chunkSize       = 4096;
+  const size_t num             = pointcloudA.getPointCount();
+  const size_t chunkCount      = ( num + chunkSize - 1 ) / chunkSize;
+  const bool   useC2p          = params_.computeC2p_ && pointcloudB.hasNormals() && pointcloudA.hasNormals();
+  const bool   useColor        = params_.computeColor_ && pointcloudA.hasColors() && pointcloudB.hasColors();
+  const bool   useReflectance =
+      params_.computeReflectance_ && pointcloudA.hasReflectances() && pointcloudB.hasReflectances();
   psnr_ = params_.resolution_;
 
-  PCCKdTree kdtree( pointcloudB );
-  PCCNNResult result;
-  const size_t num_results_max  = 30;
-  const size_t num_results_incr = 5;
+  // The colour and the point to plane metrics use all the points of B at the nearest distance.
+  const size_t                    num_results = params_.computeColor_ || params_.computeC2p_ ? num_results_max : 1;
+  PCCKdTree                       kdtree( pointcloudB, PCC_SPATIAL_INDEX_VOXEL_GRID );
+  auto&                           normalsB = pointcloudB.getNormals();
+  std::vector<QualityMetricsSums> chunkSums( chunkCount );
+  tbb::parallel_for( size_t( 0 ), chunkCount, [&]( const size_t chunk ) {
+    PCCNNResult         result;
+    QualityMetricsSums& sums = chunkSums[chunk];
+    const size_t        end  = ( std::min )( num, ( chunk + 1 ) * chunkSize );
+    for ( size_t indexA = chunk * chunkSize; indexA < end; indexA++ ) {
+      // For point 'i' in A, find its nearest neighbors in B, sorted by index.
+      kdtree.searchNearestTies( pointcloudA[indexA], num_results, result );
+      const size_t tieCount = result.count();
+      if ( tieCount == 0 ) { continue; }
 
-  auto& normalsB = pointcloudB.getNormals();
-  for (size_t indexA = 0; indexA < pointcloudA.getPointCount(); indexA++) {
-    // For point 'i' in A, find its nearest neighbor in B. store it in 'j'
-    size_t num_results = 0;
-    do {
-      num_results  += num_results_incr;
-      kdtree.search( pointcloudA[indexA], num_results, result );
-    } while( result.dist(0) == result.dist(num_results-1) && num_results + num_results_incr <= num_results_max );
+      // Compute point-to-point, which should be equal to sqrt( dist[0] )
+      const double distProjC2c = result.dist( 0 );
 
-    // Compute point-to-point, which should be equal to sqrt( dist[0] )
-    double distProjC2c = result.dist(0);
-
-    // Build the list of all the points of same distances.
-    std::vector<size_t> sameDistList;
-    if (params_.computeColor_ || params_.computeC2p_ ) {
-      for (size_t j = 0; j < num_results && ( fabs( result.dist(0) - result.dist(j)) < 1e-8 ) ; j++) {
-        sameDistList.push_back( result.indices(j) );
-      }
-    }
-    std::sort (sameDistList.begin(), sameDistList.end() );
-
-    // Compute point-to-plane, normals in B will be used for point-to-plane
-    double distProjC2p = 0.0;
-    if ( params_.computeC2p_ && pointcloudB.hasNormals() && pointcloudA.hasNormals() ){
-      for (auto& indexB : sameDistList ) {
-        std::vector<double> errVector(3);
-        for(size_t j=0;j<3;j++){
-          errVector[j] = pointcloudA[indexA][j] - pointcloudB[indexB][j];
+      // Compute point-to-plane, normals in B will be used for point-to-plane
+      double distProjC2p = 0.0;
+      if ( useC2p ) {
+        for ( size_t j = 0; j < tieCount; j++ ) {
+          const size_t indexB = result.indices( j );
+          double       errVector[3];
+          for ( size_t k = 0; k < 3; k++ ) { errVector[k] = pointcloudA[indexA][k] - pointcloudB[indexB][k]; }
+          const double dist = errVector[0] * normalsB[indexB][0] + errVector[1] * normalsB[indexB][1] +
+                              errVector[2] * normalsB[indexB][2];
+          distProjC2p += dist * dist;
         }
-        double dist = pow( errVector[0] * normalsB[indexB][0] +
-                           errVector[1] * normalsB[indexB][1] +
-                           errVector[2] * normalsB[indexB][2], 2.f );
-        distProjC2p += dist;
+        distProjC2p /= tieCount;
       }
-      distProjC2p /= sameDistList.size();
-    }
 
-    size_t indexB = result.indices(0);
-    double distColor[3];
-    distColor[0] = distColor[1] = distColor[2] = 0.0;
-    if ( params_.computeColor_ && pointcloudA.hasColors() && pointcloudB.hasColors() ) {
-      std::vector<float> yuvA, yuvB;
-      PCCColor3B rgb;
-      convertRGBtoYUV_BT709( pointcloudA.getColor( indexA ), yuvA );
-      if( params_.neighborsProc_ ) {
+      const size_t indexB = result.indices( 0 );
+      double       distColor[3];
+      distColor[0] = distColor[1] = distColor[2] = 0.0;
+      if ( useColor ) {
+        float yuvA[3], yuvB[3];
+        convertRGBtoYUV_BT709( pointcloudA.getColor( indexA ), yuvA );
         switch ( params_.neighborsProc_ ) {
-          case 0:
-            break;
-          case 1:     // Average
-          case 2:     // Weighted average
+          case 1:  // Average
+          case 2:  // Weighted average
           {
-            int nbdupcumul = 0;
             unsigned int r = 0, g = 0, b = 0;
-            for (size_t i = 0; i < sameDistList.size(); i++) {
-              int nbdup = 1; // pointcloudB.xyz.nbdup[ indices_sameDst[n] ];
-              r += nbdup * pointcloudB.getColor( sameDistList[i] )[0];
-              g += nbdup * pointcloudB.getColor( sameDistList[i] )[1];
-              b += nbdup * pointcloudB.getColor( sameDistList[i] )[2];
-              nbdupcumul += nbdup;
+            for ( size_t j = 0; j < tieCount; j++ ) {
+              const PCCColor3B& color = pointcloudB.getColor( result.indices( j ) );
+              r += color[0];
+              g += color[1];
+              b += color[2];
             }
-            rgb[0] = (unsigned char)round( (double)r / nbdupcumul );
-            rgb[1] = (unsigned char)round( (double)g / nbdupcumul );
-            rgb[2] = (unsigned char)round( (double)b / nbdupcumul );
+            PCCColor3B rgb;
+            rgb[0] = (unsigned char)round( (double)r / tieCount );
+            rgb[1] = (unsigned char)round( (double)g / tieCount );
+            rgb[2] = (unsigned char)round( (double)b / tieCount );
             convertRGBtoYUV_BT709( rgb, yuvB );
-            for(size_t i=0;i<3;i++){
-              distColor[i] = pow( yuvA[i] - yuvB[i], 2.f );
-            }
-          }
-          break;
-          case 3:   // Min
-          case 4:   // Max
+          } break;
+          case 3:  // Min
+          case 4:  // Max
           {
-            float distBest = 0;
+            float  distBest  = 0;
             size_t indexBest = 0;
-            for ( auto index : sameDistList ) {
-              convertRGBtoYUV_BT709( pointcloudB.getColor( index ), yuvB );
-              float dist = pow( yuvA[0] - yuvB[0], 2.f ) + pow( yuvA[1] - yuvB[1], 2.f ) + pow( yuvA[2] - yuvB[2], 2.f );
-              if( ( ( params_.neighborsProc_ == 3 ) && ( dist < distBest ) ) ||
-                  ( ( params_.neighborsProc_ == 4 ) && ( dist > distBest ) ) ) {
+            for ( size_t j = 0; j < tieCount; j++ ) {
+              convertRGBtoYUV_BT709( pointcloudB.getColor( result.indices( j ) ), yuvB );
+              const float dY = yuvA[0] - yuvB[0], dU = yuvA[1] - yuvB[1], dV = yuvA[2] - yuvB[2];
+              const float dist = dY * dY + dU * dU + dV * dV;
+              if ( ( ( params_.neighborsProc_ == 3 ) && ( dist < distBest ) ) ||
+                   ( ( params_.neighborsProc_ == 4 ) && ( dist > distBest ) ) ) {
                 distBest  = dist;
-                indexBest = index;
+                indexBest = result.indices( j );
               }
             }
             convertRGBtoYUV_BT709( pointcloudB.getColor( indexBest ), yuvB );
-          }
-          break;
+          } break;
+          default: convertRGBtoYUV_BT709( pointcloudB.getColor( indexB ), yuvB ); break;
+        }
+        for ( size_t i = 0; i < 3; i++ ) {
+          const float diff = yuvA[i] - yuvB[i];
+          distColor[i]     = diff * diff;
         }
-      } else {
-        convertRGBtoYUV_BT709( pointcloudB.getColor( indexB ), yuvB );
-      }
-      for(size_t i=0;i<3;i++){ 
-        distColor[i] = pow( yuvA[i] - yuvB[i], 2.f );
       }
-    }
 
-    double distReflectance = 0.0;
-    if (params_.computeReflectance_ && pointcloudA.hasReflectances() && pointcloudB.hasReflectances()) {
-      distReflectance = pow( pointcloudA.getReflectance( indexA ) - pointcloudB.getReflectance( indexB ), 2.f );
-    }
-    num++;
+      double distReflectance = 0.0;
+      if ( useReflectance ) {
+        const double diff = pointcloudA.getReflectance( indexA ) - pointcloudB.getReflectance( indexB );
+        distReflectance   = diff * diff;
+      }
 
-    // mean square distance
-    if ( params_.computeC2c_) {
-      sseC2c += distProjC2c;
-      if (distProjC2c > maxC2c){
-        maxC2c = distProjC2c;
+      // mean square distance
+      if ( params_.computeC2c_ ) {
+        sums.sseC2c_ += distProjC2c;
+        sums.maxC2c_ = ( std::max )( sums.maxC2c_, distProjC2c );
       }
-    }
-    if ( params_.computeC2p_) {
-      sseC2p += distProjC2p;
-      if (distProjC2p > maxC2p){
-        maxC2p = distProjC2p;
+      if ( params_.computeC2p_ ) {
+        sums.sseC2p_ += distProjC2p;
+        sums.maxC2p_ = ( std::max )( sums.maxC2p_, distProjC2p );
       }
-    }
-    if ( params_.computeColor_) {
-      for(size_t i = 0 ;i<3;i++) {
-        sseColor[i] += distColor[i];
+      if ( params_.computeColor_ ) {
+        for ( size_t i = 0; i < 3; i++ ) { sums.sseColor_[i] += distColor[i]; }
       }
+      if ( useReflectance ) { sums.sseReflectance_ += distReflectance; }
     }
-    if ( params_.computeReflectance_ && pointcloudA.hasReflectances() && pointcloudB.hasReflectances()) {
-      sseReflectance += distReflectance;
-    }
-  }
+  } );
+  QualityMetricsSums sums;
+  for ( auto& chunk : chunkSums ) { sums.add( chunk ); }
 
   if ( params_.computeC2c_ ) {
-    c2cMse_           = float( sseC2c / num );
+    c2cMse_           = float( sums.sseC2c_ / num );
     c2cPsnr_          = getPSNR( c2cMse_,       psnr_, 3 );
     if( params_.computeHausdorff_) {
-      c2cHausdorff_     = float( maxC2c );
+      c2cHausdorff_     = float( sums.maxC2c_ );
       c2cHausdorffPsnr_ = getPSNR( c2cHausdorff_, psnr_, 3 );
     }
   }
 
   if ( params_.computeC2p_ ) {
-    c2pMse_           = float( sseC2p / num );
+    c2pMse_           = float( sums.sseC2p_ / num );
     c2pPsnr_          = getPSNR( c2pMse_,       psnr_, 3 );
     if( params_.computeHausdorff_) {
-      c2pHausdorff_     = float( maxC2p );
+      c2pHausdorff_     = float( sums.maxC2p_ );
       c2pHausdorffPsnr_ = getPSNR( c2pHausdorff_, psnr_, 3 );
     }
   }
   if ( params_.computeColor_ ) {
     for(size_t i = 0 ;i<3;i++) {
-      colorMse_ [i] = float(   sseColor [i] / num );
+      colorMse_ [i] = float(   sums.sseColor_ [i] / num );
       colorPsnr_[i] = getPSNR( colorMse_[i], 1.0 );
     }
   }
   if ( params_.computeLidar_ ) {
-    reflectanceMse_  = float( sseReflectance / num );
+    reflectanceMse_  = float( sums.sseReflectance_ / num );
     reflectancePsnr_ = getPSNR( float( reflectanceMse_ ), float( (std::numeric_limits<unsigned short>::max)() ) );
   }
 }
@@ -352,8 +356,8 @@ void PCCMetrics::compute( const PCCGroupOfFrames& sources,
     reconstructPoints_  .push_back( reconstructOrg.getPointCount() );
     PCCPointSet3 source, reconstruct;
     if( params_.dropDuplicates_ ) {
-      sourceOrg     .removeDuplicate( source,      params_.dropDuplicates_ );
-      reconstructOrg.removeDuplicate( reconstruct, params_.dropDuplicates_ );
+      sourceOrg     .removeDuplicate( source,      params_.dropDuplicates_, params_.nbThread_ );
+      reconstructOrg.removeDuplicate( reconstruct, params_.dropDuplicates_, params_.nbThread_ );
       sourceDuplicates_      .push_back( source.getPointCount()      );
       reconstructDuplicates_ .push_back( reconstruct.getPointCount() );
       compute( source, reconstruct, normals.size() == 0 ? normalEmpty : normals[i] );
@@ -376,9 +380,12 @@ void PCCMetrics::compute( PCCPointSet3& source,
   }
   QualityMetrics q1, q2;
   q1.setParameters( params_ );
-  q1.compute( source, reconstruct );
   q2.setParameters( params_ );
-  q2.compute( reconstruct, source );
+  // both directions are computed concurrently, sharing the nbThread threads of one arena.
+  tbb::task_arena limited( (int)params_.nbThread_ );
+  limited.execute( [&] {
+    tbb::parallel_invoke( [&] { q1.compute( source, reconstruct ); }, [&] { q2.compute( reconstruct, source ); } );
+  } );
   quality1.push_back( q1 );
   quality2.push_back( q2 );
   qualityF.push_back( q1 + q2 );
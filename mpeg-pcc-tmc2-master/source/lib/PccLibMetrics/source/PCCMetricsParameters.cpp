@@ -48,6 +48,7 @@ PCCMetricsParameters::PCCMetricsParameters() {
   reconstructedDataPath_  = {};
   normalDataPath_         = {};
   nbThread_               = 0;
+  pinThreads_             = false;
 
   resolution_             = 1023;
   dropDuplicates_         = 2;
@@ -82,6 +83,7 @@ void PCCMetricsParameters::print(){
   std::cout << "\t   reconstructedDataPath                " << reconstructedDataPath_ << std::endl;
   std::cout << "\t   normalDataPath                       " << normalDataPath_        << std::endl;
   std::cout << "\t   nbThread                             " << nbThread_              << std::endl;
+  std::cout << "\t   pinThreads                           " << pinThreads_            << std::endl;
   std::cout << "\t   resolution                           " << resolution_            << std::endl;
   std::cout << "\t   dropDuplicates                       " << dropDuplicates_        << std::endl;
   std::cout << "\t   neighborsProc                        " << neighborsProc_         << std::endl;